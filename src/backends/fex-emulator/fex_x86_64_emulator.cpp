@@ -1377,6 +1377,29 @@ namespace sogen::fex
             return true;
         }
 
+        // Guest VA == host VA, so every mapped range is its own host span.
+        std::span<const std::byte> get_host_span(uint64_t address, size_t size) const override
+        {
+            if (!this->is_range_mapped(address, size))
+            {
+                return {};
+            }
+
+            return {reinterpret_cast<const std::byte*>(address), size};
+        }
+
+        std::span<std::byte> get_writable_host_span(uint64_t address, size_t size) override
+        {
+            // Read-only ranges need the temporary permission bump of try_write_memory, which a span can't undo.
+            if (!this->is_range_mapped(address, size) || !this->range_is_writable(address, size))
+            {
+                return {};
+            }
+
+            this->invalidate_code_range(address, size);
+            return {reinterpret_cast<std::byte*>(address), size};
+        }
+
         // hook_interface
         //
         // As with KVM, the guest runs natively, so fine-grained memory/execution/basic-block hooks
@@ -1479,6 +1502,11 @@ namespace sogen::fex
             return false;
         }
 
+        bool supports_basic_block_hooks() const override
+        {
+            return false;
+        }
+
 #ifdef __APPLE__
         std::vector<host_reserved_range> reserved_host_ranges() const override
         {
@@ -5,6 +5,7 @@
 #include <unordered_set>
 #include <utils/object.hpp>
 #include <utils/finally.hpp>
+#include <dirty_page_log.hpp>
 
 using icicle_emulator = struct icicle_emulator_;
 
@@ -306,7 +307,13 @@ namespace sogen::icicle
 
         bool try_write_memory(const uint64_t address, const void* data, const size_t size) override
         {
-            return icicle_write_memory(this->emu_, address, data, size);
+            if (!icicle_write_memory(this->emu_, address, data, size))
+            {
+                return false;
+            }
+
+            this->dirty_pages_.mark(address, size);
+            return true;
         }
 
         void write_memory(const uint64_t address, const void* data, const size_t size) override
@@ -321,6 +328,32 @@ namespace sogen::icicle
             ice(res, "Failed to apply permissions");
         }
 
+        // Guest writes reach the log through a write hook over the whole address space, installed when
+        // tracking first starts; try_write_memory marks the writes made from the host.
+        bool supports_dirty_page_tracking() const override
+        {
+            return true;
+        }
+
+        void start_dirty_page_tracking() override
+        {
+            if (!this->dirty_pages_.is_active())
+            {
+                auto log_write = [this](cpu_interface&, const uint64_t address, const void*, const size_t length) {
+                    this->dirty_pages_.mark(address, length); //
+                };
+
+                this->hook_memory_write(0, std::numeric_limits<uint64_t>::max(), std::move(log_write));
+            }
+
+            this->dirty_pages_.start();
+        }
+
+        std::vector<uint64_t> collect_dirty_pages() override
+        {
+            return this->dirty_pages_.collect();
+        }
+
         // The raw icicle hook wrappers are captureless function pointers, so the
         // triggering CPU is bound into the stored function up front.
         template <typename Ret, typename... Args>
@@ -351,6 +384,11 @@ namespace sogen::icicle
             return wrap_hook(id);
         }
 
+        bool supports_basic_block_instruction_counts() const override
+        {
+            return true;
+        }
+
         emulator_hook* hook_basic_block(basic_block_hook_callback callback) override
         {
             auto object = make_function_object(this->bind_cpu(std::move(callback)), this->is_in_hook_);
@@ -572,6 +610,7 @@ namespace sogen::icicle
 
         std::unordered_set<emulator_hook*> hooks_to_delete_{};
         std::unordered_map<emulator_hook*, memory_access_hook> hooks_to_install_{};
+        dirty_page_log dirty_pages_{};
 
         emulator_hook* wrap_hook(const std::optional<uint32_t> icicle_id)
         {
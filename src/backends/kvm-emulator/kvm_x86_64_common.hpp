@@ -29,6 +29,7 @@ namespace sogen::kvm::detail
 
     struct mapped_page
     {
+        uint64_t guest_address = 0;
         void* host_page = nullptr;
         memory_permission permissions = memory_permission::none;
         bool user_accessible = true;
@@ -141,9 +142,19 @@ namespace sogen::kvm::detail
     {
         std::optional<uint64_t> address{};
         uint64_t size{};
+        bool patched_breakpoint{false};
         memory_execution_hook_callback callback{};
     };
 
+    // A 0xCC patched over guest code for an int3-mode execution hook. `original` shadows the byte the guest
+    // would see; it is only meaningful while the breakpoint is armed (0xCC actually present in memory).
+    struct patched_breakpoint
+    {
+        std::byte original{};
+        size_t references{0};
+        bool armed{false};
+    };
+
     struct memory_access_hook_entry
     {
         uint64_t address{};
@@ -151,6 +162,15 @@ namespace sogen::kvm::detail
         memory_access_hook_callback callback{};
     };
 
+    // `slots` is the mask of debug registers watching the range, in DR6 status bit order.
+    struct watchpoint_entry
+    {
+        uint64_t address{};
+        uint64_t size{};
+        uint8_t slots{};
+        memory_access_hook_callback callback{};
+    };
+
     struct mmio_region
     {
         uint64_t address{};
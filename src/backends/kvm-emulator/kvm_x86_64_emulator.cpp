@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
@@ -23,15 +24,18 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <ranges>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <utils/object.hpp>
+#include <x86_debug_registers.hpp>
 
 #ifndef MSR_LSTAR
 #define MSR_LSTAR 0xC0000082
@@ -58,11 +62,17 @@ namespace sogen::kvm
         using detail::memory_access_hook_entry;
         using detail::mmio_region;
         using detail::page_size;
+        using detail::patched_breakpoint;
+        using detail::watchpoint_entry;
 
         constexpr uint32_t vp_index = 0;
+        constexpr uint32_t debug_interrupt = 1;
         constexpr uint32_t breakpoint_interrupt = 3;
         constexpr int invalid_opcode_interrupt = 6;
         constexpr std::byte int3_opcode{0xCC};
+        constexpr uint64_t trap_flag = 1ULL << 8;
+        constexpr uint64_t dr6_breakpoint_status_mask = 0xF;
+        constexpr uint64_t dr6_single_step = 1ULL << 14;
         constexpr uint64_t syscall_instruction_size = 2;
 
         constexpr uintptr_t cache_line_size = 64;
@@ -156,40 +166,73 @@ namespace sogen::kvm
             }
         }
 
-#if defined(KVM_SET_GUEST_DEBUG) && defined(KVM_GUESTDBG_ENABLE) && defined(KVM_GUESTDBG_SINGLESTEP)
-        void enable_guest_single_step(const int vcpu_fd)
+#if defined(KVM_SET_GUEST_DEBUG) && defined(KVM_GUESTDBG_ENABLE) && defined(KVM_GUESTDBG_SINGLESTEP) && defined(KVM_GUESTDBG_USE_HW_BP)
+        kvm_guest_debug make_guest_debug(const bool single_step, const x86_debug_registers& registers)
         {
             kvm_guest_debug debug{};
-            debug.control = KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_SINGLESTEP;
+            if (single_step)
+            {
+                debug.control |= KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_SINGLESTEP;
+            }
+
+            if (registers.dr7 != 0)
+            {
+                debug.control |= KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_USE_HW_BP;
+                std::ranges::copy(registers.address, std::begin(debug.arch.debugreg));
+                debug.arch.debugreg[7] = registers.dr7;
+            }
+
+            return debug;
+        }
+
+        void enable_guest_single_step(const int vcpu_fd, const x86_debug_registers& registers)
+        {
+            const auto debug = make_guest_debug(true, registers);
             check_ioctl_result(::ioctl(vcpu_fd, KVM_SET_GUEST_DEBUG, &debug), "KVM_SET_GUEST_DEBUG");
         }
 
-        void clear_guest_debug_control_noexcept(const int vcpu_fd) noexcept
+        // Leaves only the watchpoints armed.
+        void clear_guest_single_step_noexcept(const int vcpu_fd, const x86_debug_registers& registers) noexcept
         {
-            kvm_guest_debug debug{};
+            const auto debug = make_guest_debug(false, registers);
             (void)::ioctl(vcpu_fd, KVM_SET_GUEST_DEBUG, &debug);
         }
+
+        void apply_guest_debug(const int vcpu_fd, const bool single_step, const x86_debug_registers& registers)
+        {
+            const auto debug = make_guest_debug(single_step, registers);
+            check_ioctl_result(::ioctl(vcpu_fd, KVM_SET_GUEST_DEBUG, &debug), "KVM_SET_GUEST_DEBUG");
+        }
 #else
-        void enable_guest_single_step(const int)
+        void enable_guest_single_step(const int, const x86_debug_registers&)
         {
             throw std::runtime_error("KVM backend single-step requires KVM guest debug support");
         }
 
-        void clear_guest_debug_control_noexcept(const int) noexcept
+        void clear_guest_single_step_noexcept(const int, const x86_debug_registers&) noexcept
+        {
+        }
+
+        void apply_guest_debug(const int, const bool, const x86_debug_registers& registers)
         {
+            if (registers.dr7 != 0)
+            {
+                throw std::runtime_error("KVM backend watchpoints require KVM guest debug support");
+            }
         }
 #endif
 
         class scoped_guest_debug
         {
           public:
-            scoped_guest_debug(const int vcpu_fd, const bool enable)
+            scoped_guest_debug(const int vcpu_fd, const bool enable, const x86_debug_registers& registers)
                 : vcpu_fd_(vcpu_fd),
-                  active_(enable)
+                  active_(enable),
+                  registers_(&registers)
             {
                 if (this->active_)
                 {
-                    enable_guest_single_step(this->vcpu_fd_);
+                    enable_guest_single_step(this->vcpu_fd_, *this->registers_);
                 }
             }
 
@@ -200,13 +243,14 @@ namespace sogen::kvm
             {
                 if (this->active_)
                 {
-                    clear_guest_debug_control_noexcept(this->vcpu_fd_);
+                    clear_guest_single_step_noexcept(this->vcpu_fd_, *this->registers_);
                 }
             }
 
           private:
             int vcpu_fd_ = -1;
             bool active_ = false;
+            const x86_debug_registers* registers_{};
         };
 
         // No-op handler whose only purpose is to interrupt a blocking KVM_RUN ioctl so the
@@ -418,6 +462,7 @@ namespace sogen::kvm
 
             ~kvm_x86_64_emulator() override
             {
+                utils::reset_object_with_delayed_destruction(this->watchpoints_);
                 utils::reset_object_with_delayed_destruction(this->memory_write_hooks_);
                 utils::reset_object_with_delayed_destruction(this->memory_read_hooks_);
                 utils::reset_object_with_delayed_destruction(this->memory_execution_hooks_);
@@ -455,7 +500,22 @@ namespace sogen::kvm
                 }
 
                 const bool single_step = count == 1;
-                const scoped_guest_debug guest_debug(this->vcpu_fd_.get(), single_step);
+
+                // KVM latches the single-step RIP when guest debugging is enabled, so pending register writes
+                // have to reach the vCPU first.
+                this->flush_register_cache();
+                const scoped_guest_debug guest_debug(this->vcpu_fd_.get(), single_step, this->debug_registers_);
+
+                if (this->stepping_breakpoint_)
+                {
+                    // A breakpoint step-over was interrupted by a stop; keep stepping until it can be re-armed.
+                    enable_guest_single_step(this->vcpu_fd_.get(), this->debug_registers_);
+                }
+
+                if (this->resumed_breakpoint_ != this->read_instruction_pointer())
+                {
+                    this->resumed_breakpoint_.reset();
+                }
 
                 this->stop_requested_ = false;
                 this->vcpu_thread_.store(pthread_self(), std::memory_order_release);
@@ -464,8 +524,14 @@ namespace sogen::kvm
                 while (!this->stop_requested_)
                 {
                     const auto step_rip = this->read_instruction_pointer();
+                    if (this->handle_patched_breakpoint(step_rip))
+                    {
+                        continue;
+                    }
+
                     if (this->handle_pre_run_instruction())
                     {
+                        this->finish_breakpoint_step_over(single_step);
                         this->run_memory_execution_hooks(step_rip);
                         if (single_step)
                         {
@@ -547,8 +613,26 @@ namespace sogen::kvm
 
                         return;
                     case KVM_EXIT_DEBUG:
+                        if (this->handle_watchpoint_exit(this->run_->debug.arch.dr6))
+                        {
+                            continue;
+                        }
+
+                        if (this->stepping_breakpoint_ && !single_step)
+                        {
+                            // The step trap is usually delivered through the guest IDT and completes in
+                            // handle_exception_trap; only a debug exit back in guest code finishes it here.
+                            if (!this->is_exception_stub_address(this->read_instruction_pointer()))
+                            {
+                                this->finish_breakpoint_step_over(false);
+                            }
+
+                            continue;
+                        }
+
                         if (single_step)
                         {
+                            this->finish_breakpoint_step_over(true);
                             this->run_memory_execution_hooks(step_rip);
                             return;
                         }
@@ -995,7 +1079,13 @@ namespace sogen::kvm
 
             bool try_read_memory(uint64_t address, void* data, size_t size) const override
             {
-                return detail::access_memory(this->mapped_pages_, address, data, size, false);
+                if (!detail::access_memory(this->mapped_pages_, address, data, size, false))
+                {
+                    return false;
+                }
+
+                this->hide_patched_breakpoints(address, data, size);
+                return true;
             }
 
             void write_memory(uint64_t address, const void* data, size_t size) override
@@ -1008,13 +1098,44 @@ namespace sogen::kvm
 
             bool try_write_memory(uint64_t address, const void* data, size_t size) override
             {
-                return detail::access_memory(this->mapped_pages_, address, const_cast<void*>(data), size, true);
+                this->mark_pages_dirty(address, size);
+
+                if (!detail::access_memory(this->mapped_pages_, address, const_cast<void*>(data), size, true))
+                {
+                    return false;
+                }
+
+                this->preserve_patched_breakpoints(address, data, size);
+                return true;
+            }
+
+            std::span<const std::byte> get_host_span(const uint64_t address, const size_t size) const override
+            {
+                return this->find_host_span(address, size);
+            }
+
+            std::span<std::byte> get_writable_host_span(const uint64_t address, const size_t size) override
+            {
+                const auto span = this->find_host_span(address, size);
+                if (!span.empty())
+                {
+                    this->mark_pages_dirty(address, size);
+                }
+
+                return span;
+            }
+
+            void set_memory_execution_hook_mode(const memory_execution_hook_mode mode) override
+            {
+                this->memory_execution_hook_mode_ = mode;
             }
 
             // Fine-grained memory read/write/execution and basic-block hooks are registered for API
             // compatibility but never fire: the guest runs natively in the vCPU, so there is no
             // per-access/per-instruction instrumentation point without prohibitive single-stepping.
             // Callers that need these (some analyzer features) are unsupported under the KVM backend.
+            // The exception are single-address execution hooks in int3 mode, which patch a breakpoint over
+            // the hooked instruction and only exit when it is reached.
             emulator_hook* hook_memory_execution(memory_execution_hook_callback callback) override
             {
                 auto* hook = this->make_hook();
@@ -1025,11 +1146,25 @@ namespace sogen::kvm
 
             emulator_hook* hook_memory_execution(uint64_t address, memory_execution_hook_callback callback) override
             {
+                if (this->memory_execution_hook_mode_ == memory_execution_hook_mode::int3)
+                {
+                    return this->hook_breakpoint(address, std::move(callback));
+                }
+
                 auto* hook = this->make_hook();
                 this->memory_execution_hooks_[hook] = execution_hook_entry{.address = address, .size = 1, .callback = std::move(callback)};
                 return hook;
             }
 
+            emulator_hook* hook_breakpoint(const uint64_t address, memory_execution_hook_callback callback) override
+            {
+                auto* hook = this->make_hook();
+                this->install_patched_breakpoint(address);
+                this->memory_execution_hooks_[hook] =
+                    execution_hook_entry{.address = address, .size = 1, .patched_breakpoint = true, .callback = std::move(callback)};
+                return hook;
+            }
+
             emulator_hook* hook_memory_range_execution(uint64_t address, uint64_t size, memory_execution_hook_callback callback) override
             {
                 auto* hook = this->make_hook();
@@ -1054,6 +1189,26 @@ namespace sogen::kvm
                 return hook;
             }
 
+            bool supports_watchpoints() const override
+            {
+                return true;
+            }
+
+            // Watchpoints are armed in the debug registers through guest debugging, the vCPU only exits when one
+            // of them triggers.
+            emulator_hook* hook_watchpoint(const uint64_t address, const uint64_t size, const memory_operation operation,
+                                           memory_access_hook_callback callback) override
+            {
+                auto registers = this->debug_registers_;
+                const auto slots = registers.arm(address, size, operation);
+                this->update_debug_registers(registers);
+
+                auto* hook = this->make_hook();
+                this->watchpoints_[hook] =
+                    watchpoint_entry{.address = address, .size = size, .slots = slots, .callback = std::move(callback)};
+                return hook;
+            }
+
             emulator_hook* hook_instruction(int instruction_type, instruction_hook_callback callback) override
             {
                 auto* hook = this->make_hook();
@@ -1088,6 +1243,11 @@ namespace sogen::kvm
                 return hook;
             }
 
+            bool supports_basic_block_hooks() const override
+            {
+                return false;
+            }
+
             void delete_hook(emulator_hook* hook) override
             {
                 const auto instruction_it = this->instruction_hooks_.find(hook);
@@ -1096,6 +1256,20 @@ namespace sogen::kvm
                     this->syscall_hook_ = nullptr;
                 }
 
+                const auto execution_it = this->memory_execution_hooks_.find(hook);
+                if (execution_it != this->memory_execution_hooks_.end() && execution_it->second.patched_breakpoint)
+                {
+                    this->release_patched_breakpoint(*execution_it->second.address);
+                }
+
+                if (const auto watchpoint_it = this->watchpoints_.find(hook); watchpoint_it != this->watchpoints_.end())
+                {
+                    auto registers = this->debug_registers_;
+                    registers.disarm(watchpoint_it->second.slots);
+                    this->watchpoints_.erase(watchpoint_it);
+                    this->update_debug_registers(registers);
+                }
+
                 this->instruction_hooks_.erase(hook);
                 this->basic_block_hooks_.erase(hook);
                 this->interrupt_hooks_.erase(hook);
@@ -1120,6 +1294,11 @@ namespace sogen::kvm
                 std::vector<memory_execution_hook_callback> callbacks{};
                 for (const auto& [_, hook] : this->memory_execution_hooks_)
                 {
+                    if (hook.patched_breakpoint)
+                    {
+                        continue;
+                    }
+
                     if (!hook.address || (hook.size != 0 && address >= *hook.address && address - *hook.address < hook.size))
                     {
                         callbacks.push_back(hook.callback);
@@ -1153,7 +1332,7 @@ namespace sogen::kvm
                     auto& page = this->mapped_pages_[guest_address];
                     if (!page)
                     {
-                        page = std::make_unique<mapped_page>();
+                        page = std::make_unique<mapped_page>(mapped_page{.guest_address = guest_address});
                     }
 
                     if (page->host_page == nullptr)
@@ -1202,7 +1381,7 @@ namespace sogen::kvm
                         auto& page = this->mapped_pages_[guest_address];
                         if (!page)
                         {
-                            page = std::make_unique<mapped_page>();
+                            page = std::make_unique<mapped_page>(mapped_page{.guest_address = guest_address});
                         }
 
                         page->owned_page = backing;
@@ -1212,6 +1391,7 @@ namespace sogen::kvm
                     }
 
                     this->rebuild_mappings();
+                    this->arm_patched_breakpoints(address, size);
                     return;
                 }
 
@@ -1221,7 +1401,7 @@ namespace sogen::kvm
                     auto& page = this->mapped_pages_[guest_address];
                     if (!page)
                     {
-                        page = std::make_unique<mapped_page>();
+                        page = std::make_unique<mapped_page>(mapped_page{.guest_address = guest_address});
                     }
 
                     if (page->host_page == nullptr)
@@ -1236,6 +1416,12 @@ namespace sogen::kvm
                 }
 
                 this->rebuild_mappings();
+                this->arm_patched_breakpoints(address, size);
+            }
+
+            bool supports_host_memory_mapping() const override
+            {
+                return true;
             }
 
             void map_host_memory(uint64_t address, size_t size, void* host_pointer, memory_permission permissions) override
@@ -1259,7 +1445,7 @@ namespace sogen::kvm
                     auto& page = this->mapped_pages_[guest_address];
                     if (!page)
                     {
-                        page = std::make_unique<mapped_page>();
+                        page = std::make_unique<mapped_page>(mapped_page{.guest_address = guest_address});
                     }
 
                     page->owned_page = nullptr;
@@ -1269,6 +1455,10 @@ namespace sogen::kvm
                 }
 
                 this->rebuild_mappings();
+
+                // The new backing does not carry the patched bytes of whatever was mapped here before.
+                this->disarm_patched_breakpoints(address, size);
+                this->arm_patched_breakpoints(address, size);
             }
 
             bool host_memory_aliasing_is_coherent() const override
@@ -1284,6 +1474,46 @@ namespace sogen::kvm
                 flush_cache_line_range(host_pointer, size);
             }
 
+            // Guest CPU writes are logged by KVM itself (KVM_MEM_LOG_DIRTY_PAGES on every writable memslot);
+            // writes the emulator performs through host pointers bypass that log and are recorded in
+            // try_write_memory instead.
+            bool supports_dirty_page_tracking() const override
+            {
+                return true;
+            }
+
+            void start_dirty_page_tracking() override
+            {
+                if (this->dirty_page_tracking_)
+                {
+                    // Harvesting resets KVM's per-slot bitmaps, so the log restarts empty.
+                    this->flush_dirty_mappings();
+                    this->harvest_dirty_logs();
+                }
+                else
+                {
+                    // Turning logging on changes the flags of every writable memslot; the reconciliation
+                    // before the next KVM_RUN recreates them with fresh (empty) bitmaps.
+                    this->dirty_page_tracking_ = true;
+                    this->rebuild_mappings();
+                }
+
+                this->dirty_pages_.clear();
+            }
+
+            std::vector<uint64_t> collect_dirty_pages() override
+            {
+                if (!this->dirty_page_tracking_)
+                {
+                    return {};
+                }
+
+                this->flush_dirty_mappings();
+                this->harvest_dirty_logs();
+
+                return {this->dirty_pages_.begin(), this->dirty_pages_.end()};
+            }
+
             void unmap_memory(uint64_t address, size_t size) override
             {
                 if (!is_page_aligned(address) || !is_page_aligned(size))
@@ -1305,6 +1535,8 @@ namespace sogen::kvm
                     this->mapped_pages_.erase(entry);
                 }
 
+                this->disarm_patched_breakpoints(address, size);
+
                 // Drop any MMIO region whose backing pages were just removed. Regions are mapped and
                 // unmapped wholesale, so erase by overlap rather than requiring an exact size match;
                 // otherwise a stale region would keep routing exits to a callback over dead pages.
@@ -1749,6 +1981,8 @@ namespace sogen::kvm
                     }
                     else
                     {
+                        // A slot being replaced takes its dirty bitmap with it, so collect it first.
+                        this->harvest_dirty_log(it->first, it->second.id, it->second.size, it->second.flags);
                         this->delete_memslot(it->second.id);
                         it = this->current_slots_.erase(it);
                     }
@@ -1814,14 +2048,59 @@ namespace sogen::kvm
                 }
 
                 uint32_t flags = 0;
-                if (this->readonly_mem_supported_ && (permissions & memory_permission::write) == memory_permission::none)
+                const auto writable = (permissions & memory_permission::write) != memory_permission::none;
+                if (this->readonly_mem_supported_ && !writable)
                 {
                     flags |= KVM_MEM_READONLY;
                 }
 
+                if (this->dirty_page_tracking_ && writable)
+                {
+                    flags |= KVM_MEM_LOG_DIRTY_PAGES;
+                }
+
                 return flags;
             }
 
+            // Moves KVM's dirty bitmap for one memslot into dirty_pages_. KVM_GET_DIRTY_LOG also clears the
+            // bitmap, so every logged write is reported exactly once.
+            void harvest_dirty_log(const uint64_t slot_gpa, const int slot_id, const size_t slot_size, const uint32_t slot_flags)
+            {
+                if ((slot_flags & KVM_MEM_LOG_DIRTY_PAGES) == 0)
+                {
+                    return;
+                }
+
+                const auto page_count = slot_size / page_size;
+                std::vector<uint64_t> bitmap((page_count + 63) / 64, 0);
+
+                kvm_dirty_log log{};
+                log.slot = static_cast<uint32_t>(slot_id);
+                log.dirty_bitmap = bitmap.data();
+                check_ioctl_result(::ioctl(this->vm_fd_.get(), KVM_GET_DIRTY_LOG, &log), "KVM_GET_DIRTY_LOG");
+
+                for (size_t word = 0; word < bitmap.size(); ++word)
+                {
+                    for (auto bits = bitmap[word]; bits != 0; bits &= bits - 1)
+                    {
+                        const auto index = (word * 64) + static_cast<size_t>(std::countr_zero(bits));
+                        const auto entry = this->gpa_pages_.find(slot_gpa + (index * page_size));
+                        if (entry != this->gpa_pages_.end() && entry->second && entry->second->user_accessible)
+                        {
+                            this->dirty_pages_.insert(entry->second->guest_address);
+                        }
+                    }
+                }
+            }
+
+            void harvest_dirty_logs()
+            {
+                for (const auto& [slot_gpa, slot] : this->current_slots_)
+                {
+                    this->harvest_dirty_log(slot_gpa, slot.id, slot.size, slot.flags);
+                }
+            }
+
             void refresh_mmio_pages()
             {
                 for (auto& [base, region] : this->mmio_regions_)
@@ -1895,6 +2174,308 @@ namespace sogen::kvm
                 return handled;
             }
 
+            bool is_exception_stub_address(const uint64_t address) const
+            {
+                return address >= this->exception_stub_page_ && address - this->exception_stub_page_ < page_size;
+            }
+
+            void write_breakpoint_byte(const uint64_t address, const std::byte value)
+            {
+                auto data = value;
+                detail::access_memory(this->mapped_pages_, address, &data, sizeof(data), true);
+            }
+
+            bool arm_patched_breakpoint(const uint64_t address, patched_breakpoint& breakpoint)
+            {
+                if (breakpoint.armed || this->stepping_breakpoint_ == address ||
+                    !detail::access_memory(this->mapped_pages_, address, &breakpoint.original, sizeof(breakpoint.original), false))
+                {
+                    return false;
+                }
+
+                this->write_breakpoint_byte(address, int3_opcode);
+                breakpoint.armed = true;
+                return true;
+            }
+
+            void install_patched_breakpoint(const uint64_t address)
+            {
+                auto& breakpoint = this->patched_breakpoints_[address];
+                if (breakpoint.references++ == 0)
+                {
+                    this->arm_patched_breakpoint(address, breakpoint);
+                }
+            }
+
+            void release_patched_breakpoint(const uint64_t address)
+            {
+                const auto entry = this->patched_breakpoints_.find(address);
+                if (entry == this->patched_breakpoints_.end() || --entry->second.references != 0)
+                {
+                    return;
+                }
+
+                if (entry->second.armed)
+                {
+                    this->write_breakpoint_byte(address, entry->second.original);
+                }
+
+                if (this->stepping_breakpoint_ == address)
+                {
+                    this->stepping_breakpoint_.reset();
+                }
+
+                this->patched_breakpoints_.erase(entry);
+            }
+
+            template <typename Map>
+            static auto get_patched_breakpoints_in(Map& breakpoints, const uint64_t address, const size_t size)
+            {
+                return std::ranges::subrange(breakpoints.lower_bound(address), breakpoints.lower_bound(address + size));
+            }
+
+            // Writes through host pointers bypass KVM's dirty log and are recorded here instead.
+            void mark_pages_dirty(const uint64_t address, const size_t size)
+            {
+                if (this->dirty_page_tracking_ && size > 0)
+                {
+                    for (auto page = detail::align_down_to_page(address); page < address + size; page += page_size)
+                    {
+                        this->dirty_pages_.insert(page);
+                    }
+                }
+            }
+
+            // Guest pages are backed one by one, so a range is only a single span when its pages are consecutive
+            // in host memory too (typically one map_memory or map_host_memory call). Armed patched breakpoints
+            // rule a range out, their int3 bytes must stay hidden from the caller.
+            std::span<std::byte> find_host_span(const uint64_t address, const size_t size) const
+            {
+                if (size == 0 || address + size < address)
+                {
+                    return {};
+                }
+
+                const auto patched = get_patched_breakpoints_in(this->patched_breakpoints_, address, size) | std::views::values;
+                if (std::ranges::any_of(patched, [](const patched_breakpoint& breakpoint) { return breakpoint.armed; }))
+                {
+                    return {};
+                }
+
+                const auto first_page = detail::align_down_to_page(address);
+                auto entry = this->mapped_pages_.find(first_page);
+                if (entry == this->mapped_pages_.end() || !entry->second || entry->second->host_page == nullptr)
+                {
+                    return {};
+                }
+
+                auto* host_base = static_cast<std::byte*>(entry->second->host_page);
+
+                for (auto page = first_page + page_size; page < address + size; page += page_size)
+                {
+                    ++entry;
+                    if (entry == this->mapped_pages_.end() || entry->first != page || !entry->second ||
+                        entry->second->host_page != host_base + (page - first_page))
+                    {
+                        return {};
+                    }
+                }
+
+                return {host_base + (address - first_page), size};
+            }
+
+            void arm_patched_breakpoints(const uint64_t address, const size_t size)
+            {
+                for (auto& [breakpoint_address, breakpoint] : get_patched_breakpoints_in(this->patched_breakpoints_, address, size))
+                {
+                    this->arm_patched_breakpoint(breakpoint_address, breakpoint);
+                }
+            }
+
+            // The patched bytes went away with the memory they were written to.
+            void disarm_patched_breakpoints(const uint64_t address, const size_t size)
+            {
+                for (auto& breakpoint : get_patched_breakpoints_in(this->patched_breakpoints_, address, size) | std::views::values)
+                {
+                    breakpoint.armed = false;
+                }
+            }
+
+            void hide_patched_breakpoints(const uint64_t address, void* data, const size_t size) const
+            {
+                auto* bytes = static_cast<std::byte*>(data);
+                for (const auto& [breakpoint_address, breakpoint] : get_patched_breakpoints_in(this->patched_breakpoints_, address, size))
+                {
+                    if (breakpoint.armed)
+                    {
+                        bytes[breakpoint_address - address] = breakpoint.original;
+                    }
+                }
+            }
+
+            void preserve_patched_breakpoints(const uint64_t address, const void* data, const size_t size)
+            {
+                const auto* bytes = static_cast<const std::byte*>(data);
+                for (auto& [breakpoint_address, breakpoint] : get_patched_breakpoints_in(this->patched_breakpoints_, address, size))
+                {
+                    if (breakpoint.armed)
+                    {
+                        breakpoint.original = bytes[breakpoint_address - address];
+                        this->write_breakpoint_byte(breakpoint_address, int3_opcode);
+                    }
+                }
+            }
+
+            bool is_armed_patched_breakpoint(const uint64_t address) const
+            {
+                const auto entry = this->patched_breakpoints_.find(address);
+                return entry != this->patched_breakpoints_.end() && entry->second.armed;
+            }
+
+            void run_patched_breakpoint_hooks(const uint64_t address)
+            {
+                std::vector<memory_execution_hook_callback> callbacks{};
+                for (const auto& [_, hook] : this->memory_execution_hooks_)
+                {
+                    if (hook.patched_breakpoint && hook.address == address)
+                    {
+                        callbacks.push_back(hook.callback);
+                    }
+                }
+
+                for (const auto& callback : callbacks)
+                {
+                    callback(*this, address);
+                }
+            }
+
+            // Puts the original byte back and single-steps it; the next debug exit in guest code re-arms the
+            // breakpoint (see finish_breakpoint_step_over).
+            void begin_breakpoint_step_over(const uint64_t address)
+            {
+                auto& breakpoint = this->patched_breakpoints_.at(address);
+                this->write_breakpoint_byte(address, breakpoint.original);
+                breakpoint.armed = false;
+
+                this->stepping_breakpoint_ = address;
+                this->flush_register_cache();
+                enable_guest_single_step(this->vcpu_fd_.get(), this->debug_registers_);
+            }
+
+            void finish_breakpoint_step_over(const bool keep_single_step)
+            {
+                if (!this->stepping_breakpoint_)
+                {
+                    return;
+                }
+
+                const auto address = *this->stepping_breakpoint_;
+                this->stepping_breakpoint_.reset();
+
+                if (const auto entry = this->patched_breakpoints_.find(address); entry != this->patched_breakpoints_.end())
+                {
+                    this->arm_patched_breakpoint(address, entry->second);
+                }
+
+                if (!keep_single_step)
+                {
+                    clear_guest_single_step_noexcept(this->vcpu_fd_.get(), this->debug_registers_);
+                }
+            }
+
+            // Watchpoints change while the vCPU is stopped; a pending breakpoint step-over has to keep stepping.
+            void update_debug_registers(const x86_debug_registers& registers)
+            {
+                apply_guest_debug(this->vcpu_fd_.get(), this->stepping_breakpoint_.has_value(), registers);
+                this->debug_registers_ = registers;
+            }
+
+            // Data breakpoints trap after the access, so the hooks see the value the guest left behind. Returns
+            // whether the exit was only a watchpoint hit; a coinciding single-step trap is left to the caller.
+            bool handle_watchpoint_exit(const uint64_t dr6)
+            {
+                std::vector<watchpoint_entry> hits{};
+                for (const auto& watchpoint : this->watchpoints_ | std::views::values)
+                {
+                    if ((watchpoint.slots & dr6 & dr6_breakpoint_status_mask) != 0)
+                    {
+                        hits.push_back(watchpoint);
+                    }
+                }
+
+                if (hits.empty())
+                {
+                    return false;
+                }
+
+                std::vector<std::byte> data{};
+                for (const auto& hit : hits)
+                {
+                    data.assign(hit.size, std::byte{});
+                    (void)this->try_read_memory(hit.address, data.data(), data.size());
+                    hit.callback(*this, hit.address, data.data(), data.size());
+                }
+
+                return (dr6 & dr6_single_step) == 0;
+            }
+
+            // Called before entering the guest. A patched breakpoint at RIP is reported to its hooks and then
+            // stepped over, unless its hooks already ran for this visit before a stop request.
+            bool handle_patched_breakpoint(const uint64_t rip)
+            {
+                if (!this->is_armed_patched_breakpoint(rip))
+                {
+                    return false;
+                }
+
+                if (this->resumed_breakpoint_ == rip)
+                {
+                    this->resumed_breakpoint_.reset();
+                }
+                else
+                {
+                    this->run_patched_breakpoint_hooks(rip);
+                    if (this->stop_requested_)
+                    {
+                        this->resumed_breakpoint_ = rip;
+                        return true;
+                    }
+
+                    if (this->read_instruction_pointer() != rip)
+                    {
+                        return true;
+                    }
+                }
+
+                this->begin_breakpoint_step_over(rip);
+                return false;
+            }
+
+            // Called when the guest executed a patched int3, with RIP already rewound onto it.
+            bool handle_patched_breakpoint_trap(const uint64_t rip)
+            {
+                if (!this->is_armed_patched_breakpoint(rip))
+                {
+                    return false;
+                }
+
+                this->run_patched_breakpoint_hooks(rip);
+
+                if (this->read_instruction_pointer() == rip)
+                {
+                    if (this->stop_requested_)
+                    {
+                        this->resumed_breakpoint_ = rip;
+                    }
+                    else
+                    {
+                        this->begin_breakpoint_step_over(rip);
+                    }
+                }
+
+                return true;
+            }
+
             bool handle_instruction_hook(x86_hookable_instructions type, uint64_t instruction_size)
             {
                 // Capture RIP before the callbacks so the post-callback comparison can tell whether a
@@ -2108,6 +2689,14 @@ namespace sogen::kvm
                 }
                 regs.rsp = frame.rsp;
                 regs.rflags = frame.rflags;
+
+                const auto completes_step_over = vector == debug_interrupt && this->stepping_breakpoint_.has_value();
+                if (completes_step_over)
+                {
+                    // The trap flag was only raised to step over a patched breakpoint, the guest never set it.
+                    regs.rflags &= ~trap_flag;
+                }
+
                 this->set_regs(regs);
 
                 auto sregs = this->get_sregs();
@@ -2130,7 +2719,14 @@ namespace sogen::kvm
                 }
                 this->set_sregs(sregs);
 
-                if (!this->handle_exception(vector, error_code))
+                // Patched breakpoints are handled without involving the guest and resume like any other
+                // handled exception.
+                if (completes_step_over)
+                {
+                    this->finish_breakpoint_step_over(false);
+                }
+                else if (!(vector == breakpoint_interrupt && this->handle_patched_breakpoint_trap(regs.rip)) &&
+                         !this->handle_exception(vector, error_code))
                 {
                     return false;
                 }
@@ -2562,6 +3158,8 @@ namespace sogen::kvm
             int next_slot_id_ = 0;
             std::map<uint64_t, installed_memslot> current_slots_{};
             bool mappings_dirty_ = false;
+            bool dirty_page_tracking_ = false;
+            std::unordered_set<uint64_t> dirty_pages_{};
             std::vector<int> free_slot_ids_{};
             std::map<uint64_t, std::unique_ptr<mapped_page>> mapped_pages_{};
             std::map<uint64_t, std::unique_ptr<mapped_page>> internal_pages_{};
@@ -2592,8 +3190,17 @@ namespace sogen::kvm
             std::unordered_map<emulator_hook*, execution_hook_entry> memory_execution_hooks_{};
             std::unordered_map<emulator_hook*, memory_access_hook_entry> memory_read_hooks_{};
             std::unordered_map<emulator_hook*, memory_access_hook_entry> memory_write_hooks_{};
+            std::unordered_map<emulator_hook*, watchpoint_entry> watchpoints_{};
+            x86_debug_registers debug_registers_{};
             std::map<uint64_t, mmio_region> mmio_regions_{};
             instruction_hook_entry* syscall_hook_ = nullptr;
+
+            memory_execution_hook_mode memory_execution_hook_mode_ = memory_execution_hook_mode::automatic;
+            std::map<uint64_t, patched_breakpoint> patched_breakpoints_{};
+            // Breakpoint whose original instruction is being single-stepped with the 0xCC removed.
+            std::optional<uint64_t> stepping_breakpoint_{};
+            // Breakpoint whose hooks already ran before the last stop, so resuming on it must not report it again.
+            std::optional<uint64_t> resumed_breakpoint_{};
         };
 
         kvm_segment make_segment(const uint16_t selector, const bool is_code, const bool is_user)
@@ -2,6 +2,7 @@
 #include "unicorn_x86_64_emulator.hpp"
 
 #include <array>
+#include <map>
 #include <ranges>
 #include <optional>
 
@@ -10,6 +11,8 @@
 
 #include "function_wrapper.hpp"
 
+#include <dirty_page_log.hpp>
+
 namespace sogen::unicorn
 {
     namespace
@@ -382,15 +385,37 @@ namespace sogen::unicorn
                 uce(uc_mem_map(*this, address, size, static_cast<uint32_t>(permissions)));
             }
 
+            bool supports_host_memory_mapping() const override
+            {
+                return true;
+            }
+
             void map_host_memory(const uint64_t address, const size_t size, void* host_pointer, memory_permission permissions) override
             {
                 uce(uc_mem_map_ptr(*this, address, size, static_cast<uint32_t>(permissions), host_pointer));
+                this->host_mappings_[address] = {.size = size, .pointer = static_cast<std::byte*>(host_pointer)};
             }
 
             void unmap_memory(const uint64_t address, const size_t size) override
             {
                 uce(uc_mem_unmap(*this, address, size));
 
+                // A partially unmapped host mapping just loses its fast path, uc_mem_read still reaches the rest.
+                auto host_mapping = this->host_mappings_.upper_bound(address);
+                if (host_mapping != this->host_mappings_.begin())
+                {
+                    const auto previous = std::prev(host_mapping);
+                    if (previous->first + previous->second.size > address)
+                    {
+                        host_mapping = previous;
+                    }
+                }
+
+                while (host_mapping != this->host_mappings_.end() && host_mapping->first < address + size)
+                {
+                    host_mapping = this->host_mappings_.erase(host_mapping);
+                }
+
                 const auto mmio_entry = this->mmio_.find(address);
                 if (mmio_entry != this->mmio_.end())
                 {
@@ -410,12 +435,37 @@ namespace sogen::unicorn
 
             bool try_write_memory(const uint64_t address, const void* data, const size_t size) override
             {
-                return uc_mem_write(*this, address, data, size) == UC_ERR_OK;
+                if (uc_mem_write(*this, address, data, size) != UC_ERR_OK)
+                {
+                    return false;
+                }
+
+                this->dirty_pages_.mark(address, size);
+                return true;
             }
 
             void write_memory(const uint64_t address, const void* data, const size_t size) override
             {
                 uce(uc_mem_write(*this, address, data, size));
+                this->dirty_pages_.mark(address, size);
+            }
+
+            std::span<const std::byte> get_host_span(const uint64_t address, const size_t size) const override
+            {
+                return this->find_host_span(address, size);
+            }
+
+            std::span<std::byte> get_writable_host_span(const uint64_t address, const size_t size) override
+            {
+                const auto span = this->find_host_span(address, size);
+                if (!span.empty())
+                {
+                    // uc_mem_write would have flushed translations of the range as well.
+                    uce(uc_ctl_remove_cache(*this, address, address + size));
+                    this->dirty_pages_.mark(address, size);
+                }
+
+                return span;
             }
 
             void apply_memory_protection(const uint64_t address, const size_t size, memory_permission permissions) override
@@ -423,6 +473,43 @@ namespace sogen::unicorn
                 uce(uc_mem_protect(*this, address, size, static_cast<uint32_t>(permissions)));
             }
 
+            // Unicorn keeps no write log of its own. Guest writes are caught by a write hook over the whole
+            // address space, installed when tracking first starts, and the writes above mark their pages.
+            // The hook takes guest stores off unicorn's fast path, so only snapshotting callers pay for it.
+            bool supports_dirty_page_tracking() const override
+            {
+                return true;
+            }
+
+            void start_dirty_page_tracking() override
+            {
+                if (!this->dirty_pages_.is_active())
+                {
+                    auto log_write = [this](uc_engine*, uc_mem_type, const uint64_t address, const int length, int64_t) {
+                        if (length > 0)
+                        {
+                            this->dirty_pages_.mark(address, static_cast<size_t>(length));
+                        }
+                    };
+
+                    function_wrapper<void, uc_engine*, uc_mem_type, uint64_t, int, int64_t> wrapper(std::move(log_write));
+
+                    unicorn_hook hook{*this};
+
+                    uce(uc_hook_add(*this, hook.make_reference(), UC_HOOK_MEM_WRITE, wrapper.get_function(), wrapper.get_user_data(), 0,
+                                    calc_end_address(0, std::numeric_limits<uint64_t>::max())));
+
+                    this->create_hook_container()->add(std::move(wrapper), std::move(hook));
+                }
+
+                this->dirty_pages_.start();
+            }
+
+            std::vector<uint64_t> collect_dirty_pages() override
+            {
+                return this->dirty_pages_.collect();
+            }
+
             emulator_hook* hook_instruction(const int instruction_type, instruction_hook_callback callback) override
             {
                 unicorn_hook hook{*this};
@@ -752,6 +839,42 @@ namespace sogen::unicorn
             std::optional<uint64_t> violation_ip_{};
             std::vector<std::unique_ptr<hook_object>> hooks_{};
             std::unordered_map<uint64_t, mmio_callbacks> mmio_{};
+            dirty_page_log dirty_pages_{};
+
+            struct host_mapping
+            {
+                size_t size{};
+                std::byte* pointer{};
+            };
+
+            // Guest ranges mapped onto caller-owned host memory through map_host_memory. Only those have a host
+            // address unicorn lets us know about.
+            std::map<uint64_t, host_mapping> host_mappings_{};
+
+            std::span<std::byte> find_host_span(const uint64_t address, const size_t size) const
+            {
+                // In-place memory snapshots track writes made through unicorn, not through host pointers.
+                if (size == 0 || this->has_snapshots_)
+                {
+                    return {};
+                }
+
+                auto entry = this->host_mappings_.upper_bound(address);
+                if (entry == this->host_mappings_.begin())
+                {
+                    return {};
+                }
+
+                --entry;
+
+                const auto offset = address - entry->first;
+                if (offset >= entry->second.size || entry->second.size - offset < size)
+                {
+                    return {};
+                }
+
+                return {entry->second.pointer + offset, size};
+            }
 
             static uint64_t calc_end_address(const uint64_t address, uint64_t size)
             {
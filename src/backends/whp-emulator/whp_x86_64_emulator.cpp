@@ -25,6 +25,7 @@
 #include <address_utils.hpp>
 #include <utils/object.hpp>
 #include <utils/cpu_features.hpp>
+#include <x86_debug_registers.hpp>
 
 namespace sogen::whp
 {
@@ -1312,6 +1313,7 @@ namespace sogen::whp
 
             ~whp_x86_64_emulator() override
             {
+                utils::reset_object_with_delayed_destruction(this->watchpoints_);
                 utils::reset_object_with_delayed_destruction(this->memory_write_hooks_);
                 utils::reset_object_with_delayed_destruction(this->memory_read_hooks_);
                 utils::reset_object_with_delayed_destruction(this->memory_execution_hooks_);
@@ -1544,6 +1546,11 @@ namespace sogen::whp
                 }
             }
 
+            bool supports_host_memory_mapping() const override
+            {
+                return true;
+            }
+
             void map_host_memory(const uint64_t address, const size_t size, void* host_pointer,
                                  const memory_permission permissions) override
             {
@@ -1816,6 +1823,19 @@ namespace sogen::whp
                 throw std::runtime_error("Unknown memory execution hook mode");
             }
 
+            // Always patched, independent of the execution hook mode: a remapped hook page would exit on every
+            // instruction of the page instead of only on the breakpoint.
+            emulator_hook* hook_breakpoint(const uint64_t address, memory_execution_hook_callback callback) override
+            {
+                std::unique_lock lock(this->partition_mutex_);
+
+                auto* hook = this->make_hook();
+                this->install_patched_execution_breakpoint(address);
+                this->memory_execution_hooks_[hook] =
+                    execution_hook_entry{.address = address, .patched_breakpoint = true, .callback = std::move(callback)};
+                return hook;
+            }
+
             emulator_hook* hook_memory_read(const uint64_t address, const uint64_t size, memory_access_hook_callback callback) override
             {
                 std::unique_lock lock(this->partition_mutex_);
@@ -1836,10 +1856,40 @@ namespace sogen::whp
                 return hook;
             }
 
+            bool supports_watchpoints() const override
+            {
+                return true;
+            }
+
+            // Watchpoints are armed in the debug registers of every vCPU; #DB already exits to the host, so only
+            // an actual hit costs an exit. They replace whatever the guest put into DR0-DR3 and DR7.
+            emulator_hook* hook_watchpoint(const uint64_t address, const uint64_t size, const memory_operation operation,
+                                           memory_access_hook_callback callback) override
+            {
+                std::unique_lock lock(this->partition_mutex_);
+
+                auto registers = this->debug_registers_;
+                const auto slots = registers.arm(address, size, operation);
+                this->apply_debug_registers(registers);
+
+                auto* hook = this->make_hook();
+                this->watchpoints_[hook] =
+                    watchpoint_entry{.address = address, .size = size, .slots = slots, .callback = std::move(callback)};
+                return hook;
+            }
+
             void delete_hook(emulator_hook* hook) override
             {
                 std::unique_lock lock(this->partition_mutex_);
 
+                if (const auto watchpoint_it = this->watchpoints_.find(hook); watchpoint_it != this->watchpoints_.end())
+                {
+                    auto registers = this->debug_registers_;
+                    registers.disarm(watchpoint_it->second.slots);
+                    this->watchpoints_.erase(watchpoint_it);
+                    this->apply_debug_registers(registers);
+                }
+
                 const auto instruction_it = this->instruction_hooks_.find(hook);
                 if (instruction_it != this->instruction_hooks_.end() && &instruction_it->second == this->syscall_hook_)
                 {
@@ -1911,6 +1961,11 @@ namespace sogen::whp
                 return false;
             }
 
+            bool supports_basic_block_hooks() const override
+            {
+                return false;
+            }
+
           private:
             friend class whp_vcpu;
 
@@ -1935,6 +1990,15 @@ namespace sogen::whp
                 memory_access_hook_callback callback{};
             };
 
+            // `slots` is the mask of debug registers watching the range, in DR6 status bit order.
+            struct watchpoint_entry
+            {
+                uint64_t address{};
+                uint64_t size{};
+                uint8_t slots{};
+                memory_access_hook_callback callback{};
+            };
+
             struct mmio_region
             {
                 uint64_t address{};
@@ -1990,6 +2054,8 @@ namespace sogen::whp
             std::unordered_map<emulator_hook*, execution_hook_entry> memory_execution_hooks_{};
             std::unordered_map<emulator_hook*, memory_access_hook_entry> memory_read_hooks_{};
             std::unordered_map<emulator_hook*, memory_access_hook_entry> memory_write_hooks_{};
+            std::unordered_map<emulator_hook*, watchpoint_entry> watchpoints_{};
+            x86_debug_registers debug_registers_{};
             std::unordered_map<uint64_t, patched_execution_breakpoint> patched_execution_breakpoints_{};
             std::unordered_map<uint64_t, mmio_region> mmio_regions_{};
             std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> mmio_read_grace_deadlines_{};
@@ -3255,6 +3321,62 @@ namespace sogen::whp
                 return reinterpret_cast<emulator_hook*>(this->next_hook_id_++);
             }
 
+            // Assumes partition_mutex_ is held exclusively and no vCPU is running.
+            void apply_debug_registers(const x86_debug_registers& registers)
+            {
+                constexpr std::array address_registers{x86_register::dr0, x86_register::dr1, x86_register::dr2, x86_register::dr3};
+
+                for (const auto& vcpu : this->vcpus_)
+                {
+                    for (size_t index = 0; index < x86_debug_registers::count; ++index)
+                    {
+                        vcpu->reg(address_registers[index], registers.address[index]);
+                    }
+
+                    vcpu->reg(x86_register::dr7, registers.dr7);
+                }
+
+                this->debug_registers_ = registers;
+            }
+
+            // Data breakpoints trap after the access, so the hooks see the value the guest left behind. Returns
+            // whether the #DB was a watchpoint hit; its status bits are cleared so the guest never sees them.
+            bool handle_watchpoint_trap(whp_vcpu& vcpu)
+            {
+                constexpr uint64_t breakpoint_status_mask = 0xF;
+
+                std::vector<watchpoint_entry> hits{};
+                const auto dr6 = vcpu.reg(x86_register::dr6);
+
+                {
+                    std::shared_lock lock(this->partition_mutex_);
+                    for (const auto& [_, watchpoint] : this->watchpoints_)
+                    {
+                        if ((watchpoint.slots & dr6 & breakpoint_status_mask) != 0)
+                        {
+                            hits.push_back(watchpoint);
+                        }
+                    }
+                }
+
+                if (hits.empty())
+                {
+                    return false;
+                }
+
+                vcpu.reg(x86_register::dr6, dr6 & ~breakpoint_status_mask);
+
+                std::vector<std::byte> data{};
+                for (const auto& hit : hits)
+                {
+                    data.assign(hit.size, std::byte{});
+                    (void)this->try_read_memory(hit.address, data.data(), data.size());
+                    hit.callback(vcpu, hit.address, data.data(), data.size());
+                }
+
+                return true;
+            }
+
             interrupt_hook_callback copy_first_interrupt_hook() const
             {
                 std::shared_lock lock(this->partition_mutex_);
@@ -3889,6 +4011,9 @@ namespace sogen::whp
 
                 if (exception.ExceptionType == WHvX64ExceptionTypeDebugTrapOrFault)
                 {
+                    // A watchpoint can trigger on the same instruction as one of the internal single-steps.
+                    const auto watchpoint_hit = this->handle_watchpoint_trap(vcpu);
+
                     {
                         std::unique_lock lock(this->partition_mutex_);
                         if (this->complete_execution_step(vcpu))
@@ -3906,6 +4031,11 @@ namespace sogen::whp
                         }
                     }
 
+                    if (watchpoint_hit)
+                    {
+                        return true;
+                    }
+
                     // Not one of sogen's internal single-steps: a guest-armed debug breakpoint (DR0-3) or a
                     // guest trap-flag single-step. Fall through to the generic interrupt delivery below, which
                     // forwards it to the guest as #DB (vector 1 == WHvX64ExceptionTypeDebugTrapOrFault).
@@ -3,6 +3,10 @@
 #include <array>
 #include <cassert>
 
+#ifndef _WIN32
+#include <netinet/tcp.h>
+#endif
+
 namespace sogen::network
 {
     tcp_client_socket::tcp_client_socket(const int af)
@@ -39,7 +43,8 @@ namespace sogen::network
                     break;
                 }
 
-                this->sleep(std::chrono::milliseconds(10), true);
+                // Wait for send buffer space, not for incoming data the peer may only send after this reply
+                this->sleep(std::chrono::milliseconds(10), false);
                 continue;
             }
 
@@ -85,6 +90,13 @@ namespace sogen::network
         return a;
     }
 
+    bool tcp_client_socket::set_no_delay(const bool enabled)
+    {
+        int optval = enabled ? 1 : 0;
+        return setsockopt(this->get_socket(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&optval),
+                          static_cast<int>(sizeof(optval))) != SOCKET_ERROR;
+    }
+
     bool tcp_client_socket::connect(const address& target)
     {
         if (::connect(this->get_socket(), &target.get_addr(), target.get_size()) != SOCKET_ERROR)
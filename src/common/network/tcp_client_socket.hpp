@@ -25,6 +25,9 @@ namespace sogen::network
 
         std::optional<address> get_target() const;
 
+        // Disables Nagle's algorithm, for request/reply protocols sending small packets.
+        bool set_no_delay(bool enabled);
+
         bool connect(const address& target);
         void close() override;
 
@@ -0,0 +1,157 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#include "io.hpp"
+#include "win.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sogen
+{
+
+    namespace utils
+    {
+        mapped_file::mapped_file(const std::filesystem::path& file)
+        {
+#if defined(_WIN32)
+            const auto file_handle =
+                CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_handle == INVALID_HANDLE_VALUE)
+            {
+                throw std::runtime_error("Failed to open file: " + file.string());
+            }
+
+            LARGE_INTEGER file_size{};
+            if (!GetFileSizeEx(file_handle, &file_size))
+            {
+                CloseHandle(file_handle);
+                throw std::runtime_error("Failed to get file size: " + file.string());
+            }
+
+            this->size_ = static_cast<size_t>(file_size.QuadPart);
+            if (this->size_ == 0)
+            {
+                CloseHandle(file_handle);
+                return;
+            }
+
+            const auto mapping = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file_handle);
+
+            if (!mapping)
+            {
+                throw std::runtime_error("Failed to create file mapping: " + file.string());
+            }
+
+            this->handle_ = reinterpret_cast<intptr_t>(mapping);
+            this->data_ = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, this->size_));
+#elif defined(__EMSCRIPTEN__)
+            if (!io::read_file(file, &this->fallback_))
+            {
+                throw std::runtime_error("Failed to read file: " + file.string());
+            }
+
+            this->size_ = this->fallback_.size();
+            this->data_ = this->fallback_.data();
+            return;
+#else
+            const auto fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Failed to open file: " + file.string());
+            }
+
+            struct stat file_stat{};
+            if (fstat(fd, &file_stat) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Failed to get file size: " + file.string());
+            }
+
+            this->size_ = static_cast<size_t>(file_stat.st_size);
+            if (this->size_ == 0)
+            {
+                close(fd);
+                return;
+            }
+
+            // The mapping keeps its own reference to the file.
+            auto* data = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+
+            this->data_ = data == MAP_FAILED ? nullptr : static_cast<const std::byte*>(data);
+#endif
+
+            if (!this->data_)
+            {
+                this->release();
+                throw std::runtime_error("Failed to map file: " + file.string());
+            }
+        }
+
+        mapped_file::~mapped_file()
+        {
+            this->release();
+        }
+
+        mapped_file::mapped_file(mapped_file&& obj) noexcept
+        {
+            this->operator=(std::move(obj));
+        }
+
+        mapped_file& mapped_file::operator=(mapped_file&& obj) noexcept
+        {
+            if (this != &obj)
+            {
+                this->release();
+
+                this->size_ = obj.size_;
+                this->data_ = obj.data_;
+                this->handle_ = obj.handle_;
+                this->fallback_ = std::move(obj.fallback_);
+
+                if (!this->fallback_.empty())
+                {
+                    this->data_ = this->fallback_.data();
+                }
+
+                obj.size_ = 0;
+                obj.data_ = nullptr;
+                obj.handle_ = -1;
+            }
+
+            return *this;
+        }
+
+        void mapped_file::release()
+        {
+            if (this->fallback_.empty() && this->data_)
+            {
+#if defined(_WIN32)
+                UnmapViewOfFile(this->data_);
+#elif !defined(__EMSCRIPTEN__)
+                munmap(const_cast<std::byte*>(this->data_), this->size_);
+#endif
+            }
+
+#if defined(_WIN32)
+            if (this->handle_ != -1)
+            {
+                CloseHandle(reinterpret_cast<HANDLE>(this->handle_));
+            }
+#endif
+
+            this->fallback_ = {};
+            this->size_ = 0;
+            this->data_ = nullptr;
+            this->handle_ = -1;
+        }
+    }
+
+} // namespace sogen
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace sogen
+{
+
+    namespace utils
+    {
+        // Read-only view of a whole file, mapped into the host address space. Falls back to reading the file
+        // into memory where mapping is not available.
+        class mapped_file
+        {
+          public:
+            mapped_file() = default;
+            explicit mapped_file(const std::filesystem::path& file);
+            ~mapped_file();
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            mapped_file(mapped_file&& obj) noexcept;
+            mapped_file& operator=(mapped_file&& obj) noexcept;
+
+            size_t size() const
+            {
+                return this->size_;
+            }
+
+            const std::byte* data() const
+            {
+                return this->data_;
+            }
+
+            std::span<const std::byte> get_span() const
+            {
+                return {this->data_, this->size_};
+            }
+
+          private:
+            size_t size_{};
+            const std::byte* data_{};
+            intptr_t handle_{-1};
+            std::vector<std::byte> fallback_{};
+
+            void release();
+        };
+    }
+
+} // namespace sogen
@@ -0,0 +1,205 @@
+#include "shared_memory.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "win.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <atomic>
+#endif
+
+namespace sogen
+{
+
+    namespace utils
+    {
+        namespace
+        {
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+            int create_anonymous_file()
+            {
+#ifdef __APPLE__
+                static std::atomic_uint64_t counter{0};
+                const auto name = "/sogen-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+
+                const auto fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+                if (fd >= 0)
+                {
+                    shm_unlink(name.c_str());
+                }
+
+                return fd;
+#else
+                return memfd_create("sogen-shared-memory", MFD_CLOEXEC);
+#endif
+            }
+#endif
+        }
+
+        shared_memory::shared_memory(const size_t size)
+            : size_(size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+
+#if defined(_WIN32)
+            const auto high = static_cast<DWORD>(static_cast<uint64_t>(size) >> 32);
+            const auto low = static_cast<DWORD>(size & 0xFFFFFFFF);
+
+            const auto handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high, low, nullptr);
+            if (!handle)
+            {
+                throw std::runtime_error("Failed to create shared memory section");
+            }
+
+            this->handle_ = reinterpret_cast<intptr_t>(handle);
+            this->data_ = static_cast<std::byte*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#elif defined(__EMSCRIPTEN__)
+            this->data_ = new std::byte[size]{};
+#else
+            const auto fd = create_anonymous_file();
+            if (fd < 0)
+            {
+                throw std::runtime_error("Failed to create shared memory file");
+            }
+
+            this->handle_ = fd;
+
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                this->release();
+                throw std::runtime_error("Failed to size shared memory file");
+            }
+
+            auto* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            this->data_ = data == MAP_FAILED ? nullptr : static_cast<std::byte*>(data);
+#endif
+
+            if (!this->data_)
+            {
+                this->release();
+                throw std::runtime_error("Failed to map shared memory");
+            }
+        }
+
+        shared_memory::~shared_memory()
+        {
+            this->release();
+        }
+
+        void shared_memory::release()
+        {
+#if defined(_WIN32)
+            if (this->data_)
+            {
+                UnmapViewOfFile(this->data_);
+            }
+
+            if (this->handle_ != -1)
+            {
+                CloseHandle(reinterpret_cast<HANDLE>(this->handle_));
+            }
+#elif defined(__EMSCRIPTEN__)
+            delete[] this->data_;
+#else
+            if (this->data_)
+            {
+                munmap(this->data_, this->size_);
+            }
+
+            if (this->handle_ != -1)
+            {
+                close(static_cast<int>(this->handle_));
+            }
+#endif
+
+            this->data_ = nullptr;
+            this->handle_ = -1;
+        }
+
+        copy_on_write_view shared_memory::map_copy_on_write() const
+        {
+            copy_on_write_view view{};
+            view.size_ = this->size_;
+
+            if (this->size_ == 0)
+            {
+                return view;
+            }
+
+#if defined(_WIN32)
+            view.data_ = static_cast<std::byte*>(MapViewOfFile(reinterpret_cast<HANDLE>(this->handle_), FILE_MAP_COPY, 0, 0, this->size_));
+#elif defined(__EMSCRIPTEN__)
+            view.fallback_ = std::make_unique<std::byte[]>(this->size_);
+            std::memcpy(view.fallback_.get(), this->data_, this->size_);
+            view.data_ = view.fallback_.get();
+#else
+            auto* data = mmap(nullptr, this->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, static_cast<int>(this->handle_), 0);
+            view.data_ = data == MAP_FAILED ? nullptr : static_cast<std::byte*>(data);
+#endif
+
+            if (!view.data_)
+            {
+                throw std::runtime_error("Failed to map copy-on-write view");
+            }
+
+            return view;
+        }
+
+        copy_on_write_view::~copy_on_write_view()
+        {
+            this->release();
+        }
+
+        copy_on_write_view::copy_on_write_view(copy_on_write_view&& obj) noexcept
+        {
+            this->operator=(std::move(obj));
+        }
+
+        copy_on_write_view& copy_on_write_view::operator=(copy_on_write_view&& obj) noexcept
+        {
+            if (this != &obj)
+            {
+                this->release();
+
+                this->size_ = obj.size_;
+                this->data_ = obj.data_;
+                this->fallback_ = std::move(obj.fallback_);
+
+                obj.size_ = 0;
+                obj.data_ = nullptr;
+            }
+
+            return *this;
+        }
+
+        void copy_on_write_view::release()
+        {
+            if (!this->data_ || this->fallback_)
+            {
+                this->fallback_ = {};
+                this->data_ = nullptr;
+                return;
+            }
+
+#if defined(_WIN32)
+            UnmapViewOfFile(this->data_);
+#elif !defined(__EMSCRIPTEN__)
+            munmap(this->data_, this->size_);
+#endif
+
+            this->data_ = nullptr;
+        }
+    }
+
+} // namespace sogen
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sogen
+{
+
+    namespace utils
+    {
+        class copy_on_write_view;
+
+        // Anonymous host memory object (memfd on Linux, a pagefile-backed section on Windows). It is filled
+        // through its own shared view, after which any number of private copy-on-write views can be mapped
+        // on top of the same physical pages.
+        class shared_memory
+        {
+          public:
+            explicit shared_memory(size_t size);
+            ~shared_memory();
+
+            shared_memory(const shared_memory&) = delete;
+            shared_memory& operator=(const shared_memory&) = delete;
+            shared_memory(shared_memory&&) = delete;
+            shared_memory& operator=(shared_memory&&) = delete;
+
+            size_t size() const
+            {
+                return this->size_;
+            }
+
+            std::byte* data()
+            {
+                return this->data_;
+            }
+
+            const std::byte* data() const
+            {
+                return this->data_;
+            }
+
+            copy_on_write_view map_copy_on_write() const;
+
+          private:
+            size_t size_{};
+            std::byte* data_{};
+            intptr_t handle_{-1};
+
+            void release();
+        };
+
+        // Private view of a shared_memory object. Reads see the shared pages until a page is written, which
+        // gives this view its own copy of that page only.
+        class copy_on_write_view
+        {
+          public:
+            copy_on_write_view() = default;
+            ~copy_on_write_view();
+
+            copy_on_write_view(const copy_on_write_view&) = delete;
+            copy_on_write_view& operator=(const copy_on_write_view&) = delete;
+
+            copy_on_write_view(copy_on_write_view&& obj) noexcept;
+            copy_on_write_view& operator=(copy_on_write_view&& obj) noexcept;
+
+            size_t size() const
+            {
+                return this->size_;
+            }
+
+            std::byte* data() const
+            {
+                return this->data_;
+            }
+
+          private:
+            friend shared_memory;
+
+            size_t size_{};
+            std::byte* data_{};
+            std::unique_ptr<std::byte[]> fallback_{};
+
+            void release();
+        };
+    }
+
+} // namespace sogen
@@ -110,6 +110,8 @@ namespace sogen::debugger
                 return "image";
             case memory_region_kind::mmio:
                 return "mmio";
+            case memory_region_kind::shared_user_data:
+                return "shared";
             default:
                 return "unknown";
             }
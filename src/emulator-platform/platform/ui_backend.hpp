@@ -2,6 +2,7 @@
 
 #include "window.hpp"
 
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -49,6 +50,10 @@ namespace sogen
         int stride{};
         ui_surface_format format{ui_surface_format::bgra8};
         const void* pixels{};
+
+        // Region that changed since the previous present of this window. Unset when the caller doesn't track
+        // damage, in which case any pixel may have changed.
+        std::optional<RECT> damage{};
     };
 
     struct ui_event
@@ -69,6 +74,12 @@ namespace sogen
         virtual void set_event_sink(event_sink sink) = 0;
         virtual void pump_events() = 0;
 
+        // Whether pump_events() may produce anything, an idle emulator has to keep calling it then.
+        virtual bool needs_pumping() const
+        {
+            return true;
+        }
+
         virtual void reset()
         {
         }
@@ -131,6 +142,11 @@ namespace sogen
         {
         }
 
+        bool needs_pumping() const override
+        {
+            return false;
+        }
+
         void reset() override
         {
         }
@@ -140,4 +156,7 @@ namespace sogen
     std::unique_ptr<ui_backend> create_sdl_ui_backend();
     std::unique_ptr<ui_backend> create_web_ui_backend();
 
+    // Headless backend that records presented window contents into a frame capture file (see frame_capture.hpp).
+    std::unique_ptr<ui_backend> create_capture_ui_backend(const std::filesystem::path& file);
+
 } // namespace sogen
@@ -71,6 +71,8 @@ namespace sogen
         using arch_emulator<Traits>::try_write_memory;
         using arch_emulator<Traits>::move_memory;
         using arch_emulator<Traits>::set_memory;
+        using arch_emulator<Traits>::get_host_span;
+        using arch_emulator<Traits>::get_writable_host_span;
 
         virtual size_t vcpu_count() const
         {
@@ -0,0 +1,70 @@
+#pragma once
+#include "address_utils.hpp"
+
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+namespace sogen
+{
+    // Dirty-page log for backends that see every guest write through a memory write hook instead of a
+    // hardware log. Fed from that hook and from the backend's own write paths (write_memory and writable
+    // host spans), it backs memory_interface's dirty-page tracking.
+    class dirty_page_log
+    {
+      public:
+        static constexpr uint64_t page_size = 0x1000;
+
+        bool is_active() const
+        {
+            return this->active_;
+        }
+
+        void start()
+        {
+            this->active_ = true;
+            this->pages_.clear();
+            this->last_page_ = no_page;
+        }
+
+        void mark(const uint64_t address, const size_t size)
+        {
+            if (!this->active_ || size == 0)
+            {
+                return;
+            }
+
+            const auto first_page = page_align_down(address, page_size);
+            const auto last_page = page_align_down(address + (size - 1), page_size);
+
+            // Guest writes cluster on a few pages (stack, current object), skip the set for repeats.
+            if (first_page == last_page && first_page == this->last_page_)
+            {
+                return;
+            }
+
+            for (auto page = first_page;; page += page_size)
+            {
+                this->pages_.insert(page);
+                if (page == last_page)
+                {
+                    break;
+                }
+            }
+
+            this->last_page_ = last_page;
+        }
+
+        std::vector<uint64_t> collect() const
+        {
+            return {this->pages_.begin(), this->pages_.end()};
+        }
+
+      private:
+        static constexpr uint64_t no_page = std::numeric_limits<uint64_t>::max();
+
+        bool active_{false};
+        uint64_t last_page_{no_page};
+        std::unordered_set<uint64_t> pages_{};
+    };
+}
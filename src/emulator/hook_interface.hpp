@@ -88,6 +88,29 @@ namespace sogen
         virtual emulator_hook* hook_memory_read(uint64_t address, uint64_t size, memory_access_hook_callback callback) = 0;
         virtual emulator_hook* hook_memory_write(uint64_t address, uint64_t size, memory_access_hook_callback callback) = 0;
 
+        // Debugger breakpoint on a single instruction. Backends running guest code natively patch an int3 over it
+        // and hide the original byte from memory reads, so the guest runs at full speed between hits; the
+        // others instrument just that address.
+        virtual emulator_hook* hook_breakpoint(const uint64_t address, memory_execution_hook_callback callback)
+        {
+            return this->hook_memory_execution(address, std::move(callback));
+        }
+
+        // Whether hook_watchpoint is available. Backends without it only offer hook_memory_read/hook_memory_write.
+        virtual bool supports_watchpoints() const
+        {
+            return false;
+        }
+
+        // Debugger watchpoint, firing after an access of the given kind overlapping [address, address + size).
+        // Backed by debug registers, so only a few small aligned ranges fit. x86 cannot watch reads alone, a
+        // read watchpoint fires on writes too.
+        virtual emulator_hook* hook_watchpoint(uint64_t /*address*/, uint64_t /*size*/, memory_operation /*operation*/,
+                                               memory_access_hook_callback /*callback*/)
+        {
+            throw std::runtime_error("The selected emulator backend does not support watchpoints");
+        }
+
         virtual emulator_hook* hook_instruction(int instruction_type, instruction_hook_callback callback) = 0;
 
         virtual emulator_hook* hook_interrupt(interrupt_hook_callback callback) = 0;
@@ -95,6 +118,20 @@ namespace sogen
 
         virtual emulator_hook* hook_basic_block(basic_block_hook_callback callback) = 0;
 
+        // Whether hook_basic_block callbacks actually fire. Backends executing natively accept block hooks but
+        // never see block boundaries; callers needing block events have to hook block addresses instead.
+        virtual bool supports_basic_block_hooks() const
+        {
+            return true;
+        }
+
+        // Whether hook_basic_block fills in basic_block::instruction_count, which lets callers account for
+        // executed instructions per block instead of hooking every instruction.
+        virtual bool supports_basic_block_instruction_counts() const
+        {
+            return false;
+        }
+
         virtual void delete_hook(emulator_hook* hook) = 0;
     };
 
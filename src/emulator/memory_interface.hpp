@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
 #include <vector>
 #include <functional>
 #include <stdexcept>
@@ -50,6 +53,12 @@ namespace sogen
         virtual void apply_memory_protection(uint64_t address, size_t size, memory_permission permissions) = 0;
 
       public:
+        // Whether map_host_memory is implemented, so callers can choose a copying fallback up front.
+        virtual bool supports_host_memory_mapping() const
+        {
+            return false;
+        }
+
         virtual bool host_memory_aliasing_is_coherent() const
         {
             return true;
@@ -59,6 +68,27 @@ namespace sogen
         {
         }
 
+        // Optional dirty-page log backing incremental snapshot restores. A backend that supports it records
+        // the base address of every guest page written since the last start_dirty_page_tracking() call,
+        // both by the guest CPU and through write_memory. Backends that cannot observe guest writes report
+        // false and callers fall back to comparing page contents.
+        virtual bool supports_dirty_page_tracking() const
+        {
+            return false;
+        }
+
+        // (Re)starts the log with an empty dirty set.
+        virtual void start_dirty_page_tracking()
+        {
+        }
+
+        // Page-aligned addresses written since tracking was (re)started, in no particular order. Does not
+        // reset the log.
+        virtual std::vector<uint64_t> collect_dirty_pages()
+        {
+            return {};
+        }
+
         // Ranges of the host process's own address space (its image, dyld, shared libraries) that the
         // guest must avoid, for backends where guest VA == host VA. Best-effort snapshot: host
         // allocations made after the query are not covered. Backends with an independent guest
@@ -150,32 +180,65 @@ namespace sogen
             this->write_memory(reinterpret_cast<uint64_t>(address), data, size);
         }
 
-        void move_memory(uint64_t dst, uint64_t src, size_t size)
+        // Copy between possibly overlapping guest ranges (memmove). A single host memmove when both ranges are
+        // directly accessible, otherwise bounded chunks ordered so that an overlapping source is read before
+        // it gets overwritten.
+        virtual void move_memory(const uint64_t dst, const uint64_t src, const size_t size)
         {
             if (dst == src || !size)
             {
                 return;
             }
 
-            const auto copy_from_end = src < dst;
-            const auto increment = copy_from_end ? -1 : 1;
+            if (const auto source = this->get_host_span(src, size); !source.empty())
+            {
+                if (const auto destination = this->get_writable_host_span(dst, size); !destination.empty())
+                {
+                    std::memmove(destination.data(), source.data(), size);
+                    return;
+                }
+            }
+
+            std::array<std::byte, 0x1000> buffer{};
 
-            auto p_src = copy_from_end ? src + size - 1 : src;
-            auto p_dst = copy_from_end ? dst + size - 1 : dst;
+            const auto copy_chunk = [&](const size_t offset, const size_t count) {
+                this->read_memory(src + offset, buffer.data(), count);
+                this->write_memory(dst + offset, buffer.data(), count);
+            };
 
-            while (size--)
+            if (src < dst && dst - src < size)
+            {
+                for (auto remaining = size; remaining > 0;)
+                {
+                    const auto count = std::min(buffer.size(), remaining);
+                    remaining -= count;
+                    copy_chunk(remaining, count);
+                }
+            }
+            else
             {
-                const auto elem = this->read_memory<std::byte>(p_src);
-                this->write_memory(p_dst, elem);
-                p_src += increment;
-                p_dst += increment;
+                for (size_t offset = 0; offset < size;)
+                {
+                    const auto count = std::min(buffer.size(), size - offset);
+                    copy_chunk(offset, count);
+                    offset += count;
+                }
             }
         }
 
         // Fill a guest range with a byte value (memset). Writes in bounded chunks so a large size never
         // materializes a matching host allocation.
-        void set_memory(uint64_t address, uint8_t value, uint64_t size)
+        virtual void set_memory(uint64_t address, const uint8_t value, uint64_t size)
         {
+            if (std::in_range<size_t>(size))
+            {
+                if (const auto destination = this->get_writable_host_span(address, static_cast<size_t>(size)); !destination.empty())
+                {
+                    std::memset(destination.data(), value, destination.size());
+                    return;
+                }
+            }
+
             std::array<std::byte, 0x1000> buffer{};
             buffer.fill(static_cast<std::byte>(value));
 
@@ -187,6 +250,22 @@ namespace sogen
                 size -= count;
             }
         }
+
+        // Host memory backing the guest range [address, address + size), for zero-copy access. Only available
+        // when the whole range is mapped, contiguous in host memory and reads there see exactly what
+        // read_memory would return; empty otherwise, and callers fall back to copying. The span is invalidated
+        // by any mapping change.
+        virtual std::span<const std::byte> get_host_span(uint64_t /*address*/, size_t /*size*/) const
+        {
+            return {};
+        }
+
+        // get_host_span for writing. The backend accounts the whole range as written by the host (dirty page
+        // log, translated code) before handing it out, so the span must not be kept across guest execution.
+        virtual std::span<std::byte> get_writable_host_span(uint64_t /*address*/, size_t /*size*/)
+        {
+            return {};
+        }
     };
 
 } // namespace sogen
@@ -359,6 +359,16 @@ namespace sogen
             this->memory().move_memory(dst, src, size);
         }
 
+        std::span<const std::byte> get_host_span(const uint64_t address, const size_t size) const
+        {
+            return this->memory().get_host_span(address, size);
+        }
+
+        std::span<std::byte> get_writable_host_span(const uint64_t address, const size_t size)
+        {
+            return this->memory().get_writable_host_span(address, size);
+        }
+
         pointer_type read_stack(const size_t index)
         {
             pointer_type result{};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "hook_interface.hpp"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace sogen
+{
+    // DR0-DR3 and DR7 as programmed for debugger watchpoints by the backends running guest code natively.
+    struct x86_debug_registers
+    {
+        static constexpr size_t count = 4;
+
+        std::array<uint64_t, count> address{};
+        uint64_t dr7{};
+
+        // A register watches a naturally aligned 1, 2, 4 or 8 byte range, so larger or unaligned ranges take one
+        // register per piece. Returns the mask of registers used, in DR6 status bit order.
+        uint8_t arm(uint64_t watch_address, uint64_t size, const memory_operation operation)
+        {
+            if (size == 0 || (operation & memory_operation::read_write) == memory_operation::none)
+            {
+                throw std::runtime_error("Invalid watchpoint");
+            }
+
+            auto registers = *this;
+            uint8_t slots = 0;
+
+            while (size > 0)
+            {
+                uint64_t length = 8;
+                while (length > 1 && ((watch_address & (length - 1)) != 0 || length > size))
+                {
+                    length /= 2;
+                }
+
+                size_t index = 0;
+                while (index < count && (registers.dr7 & get_slot_mask(index)) != 0)
+                {
+                    ++index;
+                }
+
+                if (index == count)
+                {
+                    throw std::runtime_error("Not enough free debug registers for watchpoint");
+                }
+
+                registers.address[index] = watch_address;
+                registers.dr7 |= get_slot_bits(index, length, operation);
+                slots |= static_cast<uint8_t>(1u << index);
+
+                watch_address += length;
+                size -= length;
+            }
+
+            *this = registers;
+            return slots;
+        }
+
+        void disarm(const uint8_t slots)
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                if (slots & (1u << index))
+                {
+                    this->address[index] = 0;
+                    this->dr7 &= ~get_slot_mask(index);
+                }
+            }
+        }
+
+      private:
+        static uint64_t get_slot_mask(const size_t index)
+        {
+            return (3ull << (index * 2)) | (0xFull << (16 + index * 4));
+        }
+
+        // Local enable, condition and length bits. The condition is data writes (01) or data reads and writes
+        // (11), x86 has no read-only condition.
+        static uint64_t get_slot_bits(const size_t index, const uint64_t length, const memory_operation operation)
+        {
+            const uint64_t condition = (operation & memory_operation::read) != memory_operation::none ? 3 : 1;
+
+            uint64_t length_bits = 0;
+            switch (length)
+            {
+            case 2:
+                length_bits = 1;
+                break;
+            case 4:
+                length_bits = 3;
+                break;
+            case 8:
+                length_bits = 2;
+                break;
+            default:
+                break;
+            }
+
+            return (1ull << (index * 2)) | (condition << (16 + index * 4)) | (length_bits << (18 + index * 4));
+        }
+    };
+} // namespace sogen
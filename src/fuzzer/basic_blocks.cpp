@@ -0,0 +1,93 @@
+#include "std_include.hpp"
+#include "basic_blocks.hpp"
+
+#include <disassembler.hpp>
+
+namespace sogen
+{
+    namespace
+    {
+        std::optional<uint64_t> get_direct_target(const cs_insn& inst)
+        {
+            const auto* detail = inst.detail;
+            if (!detail || detail->x86.op_count == 0 || detail->x86.operands[0].type != X86_OP_IMM)
+            {
+                return std::nullopt;
+            }
+
+            return static_cast<uint64_t>(detail->x86.operands[0].imm);
+        }
+    }
+
+    std::vector<uint64_t> find_basic_blocks(x86_64_cpu& cpu, const uint64_t entry, const uint64_t start, const uint64_t end)
+    {
+        const disassembler d{};
+        const auto cs_selector = cpu.reg<uint16_t>(x86_register::cs);
+        const auto handle = d.resolve_handle(cpu, cs_selector);
+
+        std::set<uint64_t> blocks{};
+        std::unordered_set<uint64_t> decoded{};
+        std::vector<uint64_t> pending{};
+
+        const auto add_block = [&](const uint64_t address) {
+            if (address >= start && address < end && blocks.insert(address).second)
+            {
+                pending.push_back(address);
+            }
+        };
+
+        add_block(entry);
+
+        while (!pending.empty())
+        {
+            auto address = pending.back();
+            pending.pop_back();
+
+            // Walk the block until it branches. Reaching an instruction that was decoded before means the rest
+            // of the block is known already.
+            while (decoded.insert(address).second)
+            {
+                std::array<uint8_t, 16> bytes{};
+                if (!cpu.try_read_memory(address, bytes.data(), bytes.size()))
+                {
+                    break;
+                }
+
+                const auto instructions = d.disassemble(cpu, cs_selector, bytes, 1, address);
+                if (instructions.empty())
+                {
+                    break;
+                }
+
+                const auto& inst = instructions[0];
+                const auto next = address + inst.size;
+
+                if (cs_insn_group(handle, &inst, CS_GRP_JUMP) || cs_insn_group(handle, &inst, CS_GRP_CALL))
+                {
+                    if (const auto target = get_direct_target(inst))
+                    {
+                        add_block(*target);
+                    }
+
+                    // Calls return and conditional jumps fall through; both continue in a new block.
+                    if (inst.id != X86_INS_JMP)
+                    {
+                        add_block(next);
+                    }
+
+                    break;
+                }
+
+                if (cs_insn_group(handle, &inst, CS_GRP_RET) || cs_insn_group(handle, &inst, CS_GRP_INT) ||
+                    cs_insn_group(handle, &inst, CS_GRP_IRET) || inst.id == X86_INS_HLT || inst.id == X86_INS_UD2)
+                {
+                    break;
+                }
+
+                address = next;
+            }
+        }
+
+        return {blocks.begin(), blocks.end()};
+    }
+} // namespace sogen
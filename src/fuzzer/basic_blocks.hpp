@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <arch_emulator.hpp>
+
+namespace sogen
+{
+    // Start addresses of the basic blocks reachable from `entry` through direct jumps and calls, limited to
+    // [start, end). Indirect branches are not followed, so blocks only reachable through them stay unknown.
+    std::vector<uint64_t> find_basic_blocks(x86_64_cpu& cpu, uint64_t entry, uint64_t start, uint64_t end);
+} // namespace sogen
@@ -0,0 +1,19 @@
+#include "std_include.hpp"
+#include "emulator_backend.hpp"
+
+namespace sogen
+{
+    std::unique_ptr<x86_64_emulator> create_emulator_backend(const backend_type backend)
+    {
+        auto emu = create_x86_64_emulator(backend);
+
+        // Hardware backends trap into the host for every hooked address; a patched int3 costs one exit
+        // per hit, which is what makes breakpoint coverage affordable there.
+        if (backend == backend_type::kvm || backend == backend_type::whp)
+        {
+            emu->set_memory_execution_hook_mode(hook_interface::memory_execution_hook_mode::int3);
+        }
+
+        return emu;
+    }
+} // namespace sogen
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+
+#include <arch_emulator.hpp>
+#include <backend_selection.hpp>
+
+namespace sogen
+{
+#if SOGEN_ENABLE_RUST_CODE
+    constexpr auto DEFAULT_BACKEND = backend_type::icicle;
+#else
+    constexpr auto DEFAULT_BACKEND = backend_type::unicorn;
+#endif
+
+    std::unique_ptr<x86_64_emulator> create_emulator_backend(backend_type backend);
+} // namespace sogen
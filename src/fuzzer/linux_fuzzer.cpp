@@ -0,0 +1,205 @@
+#include "std_include.hpp"
+#include "linux_fuzzer.hpp"
+#include "basic_blocks.hpp"
+
+#include <linux_emulator.hpp>
+
+namespace sogen
+{
+    namespace
+    {
+        std::vector<std::string> default_envp()
+        {
+            return {"PATH=/usr/bin:/bin", "HOME=/root", "TERM=xterm"};
+        }
+
+        bool is_crash_signal(const int signum)
+        {
+            using namespace linux_signals;
+            return signum == LINUX_SIGSEGV || signum == LINUX_SIGBUS || signum == LINUX_SIGILL || signum == LINUX_SIGFPE ||
+                   signum == LINUX_SIGABRT;
+        }
+
+        uint64_t forward_emulator(linux_emulator& linux_emu, const std::string& function)
+        {
+            const auto* executable = linux_emu.mod_manager.executable;
+            const auto target = executable ? executable->find_export(function) : 0;
+            if (!target)
+            {
+                throw std::runtime_error("Function not found: " + function);
+            }
+
+            auto* hook = linux_emu.emu().hook_memory_execution(target, [&](cpu_interface&, uint64_t) {
+                linux_emu.stop(); //
+            });
+
+            linux_emu.log.disable_output(true);
+            linux_emu.start();
+            linux_emu.log.disable_output(false);
+            linux_emu.emu().delete_hook(hook);
+
+            if (linux_emu.emu().read_instruction_pointer() != target)
+            {
+                throw std::runtime_error("Target function was never reached: " + function);
+            }
+
+            return target;
+        }
+
+        std::vector<uint64_t> find_coverage_blocks(linux_emulator& linux_emu, const uint64_t target)
+        {
+            if (linux_emu.emu().supports_basic_block_hooks())
+            {
+                return {};
+            }
+
+            const auto& executable = *linux_emu.mod_manager.executable;
+            return find_basic_blocks(linux_emu.emu(), target, executable.image_base, executable.image_base + executable.size_of_image);
+        }
+
+        // The emulator captured at the target function, shared by all workers.
+        struct fork_state
+        {
+            std::filesystem::path emulation_root{};
+            std::vector<std::byte> state{};
+            backend_type backend{};
+            std::vector<uint64_t> blocks{};
+        };
+
+        struct linux_fuzzer_executer : fuzzer::executer
+        {
+            linux_emulator emu;
+            const std::function<fuzzer::coverage_functor>* handler{nullptr};
+            bool crashed{false};
+
+            explicit linux_fuzzer_executer(const fork_state& fork)
+                : emu(create_emulator_backend(fork.backend), fork.emulation_root)
+            {
+                utils::buffer_deserializer buffer{fork.state};
+                emu.deserialize(buffer, false);
+                emu.log.disable_output(true);
+
+                const auto report_block = [this](const uint64_t address) {
+                    if (this->handler)
+                    {
+                        (*this->handler)(address);
+                    }
+                };
+
+                if (emu.emu().supports_basic_block_hooks())
+                {
+                    emu.emu().hook_basic_block([report_block](cpu_interface&, const basic_block& block) {
+                        report_block(block.address); //
+                    });
+                }
+
+                for (const auto block : fork.blocks)
+                {
+                    emu.emu().hook_memory_execution(block, [report_block](cpu_interface&, const uint64_t address) {
+                        report_block(address); //
+                    });
+                }
+
+                // A guest handler for a fault signal would hide the crash, so stop at the fault itself.
+                emu.on_signal.add([this](const int signum, uint64_t, int) {
+                    if (is_crash_signal(signum))
+                    {
+                        this->crashed = true;
+                        emu.stop();
+                    }
+                });
+
+                const auto return_address = emu.emu().read_stack(0);
+                emu.emu().hook_memory_execution(return_address, [this](cpu_interface&, const uint64_t) {
+                    emu.stop(); //
+                });
+
+                emu.save_snapshot();
+            }
+
+            fuzzer::execution_result execute(const std::span<const uint8_t> data,
+                                             const std::function<fuzzer::coverage_functor>& coverage_handler) override
+            {
+                this->handler = &coverage_handler;
+                this->crashed = false;
+
+                emu.restore_snapshot();
+
+                const auto memory = emu.memory.allocate_memory(
+                    static_cast<size_t>(page_align_up(std::max(data.size(), static_cast<size_t>(1)))), memory_permission::read_write);
+                emu.memory.write_memory(memory, data.data(), data.size());
+
+                emu.emu().reg(x86_register::rdi, memory);
+                emu.emu().reg<uint64_t>(x86_register::rsi, data.size());
+
+                try
+                {
+                    emu.start();
+                }
+                catch (...)
+                {
+                    return fuzzer::execution_result::error;
+                }
+
+                const auto reason = emu.last_stop_reason();
+                if (this->crashed || reason == stop_reason::unhandled_memory_violation || reason == stop_reason::signal_termination ||
+                    reason == stop_reason::backend_error)
+                {
+                    return fuzzer::execution_result::error;
+                }
+
+                return fuzzer::execution_result::success;
+            }
+        };
+
+        struct linux_fuzzing_handler : fuzzer::fuzzing_handler
+        {
+            fork_state fork{};
+
+            explicit linux_fuzzing_handler(fork_state fork)
+                : fork(std::move(fork))
+            {
+            }
+
+            std::unique_ptr<fuzzer::executer> make_executer() override
+            {
+                return std::make_unique<linux_fuzzer_executer>(fork);
+            }
+        };
+    }
+
+    bool is_elf_file(const std::filesystem::path& path)
+    {
+        std::ifstream stream{path, std::ios::binary};
+        std::array<char, 4> magic{};
+
+        return stream.read(magic.data(), magic.size()) && magic == std::array<char, 4>{0x7F, 'E', 'L', 'F'};
+    }
+
+    void run_linux_fuzzer(const linux_fuzzer_options& options)
+    {
+        const auto executable = options.executable.generic_string();
+        linux_emulator linux_emu{create_emulator_backend(options.backend), options.emulation_root, options.executable, {executable},
+                                 default_envp()};
+
+        const auto target = forward_emulator(linux_emu, options.function);
+
+        fork_state fork{
+            .emulation_root = options.emulation_root,
+            .backend = options.backend,
+            .blocks = find_coverage_blocks(linux_emu, target),
+        };
+
+        if (!fork.blocks.empty())
+        {
+            printf("Tracking coverage of %zu basic blocks with execution hooks\n", fork.blocks.size());
+        }
+
+        utils::buffer_serializer buffer{};
+        linux_emu.serialize(buffer, false);
+        fork.state = buffer.move_buffer();
+
+        linux_fuzzing_handler handler{std::move(fork)};
+        fuzzer::run(handler, options.settings);
+    }
+} // namespace sogen
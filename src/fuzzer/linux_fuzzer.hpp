@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+#include <fuzzer.hpp>
+
+#include "emulator_backend.hpp"
+
+namespace sogen
+{
+    struct linux_fuzzer_options
+    {
+        std::filesystem::path executable{};
+        std::filesystem::path emulation_root{};
+
+        // Symbol of the function each input is passed to as (const uint8_t* data, size_t size).
+        std::string function{"vulnerable"};
+
+        backend_type backend{DEFAULT_BACKEND};
+        fuzzer::fuzzing_settings settings{};
+    };
+
+    bool is_elf_file(const std::filesystem::path& path);
+
+    // Fork-server style harness: the ELF runs once up to the target function, every worker starts from that
+    // state and resets to it before each input.
+    void run_linux_fuzzer(const linux_fuzzer_options& options);
+} // namespace sogen
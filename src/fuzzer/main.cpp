@@ -5,9 +5,9 @@
 
 #include <utils/finally.hpp>
 
-#if SOGEN_ENABLE_RUST_CODE
-#include <icicle_x86_64_emulator.hpp>
-#endif
+#include "basic_blocks.hpp"
+#include "emulator_backend.hpp"
+#include "linux_fuzzer.hpp"
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4702)
@@ -20,13 +20,17 @@ namespace sogen
 
     namespace
     {
-        std::unique_ptr<x86_64_emulator> create_emulator_backend()
+        // Backends that can't report basic blocks get coverage from execution hooks on every block statically
+        // reachable from the fuzzed function.
+        std::vector<uint64_t> find_coverage_blocks(windows_emulator& win_emu, const uint64_t target)
         {
-#if SOGEN_ENABLE_RUST_CODE
-            return icicle::create_x86_64_emulator();
-#else
-            throw std::runtime_error("Fuzzer requires rust code to be enabled");
-#endif
+            if (win_emu.emu().supports_basic_block_hooks())
+            {
+                return {};
+            }
+
+            const auto& executable = *win_emu.mod_manager.executable;
+            return find_basic_blocks(win_emu.emu(), target, executable.image_base, executable.image_base + executable.size_of_image);
         }
 
         void run_emulation(windows_emulator& win_emu)
@@ -61,36 +65,50 @@ namespace sogen
             win_emu.log.disable_output(false);
         }
 
-        void forward_emulator(windows_emulator& win_emu)
+        uint64_t forward_emulator(windows_emulator& win_emu, const std::string& function)
         {
-            const auto target = win_emu.mod_manager.executable->find_export("vulnerable");
-            win_emu.emu().hook_memory_execution(target, [&](cpu_interface&, uint64_t) {
+            const auto target = win_emu.mod_manager.executable->find_export(function);
+            auto* hook = win_emu.emu().hook_memory_execution(target, [&](cpu_interface&, uint64_t) {
                 win_emu.emu().stop(); //
             });
 
             run_emulation(win_emu);
+            win_emu.emu().delete_hook(hook);
+
+            return target;
         }
 
         struct fuzzer_executer : fuzzer::executer
         {
-            windows_emulator emu{create_emulator_backend()};
-            std::span<const std::byte> emulator_data{};
-            std::unordered_set<uint64_t> visited_blocks{};
+            windows_emulator emu;
             const std::function<fuzzer::coverage_functor>* handler{nullptr};
 
-            fuzzer_executer(const std::span<const std::byte> data)
-                : emulator_data(data)
+            fuzzer_executer(const windows_emulator::fork_image& image, const backend_type backend, const std::vector<uint64_t>& blocks)
+                : emu(create_emulator_backend(backend))
             {
-                emu.emu().hook_basic_block([&](cpu_interface&, const basic_block& block) {
-                    if (this->handler && visited_blocks.emplace(block.address).second)
+                const auto report_block = [this](const uint64_t address) {
+                    if (this->handler)
                     {
-                        (*this->handler)(block.address);
+                        (*this->handler)(address);
                     }
-                });
+                };
 
-                utils::buffer_deserializer deserializer{emulator_data};
-                emu.deserialize(deserializer);
-                emu.save_snapshot();
+                if (emu.emu().supports_basic_block_hooks())
+                {
+                    emu.emu().hook_basic_block([report_block](cpu_interface&, const basic_block& block) {
+                        report_block(block.address); //
+                    });
+                }
+
+                // Workers share the base image's pages and only own what they write.
+                emu.fork_from(image);
+
+                for (const auto block : blocks)
+                {
+                    emu.emu().hook_memory_execution(block, [report_block](cpu_interface&, const uint64_t address) {
+                        report_block(address); //
+                    });
+                }
 
                 const auto return_address = emu.emu().read_stack(0);
                 emu.emu().hook_memory_execution(return_address, [&](cpu_interface&, const uint64_t) {
@@ -100,8 +118,6 @@ namespace sogen
 
             void restore_emulator()
             {
-                /*utils::buffer_deserializer deserializer{ emulator_data };
-                emu.deserialize(deserializer);*/
                 emu.restore_snapshot();
             }
 
@@ -110,7 +126,6 @@ namespace sogen
             {
                 // printf("Input size: %zd\n", data.size());
                 this->handler = &coverage_handler;
-                this->visited_blocks.clear();
 
                 restore_emulator();
 
@@ -135,17 +150,22 @@ namespace sogen
 
         struct my_fuzzing_handler : fuzzer::fuzzing_handler
         {
-            std::vector<std::byte> emulator_state{};
+            std::shared_ptr<const windows_emulator::fork_image> image{};
+            backend_type backend{};
+            std::vector<uint64_t> blocks{};
             std::atomic_bool stop_fuzzing{false};
 
-            my_fuzzing_handler(std::vector<std::byte> emulator_state)
-                : emulator_state(std::move(emulator_state))
+            my_fuzzing_handler(std::shared_ptr<const windows_emulator::fork_image> image, const backend_type backend,
+                               std::vector<uint64_t> blocks)
+                : image(std::move(image)),
+                  backend(backend),
+                  blocks(std::move(blocks))
             {
             }
 
             std::unique_ptr<fuzzer::executer> make_executer() override
             {
-                return std::make_unique<fuzzer_executer>(emulator_state);
+                return std::make_unique<fuzzer_executer>(*image, backend, blocks);
             }
 
             bool stop() override
@@ -154,49 +174,132 @@ namespace sogen
             }
         };
 
-        void run_fuzzer(const windows_emulator& base_emulator)
+        struct fuzzer_options
         {
-            const auto concurrency = std::thread::hardware_concurrency() + 4;
-
-            utils::buffer_serializer serializer{};
-            base_emulator.serialize(serializer);
+            std::string_view application{};
+            std::string function{"vulnerable"};
+            std::filesystem::path emulation_root{};
+            backend_type backend{DEFAULT_BACKEND};
+            fuzzer::fuzzing_settings settings{};
+        };
 
-            my_fuzzing_handler handler{serializer.move_buffer()};
+        void run_fuzzer(const windows_emulator& base_emulator, const fuzzer_options& options, std::vector<uint64_t> blocks)
+        {
+            my_fuzzing_handler handler{base_emulator.create_fork_image(), options.backend, std::move(blocks)};
 
-            fuzzer::run(handler, concurrency);
+            fuzzer::run(handler, options.settings);
         }
 
-        void run(const std::string_view application)
+        void run(const fuzzer_options& options)
         {
+            if (is_elf_file(options.application))
+            {
+                run_linux_fuzzer({
+                    .executable = options.application,
+                    .emulation_root = options.emulation_root,
+                    .function = options.function,
+                    .backend = options.backend,
+                    .settings = options.settings,
+                });
+                return;
+            }
+
             application_settings settings{
-                .application = application,
+                .application = options.application,
             };
 
-            windows_emulator win_emu{create_emulator_backend(), std::move(settings)};
+            windows_emulator win_emu{create_emulator_backend(options.backend), std::move(settings)};
 
-            forward_emulator(win_emu);
-            run_fuzzer(win_emu);
-        }
+            const auto target = forward_emulator(win_emu, options.function);
+            auto blocks = find_coverage_blocks(win_emu, target);
 
-        int run_main(const int argc, char** argv)
-        {
-            if (argc <= 1)
+            if (!blocks.empty())
             {
-                puts("Application not specified!");
-                return 1;
+                printf("Tracking coverage of %zu basic blocks with execution hooks\n", blocks.size());
             }
 
-            // setvbuf(stdout, nullptr, _IOFBF, 0x10000);
-            if (argc > 2 && argv[1] == "-d"s)
+            run_fuzzer(win_emu, options, std::move(blocks));
+        }
+
+        fuzzer_options parse_options(const int argc, char** argv)
+        {
+            fuzzer_options options{};
+            options.settings.concurrency = std::thread::hardware_concurrency() + 4;
+            options.settings.corpus_directory = "corpus";
+            options.settings.crash_directory = "crashes";
+
+            for (int i = 1; i < argc; ++i)
             {
-                use_gdb = true;
+                const std::string_view arg = argv[i];
+                const auto has_value = i + 1 < argc;
+
+                if (arg == "-d")
+                {
+                    use_gdb = true;
+                }
+                else if (arg == "--corpus" && has_value)
+                {
+                    options.settings.corpus_directory = argv[++i];
+                }
+                else if (arg == "--crashes" && has_value)
+                {
+                    options.settings.crash_directory = argv[++i];
+                }
+                else if (arg == "--dict" && has_value)
+                {
+                    options.settings.dictionary_file = argv[++i];
+                }
+                else if (arg == "--function" && has_value)
+                {
+                    options.function = argv[++i];
+                }
+                else if (arg == "--root" && has_value)
+                {
+                    options.emulation_root = argv[++i];
+                }
+                else if (arg == "--backend" && has_value)
+                {
+                    static const std::map<std::string_view, backend_type> backends{
+                        {"unicorn", backend_type::unicorn}, {"icicle", backend_type::icicle}, {"whp", backend_type::whp},
+                        {"kvm", backend_type::kvm},         {"fex", backend_type::fex},
+                    };
+
+                    const auto backend = backends.find(argv[++i]);
+                    if (backend == backends.end())
+                    {
+                        throw std::runtime_error("Backend must be unicorn, icicle, whp, kvm or fex");
+                    }
+
+                    options.backend = backend->second;
+                }
+                else
+                {
+                    options.application = arg;
+                }
             }
 
+            return options;
+        }
+
+        int run_main(const int argc, char** argv)
+        {
+            // setvbuf(stdout, nullptr, _IOFBF, 0x10000);
             try
             {
+                const auto options = parse_options(argc, argv);
+
+                if (options.application.empty())
+                {
+                    puts("Application not specified!");
+                    puts("Usage: fuzzer [-d] [--backend <name>] [--corpus <dir>] [--crashes <dir>] [--dict <file>] [--function <name>]");
+                    puts("              [--root <dir>] <application>");
+                    puts("ELF applications are fuzzed with the Linux emulator, --root sets its emulation root.");
+                    return 1;
+                }
+
                 do
                 {
-                    run(argv[use_gdb ? 2 : 1]);
+                    run(options);
                 } while (use_gdb);
 
                 return 0;
@@ -0,0 +1,211 @@
+#include "corpus.hpp"
+
+#include <limits>
+
+#include <utils/io.hpp>
+#include <utils/string.hpp>
+
+namespace sogen::fuzzer
+{
+    namespace
+    {
+        constexpr auto NO_ENTRY = std::numeric_limits<uint32_t>::max();
+
+        uint64_t hash_input(const std::span<const uint8_t> data)
+        {
+            uint64_t hash = 0xCBF29CE484222325ULL;
+
+            for (const auto byte : data)
+            {
+                hash ^= byte;
+                hash *= 0x100000001B3ULL;
+            }
+
+            return hash;
+        }
+
+        void write_input(const std::filesystem::path& directory, const std::string_view prefix, const std::span<const uint8_t> data)
+        {
+            if (directory.empty())
+            {
+                return;
+            }
+
+            const auto name = utils::string::va("%.*s%016llx", static_cast<int>(prefix.size()), prefix.data(),
+                                                static_cast<unsigned long long>(hash_input(data)));
+
+            utils::io::write_file(directory / name, std::as_bytes(data));
+        }
+
+        void prepare_directory(const std::filesystem::path& directory)
+        {
+            if (!directory.empty() && !utils::io::directory_exists(directory) && !utils::io::create_directory(directory))
+            {
+                throw std::runtime_error("Failed to create directory: " + directory.string());
+            }
+        }
+    }
+
+    corpus::corpus(std::filesystem::path directory)
+        : directory_(std::move(directory))
+    {
+        prepare_directory(this->directory_);
+    }
+
+    std::vector<std::vector<uint8_t>> corpus::load_seeds() const
+    {
+        std::vector<std::vector<uint8_t>> seeds{};
+
+        if (this->directory_.empty())
+        {
+            return seeds;
+        }
+
+        for (const auto& file : utils::io::list_files(this->directory_))
+        {
+            const auto data = utils::io::read_file(file);
+            const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+            seeds.emplace_back(bytes, bytes + data.size());
+        }
+
+        return seeds;
+    }
+
+    void corpus::add(std::vector<uint8_t> data, std::vector<uint32_t> edges)
+    {
+        write_input(this->directory_, {}, data);
+
+        std::scoped_lock lock{this->write_mutex_};
+
+        const auto index = this->published_.load(std::memory_order_relaxed);
+        const auto segment = index / SEGMENT_SIZE;
+
+        if (segment >= MAX_SEGMENTS)
+        {
+            return;
+        }
+
+        if (!this->segments_[segment])
+        {
+            this->segments_[segment] = std::make_unique<corpus_entry[]>(SEGMENT_SIZE);
+        }
+
+        this->segments_[segment][index % SEGMENT_SIZE] = corpus_entry{
+            .data = std::move(data),
+            .edges = std::move(edges),
+        };
+
+        this->published_.store(index + 1, std::memory_order_release);
+    }
+
+    const corpus_entry& corpus::get(const size_t index) const
+    {
+        return this->segments_[index / SEGMENT_SIZE][index % SEGMENT_SIZE];
+    }
+
+    corpus_scheduler::corpus_scheduler()
+        : top_rated_(COVERAGE_MAP_SIZE, NO_ENTRY)
+    {
+    }
+
+    void corpus_scheduler::sync(const corpus& shared)
+    {
+        const auto published = shared.size();
+
+        for (auto index = this->entries_.size(); index < published; ++index)
+        {
+            const auto& entry = shared.get(index);
+            const auto local_index = static_cast<uint32_t>(this->entries_.size());
+
+            for (const auto edge : entry.edges)
+            {
+                auto& top = this->top_rated_[edge];
+                if (top == NO_ENTRY || this->entries_[top]->data.size() > entry.data.size())
+                {
+                    top = local_index;
+                    this->favored_outdated_ = true;
+                }
+            }
+
+            this->entries_.push_back(&entry);
+            this->selections_.push_back(0);
+        }
+    }
+
+    void corpus_scheduler::update_favored()
+    {
+        if (!this->favored_outdated_)
+        {
+            return;
+        }
+
+        this->favored_outdated_ = false;
+        this->favored_.clear();
+
+        std::vector<bool> covered(COVERAGE_MAP_SIZE, false);
+        std::vector<bool> favored(this->entries_.size(), false);
+
+        for (size_t edge = 0; edge < COVERAGE_MAP_SIZE; ++edge)
+        {
+            const auto top = this->top_rated_[edge];
+            if (top == NO_ENTRY || covered[edge] || favored[top])
+            {
+                continue;
+            }
+
+            favored[top] = true;
+            this->favored_.push_back(top);
+
+            for (const auto covered_edge : this->entries_[top]->edges)
+            {
+                covered[covered_edge] = true;
+            }
+        }
+    }
+
+    const corpus_entry* corpus_scheduler::select(random_generator& rng)
+    {
+        if (this->entries_.empty())
+        {
+            return nullptr;
+        }
+
+        this->update_favored();
+
+        const auto pick = [&]() -> size_t {
+            if (!this->favored_.empty() && rng.get(10) != 0)
+            {
+                return this->favored_[rng.get<size_t>(this->favored_.size())];
+            }
+
+            return rng.get<size_t>(this->entries_.size());
+        };
+
+        // Of two candidates, take the one that was mutated less often, so fresh finds get their turn quickly.
+        const auto first = pick();
+        const auto second = pick();
+        const auto index = this->selections_[first] <= this->selections_[second] ? first : second;
+
+        ++this->selections_[index];
+        return this->entries_[index];
+    }
+
+    crash_store::crash_store(std::filesystem::path directory)
+        : directory_(std::move(directory))
+    {
+        prepare_directory(this->directory_);
+    }
+
+    bool crash_store::add(const std::span<const uint8_t> data, const coverage_trace& trace)
+    {
+        if (this->coverage_.merge(trace) != coverage_novelty::new_edge)
+        {
+            return false;
+        }
+
+        ++this->unique_crashes_;
+        write_input(this->directory_, "crash-", data);
+
+        return true;
+    }
+} // namespace sogen::fuzzer
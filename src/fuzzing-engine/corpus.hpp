@@ -0,0 +1,110 @@
+#pragma once
+#include <span>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#include "coverage_map.hpp"
+#include "random_generator.hpp"
+
+namespace sogen::fuzzer
+{
+    struct corpus_entry
+    {
+        std::vector<uint8_t> data{};
+        std::vector<uint32_t> edges{};
+    };
+
+    // Inputs that produced new coverage, shared by all workers. Entries are immutable once added and are
+    // published by bumping an atomic count, so readers never lock: a worker only needs the count it saw last
+    // time to pick up everything found since. Entries are mirrored into the corpus directory, if one is given,
+    // named by content hash.
+    class corpus
+    {
+      public:
+        explicit corpus(std::filesystem::path directory = {});
+
+        // Inputs found in the corpus directory from a previous session.
+        std::vector<std::vector<uint8_t>> load_seeds() const;
+
+        void add(std::vector<uint8_t> data, std::vector<uint32_t> edges);
+
+        size_t size() const
+        {
+            return this->published_.load(std::memory_order_acquire);
+        }
+
+        // Valid for any index below a previously observed size().
+        const corpus_entry& get(size_t index) const;
+
+      private:
+        static constexpr size_t SEGMENT_SIZE = 1024;
+        static constexpr size_t MAX_SEGMENTS = 4096;
+
+        std::filesystem::path directory_{};
+
+        // Segments are never reallocated, so published entries stay put while writers append.
+        std::mutex write_mutex_{};
+        std::array<std::unique_ptr<corpus_entry[]>, MAX_SEGMENTS> segments_{};
+        std::atomic_size_t published_{0};
+    };
+
+    // Worker-local scheduling state over the shared corpus. Every edge remembers the smallest entry covering it,
+    // and the minimal set of those entries that covers every known edge is marked favored and scheduled far more
+    // often, as in AFL's cull_queue. Nothing here is shared, so selecting an input never synchronizes.
+    class corpus_scheduler
+    {
+      public:
+        corpus_scheduler();
+
+        // Picks up entries published since the last call.
+        void sync(const corpus& shared);
+
+        // Picks an entry to mutate next, biased towards favored and rarely selected entries.
+        const corpus_entry* select(random_generator& rng);
+
+        size_t get_entry_count() const
+        {
+            return this->entries_.size();
+        }
+
+        size_t get_favored_count() const
+        {
+            return this->favored_.size();
+        }
+
+      private:
+        std::vector<const corpus_entry*> entries_{};
+        std::vector<uint64_t> selections_{};
+        std::vector<uint32_t> top_rated_{};
+        std::vector<uint32_t> favored_{};
+        bool favored_outdated_{false};
+
+        void update_favored();
+    };
+
+    // Crashing inputs, deduplicated by the edges they cover, as AFL's unique crashes. Each new one is written to
+    // the crash directory, if one is given.
+    class crash_store
+    {
+      public:
+        explicit crash_store(std::filesystem::path directory = {});
+
+        // Returns true if the crash took a path no earlier crash took.
+        bool add(std::span<const uint8_t> data, const coverage_trace& trace);
+
+        size_t size() const
+        {
+            return this->unique_crashes_;
+        }
+
+      private:
+        std::filesystem::path directory_{};
+        global_coverage coverage_{};
+        std::atomic_size_t unique_crashes_{0};
+    };
+} // namespace sogen::fuzzer
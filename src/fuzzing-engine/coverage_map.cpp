@@ -0,0 +1,180 @@
+#include "coverage_map.hpp"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+namespace sogen::fuzzer
+{
+    namespace
+    {
+        constexpr auto COVERAGE_MAP_MASK = static_cast<uint32_t>(COVERAGE_MAP_SIZE - 1);
+
+        uint32_t hash_location(const uint64_t address)
+        {
+            // Block addresses are aligned and clustered, fold them so neighbouring blocks spread over the map.
+            auto value = address;
+            value ^= value >> 33;
+            value *= 0xFF51AFD7ED558CCDULL;
+            value ^= value >> 33;
+
+            return static_cast<uint32_t>(value) & COVERAGE_MAP_MASK;
+        }
+
+        constexpr std::array<uint8_t, 256> build_bucket_table()
+        {
+            std::array<uint8_t, 256> table{};
+
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                uint8_t bucket = 0;
+
+                if (i >= 128)
+                {
+                    bucket = 128;
+                }
+                else if (i >= 32)
+                {
+                    bucket = 64;
+                }
+                else if (i >= 16)
+                {
+                    bucket = 32;
+                }
+                else if (i >= 8)
+                {
+                    bucket = 16;
+                }
+                else if (i >= 4)
+                {
+                    bucket = 8;
+                }
+                else if (i > 0)
+                {
+                    bucket = static_cast<uint8_t>(1 << (i - 1));
+                }
+
+                table[i] = bucket;
+            }
+
+            return table;
+        }
+
+        constexpr auto BUCKET_TABLE = build_bucket_table();
+
+        template <typename Callback>
+        void for_each_hit(const std::span<const uint8_t> map, const Callback& callback)
+        {
+            for (size_t i = 0; i < map.size(); i += sizeof(uint64_t))
+            {
+                uint64_t word{};
+                memcpy(&word, map.data() + i, sizeof(word));
+
+                if (!word)
+                {
+                    continue;
+                }
+
+                for (size_t j = 0; j < sizeof(uint64_t); ++j)
+                {
+                    if (map[i + j])
+                    {
+                        callback(i + j, map[i + j]);
+                    }
+                }
+            }
+        }
+    }
+
+    coverage_trace::coverage_trace()
+        : map_(COVERAGE_MAP_SIZE, 0)
+    {
+    }
+
+    void coverage_trace::reset()
+    {
+        std::ranges::fill(this->map_, static_cast<uint8_t>(0));
+        this->previous_location_ = 0;
+    }
+
+    void coverage_trace::on_basic_block(const uint64_t address)
+    {
+        const auto location = hash_location(address);
+        auto& counter = this->map_[location ^ this->previous_location_];
+
+        if (counter != 0xFF)
+        {
+            ++counter;
+        }
+
+        this->previous_location_ = location >> 1;
+    }
+
+    void coverage_trace::classify()
+    {
+        for (size_t i = 0; i < this->map_.size(); i += sizeof(uint64_t))
+        {
+            uint64_t word{};
+            memcpy(&word, this->map_.data() + i, sizeof(word));
+
+            if (!word)
+            {
+                continue;
+            }
+
+            for (size_t j = 0; j < sizeof(uint64_t); ++j)
+            {
+                this->map_[i + j] = BUCKET_TABLE[this->map_[i + j]];
+            }
+        }
+    }
+
+    std::vector<uint32_t> coverage_trace::collect_edges() const
+    {
+        std::vector<uint32_t> edges{};
+
+        for_each_hit(this->map_, [&](const size_t index, uint8_t) {
+            edges.push_back(static_cast<uint32_t>(index)); //
+        });
+
+        return edges;
+    }
+
+    global_coverage::global_coverage()
+        : seen_bits_(std::make_unique<std::atomic_uint8_t[]>(COVERAGE_MAP_SIZE))
+    {
+    }
+
+    coverage_novelty global_coverage::merge(const coverage_trace& trace)
+    {
+        auto novelty = coverage_novelty::none;
+
+        for_each_hit(trace.get_map(), [&](const size_t index, const uint8_t bits) {
+            auto& seen = this->seen_bits_[index];
+
+            // Cheap relaxed check first, the common case is an edge and bucket that are already known.
+            if ((seen.load(std::memory_order_relaxed) & bits) == bits)
+            {
+                return;
+            }
+
+            const auto previous = seen.fetch_or(bits, std::memory_order_relaxed);
+            if ((previous & bits) == bits)
+            {
+                return;
+            }
+
+            if (previous == 0)
+            {
+                ++this->edge_count_;
+                novelty = coverage_novelty::new_edge;
+            }
+            else if (novelty == coverage_novelty::none)
+            {
+                novelty = coverage_novelty::new_hit_count;
+            }
+        });
+
+        return novelty;
+    }
+} // namespace sogen::fuzzer
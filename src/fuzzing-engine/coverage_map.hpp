@@ -0,0 +1,62 @@
+#pragma once
+#include <span>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace sogen::fuzzer
+{
+    constexpr size_t COVERAGE_MAP_SIZE = 1 << 16;
+
+    // Edge trace of a single execution, AFL style: every transition between two consecutive basic blocks
+    // bumps a saturating 8-bit counter in a fixed-size map indexed by (previous_block >> 1) ^ current_block.
+    class coverage_trace
+    {
+      public:
+        coverage_trace();
+
+        void reset();
+        void on_basic_block(uint64_t address);
+
+        // Folds raw hit counts into AFL's buckets (1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+), so a loop
+        // only counts as new behaviour once its iteration count moves to a different bucket.
+        void classify();
+
+        std::vector<uint32_t> collect_edges() const;
+
+        std::span<const uint8_t> get_map() const
+        {
+            return this->map_;
+        }
+
+      private:
+        std::vector<uint8_t> map_{};
+        uint32_t previous_location_{0};
+    };
+
+    enum class coverage_novelty
+    {
+        none,
+        new_hit_count,
+        new_edge,
+    };
+
+    // Union of all classified traces seen so far. Merging is lock-free, so all workers share one map.
+    class global_coverage
+    {
+      public:
+        global_coverage();
+
+        coverage_novelty merge(const coverage_trace& trace);
+
+        size_t get_edge_count() const
+        {
+            return this->edge_count_;
+        }
+
+      private:
+        std::unique_ptr<std::atomic_uint8_t[]> seen_bits_{};
+        std::atomic_size_t edge_count_{0};
+    };
+} // namespace sogen::fuzzer
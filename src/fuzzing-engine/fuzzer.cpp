@@ -1,7 +1,13 @@
 #include "fuzzer.hpp"
 #include <cinttypes>
 
-#include "input_generator.hpp"
+#include <mutex>
+#include <optional>
+#include <algorithm>
+
+#include "corpus.hpp"
+#include "mutator.hpp"
+#include "coverage_map.hpp"
 
 #include <utils/timer.hpp>
 #include <utils/string.hpp>
@@ -14,10 +20,21 @@ namespace sogen::fuzzer
         class fuzzing_context
         {
           public:
-            fuzzing_context(input_generator& generator, fuzzing_handler& handler)
-                : generator(generator),
-                  handler(handler)
+            fuzzing_context(fuzzing_handler& handler, const fuzzing_settings& settings)
+                : handler(handler),
+                  corpus(settings.corpus_directory),
+                  crashes(settings.crash_directory)
             {
+                if (!settings.dictionary_file.empty())
+                {
+                    this->tokens = load_dictionary(settings.dictionary_file);
+                }
+
+                this->seeds_ = this->corpus.load_seeds();
+                if (this->seeds_.empty())
+                {
+                    this->seeds_.emplace_back();
+                }
             }
 
             void stop()
@@ -41,12 +58,60 @@ namespace sogen::fuzzer
                 return true;
             }
 
-            input_generator& generator;
+            std::optional<std::vector<uint8_t>> take_seed()
+            {
+                // Seeds only matter during the first few iterations, don't keep contending on the lock after.
+                if (this->seeds_exhausted_.load(std::memory_order_relaxed))
+                {
+                    return std::nullopt;
+                }
+
+                std::scoped_lock lock{this->seed_mutex_};
+
+                if (this->seeds_.empty())
+                {
+                    this->seeds_exhausted_ = true;
+                    return std::nullopt;
+                }
+
+                auto seed = std::move(this->seeds_.back());
+                this->seeds_.pop_back();
+                return seed;
+            }
+
             fuzzing_handler& handler;
+            fuzzer::corpus corpus;
+            crash_store crashes;
+            global_coverage coverage{};
+            dictionary tokens{};
+
             std::atomic_uint64_t executions{0};
+            std::atomic_uint64_t new_paths{0};
 
           private:
             std::atomic_bool stop_{false};
+
+            std::mutex seed_mutex_{};
+            std::vector<std::vector<uint8_t>> seeds_{};
+            std::atomic_bool seeds_exhausted_{false};
+        };
+
+        // Workers run on private state and only touch the shared corpus and counters every SYNC_INTERVAL
+        // iterations, or right after publishing a find of their own.
+        constexpr uint64_t SYNC_INTERVAL = 64;
+
+        struct worker_state
+        {
+            random_generator rng{};
+            coverage_trace trace{};
+            corpus_scheduler scheduler{};
+            fuzzer::mutator mutator;
+            uint64_t pending_executions{0};
+
+            worker_state(const dictionary& tokens)
+                : mutator(rng, tokens)
+            {
+            }
         };
 
         std::string format_binary_data(const std::span<const uint8_t> input)
@@ -100,32 +165,86 @@ namespace sogen::fuzzer
             printf("%.*s\n", static_cast<int>(text.size()), text.c_str());
         }
 
-        void perform_fuzzing_iteration(fuzzing_context& context, executer& executer)
+        std::vector<uint8_t> generate_input(worker_state& state)
         {
-            ++context.executions;
-            context.generator.access_input([&](const std::span<const uint8_t> input) {
-                uint64_t score{0};
-                const auto result = executer.execute(input, [&](uint64_t) {
-                    ++score; //
-                });
-
-                if (result == execution_result::error)
+            const auto* entry = state.scheduler.select(state.rng);
+            auto input = entry ? entry->data : std::vector<uint8_t>{};
+
+            if (state.rng.get(8) == 0)
+            {
+                if (const auto* other = state.scheduler.select(state.rng))
                 {
-                    print_crash(input);
+                    state.mutator.splice(input, other->data);
                 }
+            }
 
-                return score;
+            state.mutator.havoc(input);
+            return input;
+        }
+
+        void perform_fuzzing_iteration(fuzzing_context& context, worker_state& state, executer& executer)
+        {
+            auto seed = context.take_seed();
+            const auto is_seed = seed.has_value();
+            auto input = is_seed ? std::move(*seed) : generate_input(state);
+
+            ++state.pending_executions;
+            state.trace.reset();
+
+            const auto result = executer.execute(input, [&](const uint64_t address) {
+                state.trace.on_basic_block(address); //
             });
+
+            state.trace.classify();
+
+            if (result == execution_result::error)
+            {
+                if (context.crashes.add(input, state.trace))
+                {
+                    print_crash(input);
+                }
+
+                return;
+            }
+
+            if (context.coverage.merge(state.trace) == coverage_novelty::none)
+            {
+                return;
+            }
+
+            if (!is_seed)
+            {
+                ++context.new_paths;
+            }
+
+            context.corpus.add(std::move(input), state.trace.collect_edges());
+            state.scheduler.sync(context.corpus);
+        }
+
+        void synchronize_worker(fuzzing_context& context, worker_state& state)
+        {
+            context.executions += state.pending_executions;
+            state.pending_executions = 0;
+
+            state.scheduler.sync(context.corpus);
         }
 
         void worker(fuzzing_context& context)
         {
             const auto executer = context.handler.make_executer();
+            worker_state state{context.tokens};
 
             while (!context.should_stop())
             {
-                perform_fuzzing_iteration(context, *executer);
+                perform_fuzzing_iteration(context, state, *executer);
+
+                if (state.pending_executions >= SYNC_INTERVAL)
+                {
+                    synchronize_worker(context, state);
+                }
             }
+
+            synchronize_worker(context, state);
         }
 
         struct worker_pool
@@ -163,21 +282,22 @@ namespace sogen::fuzzer
         };
     }
 
-    void run(fuzzing_handler& handler, const size_t concurrency)
+    void run(fuzzing_handler& handler, const fuzzing_settings& settings)
     {
         const sogen::utils::timer<> t{};
-        input_generator generator{};
-        fuzzing_context context{generator, handler};
-        worker_pool pool{context, concurrency};
+        fuzzing_context context{handler, settings};
+        worker_pool pool{context, settings.concurrency};
 
         while (!context.should_stop())
         {
             std::this_thread::sleep_for(std::chrono::seconds{1});
 
             const auto executions = context.executions.exchange(0);
-            const auto highest_scorer = context.generator.get_highest_scorer();
-            const auto avg_score = context.generator.get_average_score();
-            printf("Executions/s: %" PRIu64 " - Score: %" PRIx64 " - Avg: %.3f\n", executions, highest_scorer.score, avg_score);
+            const auto cpu_hours = std::chrono::duration<double>(t.elapsed()).count() * static_cast<double>(settings.concurrency) / 3600.0;
+            const auto paths_per_cpu_hour = static_cast<double>(context.new_paths) / std::max(cpu_hours, 1e-9);
+
+            printf("Executions/s: %" PRIu64 " - Corpus: %zu - Edges: %zu - Crashes: %zu - New paths/CPU-hour: %.1f\n", executions,
+                   context.corpus.size(), context.coverage.get_edge_count(), context.crashes.size(), paths_per_cpu_hour);
         }
 
         const auto duration = t.elapsed();
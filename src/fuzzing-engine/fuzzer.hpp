@@ -4,9 +4,11 @@
 #include <thread>
 #include <cstdint>
 #include <functional>
+#include <filesystem>
 
 namespace sogen::fuzzer
 {
+    // Called for every executed basic block, in execution order. The engine derives edges from consecutive calls.
     using coverage_functor = void(uint64_t address);
 
     enum class execution_result
@@ -34,5 +36,17 @@ namespace sogen::fuzzer
         }
     };
 
-    void run(fuzzing_handler& handler, size_t concurrency = std::thread::hardware_concurrency());
+    struct fuzzing_settings
+    {
+        size_t concurrency{std::thread::hardware_concurrency()};
+
+        // Interesting inputs are kept here and reloaded as seeds on the next run. Empty keeps them in memory.
+        std::filesystem::path corpus_directory{};
+        std::filesystem::path crash_directory{};
+
+        // Optional AFL-style token file used by the dictionary mutators.
+        std::filesystem::path dictionary_file{};
+    };
+
+    void run(fuzzing_handler& handler, const fuzzing_settings& settings = {});
 } // namespace sogen::fuzzer
@@ -0,0 +1,441 @@
+#include "mutator.hpp"
+
+#include <bit>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <string_view>
+
+#include <utils/io.hpp>
+
+namespace sogen::fuzzer
+{
+    namespace
+    {
+        constexpr std::array<int8_t, 9> INTERESTING_8{-128, -1, 0, 1, 16, 32, 64, 100, 127};
+        constexpr std::array<int16_t, 10> INTERESTING_16{-32768, -129, 128, 255, 256, 512, 1000, 1024, 4096, 32767};
+        constexpr std::array<int32_t, 8> INTERESTING_32{
+            INT32_MIN, -100663046, -32769, 32768, 65535, 65536, 100663045, INT32_MAX,
+        };
+
+        constexpr uint32_t ARITH_MAX = 35;
+
+        enum class mutation : uint8_t
+        {
+            flip_bit,
+            interesting_8,
+            interesting_16,
+            interesting_32,
+            arith_8,
+            arith_16,
+            arith_32,
+            random_byte,
+            delete_block,
+            insert_block,
+            overwrite_block,
+            overwrite_token,
+            insert_token,
+            count,
+        };
+
+        template <typename T>
+        T byte_swap(const T value)
+        {
+            auto bytes = std::bit_cast<std::array<uint8_t, sizeof(T)>>(value);
+            std::ranges::reverse(bytes);
+            return std::bit_cast<T>(bytes);
+        }
+
+        template <typename T>
+        T load(const std::vector<uint8_t>& input, const size_t offset)
+        {
+            T value{};
+            memcpy(&value, input.data() + offset, sizeof(value));
+            return value;
+        }
+
+        template <typename T>
+        void store(std::vector<uint8_t>& input, const size_t offset, const T value)
+        {
+            memcpy(input.data() + offset, &value, sizeof(value));
+        }
+
+        template <typename T, size_t N>
+        void write_interesting(random_generator& rng, std::vector<uint8_t>& input, const std::array<T, N>& values)
+        {
+            const auto offset = rng.get<size_t>(input.size() - sizeof(T) + 1);
+            auto value = static_cast<std::make_unsigned_t<T>>(values[rng.get<size_t>(values.size())]);
+
+            if (rng.get<bool>())
+            {
+                value = byte_swap(value);
+            }
+
+            store(input, offset, value);
+        }
+
+        template <typename T>
+        void apply_arith(random_generator& rng, std::vector<uint8_t>& input)
+        {
+            const auto offset = rng.get<size_t>(input.size() - sizeof(T) + 1);
+            const auto big_endian = sizeof(T) > 1 && rng.get<bool>();
+            const auto delta = static_cast<T>(rng.get<uint32_t>(ARITH_MAX) + 1);
+
+            auto value = load<T>(input, offset);
+            if (big_endian)
+            {
+                value = byte_swap(value);
+            }
+
+            value = rng.get<bool>() ? static_cast<T>(value + delta) : static_cast<T>(value - delta);
+
+            if (big_endian)
+            {
+                value = byte_swap(value);
+            }
+
+            store(input, offset, value);
+        }
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && isspace(static_cast<unsigned char>(value.front())))
+            {
+                value.remove_prefix(1);
+            }
+
+            while (!value.empty() && isspace(static_cast<unsigned char>(value.back())))
+            {
+                value.remove_suffix(1);
+            }
+
+            return value;
+        }
+
+        uint8_t parse_hex_digit(const char c)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                return static_cast<uint8_t>(c - '0');
+            }
+
+            if (c >= 'a' && c <= 'f')
+            {
+                return static_cast<uint8_t>(c - 'a' + 10);
+            }
+
+            if (c >= 'A' && c <= 'F')
+            {
+                return static_cast<uint8_t>(c - 'A' + 10);
+            }
+
+            throw std::runtime_error("Invalid hex escape in dictionary");
+        }
+
+        std::vector<uint8_t> parse_token(const std::string_view line)
+        {
+            const auto start = line.find('"');
+            const auto end = line.rfind('"');
+
+            if (start == std::string_view::npos || end == start)
+            {
+                throw std::runtime_error("Invalid dictionary line: " + std::string(line));
+            }
+
+            const auto value = line.substr(start + 1, end - start - 1);
+
+            std::vector<uint8_t> token{};
+            token.reserve(value.size());
+
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if (value[i] != '\\' || i + 1 >= value.size())
+                {
+                    token.push_back(static_cast<uint8_t>(value[i]));
+                    continue;
+                }
+
+                const auto escaped = value[++i];
+                if (escaped != 'x')
+                {
+                    token.push_back(static_cast<uint8_t>(escaped));
+                    continue;
+                }
+
+                if (i + 2 >= value.size())
+                {
+                    throw std::runtime_error("Truncated hex escape in dictionary");
+                }
+
+                token.push_back(static_cast<uint8_t>((parse_hex_digit(value[i + 1]) << 4) | parse_hex_digit(value[i + 2])));
+                i += 2;
+            }
+
+            return token;
+        }
+    }
+
+    dictionary load_dictionary(const std::filesystem::path& file)
+    {
+        std::vector<std::byte> data{};
+        if (!utils::io::read_file(file, &data))
+        {
+            throw std::runtime_error("Failed to read dictionary: " + file.string());
+        }
+
+        const std::string_view content(reinterpret_cast<const char*>(data.data()), data.size());
+
+        dictionary tokens{};
+        size_t position = 0;
+
+        while (position < content.size())
+        {
+            auto line_end = content.find('\n', position);
+            if (line_end == std::string_view::npos)
+            {
+                line_end = content.size();
+            }
+
+            const auto line = trim(content.substr(position, line_end - position));
+            position = line_end + 1;
+
+            if (line.empty() || line.front() == '#')
+            {
+                continue;
+            }
+
+            auto token = parse_token(line);
+            if (!token.empty())
+            {
+                tokens.emplace_back(std::move(token));
+            }
+        }
+
+        return tokens;
+    }
+
+    mutator::mutator(random_generator& rng, const dictionary& tokens)
+        : rng_(&rng),
+          tokens_(&tokens)
+    {
+    }
+
+    size_t mutator::random_block_length(const size_t limit)
+    {
+        // Mostly short blocks, occasionally large ones, like AFL's choose_block_len.
+        size_t max_length = 32;
+        switch (this->rng_->get<uint32_t>(3))
+        {
+        case 0:
+            max_length = 8;
+            break;
+        case 1:
+            max_length = 128;
+            break;
+        default:
+            max_length = this->rng_->get(10) == 0 ? 1500 : 32;
+            break;
+        }
+
+        max_length = std::min(max_length, limit);
+        return max_length <= 1 ? max_length : this->rng_->get<size_t>(max_length) + 1;
+    }
+
+    void mutator::insert_bytes(std::vector<uint8_t>& input, const size_t offset, const std::span<const uint8_t> data)
+    {
+        const auto length = std::min(data.size(), MAX_INPUT_SIZE - std::min(MAX_INPUT_SIZE, input.size()));
+        input.insert(input.begin() + static_cast<ptrdiff_t>(offset), data.begin(), data.begin() + static_cast<ptrdiff_t>(length));
+    }
+
+    void mutator::mutate_once(std::vector<uint8_t>& input)
+    {
+        auto& rng = *this->rng_;
+        auto op = static_cast<mutation>(rng.get<uint32_t>(static_cast<uint32_t>(mutation::count)));
+
+        if (input.empty())
+        {
+            op = mutation::insert_block;
+        }
+
+        switch (op)
+        {
+        case mutation::flip_bit: {
+            const auto bit = rng.get<size_t>(input.size() * 8);
+            input[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+            break;
+        }
+
+        case mutation::interesting_8:
+            write_interesting(rng, input, INTERESTING_8);
+            break;
+
+        case mutation::interesting_16:
+            if (input.size() >= 2)
+            {
+                write_interesting(rng, input, INTERESTING_16);
+            }
+            break;
+
+        case mutation::interesting_32:
+            if (input.size() >= 4)
+            {
+                write_interesting(rng, input, INTERESTING_32);
+            }
+            break;
+
+        case mutation::arith_8:
+            apply_arith<uint8_t>(rng, input);
+            break;
+
+        case mutation::arith_16:
+            if (input.size() >= 2)
+            {
+                apply_arith<uint16_t>(rng, input);
+            }
+            break;
+
+        case mutation::arith_32:
+            if (input.size() >= 4)
+            {
+                apply_arith<uint32_t>(rng, input);
+            }
+            break;
+
+        case mutation::random_byte:
+            // XOR with a non-zero value so the byte always changes.
+            input[rng.get<size_t>(input.size())] ^= static_cast<uint8_t>(rng.get<uint32_t>(255) + 1);
+            break;
+
+        case mutation::delete_block: {
+            if (input.size() < 2)
+            {
+                break;
+            }
+
+            const auto length = this->random_block_length(input.size() - 1);
+            const auto offset = rng.get<size_t>(input.size() - length + 1);
+            input.erase(input.begin() + static_cast<ptrdiff_t>(offset), input.begin() + static_cast<ptrdiff_t>(offset + length));
+            break;
+        }
+
+        case mutation::insert_block: {
+            if (input.size() >= MAX_INPUT_SIZE)
+            {
+                break;
+            }
+
+            const auto offset = input.empty() ? 0 : rng.get<size_t>(input.size() + 1);
+            const auto clone = !input.empty() && rng.get(4) != 0;
+
+            std::vector<uint8_t> block{};
+            if (clone)
+            {
+                const auto length = this->random_block_length(input.size());
+                const auto source = rng.get<size_t>(input.size() - length + 1);
+                block.assign(input.begin() + static_cast<ptrdiff_t>(source),
+                             input.begin() + static_cast<ptrdiff_t>(source + length));
+            }
+            else
+            {
+                const auto value = rng.get<bool>() ? rng.get<uint8_t>() : (input.empty() ? 0 : input[rng.get<size_t>(input.size())]);
+                block.assign(this->random_block_length(MAX_INPUT_SIZE), value);
+            }
+
+            this->insert_bytes(input, offset, block);
+            break;
+        }
+
+        case mutation::overwrite_block: {
+            if (input.size() < 2)
+            {
+                break;
+            }
+
+            const auto length = this->random_block_length(input.size() - 1);
+            const auto target = rng.get<size_t>(input.size() - length + 1);
+
+            if (rng.get(4) != 0)
+            {
+                const auto source = rng.get<size_t>(input.size() - length + 1);
+                memmove(input.data() + target, input.data() + source, length);
+            }
+            else
+            {
+                std::fill_n(input.begin() + static_cast<ptrdiff_t>(target), length, rng.get<uint8_t>());
+            }
+            break;
+        }
+
+        case mutation::overwrite_token: {
+            if (this->tokens_->empty())
+            {
+                break;
+            }
+
+            const auto& token = (*this->tokens_)[rng.get<size_t>(this->tokens_->size())];
+            if (token.size() > input.size())
+            {
+                break;
+            }
+
+            const auto offset = rng.get<size_t>(input.size() - token.size() + 1);
+            std::ranges::copy(token, input.begin() + static_cast<ptrdiff_t>(offset));
+            break;
+        }
+
+        case mutation::insert_token: {
+            if (this->tokens_->empty())
+            {
+                break;
+            }
+
+            const auto& token = (*this->tokens_)[rng.get<size_t>(this->tokens_->size())];
+            this->insert_bytes(input, input.empty() ? 0 : rng.get<size_t>(input.size() + 1), token);
+            break;
+        }
+
+        case mutation::count:
+            break;
+        }
+    }
+
+    void mutator::havoc(std::vector<uint8_t>& input)
+    {
+        const auto stacking = size_t{2} << this->rng_->get<uint32_t>(7);
+
+        for (size_t i = 0; i < stacking; ++i)
+        {
+            this->mutate_once(input);
+        }
+    }
+
+    bool mutator::splice(std::vector<uint8_t>& input, const std::span<const uint8_t> other)
+    {
+        const auto common_length = std::min(input.size(), other.size());
+
+        size_t first_difference = 0;
+        while (first_difference < common_length && input[first_difference] == other[first_difference])
+        {
+            ++first_difference;
+        }
+
+        size_t last_difference = common_length;
+        while (last_difference > first_difference && input[last_difference - 1] == other[last_difference - 1])
+        {
+            --last_difference;
+        }
+
+        if (last_difference - first_difference < 2)
+        {
+            return false;
+        }
+
+        const auto split = first_difference + this->rng_->get<size_t>(last_difference - first_difference);
+
+        input.resize(split);
+        input.insert(input.end(), other.begin() + static_cast<ptrdiff_t>(split), other.end());
+
+        return true;
+    }
+} // namespace sogen::fuzzer
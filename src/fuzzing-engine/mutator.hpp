@@ -0,0 +1,41 @@
+#pragma once
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#include "random_generator.hpp"
+
+namespace sogen::fuzzer
+{
+    using dictionary = std::vector<std::vector<uint8_t>>;
+
+    // Parses an AFL-style dictionary: one token per line, either `name="value"` or a bare `"value"`, with
+    // \xNN, \\ and \" escapes. Empty lines and lines starting with '#' are ignored.
+    dictionary load_dictionary(const std::filesystem::path& file);
+
+    class mutator
+    {
+      public:
+        static constexpr size_t MAX_INPUT_SIZE = 0x10000;
+
+        mutator(random_generator& rng, const dictionary& tokens);
+
+        // Applies a random stack of 2-128 small mutations (bit flips, interesting values, arithmetic, block
+        // deletion/duplication, dictionary tokens, ...).
+        void havoc(std::vector<uint8_t>& input);
+
+        // Replaces the tail of the input with the tail of another input, cut at a point where both differ.
+        // Returns false if the two inputs are too similar to produce anything new.
+        bool splice(std::vector<uint8_t>& input, std::span<const uint8_t> other);
+
+      private:
+        random_generator* rng_{};
+        const dictionary* tokens_{};
+
+        void mutate_once(std::vector<uint8_t>& input);
+
+        size_t random_block_length(size_t limit);
+        void insert_bytes(std::vector<uint8_t>& input, size_t offset, std::span<const uint8_t> data);
+    };
+} // namespace sogen::fuzzer
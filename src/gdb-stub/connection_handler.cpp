@@ -28,6 +28,7 @@ namespace sogen::gdb_stub
           client_(client)
     {
         this->client_.set_blocking(false);
+        (void)this->client_.set_no_delay(true);
 
         this->stop_ = false;
 
@@ -65,72 +66,72 @@ namespace sogen::gdb_stub
         return std::nullopt;
     }
 
-    static constexpr std::string compress(const std::string_view data)
+    namespace
     {
-        std::string result;
-        result.reserve(data.size());
+        // Appends data run-length encoded, the way gdb expands runs of '*' in replies. Counts that would encode
+        // as '#' or '$' are split.
+        void append_compressed(std::string& result, const std::string_view data)
+        {
+            size_t offset = 0;
 
-        auto compress_run = [&result](char symbol, int repeat_count) {
-            if (repeat_count >= 3)
+            while (offset < data.size())
             {
-                result.push_back('*');
+                const auto symbol = data[offset];
+
+                size_t run_end = offset + 1;
+                while (run_end < data.size() && data[run_end] == symbol && run_end - offset < 98)
+                {
+                    ++run_end;
+                }
+
+                auto repeat_count = run_end - offset - 1;
+                offset = run_end;
+
+                result.push_back(symbol);
+
                 if (repeat_count == 6 || repeat_count == 7)
                 {
+                    result.push_back('*');
                     result.push_back(static_cast<char>(5 + 29));
-                    result.push_back(symbol);
-                    if (repeat_count == 7)
-                    {
-                        result.push_back(symbol);
-                    }
+                    repeat_count -= 5;
                 }
-                else
+
+                if (repeat_count >= 3)
                 {
+                    result.push_back('*');
                     result.push_back(static_cast<char>(repeat_count + 29));
                 }
-            }
-            else if (repeat_count >= 1)
-            {
-                result.push_back(symbol);
-                if (repeat_count == 2)
+                else
                 {
-                    result.push_back(symbol);
+                    result.append(repeat_count, symbol);
                 }
             }
-        };
+        }
+    }
 
-        bool start = true;
-        char prev_ch = 0;
-        int counter = 0;
+    void connection_handler::send_reply(const std::string_view data)
+    {
+        std::string packet{};
+        packet.reserve(data.size() + CHECKSUM_SIZE + 2);
 
-        for (auto ch : data)
-        {
-            if (start || prev_ch != ch || counter == 97)
-            {
-                compress_run(prev_ch, counter);
-                result.push_back(ch);
-                prev_ch = ch;
-                counter = 0;
-                start = false;
-            }
-            else
-            {
-                counter++;
-            }
-        }
+        packet.push_back('$');
+        append_compressed(packet, data);
 
-        if (counter)
-        {
-            compress_run(prev_ch, counter);
-        }
+        const auto checksum = compute_checksum(std::string_view(packet).substr(1));
+        packet.push_back('#');
+        packet.append(utils::string::to_hex_string(checksum));
 
-        return result;
+        this->send_raw_data(packet);
     }
 
-    void connection_handler::send_reply(const std::string_view data)
+    void connection_handler::set_no_ack_mode(const bool enabled)
+    {
+        this->no_ack_mode_ = enabled;
+    }
+
+    bool connection_handler::is_no_ack_mode() const
     {
-        const auto compressed = compress(data);
-        const auto checksum = utils::string::to_hex_string(compute_checksum(compressed));
-        this->send_raw_data("$" + compressed + "#" + checksum);
+        return this->no_ack_mode_;
     }
 
     void connection_handler::send_raw_data(const std::string_view data)
@@ -27,6 +27,10 @@ namespace sogen::gdb_stub
         void send_reply(std::string_view data);
         void send_raw_data(std::string_view data);
 
+        // After QStartNoAckMode neither side acknowledges packets anymore.
+        void set_no_ack_mode(bool enabled);
+        bool is_no_ack_mode() const;
+
         void close() const;
 
         bool should_stop() const;
@@ -38,6 +42,7 @@ namespace sogen::gdb_stub
 
         std::mutex mutex_{};
         std::atomic_bool stop_{};
+        bool no_ack_mode_{false};
         std::string output_stream_{};
         std::thread output_thread_{};
         std::condition_variable condition_variable_{};
@@ -16,7 +16,8 @@ namespace sogen::gdb_stub
 {
     namespace
     {
-        constexpr size_t max_data_size = 128 * 1024;
+        // Advertised as PacketSize, which bounds how much memory a single m/x request may ask for
+        constexpr size_t max_data_size = 1024 * 1024;
 
         void rt_assert(const bool condition)
         {
@@ -59,37 +60,51 @@ namespace sogen::gdb_stub
             return server.accept();
         }
 
-        constexpr std::string escape(const std::string_view data, size_t max_size, size_t* total_copied = nullptr)
+        constexpr bool needs_escape(const char ch)
         {
-            std::string result;
-            result.reserve(data.size());
+            return ch == '$' || ch == '#' || ch == '}' || ch == '*';
+        }
 
-            size_t count = 0;
+        // Appends binary data escaped for a reply, copying runs without special bytes in one go. Stops before
+        // the result would exceed max_size and returns how many input bytes were consumed.
+        size_t append_escaped(std::string& result, const std::string_view data, size_t max_size)
+        {
+            size_t offset = 0;
 
-            for (auto ch : data)
+            while (offset < data.size() && max_size > 0)
             {
-                if (ch == '$' || ch == '#' || ch == '}' || ch == '*')
+                auto run_end = offset;
+                const auto run_limit = offset + std::min(data.size() - offset, max_size);
+                while (run_end < run_limit && !needs_escape(data[run_end]))
                 {
-                    if (max_size < 2)
-                    {
-                        break;
-                    }
-
-                    max_size--;
-                    result.push_back('}');
-                    ch ^= 0x20;
+                    ++run_end;
                 }
 
-                if (!max_size)
+                result.append(data.data() + offset, run_end - offset);
+                max_size -= run_end - offset;
+                offset = run_end;
+
+                if (offset == data.size() || max_size < 2)
                 {
                     break;
                 }
 
-                max_size--;
-                count++;
-                result.push_back(ch);
+                result.push_back('}');
+                result.push_back(static_cast<char>(data[offset] ^ 0x20));
+                max_size -= 2;
+                ++offset;
             }
 
+            return offset;
+        }
+
+        std::string escape(const std::string_view data, const size_t max_size, size_t* total_copied = nullptr)
+        {
+            std::string result;
+            result.reserve(std::min(data.size(), max_size));
+
+            const auto count = append_escaped(result, data, max_size);
+
             if (total_copied)
             {
                 *total_copied = count;
@@ -320,6 +335,34 @@ namespace sogen::gdb_stub
             send_xfer_data(c.connection, std::string(data), xml);
         }
 
+        void handle_memory_map(const debugging_context& c, const std::string_view payload)
+        {
+            const auto [command, args] = split_string(payload, ':');
+            if (command != "read")
+            {
+                c.connection.send_reply({});
+                return;
+            }
+
+            const auto [annex, data] = split_string(args, ':');
+            (void)annex; // annex is empty for the memory map
+
+            std::string xml = "<memory-map>\n";
+
+            for (const auto& region : c.handler.get_memory_regions())
+            {
+                xml += "<memory type=\"ram\" start=\"0x";
+                xml += utils::string::to_hex_number(region.address);
+                xml += "\" length=\"0x";
+                xml += utils::string::to_hex_number(region.length);
+                xml += "\"/>\n";
+            }
+
+            xml += "</memory-map>";
+
+            send_xfer_data(c.connection, std::string(data), xml);
+        }
+
         void process_xfer(const debugging_context& c, const std::string_view payload)
         {
             auto [name, args] = split_string(payload, ':');
@@ -340,6 +383,10 @@ namespace sogen::gdb_stub
             {
                 handle_threads(c, args);
             }
+            else if (name == "memory-map")
+            {
+                handle_memory_map(c, args);
+            }
             else
             {
                 c.connection.send_reply({});
@@ -358,7 +405,13 @@ namespace sogen::gdb_stub
                              ";qXfer:libraries:read+"
                              ";qXfer:exec-file:read+"
                              ";qXfer:threads:read+"
-                             ";binary-upload+");
+                             ";binary-upload+"
+                             ";QStartNoAckMode+");
+
+                if (!c.handler.get_memory_regions().empty())
+                {
+                    reply.append(";qXfer:memory-map:read+");
+                }
 
                 c.connection.send_reply(reply);
             }
@@ -410,6 +463,23 @@ namespace sogen::gdb_stub
             }
         }
 
+        void process_set(const debugging_context& c, const std::string_view payload)
+        {
+            const auto [name, args] = split_string(payload, ':');
+            (void)args;
+
+            if (name == "StartNoAckMode")
+            {
+                // gdb still acknowledges this reply, the stream processor skips that '+'
+                c.connection.send_reply("OK");
+                c.connection.set_no_ack_mode(true);
+            }
+            else
+            {
+                c.connection.send_reply({});
+            }
+        }
+
         void send_file_result(const debugging_context& c, uint32_t result)
         {
             c.connection.send_reply("F" + utils::string::to_hex_number(result));
@@ -881,17 +951,21 @@ namespace sogen::gdb_stub
 
             size = std::min(size, max_data_size - 1);
 
-            std::string data{"b"};
-            data.resize(size + 1);
+            std::string data{};
+            data.resize(size);
 
-            if (const auto res = c.handler.read_memory(address, data.data() + 1, size); !res)
+            if (const auto res = c.handler.read_memory(address, data.data(), size); !res)
             {
                 c.connection.send_reply("E01");
                 return;
             }
 
-            const auto encoded_data = escape(data, max_data_size - 1);
-            c.connection.send_reply(encoded_data);
+            // Escaping can make the reply grow up to twice the size, gdb asks for the rest in a later packet
+            std::string reply{"b"};
+            reply.reserve(size + 1);
+            append_escaped(reply, data, max_data_size - reply.size() - 1);
+
+            c.connection.send_reply(reply);
         }
 
         void switch_to_thread(const debugging_context& c, const std::string_view payload)
@@ -958,6 +1032,10 @@ namespace sogen::gdb_stub
                 process_query(c, data);
                 break;
 
+            case 'Q':
+                process_set(c, data);
+                break;
+
             case 'D':
                 c.connection.send_reply("OK");
                 c.connection.close();
@@ -1024,7 +1102,10 @@ namespace sogen::gdb_stub
 
         void process_packet(const debugging_context& c, const std::string_view packet)
         {
-            c.connection.send_raw_data("+");
+            if (!c.connection.is_no_ack_mode())
+            {
+                c.connection.send_raw_data("+");
+            }
 
             if (packet.empty())
             {
@@ -31,6 +31,12 @@ namespace sogen::gdb_stub
         uint64_t segment_address;
     };
 
+    struct memory_region
+    {
+        uint64_t address;
+        uint64_t length;
+    };
+
     struct thread_info
     {
         uint32_t id;
@@ -100,6 +106,13 @@ namespace sogen::gdb_stub
             return {};
         }
 
+        // Mapped guest memory, reported through qXfer:memory-map so the debugger does not probe unmapped
+        // addresses. Without regions no memory map is offered and every address is considered accessible.
+        virtual std::vector<memory_region> get_memory_regions()
+        {
+            return {};
+        }
+
         virtual std::vector<thread_info> get_thread_list() const
         {
             return {};
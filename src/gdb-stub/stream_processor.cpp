@@ -1,19 +1,41 @@
 #include "stream_processor.hpp"
 #include "checksum.hpp"
 
-#include <cassert>
+#include <algorithm>
 #include <stdexcept>
 
 namespace sogen::gdb_stub
 {
     namespace
     {
-        void trim_data_stream_start(std::string& stream)
+        bool parse_checksum(const std::string_view data, uint8_t& checksum)
         {
-            while (!stream.empty() && stream.front() != '$')
+            checksum = 0;
+
+            for (const auto ch : data)
             {
-                stream.erase(stream.begin());
+                uint8_t nibble{};
+                if (ch >= '0' && ch <= '9')
+                {
+                    nibble = static_cast<uint8_t>(ch - '0');
+                }
+                else if (ch >= 'a' && ch <= 'f')
+                {
+                    nibble = static_cast<uint8_t>(ch - 'a' + 10);
+                }
+                else if (ch >= 'A' && ch <= 'F')
+                {
+                    nibble = static_cast<uint8_t>(ch - 'A' + 10);
+                }
+                else
+                {
+                    return false;
+                }
+
+                checksum = static_cast<uint8_t>((checksum << 4) | nibble);
             }
+
+            return true;
         }
     }
 
@@ -35,60 +57,80 @@ namespace sogen::gdb_stub
         return packet;
     }
 
-    void stream_processor::push_stream_data(const std::string& data)
+    void stream_processor::push_stream_data(const std::string_view data)
     {
+        this->compact_stream();
         this->stream_.append(data);
         this->process_data_stream();
     }
 
+    void stream_processor::compact_stream()
+    {
+        if (this->read_offset_ == 0 || this->read_offset_ < this->stream_.size() / 2)
+        {
+            return;
+        }
+
+        this->stream_.erase(0, this->read_offset_);
+        this->scan_offset_ -= this->read_offset_;
+        this->read_offset_ = 0;
+    }
+
     void stream_processor::process_data_stream()
     {
+        const std::string_view stream = this->stream_;
+
         while (true)
         {
-            trim_data_stream_start(this->stream_);
+            // Acks, interrupts and anything else outside a packet are dropped
+            const auto start = stream.find('$', this->read_offset_);
+            if (start == std::string_view::npos)
+            {
+                this->read_offset_ = stream.size();
+                this->scan_offset_ = stream.size();
+                break;
+            }
+
+            if (this->read_offset_ != start)
+            {
+                this->read_offset_ = start;
+                this->scan_offset_ = start + 1;
+            }
 
-            const auto end = this->stream_.find_first_of('#');
-            if (end == std::string::npos)
+            // Payload bytes already searched for the terminator are not scanned again
+            const auto end = stream.find('#', std::max(this->scan_offset_, start + 1));
+            if (end == std::string_view::npos)
             {
+                this->scan_offset_ = stream.size();
                 break;
             }
 
-            const auto packet_size = end + CHECKSUM_SIZE + 1;
+            this->scan_offset_ = end;
 
-            if (packet_size > this->stream_.size())
+            const auto packet_end = end + CHECKSUM_SIZE + 1;
+            if (packet_end > stream.size())
             {
                 break;
             }
 
-            auto packet = this->stream_.substr(0, packet_size);
-            this->stream_.erase(0, packet_size);
+            this->enqueue_packet(stream.substr(start + 1, end - start - 1), stream.substr(end + 1, CHECKSUM_SIZE));
 
-            this->enqueue_packet(std::move(packet));
+            this->read_offset_ = packet_end;
+            this->scan_offset_ = packet_end;
         }
     }
 
-    void stream_processor::enqueue_packet(std::string packet)
+    void stream_processor::enqueue_packet(const std::string_view packet, const std::string_view checksum)
     {
-        constexpr auto END_BYTES = CHECKSUM_SIZE + 1;
-
-        if (packet.size() < (END_BYTES + 1) //
-            || packet.front() != '$'        //
-            || packet[packet.size() - END_BYTES] != '#')
+        uint8_t expected_checksum{};
+        if (!parse_checksum(checksum, expected_checksum))
         {
             return;
         }
 
-        const auto checksum = strtoul(packet.c_str() + packet.size() - CHECKSUM_SIZE, nullptr, 16);
-        assert((checksum & 0xFF) == checksum);
-
-        packet.erase(packet.begin());
-        packet.erase(packet.size() - END_BYTES, END_BYTES);
-
-        const auto computed_checksum = compute_checksum(packet);
-
-        if (computed_checksum == checksum)
+        if (compute_checksum(packet) == expected_checksum)
         {
-            this->packets_.push(std::move(packet));
+            this->packets_.emplace(packet);
         }
     }
 } // namespace sogen::gdb_stub
@@ -1,21 +1,28 @@
 #pragma once
 #include <queue>
 #include <string>
+#include <string_view>
 
 namespace sogen::gdb_stub
 {
+    // Splits the incoming byte stream into packet payloads. Received data is appended behind a read offset and
+    // consumed bytes are only dropped once they make up half of the buffer, so large binary packets arriving in
+    // many small reads are scanned once instead of being shifted through the buffer byte by byte.
     class stream_processor
     {
       public:
         bool has_packet() const;
         std::string get_next_packet();
-        void push_stream_data(const std::string& data);
+        void push_stream_data(std::string_view data);
 
       private:
         std::string stream_{};
+        size_t read_offset_{};
+        size_t scan_offset_{};
         std::queue<std::string> packets_{};
 
         void process_data_stream();
-        void enqueue_packet(std::string packet);
+        void compact_stream();
+        void enqueue_packet(std::string_view packet, std::string_view checksum);
     };
 } // namespace sogen::gdb_stub
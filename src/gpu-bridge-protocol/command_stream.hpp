@@ -0,0 +1,185 @@
+#pragma once
+
+// Encoding and decoding of ioctl_record_commands streams, shared by the guest shim (which batches) and the
+// emulator-side dispatcher (which replays). Like gpu_bridge_protocol.hpp it needs no Vulkan headers, but it
+// does use the standard containers, so it is kept out of the dependency-free protocol header.
+//
+// A stream is a run of records, each a command_record_header followed by `size` payload bytes. The guest
+// appends every finished command buffer recording (begin -> cmds -> end) to a frame batch and adds its
+// queue submissions behind them, so a whole frame crosses the bridge in one IOCTL at vkQueueSubmit.
+
+#include "gpu_bridge_protocol.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace sogen::gpu_bridge
+{
+    // The guest flushes a batch early once it grows past this size, well below the host's hard limit on a
+    // single record_commands IOCTL, so a long-running recording never makes one oversized transfer.
+    inline constexpr size_t max_command_batch_bytes = size_t{16} * 1024 * 1024;
+
+    inline void append_command_record(std::vector<uint8_t>& stream, const command cmd, const void* payload, const size_t size)
+    {
+        const command_record_header header{.command = static_cast<uint32_t>(cmd), .size = static_cast<uint32_t>(size)};
+        const auto* header_bytes = reinterpret_cast<const uint8_t*>(&header);
+        stream.insert(stream.end(), header_bytes, header_bytes + sizeof(header));
+
+        const auto* payload_bytes = static_cast<const uint8_t*>(payload);
+        stream.insert(stream.end(), payload_bytes, payload_bytes + size);
+    }
+
+    // Calls `handler(command, payload, size)` for every record in order. Returns false if the stream ends in a
+    // truncated record, which is dropped.
+    template <typename Handler>
+    bool for_each_command_record(const std::byte* data, const size_t size, Handler&& handler)
+    {
+        size_t offset = 0;
+        while (offset + sizeof(command_record_header) <= size)
+        {
+            command_record_header header{};
+            std::memcpy(&header, data + offset, sizeof(header));
+            offset += sizeof(header);
+            if (header.size > size - offset)
+            {
+                return false;
+            }
+
+            handler(header.command, data + offset, static_cast<size_t>(header.size));
+            offset += header.size;
+        }
+
+        return offset == size;
+    }
+
+    // Guest-side frame batch. Finished recordings and submissions are queued in issue order; take() hands the
+    // stream to a single ioctl_record_commands call. See command_batcher for when it is sent.
+    class command_batch
+    {
+      public:
+        void append_recording(const std::span<const uint8_t> recording)
+        {
+            this->stream_.insert(this->stream_.end(), recording.begin(), recording.end());
+        }
+
+        void append_submit(const queue_submit_request& request)
+        {
+            append_command_record(this->stream_, command::queue_submit, &request, sizeof(request));
+        }
+
+        // Same payload as ioctl_queue_submit2: the request followed by its three trailing arrays.
+        void append_submit2(const queue_submit2_request& request, const std::span<const submit2_semaphore_entry> waits,
+                            const std::span<const object_id> command_buffers, const std::span<const submit2_semaphore_entry> signals)
+        {
+            const size_t size = sizeof(request) + waits.size_bytes() + command_buffers.size_bytes() + signals.size_bytes();
+            const command_record_header header{
+                .command = static_cast<uint32_t>(command::queue_submit2),
+                .size = static_cast<uint32_t>(size),
+            };
+
+            const auto append = [this](const void* data, const size_t bytes) {
+                const auto* begin = static_cast<const uint8_t*>(data);
+                this->stream_.insert(this->stream_.end(), begin, begin + bytes);
+            };
+
+            append(&header, sizeof(header));
+            append(&request, sizeof(request));
+            append(waits.data(), waits.size_bytes());
+            append(command_buffers.data(), command_buffers.size_bytes());
+            append(signals.data(), signals.size_bytes());
+        }
+
+        bool empty() const
+        {
+            return this->stream_.empty();
+        }
+
+        size_t size() const
+        {
+            return this->stream_.size();
+        }
+
+        std::vector<uint8_t> take()
+        {
+            std::vector<uint8_t> stream{};
+            stream.swap(this->stream_);
+            return stream;
+        }
+
+      private:
+        std::vector<uint8_t> stream_{};
+    };
+
+    // The guest's batching policy around a command_batch. Recordings wait for the next submit, whose
+    // submissions ride behind them; a batch that grows past max_command_batch_bytes goes out early. Callers
+    // must flush() before any other bridge call so the host never observes a later command ahead of an
+    // earlier recording. A batch sent before the submit (early or by such a flush) has nobody to report its
+    // failure to, so the submit returns it. `send` carries one stream in a single ioctl_record_commands and
+    // returns its VkResult. Not synchronized; callers serialize access.
+    class command_batcher
+    {
+      public:
+        using send_function = std::function<int32_t(std::span<const uint8_t> stream)>;
+
+        explicit command_batcher(send_function send)
+            : send_(std::move(send))
+        {
+        }
+
+        void add_recording(const std::span<const uint8_t> recording)
+        {
+            this->batch_.append_recording(recording);
+            if (this->batch_.size() > max_command_batch_bytes)
+            {
+                this->flush();
+            }
+        }
+
+        void add_submit(const queue_submit_request& request)
+        {
+            this->batch_.append_submit(request);
+        }
+
+        void add_submit2(const queue_submit2_request& request, const std::span<const submit2_semaphore_entry> waits,
+                         const std::span<const object_id> command_buffers, const std::span<const submit2_semaphore_entry> signals)
+        {
+            this->batch_.append_submit2(request, waits, command_buffers, signals);
+        }
+
+        void flush()
+        {
+            if (this->batch_.empty())
+            {
+                return;
+            }
+
+            const auto stream = this->batch_.take();
+            const int32_t result = this->send_(stream);
+            if (result != 0 && this->deferred_result_ == 0)
+            {
+                this->deferred_result_ = result;
+            }
+        }
+
+        // Sends the pending batch and returns the first failure since the previous submit, or 0 (VK_SUCCESS).
+        int32_t submit()
+        {
+            this->flush();
+            return std::exchange(this->deferred_result_, 0);
+        }
+
+        bool empty() const
+        {
+            return this->batch_.empty();
+        }
+
+      private:
+        send_function send_{};
+        command_batch batch_{};
+        int32_t deferred_result_{};
+    };
+}
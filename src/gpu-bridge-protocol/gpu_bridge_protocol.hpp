@@ -16,7 +16,7 @@ namespace sogen::gpu_bridge
     // Identifies a valid bridge and lets the guest detect a host that speaks a different
     // protocol revision before issuing any further commands.
     inline constexpr uint32_t protocol_magic = 0x55504753; // 'SGPU'
-    inline constexpr uint32_t protocol_version = 29;
+    inline constexpr uint32_t protocol_version = 30;
 
     // Windows IOCTL encoding: CTL_CODE(DeviceType, Function, Method, Access).
     //   value = (DeviceType << 16) | (Access << 14) | (Function << 2) | Method
@@ -2272,12 +2272,15 @@ namespace sogen::gpu_bridge
         object_id surface;
     };
 
-    // whole command buffer's recording (begin -> cmds -> end) crosses the bridge in a single IOCTL
-    // instead of one per command. The buffer is a sequence of records, each a `command_record_header`
-    // immediately followed by `size` payload bytes, where the payload is exactly that command's normal
-    // request struct (e.g. cmd_draw_request); cmd_push_constants additionally trails its value bytes.
-    // `command` is the `command` enum value being recorded. (first non-success
-    // VkResult encountered while replaying, or VK_SUCCESS).
+    // ioctl_record_commands: in = command stream, out = result_response (first non-success VkResult
+    // encountered while replaying, or VK_SUCCESS). Whole command buffer recordings (begin -> cmds -> end)
+    // cross the bridge in a single IOCTL instead of one per command. The buffer is a sequence of records,
+    // each a `command_record_header` immediately followed by `size` payload bytes, where the payload is
+    // exactly that command's normal request struct (e.g. cmd_draw_request); cmd_push_constants
+    // additionally trails its value bytes. `command` is the `command` enum value being recorded.
+    // Since protocol 30 a stream may also carry queue_submit and queue_submit2 records (payload as for
+    // their IOCTLs), so the guest batches a frame's recordings and submissions into one IOCTL; records
+    // replay strictly in order. See command_stream.hpp.
     struct command_record_header
     {
         uint32_t command;
@@ -0,0 +1,93 @@
+#include "linux_emulation_test_utils.hpp"
+
+#include <scoped_hook.hpp>
+
+#include <array>
+
+namespace sogen
+{
+    namespace linux_test
+    {
+        namespace
+        {
+            constexpr uint64_t code_base = 0x600000;
+            constexpr uint64_t value_addr = code_base + 0x1000;
+            constexpr uint64_t loop_body = code_base + 8;
+            constexpr uint64_t loop_count = 1'000;
+
+            // loop: mov rax, [value]; inc rax; mov [value], rax; dec rcx; jnz loop; nop
+            constexpr std::array<uint8_t, 25> counter_loop{
+                0x48, 0x8B, 0x04, 0x25, 0x00, 0x10, 0x60, 0x00, //
+                0x48, 0xFF, 0xC0,                               //
+                0x48, 0x89, 0x04, 0x25, 0x00, 0x10, 0x60, 0x00, //
+                0x48, 0xFF, 0xC9,                               //
+                0x75, 0xE8,                                     //
+                0x90,
+            };
+
+            constexpr uint64_t loop_end = code_base + counter_loop.size() - 1;
+
+            void reset_loop(linux_emulator& linux_emu)
+            {
+                const uint64_t zero = 0;
+                linux_emu.memory.write_memory(value_addr, &zero, sizeof(zero));
+                linux_emu.emu().reg(x86_register::rip, code_base);
+                linux_emu.emu().reg(x86_register::rcx, loop_count);
+            }
+        }
+
+        // Breakpoints set the way a debugger does: they fire on every visit, do not show up in memory reads
+        // and leave the code intact once removed.
+        TEST(LinuxDebuggerHookTest, BreakpointsAndWatchpointsFireWithoutChangingMemory)
+        {
+            auto emu_backend = create_x86_64_emulator();
+            linux_emulator linux_emu(std::move(emu_backend), get_linux_emulation_root());
+            linux_emu.log.disable_output(true);
+
+            auto& emu = linux_emu.emu();
+
+            ASSERT_TRUE(linux_emu.memory.allocate_memory(code_base, 0x2000, memory_permission::all));
+            linux_emu.memory.write_memory(code_base, counter_loop.data(), counter_loop.size());
+
+            const scoped_hook end_hook(emu, emu.hook_breakpoint(loop_end, [&](cpu_interface&, uint64_t) { emu.stop(); }));
+
+            {
+                size_t hits = 0;
+                const scoped_hook body_hook(emu, emu.hook_breakpoint(loop_body, [&](cpu_interface&, uint64_t) { ++hits; }));
+
+                std::array<uint8_t, counter_loop.size()> code{};
+                linux_emu.memory.read_memory(code_base, code.data(), code.size());
+                EXPECT_EQ(code, counter_loop);
+
+                reset_loop(linux_emu);
+                emu.start();
+
+                EXPECT_EQ(hits, loop_count);
+                EXPECT_EQ(emu.read_memory<uint64_t>(value_addr), loop_count);
+            }
+
+            std::array<uint8_t, counter_loop.size()> code{};
+            linux_emu.memory.read_memory(code_base, code.data(), code.size());
+            EXPECT_EQ(code, counter_loop);
+
+            if (!emu.supports_watchpoints())
+            {
+                return;
+            }
+
+            size_t writes = 0;
+            uint64_t last_value = 0;
+            const scoped_hook watch_hook(emu, emu.hook_watchpoint(value_addr, sizeof(uint64_t), memory_operation::write,
+                                                                  [&](cpu_interface&, uint64_t, const void* data, const size_t size) {
+                                                                      ++writes;
+                                                                      memcpy(&last_value, data, std::min(size, sizeof(last_value)));
+                                                                  }));
+
+            reset_loop(linux_emu);
+            emu.start();
+
+            EXPECT_EQ(writes, loop_count);
+            EXPECT_EQ(last_value, loop_count);
+        }
+    } // namespace linux_test
+} // namespace sogen
@@ -0,0 +1,111 @@
+#include "linux_emulation_test_utils.hpp"
+
+#include <linux_syscall_numbers.hpp>
+
+namespace sogen
+{
+    namespace linux_test
+    {
+        namespace
+        {
+            constexpr uint64_t scratch_base = 0x600000;
+            constexpr uint64_t events_addr = scratch_base;
+            constexpr uint64_t value_addr = scratch_base + 0x800;
+            constexpr uint64_t event_size = 12;
+
+            void epoll_add(linux_emulator& linux_emu, const int64_t epfd, const int64_t fd, const uint64_t data)
+            {
+                linux_emu.memory.write_memory(value_addr, &LINUX_EPOLLIN, sizeof(LINUX_EPOLLIN));
+                linux_emu.memory.write_memory(value_addr + 4, &data, sizeof(data));
+                ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_ctl,
+                                       {static_cast<uint64_t>(epfd), 1, static_cast<uint64_t>(fd), value_addr}),
+                          0);
+            }
+
+            uint64_t read_event_data(linux_emulator& linux_emu, const size_t index)
+            {
+                uint64_t data{};
+                linux_emu.memory.read_memory(events_addr + index * event_size + 4, &data, sizeof(data));
+                return data;
+            }
+        }
+
+        // An event loop with many idle descriptors: a wait must only look at what was pushed to the ready list,
+        // and a waiter that blocks while another thread can run is parked until that thread produces an event.
+        TEST(LinuxEpollTest, ReadyListWakesParkedWaiter)
+        {
+            constexpr size_t idle_count = 1'000;
+            constexpr size_t wait_count = 100;
+
+            auto emu_backend = create_x86_64_emulator();
+            linux_emulator linux_emu(std::move(emu_backend), get_linux_emulation_root());
+            linux_emu.log.disable_output(true);
+
+            ASSERT_TRUE(linux_emu.memory.allocate_memory(scratch_base, 0x1000, memory_permission::read_write));
+
+            const auto waiter_tid = linux_emu.process.create_thread(0x700000, 0x1000, 0x100000);
+            const auto producer_tid = linux_emu.process.create_thread(0x800000, 0x1000, 0x100000);
+            ASSERT_TRUE(linux_emu.activate_thread(waiter_tid));
+
+            const auto epfd = call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_create1, {0});
+            ASSERT_GE(epfd, 0);
+
+            std::vector<int64_t> eventfds{};
+            for (size_t i = 0; i < idle_count; ++i)
+            {
+                const auto fd = call_syscall(linux_emu, linux_syscalls::LINUX_SYS_eventfd2, {0, 0});
+                ASSERT_GE(fd, 0);
+                epoll_add(linux_emu, epfd, fd, 0x1000 + i);
+                eventfds.push_back(fd);
+            }
+
+            // The first wait looks at every descriptor once, as each was queued when it was added.
+            EXPECT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_wait, {static_cast<uint64_t>(epfd), events_addr, 16, 0}), 0);
+
+            const auto& instance = *linux_emu.process.epoll_instances.at(static_cast<int>(epfd));
+            EXPECT_EQ(instance.checked_entries, idle_count);
+            EXPECT_TRUE(instance.ready_list.empty());
+
+            // Later waits find an empty ready list and look at no descriptor at all.
+            for (size_t i = 0; i < wait_count; ++i)
+            {
+                ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_wait, {static_cast<uint64_t>(epfd), events_addr, 16, 0}),
+                          0);
+            }
+            EXPECT_EQ(instance.checked_entries, idle_count);
+
+            // Nothing is ready and the producer can run, so an infinite wait parks the waiter.
+            call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_wait,
+                         {static_cast<uint64_t>(epfd), events_addr, 16, static_cast<uint64_t>(-1)});
+            ASSERT_EQ(linux_emu.current_thread_id(), producer_tid);
+            EXPECT_EQ(linux_emu.process.threads.at(waiter_tid).wait_state, thread_wait_state::epoll_wait);
+
+            // Without an event the scheduler neither wakes the waiter nor harvests for it.
+            EXPECT_FALSE(linux_emu.perform_thread_switch());
+            EXPECT_EQ(instance.checked_entries, idle_count);
+
+            const uint64_t increment = 2;
+            const auto signaled_fd = eventfds.at(idle_count / 2);
+            linux_emu.memory.write_memory(value_addr, &increment, sizeof(increment));
+            ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_write, {static_cast<uint64_t>(signaled_fd), value_addr, 8}), 8);
+
+            // The next switch completes the wait with the one ready descriptor.
+            ASSERT_TRUE(linux_emu.perform_thread_switch());
+            ASSERT_EQ(linux_emu.current_thread_id(), waiter_tid);
+            EXPECT_EQ(linux_emu.process.threads.at(waiter_tid).wait_state, thread_wait_state::running);
+            EXPECT_EQ(linux_emu.emu().reg(x86_register::rax), 1U);
+            EXPECT_EQ(read_event_data(linux_emu, 0), 0x1000 + idle_count / 2);
+            EXPECT_EQ(instance.checked_entries, idle_count + 1);
+
+            // Level-triggered: still ready until the counter is read.
+            EXPECT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_wait, {static_cast<uint64_t>(epfd), events_addr, 16, 0}), 1);
+
+            ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_read, {static_cast<uint64_t>(signaled_fd), value_addr, 8}), 8);
+            uint64_t counter{};
+            linux_emu.memory.read_memory(value_addr, &counter, sizeof(counter));
+            EXPECT_EQ(counter, increment);
+
+            EXPECT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_epoll_wait, {static_cast<uint64_t>(epfd), events_addr, 16, 0}), 0);
+        }
+    } // namespace linux_test
+} // namespace sogen
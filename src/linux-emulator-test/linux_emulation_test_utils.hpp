@@ -191,4 +191,23 @@ namespace sogen::linux_test
 
         return result;
     }
+
+    // Runs one syscall handler directly, as if the active thread had executed a syscall instruction.
+    inline int64_t call_syscall(linux_emulator& linux_emu, const uint64_t syscall_id, const std::vector<uint64_t>& args)
+    {
+        constexpr std::array argument_registers{x86_register::rdi, x86_register::rsi, x86_register::rdx,
+                                                x86_register::r10, x86_register::r8,  x86_register::r9};
+
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            linux_emu.emu().reg(argument_registers.at(i), args.at(i));
+        }
+
+        const auto* entry = linux_emu.dispatcher.get_entry(syscall_id);
+        EXPECT_NE(entry, nullptr);
+        EXPECT_NE(entry->handler, nullptr);
+        entry->handler({.emu_ref = linux_emu, .emu = linux_emu.emu(), .proc = linux_emu.process});
+
+        return static_cast<int64_t>(linux_emu.emu().reg(x86_register::rax));
+    }
 } // namespace sogen::linux_test
@@ -0,0 +1,74 @@
+#include "linux_emulation_test_utils.hpp"
+
+#include <array>
+
+namespace sogen
+{
+    namespace linux_test
+    {
+        namespace
+        {
+            constexpr uint64_t code_base = 0x600000;
+
+            // A compute-bound guest that never enters the emulator on its own: jmp $
+            constexpr std::array<uint8_t, 2> spin_loop{0xEB, 0xFE};
+
+            void prepare_spin_loop(linux_emulator& linux_emu)
+            {
+                linux_emu.log.disable_output(true);
+
+                ASSERT_TRUE(linux_emu.memory.allocate_memory(code_base, 0x1000, memory_permission::read | memory_permission::exec));
+                linux_emu.memory.write_memory(code_base, spin_loop.data(), spin_loop.size());
+                linux_emu.emu().reg(x86_register::rip, code_base);
+            }
+        }
+
+        // The debugger pumps its events from on_periodic_event, so an unlimited run of a guest that never
+        // makes a syscall must still reach it, whichever way the backend accounts instructions.
+        TEST(LinuxPeriodicEventTest, FiresDuringUnlimitedRunsOfComputeBoundGuests)
+        {
+            linux_emulator linux_emu(create_x86_64_emulator_from_environment(), get_linux_emulation_root());
+            prepare_spin_loop(linux_emu);
+
+            constexpr size_t wanted_events = 3;
+            size_t events = 0;
+
+            linux_emu.on_periodic_event = [&] {
+                if (++events == wanted_events)
+                {
+                    linux_emu.stop();
+                }
+            };
+
+            linux_emu.start();
+
+            EXPECT_EQ(events, wanted_events);
+            EXPECT_EQ(linux_emu.last_stop_reason(), stop_reason::explicit_stop);
+            EXPECT_EQ(linux_emu.emu().read_instruction_pointer(), code_base);
+        }
+
+        TEST(LinuxPeriodicEventTest, CountedRunsStayExact)
+        {
+            linux_emulator linux_emu(create_x86_64_emulator_from_environment(), get_linux_emulation_root());
+            prepare_spin_loop(linux_emu);
+
+            size_t events = 0;
+            linux_emu.on_periodic_event = [&] {
+                ++events; //
+            };
+
+            linux_emu.start(1000);
+            EXPECT_EQ(linux_emu.get_executed_instructions(), 1000u);
+            EXPECT_EQ(linux_emu.last_stop_reason(), stop_reason::instruction_limit);
+            EXPECT_EQ(events, 0u);
+
+            linux_emu.start(7);
+            EXPECT_EQ(linux_emu.get_executed_instructions(), 1007u);
+
+            // Crossing the 0x20000 instruction interval fires exactly once, and the budget still holds.
+            linux_emu.start(0x20000);
+            EXPECT_EQ(linux_emu.get_executed_instructions(), 0x20000u + 1007u);
+            EXPECT_EQ(events, 1u);
+        }
+    } // namespace linux_test
+} // namespace sogen
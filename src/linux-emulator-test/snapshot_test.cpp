@@ -0,0 +1,136 @@
+#include "linux_emulation_test_utils.hpp"
+
+#include <linux_syscall_numbers.hpp>
+
+#include <array>
+
+namespace sogen
+{
+    namespace linux_test
+    {
+        namespace
+        {
+            constexpr uint64_t scratch_base = 0x600000;
+            constexpr size_t scratch_size = 0x4000;
+            constexpr uint64_t value_addr = scratch_base + scratch_size - 0x100;
+
+            std::vector<std::pair<uint64_t, size_t>> get_region_layout(const linux_emulator& linux_emu)
+            {
+                std::vector<std::pair<uint64_t, size_t>> layout{};
+                for (const auto& [base, region] : linux_emu.memory.get_mapped_regions())
+                {
+                    layout.emplace_back(base, region.length);
+                }
+
+                return layout;
+            }
+
+            uint8_t read_byte(const linux_emulator& linux_emu, const uint64_t address)
+            {
+                uint8_t value{};
+                linux_emu.memory.read_memory(address, &value, sizeof(value));
+                return value;
+            }
+        }
+
+        // A fork-server reset loop: every iteration scribbles over memory, maps and splits regions and opens
+        // descriptors and bumps an eventfd counter, restore_snapshot has to undo all of it.
+        TEST(LinuxSnapshotTest, RestoreUndoesMemoryFdAndRegisterChanges)
+        {
+            constexpr size_t reset_count = 50;
+
+            auto emu_backend = create_x86_64_emulator();
+            linux_emulator linux_emu(std::move(emu_backend), get_linux_emulation_root());
+            linux_emu.log.disable_output(true);
+
+            ASSERT_TRUE(linux_emu.memory.allocate_memory(scratch_base, scratch_size, memory_permission::read_write));
+
+            std::vector<uint8_t> pattern(scratch_size - 0x100);
+            for (size_t i = 0; i < pattern.size(); ++i)
+            {
+                pattern[i] = static_cast<uint8_t>(i * 7);
+            }
+            linux_emu.memory.write_memory(scratch_base, pattern.data(), pattern.size());
+
+            const auto eventfd = call_syscall(linux_emu, linux_syscalls::LINUX_SYS_eventfd2, {3, 0});
+            ASSERT_GE(eventfd, 0);
+
+            linux_emu.emu().reg(x86_register::rbx, uint64_t{0x1234});
+            const auto layout = get_region_layout(linux_emu);
+
+            linux_emu.save_snapshot();
+
+            for (size_t i = 0; i < reset_count; ++i)
+            {
+                const auto value = static_cast<uint8_t>(i);
+                linux_emu.memory.write_memory(scratch_base + 0x1000, &value, sizeof(value));
+                linux_emu.memory.protect_memory(scratch_base + 0x2000, 0x1000, memory_permission::read);
+                ASSERT_NE(linux_emu.memory.allocate_memory(0x2000, memory_permission::read_write), 0U);
+
+                const auto extra_fd = call_syscall(linux_emu, linux_syscalls::LINUX_SYS_eventfd2, {1, 0});
+                ASSERT_GT(extra_fd, eventfd);
+                linux_emu.emu().reg(x86_register::rbx, uint64_t{i});
+
+                const uint64_t increment = i + 1;
+                linux_emu.memory.write_memory(value_addr, &increment, sizeof(increment));
+                ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_write, {static_cast<uint64_t>(eventfd), value_addr, 8}), 8);
+
+                linux_emu.restore_snapshot();
+            }
+
+            EXPECT_EQ(get_region_layout(linux_emu), layout);
+            EXPECT_EQ(linux_emu.memory.get_mapped_regions().at(scratch_base).permissions, memory_permission::read_write);
+            EXPECT_EQ(linux_emu.emu().reg(x86_register::rbx), 0x1234U);
+            EXPECT_EQ(linux_emu.process.fds.get(static_cast<int>(eventfd) + 1), nullptr);
+
+            std::vector<uint8_t> restored(pattern.size());
+            linux_emu.memory.read_memory(scratch_base, restored.data(), restored.size());
+            EXPECT_EQ(restored, pattern);
+
+            // The eventfd counter is part of the restored fd table, every write to it was undone.
+            ASSERT_EQ(call_syscall(linux_emu, linux_syscalls::LINUX_SYS_read, {static_cast<uint64_t>(eventfd), value_addr, 8}), 8);
+            uint64_t counter{};
+            linux_emu.memory.read_memory(value_addr, &counter, sizeof(counter));
+            EXPECT_EQ(counter, 3U);
+        }
+
+        // With a dirty-page log restore_snapshot rewrites exactly the pages written since the snapshot instead of
+        // comparing every mapped page: one the guest stored to and one the host rewrote with its old contents.
+        TEST(LinuxSnapshotTest, RestoreRewritesOnlyWrittenPages)
+        {
+            constexpr uint64_t code_base = 0x700000;
+            constexpr uint64_t target = scratch_base + 0x1000;
+            constexpr uint64_t rewritten = scratch_base + 0x3000;
+
+            linux_emulator linux_emu(create_x86_64_emulator(), get_linux_emulation_root());
+            linux_emu.log.disable_output(true);
+
+            if (!linux_emu.emu().supports_dirty_page_tracking())
+            {
+                GTEST_SKIP() << linux_emu.emu().get_name() << " has no dirty-page log";
+            }
+
+            ASSERT_TRUE(linux_emu.memory.allocate_memory(scratch_base, scratch_size, memory_permission::read_write));
+            ASSERT_TRUE(linux_emu.memory.allocate_memory(code_base, 0x1000, memory_permission::read | memory_permission::exec));
+
+            // mov byte ptr [target], 0x42
+            constexpr std::array<uint8_t, 8> writer{0xC6, 0x04, 0x25, 0x00, 0x10, 0x60, 0x00, 0x42};
+            linux_emu.memory.write_memory(code_base, writer.data(), writer.size());
+
+            linux_emu.memory.save_snapshot();
+
+            linux_emu.emu().reg(x86_register::rip, code_base);
+            linux_emu.emu().start(1);
+            ASSERT_EQ(read_byte(linux_emu, target), 0x42);
+
+            constexpr uint8_t zero = 0;
+            linux_emu.memory.write_memory(rewritten, &zero, sizeof(zero));
+
+            const auto stats = linux_emu.memory.restore_snapshot();
+
+            EXPECT_EQ(stats.restored_pages, 2u);
+            EXPECT_EQ(stats.remapped_regions, 0u);
+            EXPECT_EQ(read_byte(linux_emu, target), 0);
+        }
+    } // namespace linux_test
+} // namespace sogen
@@ -2,13 +2,20 @@
 #include "linux_emulator.hpp"
 
 #include <address_utils.hpp>
+#include <utils/finally.hpp>
 
 namespace sogen
 {
 
     namespace
     {
-        constexpr std::string_view LINUX_EMULATOR_STATE_VERSION = "linux-emulator-state-v1";
+        constexpr std::string_view LINUX_EMULATOR_STATE_VERSION = "linux-emulator-state-v2";
+
+        // Instructions between two on_periodic_event calls, also the budget of one uncounted backend run.
+        constexpr uint64_t PERIODIC_EVENT_INTERVAL = 0x20000;
+
+        // How often the host timer ends a run on backends that can not count instructions at all.
+        constexpr auto PERIODIC_EVENT_TIMER_INTERVAL = std::chrono::milliseconds(20);
 
         // GDT constants — same as Windows emulator
         constexpr uint64_t GDT_ADDR = 0x35000;
@@ -428,7 +435,18 @@ namespace sogen
 
             auto& candidate = start->second;
             ++start;
-            if (candidate.tid == old_tid || !candidate.is_thread_ready(now))
+            if (candidate.tid == old_tid || candidate.terminated)
+            {
+                continue;
+            }
+
+            if (!candidate.is_thread_ready(now))
+            {
+                continue;
+            }
+
+            if (candidate.wait_state == thread_wait_state::epoll_wait &&
+                !complete_parked_epoll_wait(this->process, this->memory, candidate, now))
             {
                 continue;
             }
@@ -521,6 +539,43 @@ namespace sogen
         }
     }
 
+    void linux_emulator::save_snapshot()
+    {
+        utils::buffer_serializer buffer{};
+
+        this->emu().serialize_state(buffer, false);
+        buffer.write(this->executed_instructions_);
+        this->process.serialize(buffer);
+        this->mod_manager.serialize(buffer);
+        this->signals.serialize(buffer);
+        this->vdso.serialize(buffer);
+
+        this->process_snapshot_ = buffer.move_buffer();
+        this->memory.save_snapshot();
+    }
+
+    void linux_emulator::restore_snapshot()
+    {
+        if (this->process_snapshot_.empty())
+        {
+            throw std::runtime_error("No snapshot saved");
+        }
+
+        utils::buffer_deserializer buffer{this->process_snapshot_};
+
+        this->emu().deserialize_state(buffer, false);
+        buffer.read(this->executed_instructions_);
+        this->memory.restore_snapshot();
+        this->process.deserialize(buffer);
+        this->mod_manager.deserialize(buffer);
+        this->signals.deserialize(buffer);
+        this->vdso.deserialize(buffer);
+
+        this->should_stop = false;
+        this->last_stop_reason_ = stop_reason::none;
+        this->last_stop_detail_.clear();
+    }
+
     uint64_t linux_emulator::add_memory_violation_observer(
         std::function<memory_violation_continuation(uint64_t, size_t, memory_operation, memory_violation_type)> observer)
     {
@@ -698,23 +753,55 @@ namespace sogen
             this->stop();
             return memory_violation_continuation::stop;
         });
+    }
+
+    void linux_emulator::update_instruction_accounting_hook(const bool counted_run)
+    {
+        // Instruction budgets must be exact, which only a per-instruction hook guarantees on every backend.
+        // Unlimited runs account per basic block where the backend reports block sizes, and otherwise in
+        // slices of the backend's own instruction limit (see start), so no hook is installed at all.
+        const auto per_instruction = counted_run;
+        const auto per_block = !per_instruction && this->emu().supports_basic_block_instruction_counts();
+
+        const auto needs_hook = per_instruction || per_block;
+        if (per_instruction == this->per_instruction_accounting_ && needs_hook == (this->instruction_accounting_hook_ != nullptr))
+        {
+            return;
+        }
+
+        if (this->instruction_accounting_hook_)
+        {
+            this->emu().delete_hook(this->instruction_accounting_hook_);
+            this->instruction_accounting_hook_ = nullptr;
+        }
 
-        // Hook instruction execution (for counting)
-        this->emu().hook_memory_execution([this](cpu_interface&, const uint64_t address) { this->on_instruction_execution(address); });
+        this->per_instruction_accounting_ = per_instruction;
+
+        if (per_instruction)
+        {
+            this->instruction_accounting_hook_ =
+                this->emu().hook_memory_execution([this](cpu_interface&, const uint64_t) { this->account_instructions(1); });
+        }
+        else if (per_block)
+        {
+            this->instruction_accounting_hook_ = this->emu().hook_basic_block([this](cpu_interface&, const basic_block& block) {
+                this->account_instructions(block.instruction_count); //
+            });
+        }
     }
 
-    void linux_emulator::on_instruction_execution(const uint64_t address)
+    void linux_emulator::account_instructions(const uint64_t count)
     {
-        ++this->executed_instructions_;
+        const auto previous_interval = this->executed_instructions_ / PERIODIC_EVENT_INTERVAL;
+        this->executed_instructions_ += count;
 
+        // Threads only switch inside syscalls, so a slice accounted after the fact may straddle two threads.
         if (this->process.active_thread)
         {
-            ++this->process.active_thread->executed_instructions;
+            this->process.active_thread->executed_instructions += count;
         }
 
-        (void)address;
-
-        if (this->on_periodic_event && (this->executed_instructions_ % 0x20000) == 0)
+        if (this->on_periodic_event && this->executed_instructions_ / PERIODIC_EVENT_INTERVAL != previous_interval)
         {
             this->on_periodic_event();
         }
@@ -730,6 +817,44 @@ namespace sogen
         const auto start_instructions = this->executed_instructions_;
         const auto target_instructions = start_instructions + count;
 
+        this->update_instruction_accounting_hook(use_count);
+        const auto sliced = !this->instruction_accounting_hook_ && this->emu().supports_instruction_counting();
+
+        // Backends that can neither count instructions nor report block sizes get their periodic events from
+        // a host timer that ends the run, the way the Windows emulator's interrupt thread ends quanta.
+        const auto timed = !use_count && !this->instruction_accounting_hook_ && !sliced && this->on_periodic_event &&
+                           this->emu().is_stop_thread_safe();
+
+        std::mutex timer_mutex{};
+        std::condition_variable timer_cond{};
+        std::thread timer_thread{};
+        bool run_finished = false;
+
+        const auto _ = utils::finally([&] {
+            {
+                std::unique_lock lock{timer_mutex};
+                run_finished = true;
+            }
+
+            timer_cond.notify_all();
+
+            if (timer_thread.joinable())
+            {
+                timer_thread.join();
+            }
+        });
+
+        if (timed)
+        {
+            timer_thread = std::thread([&] {
+                std::unique_lock lock{timer_mutex};
+                while (!timer_cond.wait_for(lock, PERIODIC_EVENT_TIMER_INTERVAL, [&] { return run_finished; }))
+                {
+                    this->emu().stop();
+                }
+            });
+        }
+
         std::set<uint64_t> resumed_fetch_faults{};
 
         while (!this->should_stop)
@@ -748,7 +873,7 @@ namespace sogen
                 }
                 else
                 {
-                    this->emu().start(0);
+                    this->emu().start(sliced ? static_cast<size_t>(PERIODIC_EVENT_INTERVAL) : 0);
                 }
             }
             catch (const std::exception& e)
@@ -801,6 +926,20 @@ namespace sogen
                 throw;
             }
 
+            if (sliced && !this->should_stop && !this->emu().has_violation())
+            {
+                // Every stop goes through stop(), so a plain return means the slice ran out.
+                this->account_instructions(PERIODIC_EVENT_INTERVAL);
+                continue;
+            }
+
+            if (timed && !this->should_stop && !this->emu().has_violation())
+            {
+                // Likewise, a plain return here means the timer ended the run.
+                this->on_periodic_event();
+                continue;
+            }
+
             if (!this->emu().has_violation())
             {
                 break;
@@ -110,7 +110,8 @@ namespace sogen
         utils::callback_list<void(uint32_t old_tid, uint32_t new_tid)> on_thread_switch{};
 
         // Callback invoked periodically during emulation (every 0x20000 instructions).
-        // Used by the web debugger for ASYNCIFY yield and event handling.
+        // Used by the web debugger for ASYNCIFY yield and event handling. Backends that can neither count
+        // instructions nor report block sizes call it from a host timer instead, about every 20 ms.
         std::function<void()> on_periodic_event{};
 
         void start(size_t count = 0);
@@ -124,6 +125,11 @@ namespace sogen
         void serialize(utils::buffer_serializer& buffer, bool is_snapshot) const;
         void deserialize(utils::buffer_deserializer& buffer, bool is_snapshot);
 
+        // In-memory restore point for reset loops: CPU, threads, fd table, epoll instances and signal state
+        // are serialized, guest memory is kept by the memory manager so a restore only rewrites what changed.
+        void save_snapshot();
+        void restore_snapshot();
+
         uint64_t get_executed_instructions() const
         {
             return this->executed_instructions_;
@@ -152,6 +158,7 @@ namespace sogen
         std::atomic_bool should_stop{false};
         stop_reason last_stop_reason_{stop_reason::none};
         std::string last_stop_detail_{};
+        std::vector<std::byte> process_snapshot_{};
         uint64_t next_memory_violation_observer_id_{1};
         std::vector<
             std::pair<uint64_t, std::function<memory_violation_continuation(uint64_t, size_t, memory_operation, memory_violation_type)>>>
@@ -163,7 +170,10 @@ namespace sogen
         void notify_interrupt_observers(int interrupt);
         void initialize_cpu_and_filesystem();
         void setup_hooks();
-        void on_instruction_execution(uint64_t address);
+        bool per_instruction_accounting_{false};
+        emulator_hook* instruction_accounting_hook_{};
+        void update_instruction_accounting_hook(bool counted_run);
+        void account_instructions(uint64_t count);
         void resolve_irelative_relocations();
     };
 
@@ -0,0 +1,667 @@
+#include "std_include.hpp"
+#include "linux_epoll.hpp"
+#include "linux_process_context.hpp"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/select.h>
+#include <unistd.h>
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <sys/epoll.h>
+#endif
+#endif
+
+namespace sogen
+{
+    namespace
+    {
+        // Wake-ups only reach an instance through pushes and its own host descriptors. An instance nested in
+        // another one has its host descriptors polled on this interval while the outer one blocks, and so does
+        // an instance with host descriptors while its waiter is parked.
+        constexpr auto NESTED_EPOLL_POLL_INTERVAL = 10ms;
+
+        int to_poll_timeout(const std::chrono::milliseconds timeout)
+        {
+            if (timeout.count() < 0)
+            {
+                return -1;
+            }
+
+            return static_cast<int>(std::min<int64_t>(timeout.count(), std::numeric_limits<int>::max()));
+        }
+
+        bool host_file_has_remaining_data(FILE* handle)
+        {
+            if (!handle)
+            {
+                return false;
+            }
+
+            const auto pos = ftell(handle);
+            if (pos < 0)
+            {
+                return true;
+            }
+
+            if (fseek(handle, 0, SEEK_END) != 0)
+            {
+                return true;
+            }
+
+            const auto end = ftell(handle);
+            (void)fseek(handle, pos, SEEK_SET);
+            return end < 0 || pos < end;
+        }
+
+        bool host_fd_has_readable_data(const int fd)
+        {
+#if defined(_WIN32)
+            auto* const os_handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+            if (os_handle == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+
+            DWORD available = 0;
+            if (PeekNamedPipe(os_handle, nullptr, 0, nullptr, &available, nullptr) != 0)
+            {
+                return available > 0;
+            }
+
+            return GetLastError() == ERROR_BROKEN_PIPE;
+#else
+            if (fd < 0 || fd >= FD_SETSIZE)
+            {
+                return false;
+            }
+
+            fd_set read_fds{};
+            FD_ZERO(&read_fds);
+            FD_SET(fd, &read_fds);
+            timeval timeout{};
+            const auto result = ::select(fd + 1, &read_fds, nullptr, nullptr, &timeout);
+            return result > 0 && FD_ISSET(fd, &read_fds);
+#endif
+        }
+
+        bool host_pipe_has_readable_data(FILE* handle)
+        {
+            if (!handle)
+            {
+                return false;
+            }
+
+            return host_fd_has_readable_data(fileno(handle));
+        }
+
+        linux_epoll_instance* find_epoll_instance(linux_process_context& proc, const int fd)
+        {
+            const auto it = proc.epoll_instances.find(fd);
+            return it != proc.epoll_instances.end() ? it->second.get() : nullptr;
+        }
+
+        bool epoll_instance_has_ready_entries(linux_process_context& proc, linux_epoll_instance& instance, std::vector<int>& epoll_stack);
+
+        bool fd_has_readable_data(linux_process_context& proc, const int fd, const linux_fd& fd_entry, std::vector<int>& epoll_stack)
+        {
+            switch (fd_entry.type)
+            {
+            case fd_type::memory_file:
+                return fd_entry.memory_file && fd_entry.memory_file->offset < fd_entry.memory_file->content.size();
+            case fd_type::file:
+                return host_file_has_remaining_data(fd_entry.handle);
+            case fd_type::pipe_read:
+                return host_pipe_has_readable_data(fd_entry.handle);
+            case fd_type::socket:
+                return fd_entry.socket_state && host_fd_has_readable_data(fd_entry.socket_state->host_socket);
+            case fd_type::eventfd:
+                return fd_entry.eventfd_state && fd_entry.eventfd_state->counter > 0;
+            case fd_type::epoll:
+                break;
+            default:
+                return false;
+            }
+
+            // Epoll instances must not be nested into themselves, guard against it anyway.
+            if (std::ranges::find(epoll_stack, fd) != epoll_stack.end())
+            {
+                return false;
+            }
+
+            auto* instance = find_epoll_instance(proc, fd);
+            if (!instance)
+            {
+                return false;
+            }
+
+            epoll_stack.push_back(fd);
+            const auto has_ready_entries = epoll_instance_has_ready_entries(proc, *instance, epoll_stack);
+            epoll_stack.pop_back();
+            return has_ready_entries;
+        }
+
+        uint32_t ready_events_for_entry(linux_process_context& proc, const linux_epoll_entry& entry, std::vector<int>& epoll_stack)
+        {
+            const auto* fd_entry = proc.fds.get(entry.fd);
+            if (!fd_entry)
+            {
+                return 0;
+            }
+
+            uint32_t ready_events = 0;
+            if ((entry.events & LINUX_EPOLLIN) && fd_has_readable_data(proc, entry.fd, *fd_entry, epoll_stack))
+            {
+                ready_events |= LINUX_EPOLLIN;
+            }
+
+            if ((entry.events & LINUX_EPOLLOUT) && fd_accepts_write_ready(*fd_entry))
+            {
+                ready_events |= LINUX_EPOLLOUT;
+            }
+
+            return ready_events;
+        }
+
+        void drain_host_readiness(linux_epoll_instance& instance, const std::chrono::milliseconds timeout)
+        {
+            if (instance.host.empty())
+            {
+                return;
+            }
+
+            std::vector<int> ready{};
+            instance.host.wait(ready, timeout);
+
+            for (const auto fd : ready)
+            {
+                instance.queue(fd);
+            }
+        }
+
+        // Keeps the host registration in sync, a socket gets a new host descriptor when it connects.
+        void sync_host_registration(linux_epoll_instance& instance, const linux_epoll_entry& entry, const linux_fd& fd_entry)
+        {
+            const auto host_fd = (entry.events & LINUX_EPOLLIN) ? get_host_readable_fd(fd_entry) : -1;
+            if (host_fd >= 0)
+            {
+                instance.host.add(entry.fd, host_fd);
+            }
+            else
+            {
+                instance.host.remove(entry.fd);
+            }
+        }
+
+        bool epoll_instance_has_ready_entries(linux_process_context& proc, linux_epoll_instance& instance, std::vector<int>& epoll_stack)
+        {
+            drain_host_readiness(instance, 0ms);
+
+            return std::ranges::any_of(instance.ready_list, [&](const int fd) {
+                const auto entry = instance.entries.find(fd);
+                return entry != instance.entries.end() && ready_events_for_entry(proc, entry->second, epoll_stack) != 0;
+            });
+        }
+    }
+
+    void linux_fd_readiness::watch(const std::shared_ptr<linux_epoll_instance>& instance, const int fd)
+    {
+        for (const auto& [watcher, watched_fd] : this->watchers)
+        {
+            if (watched_fd == fd && watcher.lock() == instance)
+            {
+                return;
+            }
+        }
+
+        this->watchers.emplace_back(instance, fd);
+    }
+
+    void linux_fd_readiness::unwatch(const linux_epoll_instance& instance, const int fd)
+    {
+        std::erase_if(this->watchers, [&](const auto& watcher) {
+            const auto locked = watcher.first.lock();
+            return !locked || (locked.get() == &instance && watcher.second == fd);
+        });
+    }
+
+    void linux_fd_readiness::notify()
+    {
+        std::erase_if(this->watchers, [](const auto& watcher) { return watcher.first.expired(); });
+
+        // Queuing notifies the readiness of the epoll fd for nested instances, index instead of iterating.
+        for (size_t i = 0; i < this->watchers.size(); ++i)
+        {
+            const auto fd = this->watchers[i].second;
+            if (const auto instance = this->watchers[i].first.lock())
+            {
+                instance->queue(fd);
+            }
+        }
+    }
+
+    void linux_epoll_instance::queue(const int fd)
+    {
+        if (!this->queued.insert(fd).second)
+        {
+            return;
+        }
+
+        if (this->ready_list.empty())
+        {
+            for (auto* waiter : this->waiters)
+            {
+                waiter->epoll_recheck_ns = 0;
+            }
+        }
+
+        this->ready_list.push_back(fd);
+
+        if (const auto owner_readiness = this->owner.lock())
+        {
+            owner_readiness->notify();
+        }
+    }
+
+    linux_host_poller::~linux_host_poller()
+    {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        if (this->epoll_fd_ >= 0)
+        {
+            ::close(this->epoll_fd_);
+        }
+#endif
+    }
+
+    void linux_host_poller::add(const int guest_fd, const int host_fd)
+    {
+        const auto it = this->host_fds_.find(guest_fd);
+        if (it != this->host_fds_.end())
+        {
+            if (it->second == host_fd)
+            {
+                return;
+            }
+
+            this->remove(guest_fd);
+        }
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        if (this->epoll_fd_ < 0)
+        {
+            this->epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        }
+
+        if (this->epoll_fd_ >= 0)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = guest_fd;
+
+            if (::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, host_fd, &event) != 0 && errno == EEXIST)
+            {
+                (void)::epoll_ctl(this->epoll_fd_, EPOLL_CTL_MOD, host_fd, &event);
+            }
+        }
+#endif
+
+        this->host_fds_[guest_fd] = host_fd;
+    }
+
+    void linux_host_poller::remove(const int guest_fd)
+    {
+        const auto it = this->host_fds_.find(guest_fd);
+        if (it == this->host_fds_.end())
+        {
+            return;
+        }
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        if (this->epoll_fd_ >= 0)
+        {
+            // Fails if the descriptor was closed already, the host dropped it from the set in that case.
+            (void)::epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, it->second, nullptr);
+        }
+#endif
+
+        this->host_fds_.erase(it);
+    }
+
+    void linux_host_poller::wait(std::vector<int>& ready, const std::chrono::milliseconds timeout)
+    {
+        if (this->host_fds_.empty())
+        {
+            return;
+        }
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        if (this->epoll_fd_ < 0)
+        {
+            return;
+        }
+
+        std::array<epoll_event, 64> events{};
+        const auto count = ::epoll_wait(this->epoll_fd_, events.data(), static_cast<int>(events.size()), to_poll_timeout(timeout));
+        for (int i = 0; i < count; ++i)
+        {
+            ready.push_back(events.at(static_cast<size_t>(i)).data.fd);
+        }
+#elif defined(_WIN32)
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            for (const auto& [guest_fd, host_fd] : this->host_fds_)
+            {
+                if (host_fd_has_readable_data(host_fd))
+                {
+                    ready.push_back(guest_fd);
+                }
+            }
+
+            if (!ready.empty() || (timeout.count() >= 0 && std::chrono::steady_clock::now() >= deadline))
+            {
+                return;
+            }
+
+            // Anonymous pipes cannot be waited on for input.
+            std::this_thread::sleep_for(1ms);
+        }
+#else
+        std::vector<pollfd> fds{};
+        fds.reserve(this->host_fds_.size());
+        for (const auto& [_, host_fd] : this->host_fds_)
+        {
+            fds.push_back(pollfd{.fd = host_fd, .events = POLLIN, .revents = 0});
+        }
+
+        if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), to_poll_timeout(timeout)) <= 0)
+        {
+            return;
+        }
+
+        size_t index = 0;
+        for (const auto& [guest_fd, _] : this->host_fds_)
+        {
+            if (fds.at(index++).revents != 0)
+            {
+                ready.push_back(guest_fd);
+            }
+        }
+#endif
+    }
+
+    bool linux_host_poller::wait_any(const std::span<const int> host_fds, const std::chrono::milliseconds timeout)
+    {
+#if defined(_WIN32)
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            if (std::ranges::any_of(host_fds, host_fd_has_readable_data))
+            {
+                return true;
+            }
+
+            if (timeout.count() >= 0 && std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(1ms);
+        }
+#else
+        std::vector<pollfd> fds{};
+        fds.reserve(host_fds.size());
+        for (const auto host_fd : host_fds)
+        {
+            fds.push_back(pollfd{.fd = host_fd, .events = POLLIN, .revents = 0});
+        }
+
+        return ::poll(fds.data(), static_cast<nfds_t>(fds.size()), to_poll_timeout(timeout)) > 0;
+#endif
+    }
+
+    bool fd_has_readable_data(linux_process_context& proc, const int fd, const linux_fd& fd_entry)
+    {
+        std::vector<int> epoll_stack{};
+        return fd_has_readable_data(proc, fd, fd_entry, epoll_stack);
+    }
+
+    bool fd_accepts_write_ready(const linux_fd& fd)
+    {
+        if (fd.type == fd_type::eventfd)
+        {
+            return fd.eventfd_state && fd.eventfd_state->counter < EVENTFD_MAX_COUNTER;
+        }
+
+        return fd.type == fd_type::file || fd.type == fd_type::pipe_write || fd.type == fd_type::socket;
+    }
+
+    int get_host_readable_fd(const linux_fd& fd)
+    {
+        if (fd.type == fd_type::pipe_read && fd.handle)
+        {
+            return fileno(fd.handle);
+        }
+
+        if (fd.type == fd_type::socket && fd.socket_state)
+        {
+            return fd.socket_state->host_socket;
+        }
+
+        return -1;
+    }
+
+    void add_epoll_entry(linux_process_context& proc, const std::shared_ptr<linux_epoll_instance>& instance, const linux_epoll_entry& entry)
+    {
+        instance->entries[entry.fd] = entry;
+
+        if (auto* fd_entry = proc.fds.get(entry.fd))
+        {
+            fd_entry->readiness->watch(instance, entry.fd);
+            sync_host_registration(*instance, entry, *fd_entry);
+
+            if (fd_entry->type == fd_type::epoll)
+            {
+                instance->nested_fds.insert(entry.fd);
+            }
+        }
+
+        // Whatever state the fd is in right now was never pushed, so look at it once.
+        instance->queue(entry.fd);
+    }
+
+    void remove_epoll_entry(linux_process_context& proc, linux_epoll_instance& instance, const int fd)
+    {
+        instance.entries.erase(fd);
+        instance.host.remove(fd);
+        instance.nested_fds.erase(fd);
+
+        if (auto* fd_entry = proc.fds.get(fd))
+        {
+            fd_entry->readiness->unwatch(instance, fd);
+        }
+    }
+
+    void rearm_epoll_instances(linux_process_context& proc)
+    {
+        for (const auto& [epfd, instance] : proc.epoll_instances)
+        {
+            if (auto* epoll_fd = proc.fds.get(epfd))
+            {
+                instance->owner = epoll_fd->readiness;
+            }
+
+            const auto entries = instance->entries;
+            for (const auto& [_, entry] : entries)
+            {
+                add_epoll_entry(proc, instance, entry);
+            }
+        }
+
+        // Every entry was queued again, so parked waiters look at their instance once more.
+        for (auto& [_, thread] : proc.threads)
+        {
+            if (thread.terminated || thread.wait_state != thread_wait_state::epoll_wait)
+            {
+                continue;
+            }
+
+            if (auto* instance = find_epoll_instance(proc, thread.epoll_wait_fd))
+            {
+                instance->waiters.push_back(&thread);
+            }
+
+            thread.epoll_recheck_ns = 0;
+        }
+    }
+
+    std::vector<linux_epoll_ready_event> harvest_epoll_events(linux_process_context& proc, linux_epoll_instance& instance,
+                                                              const size_t max_events)
+    {
+        drain_host_readiness(instance, 0ms);
+
+        std::vector<linux_epoll_ready_event> events{};
+        std::vector<int> epoll_stack{};
+
+        // Every queued fd is looked at once, the ones still ready are queued again behind it. That keeps
+        // level-triggered fds reported on every wait while rotating through them when max_events is small.
+        std::vector<int> still_ready{};
+        for (auto pending = instance.ready_list.size(); pending > 0 && events.size() < max_events; --pending)
+        {
+            const auto fd = instance.ready_list.front();
+            instance.ready_list.pop_front();
+            instance.queued.erase(fd);
+            ++instance.checked_entries;
+
+            const auto entry = instance.entries.find(fd);
+            const auto* fd_entry = proc.fds.get(fd);
+            if (entry == instance.entries.end() || !fd_entry)
+            {
+                continue;
+            }
+
+            sync_host_registration(instance, entry->second, *fd_entry);
+
+            const auto ready_events = ready_events_for_entry(proc, entry->second, epoll_stack);
+            if (ready_events == 0)
+            {
+                continue;
+            }
+
+            events.push_back({.events = ready_events, .data = entry->second.data});
+            still_ready.push_back(fd);
+        }
+
+        for (const auto fd : still_ready)
+        {
+            if (instance.queued.insert(fd).second)
+            {
+                instance.ready_list.push_back(fd);
+            }
+        }
+
+        return events;
+    }
+
+    std::vector<linux_epoll_ready_event> wait_for_epoll_events(linux_process_context& proc, linux_epoll_instance& instance,
+                                                               const size_t max_events, const std::chrono::milliseconds timeout)
+    {
+        if (instance.host.empty() && instance.nested_fds.empty())
+        {
+            return {};
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (true)
+        {
+            auto slice = std::chrono::milliseconds{-1};
+            if (timeout.count() >= 0)
+            {
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                slice = std::max(remaining, std::chrono::milliseconds{0});
+            }
+
+            if (!instance.nested_fds.empty() && (slice.count() < 0 || slice > NESTED_EPOLL_POLL_INTERVAL))
+            {
+                slice = NESTED_EPOLL_POLL_INTERVAL;
+            }
+
+            drain_host_readiness(instance, slice);
+
+            auto events = harvest_epoll_events(proc, instance, max_events);
+            if (!events.empty() || (timeout.count() >= 0 && std::chrono::steady_clock::now() >= deadline))
+            {
+                return events;
+            }
+        }
+    }
+
+    void write_epoll_events(memory_interface& memory, const uint64_t address, const std::span<const linux_epoll_ready_event> events)
+    {
+        if (events.empty())
+        {
+            return;
+        }
+
+        std::vector<linux_epoll_event> guest_events{};
+        guest_events.reserve(events.size());
+        for (const auto& event : events)
+        {
+            guest_events.push_back({.events = event.events, .data = event.data});
+        }
+
+        memory.write_memory(address, guest_events.data(), guest_events.size() * sizeof(linux_epoll_event));
+    }
+
+    void add_epoll_waiter(linux_epoll_instance& instance, linux_thread& thread, const uint64_t now_ns)
+    {
+        thread.epoll_recheck_ns = thread.sleep_deadline_ns;
+        if (!instance.host.empty() || !instance.nested_fds.empty())
+        {
+            constexpr auto interval_ns = static_cast<uint64_t>(std::chrono::nanoseconds{NESTED_EPOLL_POLL_INTERVAL}.count());
+            thread.epoll_recheck_ns = std::min(thread.epoll_recheck_ns, now_ns + interval_ns);
+        }
+
+        if (std::ranges::find(instance.waiters, &thread) == instance.waiters.end())
+        {
+            instance.waiters.push_back(&thread);
+        }
+    }
+
+    void remove_epoll_waiter(linux_epoll_instance& instance, const linux_thread& thread)
+    {
+        std::erase(instance.waiters, &thread);
+    }
+
+    bool complete_parked_epoll_wait(linux_process_context& proc, memory_interface& memory, linux_thread& thread, const uint64_t now_ns)
+    {
+        auto* instance = find_epoll_instance(proc, thread.epoll_wait_fd);
+        std::vector<linux_epoll_ready_event> events{};
+
+        if (instance)
+        {
+            events = harvest_epoll_events(proc, *instance, thread.epoll_wait_max_events);
+            if (events.empty() && now_ns < thread.sleep_deadline_ns)
+            {
+                // Woken for nothing, or the poll interval passed without host input.
+                add_epoll_waiter(*instance, thread, now_ns);
+                return false;
+            }
+
+            remove_epoll_waiter(*instance, thread);
+        }
+
+        write_epoll_events(memory, thread.epoll_wait_events, events);
+
+        thread.saved_regs.rax = static_cast<uint64_t>(events.size());
+        thread.wait_state = thread_wait_state::running;
+        thread.sleep_deadline_ns = 0;
+        thread.epoll_recheck_ns = 0;
+        thread.epoll_wait_fd = -1;
+        return true;
+    }
+
+} // namespace sogen
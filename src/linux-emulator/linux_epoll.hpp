@@ -0,0 +1,152 @@
+#pragma once
+
+#include "std_include.hpp"
+#include "linux_thread.hpp"
+
+#include <memory_interface.hpp>
+
+namespace sogen
+{
+
+    struct linux_fd;
+    struct linux_epoll_instance;
+    struct linux_process_context;
+
+    constexpr int LINUX_EPOLL_CTL_ADD = 1;
+    constexpr int LINUX_EPOLL_CTL_DEL = 2;
+    constexpr int LINUX_EPOLL_CTL_MOD = 3;
+
+    constexpr uint32_t LINUX_EPOLLIN = 0x001;
+    constexpr uint32_t LINUX_EPOLLOUT = 0x004;
+
+    constexpr uint64_t EVENTFD_MAX_COUNTER = 0xFFFFFFFFFFFFFFFE;
+
+#pragma pack(push, 1)
+
+    // Guest struct epoll_event, packed on x86-64.
+    struct linux_epoll_event
+    {
+        uint32_t events;
+        uint64_t data;
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(linux_epoll_event) == 12);
+
+    // Epoll instances watching one open file description. Duplicated fds and both ends of a pipe share it, so
+    // anything inside the emulator that changes the description's readiness only has to call notify().
+    struct linux_fd_readiness
+    {
+        std::vector<std::pair<std::weak_ptr<linux_epoll_instance>, int>> watchers{};
+
+        void watch(const std::shared_ptr<linux_epoll_instance>& instance, int fd);
+        void unwatch(const linux_epoll_instance& instance, int fd);
+        void notify();
+    };
+
+    // Host descriptors whose readiness only the host kernel knows about: pipes and sockets fed from outside
+    // the emulator. Backed by a host epoll instance on Linux and by poll() on other hosts.
+    class linux_host_poller
+    {
+      public:
+        linux_host_poller() = default;
+        ~linux_host_poller();
+
+        linux_host_poller(const linux_host_poller&) = delete;
+        linux_host_poller& operator=(const linux_host_poller&) = delete;
+        linux_host_poller(linux_host_poller&&) = delete;
+        linux_host_poller& operator=(linux_host_poller&&) = delete;
+
+        void add(int guest_fd, int host_fd);
+        void remove(int guest_fd);
+
+        bool empty() const
+        {
+            return this->host_fds_.empty();
+        }
+
+        // Appends the guest fds whose host descriptor is readable, blocking up to timeout (negative waits forever).
+        void wait(std::vector<int>& ready, std::chrono::milliseconds timeout);
+
+        static bool wait_any(std::span<const int> host_fds, std::chrono::milliseconds timeout);
+
+      private:
+        std::map<int, int> host_fds_{};
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        int epoll_fd_{-1};
+#endif
+    };
+
+    struct linux_epoll_entry
+    {
+        int fd{};
+        uint32_t events{};
+        uint64_t data{};
+    };
+
+    struct linux_epoll_instance
+    {
+        std::map<int, linux_epoll_entry> entries{};
+
+        // Registered fds that may have pending events, each queued at most once. Waits only look at this list
+        // and re-check every entry they take from it, so a spurious push costs one check and nothing else.
+        std::deque<int> ready_list{};
+        std::unordered_set<int> queued{};
+
+        linux_host_poller host{};
+        std::set<int> nested_fds{};
+
+        // Readiness of the epoll fd itself, so an instance registered in another one can wake it.
+        std::weak_ptr<linux_fd_readiness> owner{};
+
+        // Threads parked in epoll_wait on this instance. The ready list going from empty to non-empty makes
+        // them runnable, so the scheduler only has to compare deadlines. Rebuilt after a snapshot was loaded.
+        std::vector<linux_thread*> waiters{};
+
+        // Ready list entries looked at by harvests so far.
+        uint64_t checked_entries{};
+
+        void queue(int fd);
+    };
+
+    struct linux_epoll_ready_event
+    {
+        uint32_t events{};
+        uint64_t data{};
+    };
+
+    bool fd_has_readable_data(linux_process_context& proc, int fd, const linux_fd& fd_entry);
+    bool fd_accepts_write_ready(const linux_fd& fd);
+
+    // Host descriptor to wait on for input, or -1 if only the emulator itself can make the fd readable.
+    int get_host_readable_fd(const linux_fd& fd);
+
+    void add_epoll_entry(linux_process_context& proc, const std::shared_ptr<linux_epoll_instance>& instance,
+                         const linux_epoll_entry& entry);
+    void remove_epoll_entry(linux_process_context& proc, linux_epoll_instance& instance, int fd);
+
+    // Registers the restored entries of every instance again after a snapshot was loaded.
+    void rearm_epoll_instances(linux_process_context& proc);
+
+    // Takes up to max_events events off the ready list. Costs O(queued entries), not O(registered entries).
+    std::vector<linux_epoll_ready_event> harvest_epoll_events(linux_process_context& proc, linux_epoll_instance& instance,
+                                                              size_t max_events);
+
+    // Blocks the host thread until a host descriptor makes an entry ready or the timeout passes. Only useful
+    // when no other guest thread can run, as nothing else could push an event meanwhile.
+    std::vector<linux_epoll_ready_event> wait_for_epoll_events(linux_process_context& proc, linux_epoll_instance& instance,
+                                                               size_t max_events, std::chrono::milliseconds timeout);
+
+    void write_epoll_events(memory_interface& memory, uint64_t address, std::span<const linux_epoll_ready_event> events);
+
+    // Registers a thread parked in epoll_wait with the instance and sets when the scheduler looks at it next:
+    // its deadline, or the poll interval if only polling can notice host or nested readiness.
+    void add_epoll_waiter(linux_epoll_instance& instance, linux_thread& thread, uint64_t now_ns);
+    void remove_epoll_waiter(linux_epoll_instance& instance, const linux_thread& thread);
+
+    // Finishes the epoll_wait of a parked thread once the instance woke it or its deadline passed, writing the
+    // result into its saved registers. Returns false while the thread has to keep waiting.
+    bool complete_parked_epoll_wait(linux_process_context& proc, memory_interface& memory, linux_thread& thread, uint64_t now_ns);
+
+} // namespace sogen
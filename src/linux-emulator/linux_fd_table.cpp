@@ -213,6 +213,12 @@ namespace sogen
                 buffer.write(fd.memory_file->content);
                 buffer.write<uint64_t>(fd.memory_file->offset);
             }
+            else if (fd.type == fd_type::eventfd)
+            {
+                const auto state = fd.eventfd_state ? *fd.eventfd_state : linux_eventfd_state{};
+                buffer.write(state.counter);
+                buffer.write(state.semaphore);
+            }
             else
             {
                 buffer.write<int64_t>(tell_or_zero(fd.handle, fd.host_path));
@@ -247,6 +253,12 @@ namespace sogen
                         throw std::runtime_error("Linux fd snapshot has an invalid memory file offset");
                     }
                 }
+                else if (fd.type == fd_type::eventfd)
+                {
+                    fd.eventfd_state = std::make_shared<linux_eventfd_state>();
+                    buffer.read(fd.eventfd_state->counter);
+                    buffer.read(fd.eventfd_state->semaphore);
+                }
                 else
                 {
                     const auto offset = buffer.read<int64_t>();
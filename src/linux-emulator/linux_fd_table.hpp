@@ -1,6 +1,7 @@
 #pragma once
 
 #include "std_include.hpp"
+#include "linux_epoll.hpp"
 
 #include <cstdio>
 #include <memory>
@@ -34,6 +35,12 @@ namespace sogen
         size_t offset{};
     };
 
+    struct linux_eventfd_state
+    {
+        uint64_t counter{};
+        bool semaphore{};
+    };
+
     struct linux_socket_state
     {
         int domain{};
@@ -82,6 +89,8 @@ namespace sogen
         bool read_only_mapping{};
 
         std::shared_ptr<linux_socket_state> socket_state{};
+        std::shared_ptr<linux_eventfd_state> eventfd_state{};
+        std::shared_ptr<linux_fd_readiness> readiness{std::make_shared<linux_fd_readiness>()};
 
         ~linux_fd() = default;
         linux_fd() = default;
@@ -98,7 +107,9 @@ namespace sogen
               flags(other.flags),
               close_on_exec(other.close_on_exec),
               read_only_mapping(other.read_only_mapping),
-              socket_state(std::move(other.socket_state))
+              socket_state(std::move(other.socket_state)),
+              eventfd_state(std::move(other.eventfd_state)),
+              readiness(std::move(other.readiness))
         {
         }
 
@@ -115,6 +126,8 @@ namespace sogen
                 close_on_exec = other.close_on_exec;
                 read_only_mapping = other.read_only_mapping;
                 socket_state = std::move(other.socket_state);
+                eventfd_state = std::move(other.eventfd_state);
+                readiness = std::move(other.readiness);
             }
             return *this;
         }
@@ -337,6 +350,8 @@ namespace sogen
             new_entry.handle = duplicate_handle(existing.handle, get_stream_mode(existing));
             new_entry.memory_file = existing.memory_file;
             new_entry.socket_state = existing.socket_state;
+            new_entry.eventfd_state = existing.eventfd_state;
+            new_entry.readiness = existing.readiness;
             if (existing.handle && !new_entry.handle)
             {
                 return std::nullopt;
@@ -2,6 +2,7 @@
 #include "linux_memory_manager.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 
 namespace sogen
@@ -84,16 +85,194 @@ namespace sogen
         this->mapped_regions_.clear();
 
         auto data_it = region_data.begin();
-        for (const auto& [base, region] : new_regions)
+        for (auto& [base, region] : new_regions)
         {
             this->map_memory(base, region.length, region.permissions);
             this->write_memory(base, data_it->data(), region.length);
+            region.mapping_generation = ++this->next_mapping_generation_;
             ++data_it;
         }
 
         this->mapped_regions_ = std::move(new_regions);
     }
 
+    void linux_memory_manager::save_snapshot()
+    {
+        auto snapshot = std::make_unique<memory_snapshot>();
+        snapshot->regions = this->mapped_regions_;
+        snapshot->mmap_base = this->mmap_base_;
+
+        for (const auto& [base, region] : this->mapped_regions_)
+        {
+            auto& data = snapshot->data[base];
+            data.resize(region.length);
+            this->read_memory(base, data.data(), region.length);
+        }
+
+        this->snapshot_ = std::move(snapshot);
+
+        if (this->memory_->supports_dirty_page_tracking())
+        {
+            this->memory_->start_dirty_page_tracking();
+        }
+    }
+
+    linux_memory_manager::snapshot_restore_stats linux_memory_manager::restore_snapshot()
+    {
+        if (!this->snapshot_)
+        {
+            throw std::runtime_error("No memory snapshot saved");
+        }
+
+        const auto& snapshot = *this->snapshot_;
+        snapshot_restore_stats stats{};
+
+        // Collected before anything below writes guest memory itself.
+        const auto use_dirty_log = this->memory_->supports_dirty_page_tracking();
+        const auto dirty_pages = use_dirty_log ? this->memory_->collect_dirty_pages() : std::vector<uint64_t>{};
+
+        this->mmap_base_ = snapshot.mmap_base;
+
+        // A region still carrying the snapshot's mapping generation at the same extent holds the captured
+        // pages, only its written pages and its protection need restoring. Everything else is unmapped.
+        for (auto i = this->mapped_regions_.begin(); i != this->mapped_regions_.end();)
+        {
+            const auto& [base, region] = *i;
+            const auto snapshot_entry = snapshot.regions.find(base);
+
+            if (snapshot_entry != snapshot.regions.end() && snapshot_entry->second.length == region.length &&
+                snapshot_entry->second.mapping_generation == region.mapping_generation)
+            {
+                ++i;
+                continue;
+            }
+
+            this->unmap_memory(base, region.length);
+            i = this->mapped_regions_.erase(i);
+        }
+
+        for (auto& [base, region] : this->mapped_regions_)
+        {
+            const auto& snapshot_region = snapshot.regions.at(base);
+            if (region.permissions != snapshot_region.permissions)
+            {
+                this->apply_memory_protection(base, region.length, snapshot_region.permissions);
+                region.permissions = snapshot_region.permissions;
+            }
+
+            if (!use_dirty_log)
+            {
+                stats.restored_pages += this->restore_changed_snapshot_pages(base, snapshot.data.at(base));
+            }
+        }
+
+        if (use_dirty_log)
+        {
+            stats.restored_pages += this->restore_snapshot_pages(dirty_pages);
+        }
+
+        for (const auto& [base, region] : snapshot.regions)
+        {
+            if (this->mapped_regions_.contains(base))
+            {
+                continue;
+            }
+
+            const auto& data = snapshot.data.at(base);
+            this->map_memory(base, region.length, region.permissions);
+            this->write_memory(base, data.data(), data.size());
+            this->mapped_regions_.emplace(base, region);
+            ++stats.remapped_regions;
+        }
+
+        if (use_dirty_log)
+        {
+            this->memory_->start_dirty_page_tracking();
+        }
+
+        return stats;
+    }
+
+    size_t linux_memory_manager::restore_snapshot_pages(const std::vector<uint64_t>& pages)
+    {
+        const auto& snapshot = *this->snapshot_;
+        size_t restored_pages = 0;
+
+        for (const auto page : pages)
+        {
+            // Pages of remapped regions were already rewritten in full; regions mapped after the snapshot are gone.
+            auto entry = snapshot.regions.upper_bound(page);
+            if (entry == snapshot.regions.begin())
+            {
+                continue;
+            }
+
+            --entry;
+            const auto offset = page - entry->first;
+            if (offset >= entry->second.length || !this->mapped_regions_.contains(entry->first))
+            {
+                continue;
+            }
+
+            const auto& data = snapshot.data.at(entry->first);
+            const auto length = std::min<size_t>(LINUX_PAGE_SIZE, static_cast<size_t>(data.size() - offset));
+            this->write_memory(page, data.data() + offset, length);
+            ++restored_pages;
+        }
+
+        return restored_pages;
+    }
+
+    size_t linux_memory_manager::restore_changed_snapshot_pages(const uint64_t address, const std::vector<std::byte>& data)
+    {
+        // Fallback for backends without a dirty-page log: every page is read back and compared, runs of
+        // changed pages are written back with one call each.
+        constexpr size_t chunk_size = 0x100000;
+
+        std::vector<std::byte> current{};
+        size_t restored_pages = 0;
+
+        for (size_t chunk_offset = 0; chunk_offset < data.size(); chunk_offset += chunk_size)
+        {
+            const auto length = std::min(chunk_size, data.size() - chunk_offset);
+            current.resize(length);
+            this->read_memory(address + chunk_offset, current.data(), length);
+
+            size_t run_start = 0;
+            size_t run_length = 0;
+
+            const auto flush_run = [&] {
+                if (run_length > 0)
+                {
+                    this->write_memory(address + chunk_offset + run_start, data.data() + chunk_offset + run_start, run_length);
+                    run_length = 0;
+                }
+            };
+
+            for (size_t offset = 0; offset < length; offset += LINUX_PAGE_SIZE)
+            {
+                const auto page_length = std::min<size_t>(LINUX_PAGE_SIZE, length - offset);
+                if (std::memcmp(current.data() + offset, data.data() + chunk_offset + offset, page_length) == 0)
+                {
+                    flush_run();
+                    continue;
+                }
+
+                if (run_length == 0)
+                {
+                    run_start = offset;
+                }
+
+                run_length += page_length;
+                ++restored_pages;
+            }
+
+            flush_run();
+        }
+
+        return restored_pages;
+    }
+
     bool linux_memory_manager::allocate_memory(const uint64_t address, const size_t size, const memory_permission permissions)
     {
         if (this->overlaps_mapped_region(address, size))
@@ -102,7 +281,8 @@ namespace sogen
         }
 
         this->map_memory(address, size, permissions);
-        this->mapped_regions_[address] = mapped_region{.length = size, .permissions = permissions};
+        this->mapped_regions_[address] =
+            mapped_region{.length = size, .permissions = permissions, .mapping_generation = ++this->next_mapping_generation_};
         this->notify_memory_allocate(address, size, permissions, true);
 
         return true;
@@ -186,7 +366,8 @@ namespace sogen
             if (base < prot_start)
             {
                 const auto before_len = static_cast<size_t>(prot_start - base);
-                to_add.push_back({base, {.length = before_len, .permissions = region.permissions}});
+                to_add.push_back(
+                    {base, {.length = before_len, .permissions = region.permissions, .mapping_generation = region.mapping_generation}});
             }
 
             // The protected part
@@ -194,14 +375,16 @@ namespace sogen
             const auto overlap_end = std::min(region_end, prot_end);
             const auto overlap_len = static_cast<size_t>(overlap_end - overlap_start);
             this->apply_memory_protection(overlap_start, overlap_len, permissions);
-            to_add.push_back({overlap_start, {.length = overlap_len, .permissions = permissions}});
+            to_add.push_back(
+                {overlap_start, {.length = overlap_len, .permissions = permissions, .mapping_generation = region.mapping_generation}});
             changed = true;
 
             // Part after the protected range
             if (region_end > prot_end)
             {
                 const auto after_len = static_cast<size_t>(region_end - prot_end);
-                to_add.push_back({prot_end, {.length = after_len, .permissions = region.permissions}});
+                to_add.push_back(
+                    {prot_end, {.length = after_len, .permissions = region.permissions, .mapping_generation = region.mapping_generation}});
             }
         }
 
@@ -264,15 +447,17 @@ namespace sogen
             // Region extends before the unmapped range — keep the prefix
             if (base < aligned_start)
             {
-                const auto before_len = static_cast<size_t>(aligned_start - base);
-                to_add.push_back({base, {.length = before_len, .permissions = region.permissions}});
+                auto prefix = region;
+                prefix.length = static_cast<size_t>(aligned_start - base);
+                to_add.push_back({base, prefix});
             }
 
             // Region extends after the unmapped range — keep the suffix
             if (region_end > aligned_end)
             {
-                const auto after_len = static_cast<size_t>(region_end - aligned_end);
-                to_add.push_back({aligned_end, {.length = after_len, .permissions = region.permissions}});
+                auto suffix = region;
+                suffix.length = static_cast<size_t>(region_end - aligned_end);
+                to_add.push_back({aligned_end, suffix});
             }
 
             // Unmap the overlapping portion
@@ -495,6 +680,16 @@ namespace sogen
         }
     }
 
+    std::span<const std::byte> linux_memory_manager::get_host_span(const uint64_t address, const size_t size) const
+    {
+        return this->memory_->get_host_span(address, size);
+    }
+
+    std::span<std::byte> linux_memory_manager::get_writable_host_span(const uint64_t address, const size_t size)
+    {
+        return this->memory_->get_writable_host_span(address, size);
+    }
+
     void linux_memory_manager::map_memory(const uint64_t address, const size_t size, const memory_permission permissions)
     {
         this->memory_->map_memory(address, size, permissions);
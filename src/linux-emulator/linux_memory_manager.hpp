@@ -4,6 +4,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <atomic>
 #include <cstdint>
 #include <optional>
@@ -66,15 +67,36 @@ namespace sogen
         {
             size_t length{};
             memory_permission permissions{};
+
+            // Runtime-only stamp, renewed whenever the region is mapped. Pieces split off by mprotect or a
+            // partial munmap keep it, so an entry equal to a snapshot entry still holds the captured pages.
+            // Not serialized.
+            uint64_t mapping_generation{};
         };
 
         using mapped_region_map = std::map<uint64_t, mapped_region>;
 
+        // Mapped regions and their contents, the restore point of save_snapshot.
+        struct memory_snapshot
+        {
+            mapped_region_map regions{};
+            std::map<uint64_t, std::vector<std::byte>> data{};
+            uint64_t mmap_base{};
+        };
+
+        struct snapshot_restore_stats
+        {
+            size_t restored_pages{};
+            size_t remapped_regions{};
+        };
+
         // memory_interface
         void read_memory(uint64_t address, void* data, size_t size) const override;
         bool try_read_memory(uint64_t address, void* data, size_t size) const override;
         void write_memory(uint64_t address, const void* data, size_t size) override;
         bool try_write_memory(uint64_t address, const void* data, size_t size) override;
+        std::span<const std::byte> get_host_span(uint64_t address, size_t size) const override;
+        std::span<std::byte> get_writable_host_span(uint64_t address, size_t size) override;
 
         // Allocate and map a region
         bool allocate_memory(uint64_t address, size_t size, memory_permission permissions);
@@ -126,10 +148,23 @@ namespace sogen
         void serialize_memory_state(utils::buffer_serializer& buffer) const;
         void deserialize_memory_state(utils::buffer_deserializer& buffer);
 
+        // In-memory snapshot for fast reset loops (fuzzing, replay). restore_snapshot only rewrites pages
+        // written since the snapshot - taken from the backend's dirty-page log when it has one, otherwise
+        // found by comparing page contents - and only remaps regions the guest mapped, unmapped or split.
+        void save_snapshot();
+        snapshot_restore_stats restore_snapshot();
+
+        bool has_snapshot() const
+        {
+            return this->snapshot_ != nullptr;
+        }
+
       private:
         memory_interface* memory_{};
         mapped_region_map mapped_regions_{};
         uint64_t mmap_base_{LINUX_DEFAULT_MMAP_BASE};
+        uint64_t next_mapping_generation_{0};
+        std::unique_ptr<memory_snapshot> snapshot_{};
         uint64_t next_memory_callback_id_{1};
         std::vector<std::pair<uint64_t, memory_allocate_callback>> memory_allocate_callbacks_{};
         std::vector<std::pair<uint64_t, memory_protect_callback>> memory_protect_callbacks_{};
@@ -139,6 +174,9 @@ namespace sogen
         void notify_memory_protect(uint64_t address, size_t size, memory_permission permissions);
         void notify_memory_release(uint64_t address, size_t size);
 
+        size_t restore_snapshot_pages(const std::vector<uint64_t>& pages);
+        size_t restore_changed_snapshot_pages(uint64_t address, const std::vector<std::byte>& data);
+
         void map_memory(uint64_t address, size_t size, memory_permission permissions) override;
         void unmap_memory(uint64_t address, size_t size) override;
         void apply_memory_protection(uint64_t address, size_t size, memory_permission permissions) override;
@@ -29,12 +29,23 @@ namespace sogen
 
         static void serialize(buffer_serializer& buffer, const linux_epoll_instance& instance)
         {
-            buffer.write_vector(instance.entries);
+            std::vector<linux_epoll_entry> entries{};
+            entries.reserve(instance.entries.size());
+            for (const auto& [_, entry] : instance.entries)
+            {
+                entries.push_back(entry);
+            }
+
+            buffer.write_vector(entries);
         }
 
         static void deserialize(buffer_deserializer& buffer, linux_epoll_instance& instance)
         {
-            buffer.read_vector(instance.entries);
+            const auto entries = buffer.read_vector<linux_epoll_entry>();
+            for (const auto& entry : entries)
+            {
+                instance.entries[entry.fd] = entry;
+            }
         }
     }
 
@@ -476,6 +487,8 @@ namespace sogen
         this->argv = std::move(new_argv);
         this->envp = std::move(new_envp);
         this->auxv = std::move(new_auxv);
+
+        rearm_epoll_instances(*this);
     }
 
 } // namespace sogen
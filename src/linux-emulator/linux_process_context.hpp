@@ -24,18 +24,6 @@ namespace sogen
         std::string name{};
     };
 
-    struct linux_epoll_entry
-    {
-        int fd{};
-        uint32_t events{};
-        uint64_t data{};
-    };
-
-    struct linux_epoll_instance
-    {
-        std::vector<linux_epoll_entry> entries{};
-    };
-
     struct linux_process_context
     {
         linux_fd_table fds{};
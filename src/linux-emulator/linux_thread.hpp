@@ -36,6 +36,7 @@ namespace sogen
         running,    // Thread is runnable
         futex_wait, // Blocked on FUTEX_WAIT — waiting for a wake on futex_wait_address
         sleeping,   // Blocked on nanosleep/clock_nanosleep — waiting until sleep_deadline
+        epoll_wait, // Blocked on epoll_wait — waiting for an event on epoll_wait_fd or sleep_deadline
     };
 
     struct linux_thread
@@ -62,7 +63,11 @@ namespace sogen
         uint64_t futex_wait_address{};          // Address being waited on (for futex_wait state)
         uint32_t futex_wait_val{};              // Expected value at the futex address
         uint32_t futex_wait_bitset{0xFFFFFFFF}; // Bitset mask for FUTEX_WAIT_BITSET
-        uint64_t sleep_deadline_ns{};           // Absolute nanosecond deadline (for sleeping state)
+        uint64_t sleep_deadline_ns{};           // Absolute nanosecond deadline (for sleeping and epoll_wait states)
+        int epoll_wait_fd{-1};                  // Epoll instance being waited on (for epoll_wait state)
+        uint64_t epoll_wait_events{};           // Guest epoll_event array receiving the result
+        uint32_t epoll_wait_max_events{};       // Capacity of that array
+        uint64_t epoll_recheck_ns{};            // When the scheduler looks at the epoll instance next, reset on a wake-up
 
         linux_saved_registers saved_regs{};
 
@@ -85,6 +90,10 @@ namespace sogen
                 // Ready if the sleep deadline has passed
                 return current_time_ns >= this->sleep_deadline_ns;
 
+            case thread_wait_state::epoll_wait:
+                // The instance resets the recheck time once an event is queued, the scheduler then harvests it.
+                return current_time_ns >= this->epoll_recheck_ns;
+
             case thread_wait_state::futex_wait:
                 // Futex readiness is checked externally by reading the memory value.
                 // The scheduler should call check_futex_ready() with the memory interface.
@@ -3,6 +3,7 @@
 #include "../linux_syscall_dispatcher.hpp"
 #include "../linux_stat.hpp"
 #include "../procfs.hpp"
+#include "../linux_epoll.hpp"
 
 #include <algorithm>
 #include <cerrno>
@@ -46,6 +47,60 @@ namespace sogen
         constexpr int LINUX_O_DIRECTORY = 0200000;
         constexpr int LINUX_O_CLOEXEC = 02000000;
 
+        // The counter is transferred as a single 8 byte value. There is no thread to wait for here, so reads of
+        // an empty counter and writes that would overflow it fail with EAGAIN even on blocking eventfds.
+        int64_t read_eventfd(const linux_syscall_context& c, linux_fd& fd_entry, const uint64_t buf_addr, const size_t count)
+        {
+            auto& state = *fd_entry.eventfd_state;
+            if (count < sizeof(uint64_t))
+            {
+                return -LINUX_EINVAL;
+            }
+
+            if (state.counter == 0)
+            {
+                return -LINUX_EAGAIN;
+            }
+
+            const uint64_t value = state.semaphore ? 1 : state.counter;
+            state.counter -= value;
+            c.emu.write_memory(buf_addr, &value, sizeof(value));
+
+            // Room for writers again.
+            fd_entry.readiness->notify();
+            return sizeof(value);
+        }
+
+        int64_t write_eventfd(const linux_syscall_context& c, linux_fd& fd_entry, const uint64_t buf_addr, const size_t count)
+        {
+            auto& state = *fd_entry.eventfd_state;
+            if (count < sizeof(uint64_t))
+            {
+                return -LINUX_EINVAL;
+            }
+
+            uint64_t value{};
+            c.emu.read_memory(buf_addr, &value, sizeof(value));
+
+            if (value == std::numeric_limits<uint64_t>::max())
+            {
+                return -LINUX_EINVAL;
+            }
+
+            if (value > EVENTFD_MAX_COUNTER - state.counter)
+            {
+                return -LINUX_EAGAIN;
+            }
+
+            state.counter += value;
+            if (value != 0)
+            {
+                fd_entry.readiness->notify();
+            }
+
+            return sizeof(value);
+        }
+
         int64_t host_read_fd(const int fd, void* buffer, const size_t count)
         {
 #if defined(_WIN32)
@@ -306,9 +361,10 @@ namespace sogen
                 }
 
                 cleaned_instances.push_back(instance.get());
-                auto& entries = instance->entries;
-                entries.erase(std::ranges::remove_if(entries, [fd](const linux_epoll_entry& entry) { return entry.fd == fd; }).begin(),
-                              entries.end());
+                if (instance->entries.contains(fd))
+                {
+                    remove_epoll_entry(proc, *instance, fd);
+                }
             }
         }
 
@@ -778,6 +834,12 @@ namespace sogen
             return;
         }
 
+        if (fd_entry->type == fd_type::eventfd && fd_entry->eventfd_state)
+        {
+            write_linux_syscall_result(c, read_eventfd(c, *fd_entry, buf_addr, count));
+            return;
+        }
+
         if (!fd_allows_read(*fd_entry))
         {
             write_linux_syscall_result(c, -LINUX_EBADF);
@@ -883,6 +945,12 @@ namespace sogen
             return;
         }
 
+        if (fd_entry->type == fd_type::eventfd && fd_entry->eventfd_state)
+        {
+            write_linux_syscall_result(c, write_eventfd(c, *fd_entry, buf_addr, count));
+            return;
+        }
+
         std::vector<uint8_t> buffer(count);
         c.emu.read_memory(buf_addr, buffer.data(), count);
 
@@ -930,6 +998,8 @@ namespace sogen
                 return;
             }
 
+            // Shared with the read end, whose watchers can pick up the data now.
+            fd_entry->readiness->notify();
             write_linux_syscall_result(c, written);
             return;
         }
@@ -1122,6 +1192,7 @@ namespace sogen
             }
 
             const auto pos = seek_memory_file(*fd_entry, offset, whence);
+            fd_entry->readiness->notify();
             write_linux_syscall_result(c, pos.has_value() ? static_cast<int64_t>(*pos) : -LINUX_EINVAL);
             return;
         }
@@ -1,15 +1,14 @@
 #include "../std_include.hpp"
 #include "../linux_emulator.hpp"
 #include "../linux_syscall_dispatcher.hpp"
+#include "../linux_epoll.hpp"
 
 #include <array>
 #include <algorithm>
 #include <fcntl.h>
 #if defined(_WIN32)
 #include <io.h>
-#include <windows.h>
 #else
-#include <sys/select.h>
 #include <unistd.h>
 #endif
 
@@ -22,17 +21,103 @@ namespace sogen
 
     namespace
     {
-        constexpr int EPOLL_CTL_ADD = 1;
-        constexpr int EPOLL_CTL_DEL = 2;
-        constexpr int EPOLL_CTL_MOD = 3;
-
-        constexpr uint32_t EPOLLIN = 0x001;
-        constexpr uint32_t EPOLLOUT = 0x004;
-
         constexpr int16_t POLLIN = 0x0001;
         constexpr int16_t POLLOUT = 0x0004;
         constexpr int16_t POLLNVAL = 0x0020;
 
+        constexpr int LINUX_O_CLOEXEC = 02000000;
+        constexpr int LINUX_O_NONBLOCK = 04000;
+        constexpr int LINUX_EFD_SEMAPHORE = 1;
+
+#pragma pack(push, 1)
+
+        struct linux_pollfd
+        {
+            int32_t fd;
+            int16_t events;
+            int16_t revents;
+        };
+
+#pragma pack(pop)
+
+        static_assert(sizeof(linux_pollfd) == 8);
+
+        struct linux_timespec
+        {
+            int64_t tv_sec;
+            int64_t tv_nsec;
+        };
+
+        uint64_t current_time_ns()
+        {
+            const auto now = std::chrono::system_clock::now().time_since_epoch();
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        }
+
+        // Converts a guest timespec (or timeval, when sub_second_unit is microseconds) to a timeout, a null
+        // pointer waits forever.
+        std::chrono::milliseconds read_guest_timeout(x86_64_emulator& emu, const uint64_t address,
+                                                     const std::chrono::nanoseconds sub_second_unit = 1ns)
+        {
+            if (address == 0)
+            {
+                return std::chrono::milliseconds{-1};
+            }
+
+            linux_timespec value{};
+            emu.read_memory(address, &value, sizeof(value));
+
+            const auto timeout =
+                std::chrono::seconds{std::max<int64_t>(value.tv_sec, 0)} + sub_second_unit * std::max<int64_t>(value.tv_nsec, 0);
+            return std::chrono::ceil<std::chrono::milliseconds>(timeout);
+        }
+
+        int create_eventfd(const linux_syscall_context& c, const uint64_t initial_value, const int flags)
+        {
+            linux_fd efd{};
+            efd.type = fd_type::eventfd;
+            efd.close_on_exec = (flags & LINUX_O_CLOEXEC) != 0;
+            efd.flags = flags & LINUX_O_NONBLOCK;
+            efd.eventfd_state = std::make_shared<linux_eventfd_state>();
+            efd.eventfd_state->counter = initial_value;
+            efd.eventfd_state->semaphore = (flags & LINUX_EFD_SEMAPHORE) != 0;
+
+            return c.proc.fds.allocate(std::move(efd));
+        }
+
+        // Parks the calling thread if another thread can run meanwhile, that one may produce the awaited event.
+        // The instance makes the thread runnable once an event gets queued on it, otherwise it waits for its deadline.
+        bool park_epoll_wait(const linux_syscall_context& c, linux_epoll_instance& instance, const int epfd, const uint64_t events_addr,
+                             const int max_events, const int timeout)
+        {
+            auto* thread = c.proc.active_thread;
+            if (!thread)
+            {
+                return false;
+            }
+
+            thread->wait_state = thread_wait_state::epoll_wait;
+            thread->epoll_wait_fd = epfd;
+            thread->epoll_wait_events = events_addr;
+            thread->epoll_wait_max_events = static_cast<uint32_t>(max_events);
+            const auto now = current_time_ns();
+            thread->sleep_deadline_ns =
+                timeout < 0 ? std::numeric_limits<uint64_t>::max() : now + static_cast<uint64_t>(timeout) * 1'000'000;
+            add_epoll_waiter(instance, *thread, now);
+
+            if (c.emu_ref.perform_thread_switch())
+            {
+                return true;
+            }
+
+            remove_epoll_waiter(instance, *thread);
+            thread->wait_state = thread_wait_state::running;
+            thread->epoll_wait_fd = -1;
+            thread->sleep_deadline_ns = 0;
+            thread->epoll_recheck_ns = 0;
+            return false;
+        }
+
         int host_create_pipe(std::array<int, 2>& pipefd)
         {
 #if defined(_WIN32)
@@ -83,143 +168,6 @@ namespace sogen
             }
 #endif
         }
-
-        bool host_file_has_remaining_data(FILE* handle)
-        {
-            if (!handle)
-            {
-                return false;
-            }
-
-            const auto pos = ftell(handle);
-            if (pos < 0)
-            {
-                return true;
-            }
-
-            if (fseek(handle, 0, SEEK_END) != 0)
-            {
-                return true;
-            }
-
-            const auto end = ftell(handle);
-            (void)fseek(handle, pos, SEEK_SET);
-            return end < 0 || pos < end;
-        }
-
-        bool host_pipe_has_readable_data(FILE* handle)
-        {
-            if (!handle)
-            {
-                return false;
-            }
-
-#if defined(_WIN32)
-            auto* const os_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(handle)));
-            if (os_handle == INVALID_HANDLE_VALUE)
-            {
-                return false;
-            }
-
-            DWORD available = 0;
-            if (PeekNamedPipe(os_handle, nullptr, 0, nullptr, &available, nullptr) != 0)
-            {
-                return available > 0;
-            }
-
-            return GetLastError() == ERROR_BROKEN_PIPE;
-#else
-            const auto fd = fileno(handle);
-            if (fd < 0 || fd >= FD_SETSIZE)
-            {
-                return false;
-            }
-
-            fd_set read_fds{};
-            FD_ZERO(&read_fds);
-            FD_SET(fd, &read_fds);
-            timeval timeout{};
-            const auto result = ::select(fd + 1, &read_fds, nullptr, nullptr, &timeout);
-            return result > 0 && FD_ISSET(fd, &read_fds);
-#endif
-        }
-
-        bool epoll_instance_has_ready_entries(linux_process_context& proc, const linux_epoll_instance& instance,
-                                              std::vector<int>& epoll_stack);
-
-        bool fd_has_readable_data(linux_process_context& proc, const int fd, const linux_fd& fd_entry, std::vector<int>& epoll_stack)
-        {
-            if (fd_entry.type == fd_type::memory_file)
-            {
-                return fd_entry.memory_file && fd_entry.memory_file->offset < fd_entry.memory_file->content.size();
-            }
-
-            if (fd_entry.type == fd_type::file)
-            {
-                return host_file_has_remaining_data(fd_entry.handle);
-            }
-
-            if (fd_entry.type == fd_type::pipe_read)
-            {
-                return host_pipe_has_readable_data(fd_entry.handle);
-            }
-
-            if (fd_entry.type != fd_type::epoll)
-            {
-                return false;
-            }
-
-            if (std::ranges::find(epoll_stack, fd) != epoll_stack.end())
-            {
-                return false;
-            }
-
-            auto it = proc.epoll_instances.find(fd);
-            if (it == proc.epoll_instances.end() || !it->second)
-            {
-                return false;
-            }
-
-            epoll_stack.push_back(fd);
-            const auto has_ready_entries = epoll_instance_has_ready_entries(proc, *it->second, epoll_stack);
-            epoll_stack.pop_back();
-            return has_ready_entries;
-        }
-
-        bool fd_accepts_write_ready(const linux_fd& fd)
-        {
-            return fd.type == fd_type::file || fd.type == fd_type::pipe_write || fd.type == fd_type::socket;
-        }
-
-        uint32_t ready_events_for_entry(linux_process_context& proc, const linux_epoll_entry& entry, std::vector<int>& epoll_stack)
-        {
-            auto* fd_entry = proc.fds.get(entry.fd);
-            if (!fd_entry)
-            {
-                return 0;
-            }
-
-            uint32_t ready_events = 0;
-            if ((entry.events & EPOLLIN) && fd_has_readable_data(proc, entry.fd, *fd_entry, epoll_stack))
-            {
-                ready_events |= EPOLLIN;
-            }
-
-            if ((entry.events & EPOLLOUT) && fd_accepts_write_ready(*fd_entry))
-            {
-                ready_events |= EPOLLOUT;
-            }
-
-            return ready_events;
-        }
-
-        bool epoll_instance_has_ready_entries(linux_process_context& proc, const linux_epoll_instance& instance,
-                                              std::vector<int>& epoll_stack)
-        {
-            return std::ranges::any_of(instance.entries, [&proc, &epoll_stack](const linux_epoll_entry& entry) {
-                return ready_events_for_entry(proc, entry, epoll_stack) != 0;
-            });
-        }
     }
 
     void sys_pipe(const linux_syscall_context& c)
@@ -270,6 +218,7 @@ namespace sogen
         linux_fd write_end{};
         write_end.type = fd_type::pipe_write;
         write_end.handle = write_stream;
+        write_end.readiness = read_end.readiness;
 
         const auto read_fd = c.proc.fds.allocate(std::move(read_end));
         const auto write_fd = c.proc.fds.allocate(std::move(write_end));
@@ -285,9 +234,6 @@ namespace sogen
         const auto pipefd_addr = get_linux_syscall_argument(c.emu, 0);
         const auto flags = static_cast<int>(get_linux_syscall_argument(c.emu, 1));
 
-        constexpr int LINUX_O_CLOEXEC = 02000000;
-        constexpr int LINUX_O_NONBLOCK = 04000;
-
         std::array<int, 2> host_pipe{-1, -1};
         if (host_create_pipe(host_pipe) != 0)
         {
@@ -341,6 +287,7 @@ namespace sogen
         write_end.handle = write_stream;
         write_end.close_on_exec = cloexec;
         write_end.flags = flags & LINUX_O_NONBLOCK;
+        write_end.readiness = read_end.readiness;
 
         const auto read_fd = c.proc.fds.allocate(std::move(read_end));
         const auto write_fd = c.proc.fds.allocate(std::move(write_end));
@@ -353,61 +300,37 @@ namespace sogen
 
     void sys_eventfd(const linux_syscall_context& c)
     {
-        // eventfd(unsigned int initval) — simplified stub
-        // We create an fd entry but don't implement full eventfd semantics
-        (void)get_linux_syscall_argument(c.emu, 0); // initval
-
-        linux_fd efd{};
-        efd.type = fd_type::eventfd;
-
-        const auto fd_num = c.proc.fds.allocate(std::move(efd));
-        write_linux_syscall_result(c, fd_num);
+        const auto initial_value = static_cast<uint32_t>(get_linux_syscall_argument(c.emu, 0));
+        write_linux_syscall_result(c, create_eventfd(c, initial_value, 0));
     }
 
     void sys_eventfd2(const linux_syscall_context& c)
     {
-        // eventfd2(unsigned int initval, int flags) — simplified stub
-        (void)get_linux_syscall_argument(c.emu, 0); // initval
+        const auto initial_value = static_cast<uint32_t>(get_linux_syscall_argument(c.emu, 0));
         const auto flags = static_cast<int>(get_linux_syscall_argument(c.emu, 1));
 
-        constexpr int LINUX_O_CLOEXEC = 02000000;
-
-        linux_fd efd{};
-        efd.type = fd_type::eventfd;
-        efd.close_on_exec = (flags & LINUX_O_CLOEXEC) != 0;
-
-        const auto fd_num = c.proc.fds.allocate(std::move(efd));
-        write_linux_syscall_result(c, fd_num);
-    }
-
-    namespace
-    {
-
-#pragma pack(push, 1)
-
-        struct linux_epoll_event
+        if ((flags & ~(LINUX_O_CLOEXEC | LINUX_O_NONBLOCK | LINUX_EFD_SEMAPHORE)) != 0)
         {
-            uint32_t events;
-            uint64_t data;
-        };
-
-#pragma pack(pop)
-
-        static_assert(sizeof(linux_epoll_event) == 12);
+            write_linux_syscall_result(c, -LINUX_EINVAL);
+            return;
+        }
 
+        write_linux_syscall_result(c, create_eventfd(c, initial_value, flags));
     }
 
     void sys_epoll_create1(const linux_syscall_context& c)
     {
         const auto flags = static_cast<int>(get_linux_syscall_argument(c.emu, 0));
-        constexpr int LINUX_O_CLOEXEC = 02000000;
 
         linux_fd efd{};
         efd.type = fd_type::epoll;
         efd.close_on_exec = (flags & LINUX_O_CLOEXEC) != 0;
 
+        auto instance = std::make_shared<linux_epoll_instance>();
+        instance->owner = efd.readiness;
+
         const auto fd_num = c.proc.fds.allocate(std::move(efd));
-        c.proc.epoll_instances[fd_num] = std::make_shared<linux_epoll_instance>();
+        c.proc.epoll_instances[fd_num] = std::move(instance);
 
         write_linux_syscall_result(c, fd_num);
     }
@@ -421,48 +344,50 @@ namespace sogen
 
         auto* epoll_fd = c.proc.fds.get(epfd);
         auto it = c.proc.epoll_instances.find(epfd);
-        if (!epoll_fd || epoll_fd->type != fd_type::epoll || it == c.proc.epoll_instances.end() || !it->second)
+        if (!epoll_fd || epoll_fd->type != fd_type::epoll || it == c.proc.epoll_instances.end() || !it->second || !c.proc.fds.get(fd))
         {
             write_linux_syscall_result(c, -LINUX_EBADF);
             return;
         }
 
+        if (fd == epfd)
+        {
+            write_linux_syscall_result(c, -LINUX_EINVAL);
+            return;
+        }
+
+        const auto& instance = it->second;
+        const auto registered = instance->entries.contains(fd);
+
         linux_epoll_event ev{};
-        if (event_addr != 0)
+        if (event_addr != 0 && op != LINUX_EPOLL_CTL_DEL)
         {
             c.emu.read_memory(event_addr, &ev, sizeof(ev));
         }
 
         switch (op)
         {
-        case EPOLL_CTL_ADD: {
-            linux_epoll_entry entry{};
-            entry.fd = fd;
-            entry.events = ev.events;
-            entry.data = ev.data;
-            it->second->entries.push_back(entry);
-            write_linux_syscall_result(c, 0);
-            break;
-        }
-        case EPOLL_CTL_DEL: {
-            auto& entries = it->second->entries;
-            entries.erase(std::ranges::remove_if(entries, [fd](const linux_epoll_entry& e) { return e.fd == fd; }).begin(), entries.end());
+        case LINUX_EPOLL_CTL_ADD:
+        case LINUX_EPOLL_CTL_MOD:
+            if (registered != (op == LINUX_EPOLL_CTL_MOD))
+            {
+                write_linux_syscall_result(c, registered ? -LINUX_EEXIST : -LINUX_ENOENT);
+                break;
+            }
+
+            add_epoll_entry(c.proc, instance, linux_epoll_entry{.fd = fd, .events = ev.events, .data = ev.data});
             write_linux_syscall_result(c, 0);
             break;
-        }
-        case EPOLL_CTL_MOD: {
-            for (auto& entry : it->second->entries)
+        case LINUX_EPOLL_CTL_DEL:
+            if (!registered)
             {
-                if (entry.fd == fd)
-                {
-                    entry.events = ev.events;
-                    entry.data = ev.data;
-                    break;
-                }
+                write_linux_syscall_result(c, -LINUX_ENOENT);
+                break;
             }
+
+            remove_epoll_entry(c.proc, *instance, fd);
             write_linux_syscall_result(c, 0);
             break;
-        }
         default:
             write_linux_syscall_result(c, -LINUX_EINVAL);
             break;
@@ -476,8 +401,6 @@ namespace sogen
         const auto maxevents = static_cast<int>(get_linux_syscall_argument(c.emu, 2));
         const auto timeout = static_cast<int>(get_linux_syscall_argument(c.emu, 3));
 
-        (void)timeout;
-
         auto* epoll_fd = c.proc.fds.get(epfd);
         auto it = c.proc.epoll_instances.find(epfd);
         if (!epoll_fd || epoll_fd->type != fd_type::epoll || it == c.proc.epoll_instances.end() || !it->second)
@@ -486,30 +409,29 @@ namespace sogen
             return;
         }
 
-        int count = 0;
-        std::vector<int> epoll_stack{epfd};
-        for (const auto& entry : it->second->entries)
+        if (maxevents <= 0)
         {
-            if (count >= maxevents)
-            {
-                break;
-            }
+            write_linux_syscall_result(c, -LINUX_EINVAL);
+            return;
+        }
 
-            const auto ready_events = ready_events_for_entry(c.proc, entry, epoll_stack);
+        auto& instance = *it->second;
+        auto events = harvest_epoll_events(c.proc, instance, static_cast<size_t>(maxevents));
 
-            if (ready_events != 0)
+        if (events.empty() && timeout != 0)
+        {
+            if (park_epoll_wait(c, instance, epfd, events_addr, maxevents, timeout))
             {
-                linux_epoll_event out_ev{};
-                out_ev.events = ready_events;
-                out_ev.data = entry.data;
-                c.emu.write_memory(events_addr + static_cast<uint64_t>(count) * sizeof(linux_epoll_event), &out_ev, sizeof(out_ev));
-                ++count;
+                return;
             }
+
+            // No other thread can push an event, only the host can still make an entry ready. Without host
+            // descriptors this returns right away instead of deadlocking.
+            events = wait_for_epoll_events(c.proc, instance, static_cast<size_t>(maxevents), std::chrono::milliseconds{timeout});
         }
 
-        // If nothing is ready and timeout is 0 (non-blocking), return 0
-        // If nothing is ready and timeout > 0, we'd need to block — return 0 to avoid deadlock
-        write_linux_syscall_result(c, count);
+        write_epoll_events(c.emu, events_addr, events);
+        write_linux_syscall_result(c, static_cast<int64_t>(events.size()));
     }
 
     void sys_epoll_pwait(const linux_syscall_context& c)
@@ -519,182 +441,220 @@ namespace sogen
         sys_epoll_wait(c);
     }
 
-    void sys_poll(const linux_syscall_context& c)
+    namespace
     {
-        const auto fds_addr = get_linux_syscall_argument(c.emu, 0);
-        const auto nfds = static_cast<uint32_t>(get_linux_syscall_argument(c.emu, 1));
-        const auto timeout = static_cast<int>(get_linux_syscall_argument(c.emu, 2));
-
-        (void)timeout;
+        void poll_fds(const linux_syscall_context& c, const std::chrono::milliseconds timeout)
+        {
+            const auto fds_addr = get_linux_syscall_argument(c.emu, 0);
+            const auto nfds = static_cast<uint32_t>(get_linux_syscall_argument(c.emu, 1));
 
-#pragma pack(push, 1)
+            std::vector<linux_pollfd> pfds(nfds);
+            if (nfds > 0)
+            {
+                c.emu.read_memory(fds_addr, pfds.data(), pfds.size() * sizeof(linux_pollfd));
+            }
 
-        struct linux_pollfd
-        {
-            int32_t fd;
-            int16_t events;
-            int16_t revents;
-        };
+            std::vector<int> host_fds{};
+            const auto scan = [&] {
+                int ready_count = 0;
+                host_fds.clear();
 
-#pragma pack(pop)
+                for (auto& pfd : pfds)
+                {
+                    pfd.revents = 0;
 
-        static_assert(sizeof(linux_pollfd) == 8);
+                    if (pfd.fd < 0)
+                    {
+                        // Negative fd: ignore, leave revents as 0
+                        continue;
+                    }
 
-        int ready_count = 0;
+                    const auto* fd_entry = c.proc.fds.get(pfd.fd);
+                    if (!fd_entry)
+                    {
+                        pfd.revents = POLLNVAL;
+                        ++ready_count;
+                        continue;
+                    }
 
-        for (uint32_t i = 0; i < nfds; ++i)
-        {
-            const auto entry_addr = fds_addr + static_cast<uint64_t>(i) * sizeof(linux_pollfd);
-            linux_pollfd pfd{};
-            c.emu.read_memory(entry_addr, &pfd, sizeof(pfd));
+                    if ((pfd.events & POLLIN) && fd_has_readable_data(c.proc, pfd.fd, *fd_entry))
+                    {
+                        pfd.revents |= POLLIN;
+                    }
 
-            pfd.revents = 0;
+                    if ((pfd.events & POLLOUT) && fd_accepts_write_ready(*fd_entry))
+                    {
+                        pfd.revents |= POLLOUT;
+                    }
 
-            if (pfd.fd < 0)
-            {
-                // Negative fd: ignore, leave revents as 0
-                c.emu.write_memory(entry_addr, &pfd, sizeof(pfd));
-                continue;
-            }
+                    if (pfd.revents != 0)
+                    {
+                        ++ready_count;
+                    }
+                    else if (const auto host_fd = get_host_readable_fd(*fd_entry); (pfd.events & POLLIN) && host_fd >= 0)
+                    {
+                        host_fds.push_back(host_fd);
+                    }
+                }
 
-            auto* fd_entry = c.proc.fds.get(pfd.fd);
-            if (!fd_entry)
-            {
-                pfd.revents = POLLNVAL;
-                c.emu.write_memory(entry_addr, &pfd, sizeof(pfd));
-                ++ready_count;
-                continue;
-            }
+                return ready_count;
+            };
 
-            std::vector<int> epoll_stack{};
-            if ((pfd.events & POLLIN) && fd_has_readable_data(c.proc, pfd.fd, *fd_entry, epoll_stack))
-            {
-                pfd.revents |= POLLIN;
-            }
+            auto ready_count = scan();
 
-            if ((pfd.events & POLLOUT) && fd_accepts_write_ready(*fd_entry))
+            // Nothing the guest could do meanwhile would make an fd ready, so block on the host descriptors.
+            if (ready_count == 0 && timeout.count() != 0 && !host_fds.empty() && linux_host_poller::wait_any(host_fds, timeout))
             {
-                pfd.revents |= POLLOUT;
+                ready_count = scan();
             }
 
-            if (pfd.revents != 0)
+            if (nfds > 0)
             {
-                ++ready_count;
+                c.emu.write_memory(fds_addr, pfds.data(), pfds.size() * sizeof(linux_pollfd));
             }
 
-            c.emu.write_memory(entry_addr, &pfd, sizeof(pfd));
+            write_linux_syscall_result(c, ready_count);
         }
 
-        write_linux_syscall_result(c, ready_count);
-    }
+        void select_fds(const linux_syscall_context& c, const std::chrono::milliseconds timeout)
+        {
+            const auto nfds = static_cast<int>(get_linux_syscall_argument(c.emu, 0));
+            const auto readfds_addr = get_linux_syscall_argument(c.emu, 1);
+            const auto writefds_addr = get_linux_syscall_argument(c.emu, 2);
+            const auto exceptfds_addr = get_linux_syscall_argument(c.emu, 3);
 
-    void sys_ppoll(const linux_syscall_context& c)
-    {
-        // ppoll is poll with a timespec timeout and signal mask
-        // We ignore the signal mask and treat it as poll
-        sys_poll(c);
-    }
+            // fd_set is 128 bytes (1024 bits) on Linux
+            constexpr size_t FD_SET_SIZE = 128;
 
-    void sys_select(const linux_syscall_context& c)
-    {
-        const auto nfds = static_cast<int>(get_linux_syscall_argument(c.emu, 0));
-        const auto readfds_addr = get_linux_syscall_argument(c.emu, 1);
-        const auto writefds_addr = get_linux_syscall_argument(c.emu, 2);
-        const auto exceptfds_addr = get_linux_syscall_argument(c.emu, 3);
-        // timeout is arg 4
-
-        // fd_set is 128 bytes (1024 bits) on Linux
-        constexpr size_t FD_SET_SIZE = 128;
-
-        auto read_fd_set = [&](uint64_t addr, std::vector<uint8_t>& bits) {
-            bits.resize(FD_SET_SIZE, 0);
-            if (addr)
-            {
-                c.emu.read_memory(addr, bits.data(), FD_SET_SIZE);
-            }
-        };
+            auto read_fd_set = [&](uint64_t addr, std::vector<uint8_t>& bits) {
+                bits.resize(FD_SET_SIZE, 0);
+                if (addr)
+                {
+                    c.emu.read_memory(addr, bits.data(), FD_SET_SIZE);
+                }
+            };
 
-        auto write_fd_set = [&](uint64_t addr, const std::vector<uint8_t>& bits) {
-            if (addr)
-            {
-                c.emu.write_memory(addr, bits.data(), FD_SET_SIZE);
-            }
-        };
+            auto write_fd_set = [&](uint64_t addr, const std::vector<uint8_t>& bits) {
+                if (addr)
+                {
+                    c.emu.write_memory(addr, bits.data(), FD_SET_SIZE);
+                }
+            };
 
-        auto fd_isset = [](int fd, const std::vector<uint8_t>& bits) -> bool {
-            if (fd < 0 || static_cast<size_t>(fd / 8) >= bits.size())
-            {
-                return false;
-            }
-            return (bits.at(static_cast<size_t>(fd / 8)) & (1 << (fd % 8))) != 0;
-        };
+            auto fd_isset = [](int fd, const std::vector<uint8_t>& bits) -> bool {
+                if (fd < 0 || static_cast<size_t>(fd / 8) >= bits.size())
+                {
+                    return false;
+                }
+                return (bits.at(static_cast<size_t>(fd / 8)) & (1 << (fd % 8))) != 0;
+            };
 
-        auto fd_set_bit = [](int fd, std::vector<uint8_t>& bits) {
-            if (fd >= 0 && static_cast<size_t>(fd / 8) < bits.size())
-            {
-                bits.at(static_cast<size_t>(fd / 8)) |= static_cast<uint8_t>(1 << (fd % 8));
-            }
-        };
+            auto fd_set_bit = [](int fd, std::vector<uint8_t>& bits) {
+                if (fd >= 0 && static_cast<size_t>(fd / 8) < bits.size())
+                {
+                    bits.at(static_cast<size_t>(fd / 8)) |= static_cast<uint8_t>(1 << (fd % 8));
+                }
+            };
+
+            std::vector<uint8_t> read_bits;
+            std::vector<uint8_t> write_bits;
+            std::vector<uint8_t> except_bits;
+            read_fd_set(readfds_addr, read_bits);
+            read_fd_set(writefds_addr, write_bits);
+            read_fd_set(exceptfds_addr, except_bits);
+
+            std::vector<uint8_t> out_read;
+            std::vector<uint8_t> out_write;
+            std::vector<uint8_t> out_except;
+            std::vector<int> host_fds{};
+
+            const auto scan = [&] {
+                // Clear output sets
+                out_read.assign(FD_SET_SIZE, 0);
+                out_write.assign(FD_SET_SIZE, 0);
+                out_except.assign(FD_SET_SIZE, 0);
+                host_fds.clear();
+
+                int ready_count = 0;
+
+                for (int fd = 0; fd < nfds; ++fd)
+                {
+                    const bool want_read = readfds_addr && fd_isset(fd, read_bits);
+                    const bool want_write = writefds_addr && fd_isset(fd, write_bits);
+                    const bool want_except = exceptfds_addr && fd_isset(fd, except_bits);
 
-        std::vector<uint8_t> read_bits;
-        std::vector<uint8_t> write_bits;
-        std::vector<uint8_t> except_bits;
-        read_fd_set(readfds_addr, read_bits);
-        read_fd_set(writefds_addr, write_bits);
-        read_fd_set(exceptfds_addr, except_bits);
+                    if (!want_read && !want_write && !want_except)
+                    {
+                        continue;
+                    }
 
-        // Clear output sets
-        std::vector<uint8_t> out_read(FD_SET_SIZE, 0);
-        std::vector<uint8_t> out_write(FD_SET_SIZE, 0);
-        std::vector<uint8_t> out_except(FD_SET_SIZE, 0);
+                    auto* fd_entry = c.proc.fds.get(fd);
+                    if (!fd_entry)
+                    {
+                        continue;
+                    }
 
-        int ready_count = 0;
+                    if (want_write && fd_accepts_write_ready(*fd_entry))
+                    {
+                        fd_set_bit(fd, out_write);
+                        ++ready_count;
+                    }
 
-        for (int fd = 0; fd < nfds; ++fd)
-        {
-            const bool want_read = readfds_addr && fd_isset(fd, read_bits);
-            const bool want_write = writefds_addr && fd_isset(fd, write_bits);
-            const bool want_except = exceptfds_addr && fd_isset(fd, except_bits);
+                    if (want_read && fd_has_readable_data(c.proc, fd, *fd_entry))
+                    {
+                        fd_set_bit(fd, out_read);
+                        ++ready_count;
+                    }
+                    else if (const auto host_fd = get_host_readable_fd(*fd_entry); want_read && host_fd >= 0)
+                    {
+                        host_fds.push_back(host_fd);
+                    }
 
-            if (!want_read && !want_write && !want_except)
-            {
-                continue;
-            }
+                    // No exceptions
+                    (void)want_except;
+                }
 
-            auto* fd_entry = c.proc.fds.get(fd);
-            if (!fd_entry)
-            {
-                continue;
-            }
+                return ready_count;
+            };
 
-            if (want_write && fd_accepts_write_ready(*fd_entry))
-            {
-                fd_set_bit(fd, out_write);
-                ++ready_count;
-            }
-            std::vector<int> epoll_stack{};
-            if (want_read && fd_has_readable_data(c.proc, fd, *fd_entry, epoll_stack))
+            auto ready_count = scan();
+
+            if (ready_count == 0 && timeout.count() != 0 && !host_fds.empty() && linux_host_poller::wait_any(host_fds, timeout))
             {
-                fd_set_bit(fd, out_read);
-                ++ready_count;
+                ready_count = scan();
             }
 
-            // No exceptions
-            (void)want_except;
+            write_fd_set(readfds_addr, out_read);
+            write_fd_set(writefds_addr, out_write);
+            write_fd_set(exceptfds_addr, out_except);
+
+            write_linux_syscall_result(c, ready_count);
         }
+    }
 
-        write_fd_set(readfds_addr, out_read);
-        write_fd_set(writefds_addr, out_write);
-        write_fd_set(exceptfds_addr, out_except);
+    void sys_poll(const linux_syscall_context& c)
+    {
+        const auto timeout = static_cast<int>(get_linux_syscall_argument(c.emu, 2));
+        poll_fds(c, std::chrono::milliseconds{timeout});
+    }
 
-        write_linux_syscall_result(c, ready_count);
+    void sys_ppoll(const linux_syscall_context& c)
+    {
+        // ppoll is poll with a timespec timeout and signal mask
+        // We ignore the signal mask and treat it as poll
+        poll_fds(c, read_guest_timeout(c.emu, get_linux_syscall_argument(c.emu, 2)));
+    }
+
+    void sys_select(const linux_syscall_context& c)
+    {
+        select_fds(c, read_guest_timeout(c.emu, get_linux_syscall_argument(c.emu, 4), 1us));
     }
 
     void sys_pselect6(const linux_syscall_context& c)
     {
         // pselect6 is select with a timespec and signal mask
         // We ignore the signal mask and delegate to select logic
-        sys_select(c);
+        select_fds(c, read_guest_timeout(c.emu, get_linux_syscall_argument(c.emu, 4)));
     }
 
     // NOLINTEND(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
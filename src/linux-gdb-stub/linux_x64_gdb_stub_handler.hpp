@@ -138,6 +138,25 @@ namespace sogen
             return libs;
         }
 
+        std::vector<gdb_stub::memory_region> get_memory_regions() override
+        {
+            std::vector<gdb_stub::memory_region> regions{};
+
+            for (const auto& [address, region] : this->linux_emu_->memory.get_mapped_regions())
+            {
+                if (!regions.empty() && regions.back().address + regions.back().length == address)
+                {
+                    regions.back().length += region.length;
+                }
+                else
+                {
+                    regions.push_back({.address = address, .length = region.length});
+                }
+            }
+
+            return regions;
+        }
+
         std::string get_executable_path() override
         {
             return this->linux_emu_->mod_manager.get_executable_path().string();
@@ -254,39 +254,40 @@ namespace sogen
         using hook_map = std::unordered_map<breakpoint_key, scoped_hook>;
         utils::concurrency::container<hook_map> hooks_{};
 
-        std::vector<emulator_hook*> create_execute_hook(const uint64_t addr, const size_t size)
+        // The breakpoint kind gdb sends is the size of the instruction to patch, the breakpoint itself is at addr.
+        std::vector<emulator_hook*> create_execute_hook(const uint64_t addr)
         {
-            std::vector<emulator_hook*> hooks{};
-            hooks.reserve(size);
-
-            for (size_t i = 0; i < size; ++i)
-            {
-                auto* hook = this->emu_->hook_memory_execution(addr + i, [this](cpu_interface&, const uint64_t) {
-                    this->on_interrupt(); //
-                });
-
-                hooks.push_back(hook);
-            }
-
-            return hooks;
-        }
-
-        std::vector<emulator_hook*> create_read_hook(const uint64_t addr, const size_t size)
-        {
-            auto* hook = this->emu_->hook_memory_read(addr, size, [this](cpu_interface&, const uint64_t, const void*, const size_t) {
+            auto* hook = this->emu_->hook_breakpoint(addr, [this](cpu_interface&, const uint64_t) {
                 this->on_interrupt(); //
             });
 
             return {hook};
         }
 
-        std::vector<emulator_hook*> create_write_hook(const uint64_t addr, const size_t size)
+        std::vector<emulator_hook*> create_watchpoint(const uint64_t addr, const size_t size, const memory_operation operation)
         {
-            auto* hook = this->emu_->hook_memory_write(addr, size, [this](cpu_interface&, const uint64_t, const void*, const size_t) {
+            auto callback = [this](cpu_interface&, const uint64_t, const void*, const size_t) {
                 this->on_interrupt(); //
-            });
+            };
 
-            return {hook};
+            if (this->emu_->supports_watchpoints())
+            {
+                return {this->emu_->hook_watchpoint(addr, size, operation, std::move(callback))};
+            }
+
+            std::vector<emulator_hook*> hooks{};
+
+            if ((operation & memory_operation::read) != memory_operation::none)
+            {
+                hooks.push_back(this->emu_->hook_memory_read(addr, size, callback));
+            }
+
+            if ((operation & memory_operation::write) != memory_operation::none)
+            {
+                hooks.push_back(this->emu_->hook_memory_write(addr, size, callback));
+            }
+
+            return hooks;
         }
 
         std::vector<emulator_hook*> create_hook(const gdb_stub::breakpoint_type type, const uint64_t addr, const size_t size)
@@ -297,17 +298,13 @@ namespace sogen
             {
             case software:
             case hardware_exec:
-                return this->create_execute_hook(addr, size);
+                return this->create_execute_hook(addr);
             case hardware_read:
-                return this->create_read_hook(addr, size);
+                return this->create_watchpoint(addr, size, memory_operation::read);
             case hardware_write:
-                return this->create_write_hook(addr, size);
-            case hardware_read_write: {
-                auto hooks1 = this->create_hook(hardware_read, addr, size);
-                auto hooks2 = this->create_hook(hardware_write, addr, size);
-                hooks1.insert(hooks1.end(), hooks2.begin(), hooks2.end());
-                return hooks1;
-            }
+                return this->create_watchpoint(addr, size, memory_operation::write);
+            case hardware_read_write:
+                return this->create_watchpoint(addr, size, memory_operation::read_write);
             default:
                 throw std::runtime_error("Bad bp type");
             }
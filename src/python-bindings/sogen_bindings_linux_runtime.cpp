@@ -87,6 +87,11 @@ namespace sogen::py
             .def("memory_execution_at", &linux_hook_registry::memory_execution_at)
             .def("memory_read", &linux_hook_registry::memory_read)
             .def("memory_write", &linux_hook_registry::memory_write)
+            .def("memory_read_batched", &linux_hook_registry::memory_read_batched, nb::arg("address"), nb::arg("size"),
+                 nb::arg("callback"), nb::arg("batch_size") = 4096)
+            .def("memory_write_batched", &linux_hook_registry::memory_write_batched, nb::arg("address"), nb::arg("size"),
+                 nb::arg("callback"), nb::arg("batch_size") = 4096)
+            .def("flush", &linux_hook_registry::flush_batches, nb::call_guard<nb::gil_scoped_release>())
             .def("instruction", &linux_hook_registry::instruction)
             .def("interrupt", &linux_hook_registry::interrupt)
             .def("memory_violation", &linux_hook_registry::memory_violation)
@@ -121,6 +126,7 @@ namespace sogen::py
             .value("running", thread_wait_state::running)
             .value("futex_wait", thread_wait_state::futex_wait)
             .value("sleeping", thread_wait_state::sleeping)
+            .value("epoll_wait", thread_wait_state::epoll_wait)
             .export_values();
 
         nb::class_<sogen_linux_thread>(m, "Thread")
@@ -171,6 +177,10 @@ namespace sogen::py
         nb::class_<linux_memory_manager>(m, "MemoryManager")
             .def("read_memory",
                  [](const linux_memory_manager& self, uint64_t address, size_t size) { return read_memory_bytes(self, address, size); })
+            .def(
+                "read_memory",
+                [](const linux_memory_manager& self, uint64_t address, nb::handle out) { read_memory_into(self, address, out); },
+                nb::arg("address"), nb::arg("out"))
             .def("write_memory",
                  [](linux_memory_manager& self, uint64_t address, const nb::bytes& buffer) { write_memory_bytes(self, address, buffer); })
             .def("allocate_memory",
@@ -221,6 +231,7 @@ namespace sogen::py
             .def("serialize_state", &sogen_linux_emulator::serialize_state)
             .def("deserialize_state", &sogen_linux_emulator::deserialize_state)
             .def("read_memory", &sogen_linux_emulator::read_memory)
+            .def("read_memory", &sogen_linux_emulator::read_memory_into, nb::arg("address"), nb::arg("out"))
             .def("write_memory", &sogen_linux_emulator::write_memory)
             .def("read_register", &sogen_linux_emulator::read_register)
             .def("write_register", &sogen_linux_emulator::write_register)
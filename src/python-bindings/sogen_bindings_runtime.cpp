@@ -55,6 +55,11 @@ namespace sogen::py
             .def("memory_execution_at", &hook_registry::memory_execution_at)
             .def("memory_read", &hook_registry::memory_read)
             .def("memory_write", &hook_registry::memory_write)
+            .def("memory_read_batched", &hook_registry::memory_read_batched, nb::arg("address"), nb::arg("size"), nb::arg("callback"),
+                 nb::arg("batch_size") = 4096)
+            .def("memory_write_batched", &hook_registry::memory_write_batched, nb::arg("address"), nb::arg("size"), nb::arg("callback"),
+                 nb::arg("batch_size") = 4096)
+            .def("flush", &hook_registry::flush_batches, nb::call_guard<nb::gil_scoped_release>())
             .def("instruction", &hook_registry::instruction)
             .def("interrupt", &hook_registry::interrupt)
             .def("memory_violation", &hook_registry::memory_violation)
@@ -64,6 +69,8 @@ namespace sogen::py
         nb::class_<memory_manager>(m, "MemoryManager")
             .def("read_memory",
                  [](const memory_manager& self, uint64_t address, size_t size) { return read_memory_bytes(self, address, size); })
+            .def("read_memory", [](const memory_manager& self, uint64_t address, nb::handle out) { read_memory_into(self, address, out); },
+                 nb::arg("address"), nb::arg("out"))
             .def("write_memory",
                  [](memory_manager& self, uint64_t address, const nb::bytes& buffer) { write_memory_bytes(self, address, buffer); })
             .def(
@@ -187,6 +194,7 @@ namespace sogen::py
             .def_prop_ro(
                 "hooks", [](sogen_windows_emulator& self) -> hook_registry& { return *self.hooks; }, nb::rv_policy::reference_internal)
             .def("read_memory", &sogen_windows_emulator::read_memory)
+            .def("read_memory", &sogen_windows_emulator::read_memory_into, nb::arg("address"), nb::arg("out"))
             .def("write_memory", &sogen_windows_emulator::write_memory)
             .def("read_register", &sogen_windows_emulator::read_register)
             .def("write_register", &sogen_windows_emulator::write_register)
@@ -28,6 +28,11 @@ namespace sogen::py
 
         nb::setattr(m, "MemoryOperation", m.attr("MemoryPermission"));
 
+        // Record layout of the buffers passed to Hooks.memory_read_batched / memory_write_batched callbacks,
+        // usable with struct.iter_unpack or numpy.frombuffer.
+        m.attr("MEMORY_ACCESS_RECORD_FORMAT") = memory_access_record_format;
+        m.attr("MEMORY_ACCESS_RECORD_SIZE") = sizeof(memory_access_record);
+
         nb::enum_<memory_region_kind>(m, "MemoryRegionKind")
             .value("free", memory_region_kind::free)
             .value("private_allocation", memory_region_kind::private_allocation)
@@ -35,6 +40,7 @@ namespace sogen::py
             .value("pagefile_section_view", memory_region_kind::pagefile_section_view)
             .value("section_image", memory_region_kind::section_image)
             .value("mmio", memory_region_kind::mmio)
+            .value("shared_user_data", memory_region_kind::shared_user_data)
             .export_values();
 
         nb::enum_<memory_violation_type>(m, "MemoryViolationType")
@@ -1,6 +1,8 @@
 #include "sogen_internal.hpp"
 #include <windows_emulator.hpp>
 
+#include <utils/finally.hpp>
+
 namespace sogen::py
 {
     std::string stop_reason_to_string(const stop_reason reason)
@@ -93,6 +95,171 @@ namespace sogen::py
         memory.write_memory(address, buffer.data(), buffer.size());
     }
 
+    void read_memory_into(const memory_interface& memory, const uint64_t address, const nb::handle out)
+    {
+        Py_buffer view{};
+        if (PyObject_GetBuffer(out.ptr(), &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) != 0)
+        {
+            throw nb::python_error();
+        }
+
+        try
+        {
+            memory.read_memory(address, view.buf, static_cast<size_t>(view.len));
+        }
+        catch (...)
+        {
+            PyBuffer_Release(&view);
+            throw;
+        }
+
+        PyBuffer_Release(&view);
+    }
+
+    memory_access_batch::memory_access_batch(nb::object callback, const size_t batch_size)
+        : callback_(std::move(callback)),
+          batch_size_(std::max<size_t>(batch_size, 1))
+    {
+        this->records_.reserve(this->batch_size_);
+        this->pending_.reserve(this->batch_size_);
+    }
+
+    memory_access_batch::~memory_access_batch()
+    {
+        // The last reference can go away inside the emulator, with the GIL released.
+        nb::gil_scoped_acquire gil{};
+        this->callback_ = nb::object{};
+    }
+
+    void memory_access_batch::record(const uint64_t address, const void* data, const size_t length, const memory_operation operation)
+    {
+        memory_access_record entry{};
+        entry.address = address;
+        entry.size = static_cast<uint32_t>(length);
+        entry.operation = static_cast<uint32_t>(operation);
+        std::memcpy(&entry.value, data, std::min(length, sizeof(entry.value)));
+
+        bool full{};
+        {
+            const std::scoped_lock lock{this->mutex_};
+            this->records_.push_back(entry);
+            full = this->records_.size() >= this->batch_size_;
+        }
+
+        if (full)
+        {
+            this->flush();
+        }
+    }
+
+    void memory_access_batch::flush()
+    {
+        const std::scoped_lock delivery_lock{this->delivery_mutex_};
+        if (this->delivering_)
+        {
+            // Flushed again from within the callback, the current chunk is still being looked at.
+            return;
+        }
+
+        {
+            const std::scoped_lock lock{this->mutex_};
+            if (this->records_.empty())
+            {
+                return;
+            }
+
+            this->pending_.clear();
+            this->pending_.swap(this->records_);
+        }
+
+        nb::gil_scoped_acquire gil{};
+
+        auto* memory = reinterpret_cast<char*>(this->pending_.data());
+        const auto size = static_cast<Py_ssize_t>(this->pending_.size() * sizeof(memory_access_record));
+        const auto view = nb::steal(PyMemoryView_FromMemory(memory, size, PyBUF_READ));
+        if (!view.is_valid())
+        {
+            throw nb::python_error();
+        }
+
+        this->delivering_ = true;
+        const auto _ = utils::finally([this, &view] {
+            this->delivering_ = false;
+            this->release_view(view);
+        });
+
+        this->callback_(view);
+    }
+
+    void memory_access_batch::release_view(const nb::handle view) noexcept
+    {
+        // Views the callback kept alive must not see the buffer being reused. Release fails if something
+        // still exports it (e.g. a numpy array over the view), the records then stay with the view.
+        try
+        {
+            view.attr("release")();
+            return;
+        }
+        catch (...)
+        {
+        }
+
+        // Moving a vector keeps its storage, so the view still points at the moved-to buffer.
+        using record_buffer = std::vector<memory_access_record>;
+        auto* records = new record_buffer(std::move(this->pending_));
+        this->pending_ = {};
+        this->pending_.reserve(this->batch_size_);
+
+        nb::object owner{};
+        try
+        {
+            // The finalizer holds the capsule until the view is collected, which frees the records.
+            owner = nb::capsule(records, [](void* buffer) noexcept { delete static_cast<record_buffer*>(buffer); });
+            nb::module_::import_("weakref").attr("finalize")(view, nb::cpp_function([](nb::handle) {}), owner);
+        }
+        catch (...)
+        {
+            // Leak the records rather than free them under the view.
+            (void)owner.release();
+        }
+    }
+
+    emulator_hook* hook_memory_access(sogen::x86_64_emulator& emu, const memory_operation operation, const uint64_t address,
+                                      const uint64_t size, nb::object callback, const size_t batch_size,
+                                      std::vector<std::shared_ptr<memory_access_batch>>& batches)
+    {
+        auto batch = std::make_shared<memory_access_batch>(std::move(callback), batch_size);
+        batches.push_back(batch);
+
+        auto recorder = [operation, batch = std::move(batch)](cpu_interface&, const uint64_t addr, const void* data, const size_t length) {
+            batch->record(addr, data, length, operation);
+        };
+
+        if (operation == memory_operation::write)
+        {
+            return emu.hook_memory_write(address, size, std::move(recorder));
+        }
+
+        return emu.hook_memory_read(address, size, std::move(recorder));
+    }
+
+    void flush_memory_access_batches(std::vector<std::shared_ptr<memory_access_batch>>& batches)
+    {
+        if (batches.empty())
+        {
+            return;
+        }
+
+        for (const auto& batch : batches)
+        {
+            batch->flush();
+        }
+
+        // A batch only referenced from here belongs to a removed hook and has nothing left to deliver.
+        nb::gil_scoped_acquire gil{};
+        std::erase_if(batches, [](const std::shared_ptr<memory_access_batch>& batch) { return batch.use_count() == 1; });
+    }
+
     nb::bytes serialize_state_bytes(const windows_emulator& emulator)
     {
         utils::buffer_serializer serializer{};
@@ -3,6 +3,7 @@
 #include "sogen_bindings.hpp"
 #include <utils/function.hpp>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <utility>
 
@@ -146,6 +147,61 @@ namespace sogen::py
         void dispatch_address(uint64_t address);
     };
 
+    // One memory access as delivered by the batched memory hooks, laid out as MEMORY_ACCESS_RECORD_FORMAT.
+    // value holds the first (up to) eight bytes that were accessed, little endian.
+    struct memory_access_record
+    {
+        uint64_t address{};
+        uint64_t value{};
+        uint32_t size{};
+        uint32_t operation{};
+    };
+
+    static_assert(sizeof(memory_access_record) == 24);
+
+    inline constexpr auto memory_access_record_format = "<QQII";
+
+    // Collects memory accesses without touching the GIL and hands them to Python in chunks, as a read-only
+    // memoryview over the native record buffer. The view is released after the callback. If the callback kept
+    // an export of it, the buffer is handed over to the view and a fresh one is used for the next chunk.
+    class memory_access_batch
+    {
+      public:
+        memory_access_batch(nb::object callback, size_t batch_size);
+        ~memory_access_batch();
+
+        memory_access_batch(const memory_access_batch&) = delete;
+        memory_access_batch& operator=(const memory_access_batch&) = delete;
+        memory_access_batch(memory_access_batch&&) = delete;
+        memory_access_batch& operator=(memory_access_batch&&) = delete;
+
+        void record(uint64_t address, const void* data, size_t length, memory_operation operation);
+
+        // Delivers everything recorded so far. Must be called without holding the GIL.
+        void flush();
+
+      private:
+        void release_view(nb::handle view) noexcept;
+
+        nb::object callback_{};
+        size_t batch_size_{};
+
+        std::mutex mutex_{};
+        std::vector<memory_access_record> records_{};
+
+        std::recursive_mutex delivery_mutex_{};
+        std::vector<memory_access_record> pending_{};
+        bool delivering_{false};
+    };
+
+    emulator_hook* hook_memory_access(sogen::x86_64_emulator& emu, memory_operation operation, uint64_t address, uint64_t size,
+                                      nb::object callback, size_t batch_size, std::vector<std::shared_ptr<memory_access_batch>>& batches);
+
+    // Flushes all batches and forgets the ones whose hook is gone. Must be called without holding the GIL.
+    void flush_memory_access_batches(std::vector<std::shared_ptr<memory_access_batch>>& batches);
+
+    void read_memory_into(const memory_interface& memory, uint64_t address, nb::handle out);
+
     // Wrapper holding bound hook lifetimes for the various low-level emulator hooks
     // (memory_execution, instruction, basic_block, ...).
     struct hook_registry
@@ -153,6 +209,7 @@ namespace sogen::py
         windows_emulator* emu{};
         std::shared_ptr<api_hook_registry> apis{};
         std::vector<hook_handle> active_hooks{};
+        std::vector<std::shared_ptr<memory_access_batch>> batches{};
 
         explicit hook_registry(windows_emulator& emulator);
 
@@ -162,6 +219,9 @@ namespace sogen::py
         hook_handle memory_execution_at(uint64_t address, nb::object callback);
         hook_handle memory_read(uint64_t address, uint64_t size, nb::object callback);
         hook_handle memory_write(uint64_t address, uint64_t size, nb::object callback);
+        hook_handle memory_read_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size);
+        hook_handle memory_write_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size);
+        void flush_batches();
         hook_handle instruction(x86_hookable_instructions instruction_type, nb::object callback);
         hook_handle interrupt(nb::object callback);
         hook_handle memory_violation(nb::object callback);
@@ -261,6 +321,7 @@ namespace sogen::py
         std::optional<uint32_t> current_thread_id() const;
 
         nb::bytes read_memory(uint64_t address, size_t size) const;
+        void read_memory_into(uint64_t address, nb::handle out) const;
         void write_memory(uint64_t address, const nb::bytes& buffer) const;
         uint64_t read_register(x86_register reg) const;
         void write_register(x86_register reg, uint64_t value) const;
@@ -416,6 +477,7 @@ namespace sogen::py
         linux_emulator* emu{};
         std::shared_ptr<linux_symbol_hook_registry> symbols{};
         std::vector<hook_handle> active_hooks{};
+        std::vector<std::shared_ptr<memory_access_batch>> batches{};
 
         explicit linux_hook_registry(linux_emulator& emulator);
 
@@ -425,6 +487,9 @@ namespace sogen::py
         hook_handle memory_execution_at(uint64_t address, nb::object callback);
         hook_handle memory_read(uint64_t address, uint64_t size, nb::object callback);
         hook_handle memory_write(uint64_t address, uint64_t size, nb::object callback);
+        hook_handle memory_read_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size);
+        hook_handle memory_write_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size);
+        void flush_batches();
         hook_handle instruction(x86_hookable_instructions instruction_type, nb::object callback);
         hook_handle interrupt(nb::object callback);
         hook_handle basic_block(nb::object callback);
@@ -493,6 +558,7 @@ namespace sogen::py
 
         linux_memory_manager& memory() const;
         nb::bytes read_memory(uint64_t address, size_t size) const;
+        void read_memory_into(uint64_t address, nb::handle out) const;
         void write_memory(uint64_t address, const nb::bytes& buffer) const;
         uint64_t read_register(x86_register reg) const;
         void write_register(x86_register reg, uint64_t value) const;
@@ -60,6 +60,23 @@ namespace sogen::py
         return make_hook(hook);
     }
 
+    hook_handle hook_registry::memory_read_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size)
+    {
+        return make_hook(
+            hook_memory_access(this->emu->emu(), memory_operation::read, address, size, std::move(callback), batch_size, this->batches));
+    }
+
+    hook_handle hook_registry::memory_write_batched(uint64_t address, uint64_t size, nb::object callback, size_t batch_size)
+    {
+        return make_hook(
+            hook_memory_access(this->emu->emu(), memory_operation::write, address, size, std::move(callback), batch_size, this->batches));
+    }
+
+    void hook_registry::flush_batches()
+    {
+        flush_memory_access_batches(this->batches);
+    }
+
     hook_handle hook_registry::instruction(x86_hookable_instructions instruction_type, nb::object callback)
     {
         auto* hook = this->emu->emu().hook_instruction(instruction_type, [cb = std::move(callback)](cpu_interface&, uint64_t data) {
@@ -162,6 +179,7 @@ namespace sogen::py
     void sogen_windows_emulator::start(const size_t count) const
     {
         this->emu->start(count);
+        this->hooks->flush_batches();
     }
 
     void sogen_windows_emulator::stop() const
@@ -224,6 +242,11 @@ namespace sogen::py
         return read_memory_bytes(this->emu->memory, address, size);
     }
 
+    void sogen_windows_emulator::read_memory_into(const uint64_t address, const nb::handle out) const
+    {
+        sogen::py::read_memory_into(this->emu->memory, address, out);
+    }
+
     void sogen_windows_emulator::write_memory(const uint64_t address, const nb::bytes& buffer) const
     {
         write_memory_bytes(this->emu->memory, address, buffer);
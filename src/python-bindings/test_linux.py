@@ -3,6 +3,7 @@ import ctypes
 import os
 import shutil
 import socket
+import struct
 import subprocess
 import sys
 import threading
@@ -202,6 +203,18 @@ execution_hits = []
 read_hits = []
 write_hits = []
 instruction_hits = []
+batched_accesses = []
+kept_batches = []
+
+
+def on_access_batch(view):
+    assert view.readonly
+    batched_accesses.extend(struct.iter_unpack(sogen.MEMORY_ACCESS_RECORD_FORMAT, view))
+
+
+def keep_access_batch(view):
+    # The iterator keeps an export of the view alive past the callback.
+    kept_batches.append(struct.iter_unpack(sogen.MEMORY_ACCESS_RECORD_FORMAT, view))
 
 
 def on_cpuid(data):
@@ -215,6 +228,9 @@ hook_handles = [
     hook_emu.hooks.memory_read(0x200000, 8, lambda address, data: read_hits.append((address, bytes(data)))),
     hook_emu.hooks.memory_write(0x200008, 8, lambda address, data: write_hits.append((address, bytes(data)))),
     hook_emu.hooks.instruction(sogen.Instruction.cpuid, on_cpuid),
+    hook_emu.hooks.memory_read_batched(0x200000, 16, on_access_batch),
+    hook_emu.hooks.memory_write_batched(0x200000, 16, on_access_batch),
+    hook_emu.hooks.memory_read_batched(0x200000, 16, keep_access_batch),
 ]
 assert all(handle.active is True for handle in hook_handles)
 hook_emu.start(50)
@@ -224,6 +240,16 @@ assert read_hits == [(0x200000, b"ABCDEFGH")]
 assert write_hits == [(0x200008, b"ABCDEFGH")]
 assert instruction_hits, "cpuid instruction hook did not fire"
 assert hook_emu.read_memory(0x200008, 8) == b"ABCDEFGH"
+value = int.from_bytes(b"ABCDEFGH", "little")
+assert batched_accesses == [
+    (0x200000, value, 8, int(sogen.MemoryOperation.read)),
+    (0x200008, value, 8, int(sogen.MemoryOperation.write)),
+]
+assert [list(records) for records in kept_batches] == [[(0x200000, value, 8, int(sogen.MemoryOperation.read))]]
+kept_batches = None
+into = bytearray(8)
+hook_emu.read_memory(0x200008, into)
+assert into == b"ABCDEFGH"
 for handle in hook_handles:
     handle.remove()
     assert handle.active is False
@@ -16,10 +16,12 @@
 #include <cstdio>
 #include <cstring>
 #include <mutex>
+#include <span>
 #include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #define VK_NO_PROTOTYPES
@@ -28,6 +30,7 @@
 #define VK_USE_PLATFORM_WIN32_KHR
 #include <vulkan/vulkan_win32.h>
 
+#include <command_stream.hpp>
 #include <gpu_bridge_protocol.hpp>
 #include <vk_feature_chain.hpp>
 
@@ -135,6 +138,9 @@ namespace
     // Flushes the coalesced descriptor-set updates (see vkUpdateDescriptorSets); defined below.
     void flush_descriptor_updates();
 
+    // Sends finished command-buffer recordings still waiting for a submit (see g_pending_commands); defined below.
+    void flush_command_batch();
+
     bool bridge_call(uint32_t code, const void* in, DWORD in_len, void* out, DWORD out_len)
     {
         // Every other bridge call may make the host observe descriptor state (record, submit, ...), so drain
@@ -142,6 +148,12 @@ namespace
         if (code != gb::ioctl_update_descriptor_sets_batch)
         {
             flush_descriptor_updates();
+
+            // Recordings are replayed after the descriptor updates that preceded their submit, as before.
+            if (code != gb::ioctl_record_commands)
+            {
+                flush_command_batch();
+            }
         }
 
         const HANDLE handle = bridge();
@@ -250,10 +262,10 @@ namespace
     }
 
     // Command-buffer recording is batched: instead of one IOCTL per vkCmd*, each command is appended to a
-    // per-command-buffer byte stream and the whole stream (begin -> cmds -> end) is flushed to the bridge
-    // in a single IOCTL at vkEndCommandBuffer. This amortises the boundary crossing, which dominates
-    // emulated frame time. The shim only runs inside the single-threaded emulator, so the map needs no
-    // lock. Each record is a gb::command_record_header followed by that command's request payload.
+    // per-command-buffer byte stream, and vkEndCommandBuffer moves the whole stream (begin -> cmds -> end)
+    // into g_pending_commands. This amortises the boundary crossing, which dominates emulated frame time.
+    // The shim only runs inside the single-threaded emulator, so the map needs no lock. Each record is a
+    // gb::command_record_header followed by that command's request payload.
     std::unordered_map<gb::object_id, std::vector<uint8_t>> g_command_streams;
 
     // Pending coalesced vkUpdateDescriptorSets blobs (the hottest bridge call - DXVK updates per draw).
@@ -284,12 +296,39 @@ namespace
 
     void record_command(gb::object_id command_buffer, gb::command command, const void* payload, size_t size)
     {
-        auto& stream = g_command_streams[command_buffer];
-        gb::command_record_header header{.command = static_cast<uint32_t>(command), .size = static_cast<uint32_t>(size)};
-        const auto* header_bytes = reinterpret_cast<const uint8_t*>(&header);
-        stream.insert(stream.end(), header_bytes, header_bytes + sizeof(header));
-        const auto* payload_bytes = reinterpret_cast<const uint8_t*>(payload);
-        stream.insert(stream.end(), payload_bytes, payload_bytes + size);
+        gb::append_command_record(g_command_streams[command_buffer], command, payload, size);
+    }
+
+    // Finished recordings of the current frame. They cross the bridge together with the next vkQueueSubmit,
+    // whose submissions are appended behind them, so a frame costs one IOCTL per submit instead of one per
+    // command buffer plus one per submitted command buffer. Every other bridge call flushes the batch first
+    // (see bridge_call), so the host sees commands in the same order as without batching. Like the
+    // descriptor updates this is shared by all threads, hence the mutex.
+    gb::command_batcher g_pending_commands{[](const std::span<const uint8_t> batch) {
+        // bridge_call skips the batch flush for record_commands, so this cannot re-enter.
+        gb::result_response response{};
+        if (!bridge_call(gb::ioctl_record_commands, batch.data(), static_cast<DWORD>(batch.size()), &response, sizeof(response)))
+        {
+            response.vk_result = VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        return response.vk_result;
+    }};
+
+    // Held across the IOCTL for the same ordering reason as in flush_descriptor_updates.
+    std::mutex g_pending_commands_mutex;
+
+    void flush_command_batch()
+    {
+        std::lock_guard<std::mutex> lock(g_pending_commands_mutex);
+        g_pending_commands.flush();
+    }
+
+    // Sends the batch with the submissions just added to it and reports any replay failure since the last
+    // submit. Caller holds g_pending_commands_mutex.
+    VkResult submit_command_batch_locked()
+    {
+        return g_pending_commands.submit() == VK_SUCCESS ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
     }
 
     // OutputDebugStringA is unbuffered; printf mirrors it to stdout, which the emulator captures.
@@ -826,12 +865,10 @@ extern "C"
         const std::vector<uint8_t> stream = std::move(it->second);
         g_command_streams.erase(it);
 
-        gb::result_response response{};
-        if (!bridge_call(gb::ioctl_record_commands, stream.data(), static_cast<DWORD>(stream.size()), &response, sizeof(response)))
-        {
-            return VK_ERROR_INITIALIZATION_FAILED;
-        }
-        return static_cast<VkResult>(response.vk_result);
+        // The recording waits for the next submit (see g_pending_commands); a replay failure surfaces there.
+        std::lock_guard<std::mutex> lock(g_pending_commands_mutex);
+        g_pending_commands.add_recording(stream);
+        return VK_SUCCESS;
     }
 
     __declspec(dllexport) VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice device, VkCommandPool commandPool,
@@ -1205,53 +1242,37 @@ extern "C"
 
         // A zero-batch submission (no command buffers) is still a valid fence signal in Vulkan. Forward
         // a fence-only submit so a later vkWaitForFences doesn't spin forever on an unsignaled fence.
-        if (total == 0)
+        if (total == 0 && !fence)
         {
-            if (!fence)
-            {
-                return VK_SUCCESS;
-            }
-
-            gb::queue_submit_request request{};
-            request.queue = to_object_id(queue);
-            request.command_buffer = gb::null_object;
-            request.fence = to_object_id(fence);
-
-            gb::result_response response{};
-            if (!bridge_call(gb::ioctl_queue_submit, &request, sizeof(request), &response, sizeof(response)) ||
-                response.vk_result != VK_SUCCESS)
-            {
-                return VK_ERROR_INITIALIZATION_FAILED;
-            }
             return VK_SUCCESS;
         }
 
+        // The submissions ride behind the pending recordings, so the frame crosses the bridge in one IOCTL.
+        std::lock_guard<std::mutex> lock(g_pending_commands_mutex);
+        if (total == 0)
+        {
+            g_pending_commands.add_submit(
+                {.queue = to_object_id(queue), .command_buffer = gb::null_object, .fence = to_object_id(fence)});
+        }
+
         uint32_t emitted = 0;
         for (uint32_t s = 0; s < submitCount; ++s)
         {
             for (uint32_t i = 0; i < pSubmits[s].commandBufferCount; ++i)
             {
                 ++emitted;
-
-                gb::queue_submit_request request{};
-                request.queue = to_object_id(queue);
-                request.command_buffer = to_object_id(pSubmits[s].pCommandBuffers[i]);
-                request.fence = (emitted == total) ? to_object_id(fence) : gb::null_object;
-
-                gb::result_response response{};
-                if (!bridge_call(gb::ioctl_queue_submit, &request, sizeof(request), &response, sizeof(response)) ||
-                    response.vk_result != VK_SUCCESS)
-                {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
+                g_pending_commands.add_submit({.queue = to_object_id(queue),
+                                               .command_buffer = to_object_id(pSubmits[s].pCommandBuffers[i]),
+                                               .fence = (emitted == total) ? to_object_id(fence) : gb::null_object});
             }
         }
-        return VK_SUCCESS;
+        return submit_command_batch_locked();
     }
 
     // synchronization2 submit: DXVK uses this for queue submission. Marshal each VkSubmitInfo2 (wait
     // semaphores, command buffers, signal semaphores) and forward to the host's real vkQueueSubmit2,
-    // which has the real timeline semaphores. The fence is attached to the final submission.
+    // which has the real timeline semaphores. The fence is attached to the final submission. As in
+    // vkQueueSubmit, all submissions join the pending recordings in one record_commands IOCTL.
     __declspec(dllexport) VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit2(VkQueue queue, uint32_t submitCount, const VkSubmitInfo2* pSubmits,
                                                                         VkFence fence)
     {
@@ -1263,57 +1284,44 @@ extern "C"
             submitCount = fence ? 1 : 0;
         }
 
+        std::lock_guard<std::mutex> lock(g_pending_commands_mutex);
         for (uint32_t s = 0; s < submitCount; ++s)
         {
             const VkSubmitInfo2& si = pSubmits[s];
-            const uint32_t wait_count = si.waitSemaphoreInfoCount;
-            const uint32_t cmd_count = si.commandBufferInfoCount;
-            const uint32_t signal_count = si.signalSemaphoreInfoCount;
-
-            std::vector<uint8_t> message(sizeof(gb::queue_submit2_request) +
-                                         static_cast<size_t>(wait_count + signal_count) * sizeof(gb::submit2_semaphore_entry) +
-                                         static_cast<size_t>(cmd_count) * sizeof(uint64_t));
-            auto* header = reinterpret_cast<gb::queue_submit2_request*>(message.data());
-            header->queue = to_object_id(queue);
-            header->fence = (s + 1 == submitCount) ? to_object_id(fence) : gb::null_object;
-            header->wait_count = wait_count;
-            header->command_buffer_count = cmd_count;
-            header->signal_count = signal_count;
-            header->reserved = 0;
-
-            size_t offset = sizeof(*header);
-            auto* waits = reinterpret_cast<gb::submit2_semaphore_entry*>(message.data() + offset);
-            for (uint32_t i = 0; i < wait_count; ++i)
+
+            std::vector<gb::submit2_semaphore_entry> waits(si.waitSemaphoreInfoCount);
+            for (uint32_t i = 0; i < si.waitSemaphoreInfoCount; ++i)
             {
                 waits[i] = {.semaphore = to_object_id(si.pWaitSemaphoreInfos[i].semaphore),
                             .value = si.pWaitSemaphoreInfos[i].value,
                             .stage_mask = si.pWaitSemaphoreInfos[i].stageMask};
             }
-            offset += static_cast<size_t>(wait_count) * sizeof(gb::submit2_semaphore_entry);
 
-            auto* cmds = reinterpret_cast<uint64_t*>(message.data() + offset);
-            for (uint32_t i = 0; i < cmd_count; ++i)
+            std::vector<gb::object_id> cmds(si.commandBufferInfoCount);
+            for (uint32_t i = 0; i < si.commandBufferInfoCount; ++i)
             {
                 cmds[i] = to_object_id(si.pCommandBufferInfos[i].commandBuffer);
             }
-            offset += static_cast<size_t>(cmd_count) * sizeof(uint64_t);
 
-            auto* signals = reinterpret_cast<gb::submit2_semaphore_entry*>(message.data() + offset);
-            for (uint32_t i = 0; i < signal_count; ++i)
+            std::vector<gb::submit2_semaphore_entry> signals(si.signalSemaphoreInfoCount);
+            for (uint32_t i = 0; i < si.signalSemaphoreInfoCount; ++i)
             {
                 signals[i] = {.semaphore = to_object_id(si.pSignalSemaphoreInfos[i].semaphore),
                               .value = si.pSignalSemaphoreInfos[i].value,
                               .stage_mask = si.pSignalSemaphoreInfos[i].stageMask};
             }
 
-            gb::result_response response{};
-            if (!bridge_call(gb::ioctl_queue_submit2, message.data(), static_cast<DWORD>(message.size()), &response, sizeof(response)) ||
-                response.vk_result != VK_SUCCESS)
-            {
-                return VK_ERROR_INITIALIZATION_FAILED;
-            }
+            const gb::queue_submit2_request header{
+                .queue = to_object_id(queue),
+                .fence = (s + 1 == submitCount) ? to_object_id(fence) : gb::null_object,
+                .wait_count = si.waitSemaphoreInfoCount,
+                .command_buffer_count = si.commandBufferInfoCount,
+                .signal_count = si.signalSemaphoreInfoCount,
+                .reserved = 0,
+            };
+            g_pending_commands.add_submit2(header, waits, cmds, signals);
         }
-        return VK_SUCCESS;
+        return submit_command_batch_locked();
     }
 
     // Poll-and-yield: the host endpoint only ever does a non-blocking vkGetFenceStatus, so the host
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include <ui_backends/frame_capture.hpp>
+
+// Turns a frame capture written by the capture UI backend (analyzer --capture) into one PNG per frame and
+// window, named window-<handle>-<frame>.png so the frames of a window can be fed to a video encoder in order.
+int main(const int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        (void)fprintf(stderr, "Usage: %s <capture file> <output directory>\n", argv[0]);
+        return 1;
+    }
+
+    const std::filesystem::path capture_path = argv[1];
+    const std::filesystem::path output_path = argv[2];
+
+    try
+    {
+        std::filesystem::create_directories(output_path);
+
+        sogen::frame_capture::decoder decoder{capture_path};
+        std::unordered_map<uint32_t, uint64_t> frame_counts{};
+        uint64_t total_frames = 0;
+
+        while (const auto frame = decoder.next())
+        {
+            const auto& header = frame->header;
+            const auto index = frame_counts[header.window]++;
+
+            char file_name[64]{};
+            (void)snprintf(file_name, sizeof(file_name), "window-%X-%06llu.png", header.window, static_cast<unsigned long long>(index));
+
+            sogen::frame_capture::write_png(output_path / file_name, header.width, header.height, frame->pixels, header.format);
+            ++total_frames;
+        }
+
+        (void)printf("Wrote %llu frames of %zu windows to %s\n", static_cast<unsigned long long>(total_frames), frame_counts.size(),
+                     output_path.string().c_str());
+    }
+    catch (const std::exception& e)
+    {
+        (void)fprintf(stderr, "Failed to export frame capture: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <vector>
+
+#include <registry/registry_cache.hpp>
+
+// Compiles the hives of an emulation root, plus optional .reg files, into the registry cache that
+// registry_manager picks up on startup. Runs only use it when they apply the same .reg files in the same order.
+int main(const int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        (void)fprintf(stderr, "Usage: %s <registry directory> [file.reg ...]\n", argv[0]);
+        return 1;
+    }
+
+    const std::filesystem::path hive_path = argv[1];
+    const std::vector<std::filesystem::path> registry_files(argv + 2, argv + argc);
+    const auto output = hive_path / sogen::registry_cache::file_name;
+
+    try
+    {
+        sogen::registry_cache::compile(hive_path, registry_files, output);
+    }
+    catch (const std::exception& e)
+    {
+        (void)fprintf(stderr, "Failed to compile registry cache: %s\n", e.what());
+        return 1;
+    }
+
+    (void)printf("Wrote %s\n", output.string().c_str());
+    return 0;
+}
@@ -17,7 +17,6 @@ namespace sogen
 
     namespace
     {
-        constexpr size_t MAX_INSTRUCTION_BYTES = 15;
         constexpr uint64_t SYSCALL_INSTRUCTION_SIZE = 2;
 
         template <typename Return, typename... Args>
@@ -36,26 +35,6 @@ namespace sogen
             };
         }
 
-        std::string get_instruction_string(const disassembler& d, x86_64_cpu& emu, const uint64_t address)
-        {
-            std::array<uint8_t, MAX_INSTRUCTION_BYTES> instruction_bytes{};
-            const auto result = emu.try_read_memory(address, instruction_bytes.data(), instruction_bytes.size());
-            if (!result)
-            {
-                return {};
-            }
-
-            const auto reg_cs = emu.reg<uint16_t>(x86_register::cs);
-            const auto instructions = d.disassemble(emu, reg_cs, instruction_bytes, 1, address);
-            if (instructions.empty())
-            {
-                return {};
-            }
-
-            const auto& inst = instructions[0];
-            return std::string(inst.mnemonic) + (strlen(inst.op_str) ? " "s + inst.op_str : "");
-        }
-
         bool is_int_resource(const uint64_t address)
         {
             return (address >> 0x10) == 0;
@@ -151,14 +130,15 @@ namespace sogen
             return details;
         }
 
-        void handle_suspicious_activity(const analysis_context& c, const std::string_view details)
+        void handle_suspicious_activity(analysis_context& c, const std::string_view details)
         {
             std::string decoded_instruction{};
             const auto rip = c.win_emu->emu().read_instruction_pointer();
 
             if (details == "Illegal instruction")
             {
-                decoded_instruction = get_instruction_string(c.d, c.win_emu->emu(), rip);
+                const auto* instruction = c.code_cache.get_instruction(c.win_emu->emu(), rip);
+                decoded_instruction = instruction ? instruction->text : std::string{};
             }
 
             c.emit_observation<suspicious_activity_event>([&](auto& event) {
@@ -191,9 +171,71 @@ namespace sogen
             }
         }
 
-        void handle_memory_allocate(const analysis_context& c, const uint64_t address, const uint64_t length,
+        void watch_code_range(analysis_context& c, const uint64_t address, const uint64_t length)
+        {
+            auto* hook = c.win_emu->emu().hook_memory_write(address, length,
+                                                            [&c](cpu_interface&, const uint64_t write_address, const void*, size_t size) {
+                                                                c.code_cache.invalidate(write_address, size); //
+                                                            });
+
+            c.watched_code_ranges[{address, length}] = hook;
+        }
+
+        // Stops watching writes to [address, address + length). Parts of watched ranges outside of it stay watched.
+        void unwatch_code_range(analysis_context& c, const uint64_t address, const uint64_t length)
+        {
+            const auto end = address + length;
+            std::vector<std::pair<uint64_t, uint64_t>> remainders{};
+
+            for (auto entry = c.watched_code_ranges.begin(); entry != c.watched_code_ranges.end();)
+            {
+                const auto [range_start, range_length] = entry->first;
+                const auto range_end = range_start + range_length;
+                if (range_end <= address || range_start >= end)
+                {
+                    ++entry;
+                    continue;
+                }
+
+                c.win_emu->emu().delete_hook(entry->second);
+
+                if (range_start < address)
+                {
+                    remainders.emplace_back(range_start, address - range_start);
+                }
+
+                if (range_end > end)
+                {
+                    remainders.emplace_back(end, range_end - end);
+                }
+
+                entry = c.watched_code_ranges.erase(entry);
+            }
+
+            for (const auto& [remainder_start, remainder_length] : remainders)
+            {
+                watch_code_range(c, remainder_start, remainder_length);
+            }
+        }
+
+        // Keeps decoded code in sync with guest memory. Pages that are writable and executable at once can
+        // change without any protection change, so writes to them are watched.
+        void track_code_range(analysis_context& c, const uint64_t address, const uint64_t length, const memory_permission permission)
+        {
+            c.code_cache.invalidate(address, length);
+            unwatch_code_range(c, address, length);
+
+            if (is_executable(permission) && is_writable(permission))
+            {
+                watch_code_range(c, address, length);
+            }
+        }
+
+        void handle_memory_allocate(analysis_context& c, const uint64_t address, const uint64_t length,
                                     const memory_permission permission, const bool commit)
         {
+            track_code_range(c, address, length, permission);
+
             if (!c.settings->skip_generic_activity)
             {
                 c.emit_observation<memory_allocate_event>([&](auto& event) {
@@ -205,9 +247,10 @@ namespace sogen
             }
         }
 
-        void handle_memory_protect(const analysis_context& c, const uint64_t address, const uint64_t length,
-                                   const memory_permission permission)
+        void handle_memory_protect(analysis_context& c, const uint64_t address, const uint64_t length, const memory_permission permission)
         {
+            track_code_range(c, address, length, permission);
+
             if (!c.settings->skip_generic_activity)
             {
                 c.emit_observation<memory_protect_event>([&](auto& event) {
@@ -218,6 +261,12 @@ namespace sogen
             }
         }
 
+        void handle_memory_release(analysis_context& c, const uint64_t address, const uint64_t length)
+        {
+            c.code_cache.invalidate(address, length);
+            unwatch_code_range(c, address, length);
+        }
+
         void handle_memory_violate(const analysis_context& c, const uint64_t address, const uint64_t size, const memory_operation operation,
                                    const memory_violation_type type)
         {
@@ -298,8 +347,10 @@ namespace sogen
             });
         }
 
-        void handle_thread_terminated(const analysis_context& c, handle, emulator_thread& t)
+        void handle_thread_terminated(analysis_context& c, handle, emulator_thread& t)
         {
+            c.thread_blocks.erase(t.id);
+
             if (!c.settings->skip_generic_activity)
             {
                 c.emit_observation<thread_terminated_event>([&](auto& event) { event.terminated_thread_id = t.id; });
@@ -325,16 +376,25 @@ namespace sogen
             }
         }
 
-        void handle_module_load(const analysis_context& c, const mapped_module& mod)
+        void handle_module_load(analysis_context& c, const mapped_module& mod)
         {
+            c.code_cache.invalidate(mod.image_base, mod.size_of_image);
+
+            for (const auto& section : mod.sections)
+            {
+                track_code_range(c, section.region.start, section.region.length, section.region.permissions);
+            }
+
             c.emit_observation<module_load_event>([&](auto& event) {
                 event.path = mod.module_path.string();
                 event.image_base = mod.image_base;
             });
         }
 
-        void handle_module_unload(const analysis_context& c, const mapped_module& mod)
+        void handle_module_unload(analysis_context& c, const mapped_module& mod)
         {
+            c.code_cache.invalidate(mod.image_base, mod.size_of_image);
+
             c.emit_observation<module_unload_event>([&](auto& event) {
                 event.path = mod.module_path.string();
                 event.image_base = mod.image_base;
@@ -397,45 +457,93 @@ namespace sogen
             }
         }
 
-        bool is_return(const disassembler& d, x86_64_cpu& emu, const uint64_t address)
+        bool is_return(analysis_context& c, const uint64_t address)
         {
-            std::array<uint8_t, MAX_INSTRUCTION_BYTES> instruction_bytes{};
-            const auto result = emu.try_read_memory(address, instruction_bytes.data(), instruction_bytes.size());
-            if (!result)
+            const auto* instruction = c.code_cache.get_instruction(c.win_emu->emu(), address);
+            return instruction && instruction->is_return;
+        }
+
+        bool is_summarized_address(const analysis_context& c, const uint64_t address)
+        {
+            auto& mod_manager = c.win_emu->mod_manager;
+            if (mod_manager.executable->contains(address))
             {
-                return false;
+                return true;
             }
 
-            const auto reg_cs = emu.reg<uint16_t>(x86_register::cs);
-            const auto instructions = d.disassemble(emu, reg_cs, instruction_bytes, 1, address);
-            if (instructions.empty())
+            const auto* binary = mod_manager.find_by_address(address);
+            return !binary || c.settings->modules.contains(binary->name);
+        }
+
+        // Code is traced and counted per basic block when it is entered, which leaves on_instruction unset so
+        // the emulator can account for instructions per block as well. Only valid when blocks cannot run
+        // concurrently on several vCPUs, as the block hook runs outside the emulator's own serialization. The
+        // web debugger pumps its events per instruction and keeps the instruction path.
+        bool uses_block_tracing(const analysis_context& c)
+        {
+#if defined(OS_EMSCRIPTEN) && !defined(SOGEN_EMSCRIPTEN_SUPPORT_NODEJS)
+            return false;
+#else
+            auto& emu = c.win_emu->emu();
+            return !c.settings->trace_every_instruction && emu.supports_basic_block_hooks() && c.win_emu->vcpu_count() == 1;
+#endif
+        }
+
+        // Address of the last instruction in [address, address + size), decoded from the start of the range.
+        uint64_t find_last_instruction(analysis_context& c, const uint64_t address, const uint64_t size)
+        {
+            auto& emu = c.win_emu->emu();
+            auto current = address;
+
+            while (true)
             {
-                return false;
+                const auto* instruction = c.code_cache.get_instruction(emu, current);
+                if (!instruction || current + instruction->size >= address + size)
+                {
+                    return current;
+                }
+
+                current += instruction->size;
+            }
+        }
+
+        // Whether control reached the current code through a return. With block tracing, where only block
+        // starts are seen, that is the last instruction of the block entered before.
+        bool was_entered_by_return(analysis_context& c, const emulator_thread& thread)
+        {
+            if (!uses_block_tracing(c))
+            {
+                return is_return(c, thread.previous_ip);
             }
 
-            const auto handle = d.resolve_handle(emu, reg_cs);
-            return cs_insn_group(handle, instructions.data(), CS_GRP_RET);
+            const auto& previous = c.thread_blocks[thread.id].previous;
+            return previous.size > 0 && is_return(c, find_last_instruction(c, previous.address, previous.size));
         }
 
-        void record_instruction(analysis_context& c, const uint64_t address)
+        // The instruction executed right before the syscall that `address` points behind. With block tracing it
+        // lies in the block entered before if the syscall starts its block, and in the syscall's block otherwise.
+        uint64_t get_syscall_predecessor(analysis_context& c, const uint64_t address)
         {
-            auto& emu = c.win_emu->emu();
-            std::array<uint8_t, MAX_INSTRUCTION_BYTES> instruction_bytes{};
-            const auto result = emu.try_read_memory(address, instruction_bytes.data(), instruction_bytes.size());
-            if (!result)
+            const auto& thread = c.win_emu->current_thread();
+            if (!uses_block_tracing(c))
             {
-                return;
+                return thread.previous_ip;
             }
 
-            const auto reg_cs = emu.reg<uint16_t>(x86_register::cs);
-            disassembler disasm{};
-            const auto instructions = disasm.disassemble(emu, reg_cs, instruction_bytes, 1, address);
-            if (instructions.empty())
+            const auto& blocks = c.thread_blocks[thread.id];
+            const auto syscall_address = address - SYSCALL_INSTRUCTION_SIZE;
+
+            if (blocks.current.size == 0)
             {
-                return;
+                return 0;
             }
 
-            ++c.instructions[instructions[0].id];
+            if (blocks.current.address != syscall_address)
+            {
+                return find_last_instruction(c, blocks.current.address, syscall_address - blocks.current.address);
+            }
+
+            return blocks.previous.size > 0 ? find_last_instruction(c, blocks.previous.address, blocks.previous.size) : 0;
         }
 
         uint64_t next_traced_call_count(analysis_context& c)
@@ -489,22 +597,14 @@ namespace sogen
             });
         }
 
-        void handle_instruction(analysis_context& c, const uint64_t address)
+        // Traces entering the code at `address`. previous_ip is the instruction executed before, or with block
+        // tracing the start of the block entered before, which lies in the same module.
+        void trace_code_entry(analysis_context& c, const uint64_t address, const uint64_t previous_ip)
         {
             auto& win_emu = *c.win_emu;
             update_import_access(c, address);
 
-#if defined(OS_EMSCRIPTEN) && !defined(SOGEN_EMSCRIPTEN_SUPPORT_NODEJS)
-            if ((win_emu.get_executed_instructions() % 0x20000) == 0)
-            {
-                debugger::event_context ec{.win_emu = win_emu};
-                debugger::handle_events(ec);
-            }
-#endif
-
             const auto& current_thread = c.win_emu->current_thread();
-            const auto previous_ip = current_thread.previous_ip;
-            [[maybe_unused]] const auto current_ip = current_thread.current_ip;
             const auto is_main_exe = win_emu.mod_manager.executable->contains(address);
             const auto is_previous_main_exe = win_emu.mod_manager.executable->contains(previous_ip);
 
@@ -539,11 +639,6 @@ namespace sogen
                 return is_current_binary_interesting || (previous_binary && c.settings->modules.contains(previous_binary->name));
             };
 
-            if (c.settings->instruction_summary && (is_current_binary_interesting || !binary))
-            {
-                record_instruction(c, address);
-            }
-
             const auto is_interesting_call = is_previous_main_exe                                              //
                                              || (!previous_binary && current_thread.executed_instructions > 1) //
                                              || is_in_interesting_module();
@@ -573,7 +668,7 @@ namespace sogen
             {
                 c.emit_observation<entry_point_execution_event>([&](auto& event) { event.interesting = is_interesting_call; });
             }
-            else if (is_previous_main_exe && binary != previous_binary && !is_return(c.d, c.win_emu->emu(), previous_ip))
+            else if (is_previous_main_exe && binary != previous_binary && !was_entered_by_return(c, current_thread))
             {
                 auto nearest_entry = binary->address_names.upper_bound(address);
                 if (nearest_entry == binary->address_names.begin())
@@ -590,6 +685,38 @@ namespace sogen
             }
         }
 
+        void handle_instruction(analysis_context& c, const uint64_t address)
+        {
+#if defined(OS_EMSCRIPTEN) && !defined(SOGEN_EMSCRIPTEN_SUPPORT_NODEJS)
+            if ((c.win_emu->get_executed_instructions() % 0x20000) == 0)
+            {
+                debugger::event_context ec{.win_emu = *c.win_emu};
+                debugger::handle_events(ec);
+            }
+#endif
+
+            if (c.settings->instruction_summary && is_summarized_address(c, address))
+            {
+                c.code_cache.count_instruction(c.win_emu->emu(), address);
+            }
+
+            trace_code_entry(c, address, c.win_emu->current_thread().previous_ip);
+        }
+
+        void handle_block(analysis_context& c, const basic_block& block)
+        {
+            auto& blocks = c.thread_blocks[c.win_emu->current_thread().id];
+            blocks.previous = blocks.current;
+            blocks.current = block;
+
+            if (c.settings->instruction_summary && is_summarized_address(c, block.address))
+            {
+                c.code_cache.count_block(c.win_emu->emu(), block.address, block.size);
+            }
+
+            trace_code_entry(c, block.address, blocks.previous.address);
+        }
+
         void handle_rdtsc(analysis_context& c)
         {
             auto& win_emu = *c.win_emu;
@@ -644,7 +771,7 @@ namespace sogen
 
             const auto* mod = win_emu.mod_manager.find_by_address(address);
             const auto is_sus_module = mod != win_emu.mod_manager.ntdll && mod != win_emu.mod_manager.win32u;
-            const auto previous_ip = win_emu.current_thread().previous_ip;
+            const auto previous_ip = get_syscall_predecessor(c, address);
             const auto is_valid_32_bit_module = utils::make_lazy([&] {
                 return mod                                                              //
                        && win_emu.process.is_wow64_process                              //
@@ -857,6 +984,7 @@ namespace sogen
         cb.on_memory_protect = make_callback(c, handle_memory_protect);
         cb.on_memory_violate = make_callback(c, handle_memory_violate);
         cb.on_memory_allocate = make_callback(c, handle_memory_allocate);
+        cb.on_memory_release = make_callback(c, handle_memory_release);
 
         (void)cb.on_module_load.add(make_callback(c, handle_module_load));
         (void)cb.on_module_unload.add(make_callback(c, handle_module_unload));
@@ -867,13 +995,23 @@ namespace sogen
         cb.on_thread_switch = make_callback(c, handle_thread_switch);
         cb.on_thread_set_name = make_callback(c, handle_thread_set_name);
 
-        cb.on_instruction = make_callback(c, handle_instruction);
         cb.on_debug_string.add(make_callback(c, handle_debug_string));
         cb.on_generic_access = make_callback(c, handle_generic_access);
         cb.on_generic_activity = make_callback(c, handle_generic_activity);
         cb.on_suspicious_activity = make_callback(c, handle_suspicious_activity);
         cb.on_fast_fail = make_callback(c, handle_fast_fail);
 
+        if (uses_block_tracing(c))
+        {
+            c.win_emu->emu().hook_basic_block([&c](cpu_interface&, const basic_block& block) {
+                handle_block(c, block); //
+            });
+        }
+        else
+        {
+            cb.on_instruction = make_callback(c, handle_instruction);
+        }
+
         watch_import_table(c);
     }
 
@@ -2,12 +2,13 @@
 
 #include <type_traits>
 #include <utility>
+#include <map>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "analysis_event.hpp"
-#include "disassembler.hpp"
+#include "instruction_cache.hpp"
 
 namespace sogen
 {
@@ -30,6 +31,7 @@ namespace sogen
         bool skip_generic_activity{false};
         bool reproducible{false};
         bool log_first_section_execution{false};
+        bool trace_every_instruction{false};
 
         string_set modules{};
         string_set ignored_functions{};
@@ -44,6 +46,13 @@ namespace sogen
         std::string import_module{};
     };
 
+    // The basic blocks a thread entered last, while code is traced per block rather than per instruction.
+    struct traced_blocks
+    {
+        basic_block current{};
+        basic_block previous{};
+    };
+
     struct analysis_context
     {
         const analysis_settings* settings{};
@@ -53,8 +62,9 @@ namespace sogen
         std::string output{};
         bool has_reached_main{false};
 
-        disassembler d{};
-        std::unordered_map<uint32_t, uint64_t> instructions{};
+        instruction_cache code_cache{};
+        std::map<std::pair<uint64_t, uint64_t>, emulator_hook*> watched_code_ranges{};
+        std::unordered_map<uint32_t, traced_blocks> thread_blocks{};
         std::vector<accessed_import> accessed_imports{};
         std::set<uint64_t> rdtsc_cache{};
         std::set<uint64_t> rdtscp_cache{};
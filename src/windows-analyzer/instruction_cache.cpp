@@ -0,0 +1,186 @@
+#include "std_include.hpp"
+#include "instruction_cache.hpp"
+
+namespace sogen
+{
+    namespace
+    {
+        constexpr size_t MAX_INSTRUCTION_BYTES = 15;
+        constexpr uint64_t PAGE_SIZE = 0x1000;
+
+        // Invalidating more pages than this drops the whole cache instead of tracking every page
+        constexpr uint64_t MAX_TRACKED_INVALIDATION_PAGES = 0x4000;
+    }
+
+    const instruction_cache::decoded_instruction* instruction_cache::get_instruction(x86_64_cpu& cpu, const uint64_t address)
+    {
+        const auto cs_selector = cpu.reg<uint16_t>(x86_register::cs);
+        auto& entry = this->instructions_[address];
+
+        const auto generation = this->get_generation(address, MAX_INSTRUCTION_BYTES);
+        if (entry.decoded && entry.generation == generation && entry.cs_selector == cs_selector)
+        {
+            return entry.valid ? &entry.instruction : nullptr;
+        }
+
+        entry = {};
+
+        std::array<uint8_t, MAX_INSTRUCTION_BYTES> instruction_bytes{};
+        if (!cpu.try_read_memory(address, instruction_bytes.data(), instruction_bytes.size()))
+        {
+            this->instructions_.erase(address);
+            return nullptr;
+        }
+
+        entry.generation = generation;
+        entry.cs_selector = cs_selector;
+        entry.decoded = true;
+
+        const auto instructions = this->disassembler_.disassemble(cpu, cs_selector, instruction_bytes, 1, address);
+        if (instructions.empty())
+        {
+            return nullptr;
+        }
+
+        const auto& inst = instructions[0];
+        const auto handle = this->disassembler_.resolve_handle(cpu, cs_selector);
+
+        entry.valid = true;
+        entry.instruction.id = inst.id;
+        entry.instruction.size = static_cast<uint8_t>(inst.size);
+        entry.instruction.is_return = cs_insn_group(handle, &inst, CS_GRP_RET);
+        entry.instruction.text = std::string(inst.mnemonic) + (strlen(inst.op_str) ? " "s + inst.op_str : "");
+
+        return &entry.instruction;
+    }
+
+    void instruction_cache::count_instruction(x86_64_cpu& cpu, const uint64_t address)
+    {
+        const auto* instruction = this->get_instruction(cpu, address);
+        if (instruction)
+        {
+            ++this->instruction_counts_[instruction->id];
+        }
+    }
+
+    void instruction_cache::count_block(x86_64_cpu& cpu, const uint64_t address, const size_t size)
+    {
+        const auto cs_selector = cpu.reg<uint16_t>(x86_register::cs);
+        auto& block = this->blocks_[address];
+
+        const auto generation = this->get_generation(address, size);
+        if (block.generation != generation || block.cs_selector != cs_selector || block.size != size)
+        {
+            this->retire_block(block);
+
+            block.generation = generation;
+            block.cs_selector = cs_selector;
+            block.size = size;
+            block.instruction_ids.clear();
+
+            std::vector<uint8_t> code(size);
+            if (size > 0 && cpu.try_read_memory(address, code.data(), code.size()))
+            {
+                const auto instructions = this->disassembler_.disassemble(cpu, cs_selector, code, 0, address);
+                block.instruction_ids.reserve(instructions.size());
+
+                for (const auto& inst : instructions)
+                {
+                    block.instruction_ids.push_back(inst.id);
+                }
+            }
+        }
+
+        ++block.executions;
+    }
+
+    std::unordered_map<uint32_t, uint64_t> instruction_cache::get_instruction_counts() const
+    {
+        auto counts = this->instruction_counts_;
+
+        for (const auto& block : this->blocks_ | std::views::values)
+        {
+            for (const auto id : block.instruction_ids)
+            {
+                counts[id] += block.executions;
+            }
+        }
+
+        return counts;
+    }
+
+    void instruction_cache::invalidate(const uint64_t address, const uint64_t length)
+    {
+        if (length == 0)
+        {
+            return;
+        }
+
+        const auto first_page = address / PAGE_SIZE;
+        const auto last_page = (address + length - 1) / PAGE_SIZE;
+
+        if (last_page - first_page >= MAX_TRACKED_INVALIDATION_PAGES)
+        {
+            this->clear();
+            return;
+        }
+
+        ++this->current_generation_;
+
+        for (auto page = first_page; page <= last_page; ++page)
+        {
+            this->page_generations_[page] = this->current_generation_;
+        }
+    }
+
+    uint64_t instruction_cache::get_generation(const uint64_t address, const uint64_t size) const
+    {
+        if (this->page_generations_.empty())
+        {
+            return 0;
+        }
+
+        const auto first_page = address / PAGE_SIZE;
+        const auto last_page = (address + std::max<uint64_t>(size, 1) - 1) / PAGE_SIZE;
+
+        // Generations only grow, so the newest page of the range changes whenever any of its pages does
+        uint64_t generation = 0;
+        for (auto page = first_page; page <= last_page; ++page)
+        {
+            const auto entry = this->page_generations_.find(page);
+            if (entry != this->page_generations_.end())
+            {
+                generation = std::max(generation, entry->second);
+            }
+        }
+
+        return generation;
+    }
+
+    void instruction_cache::retire_block(block_entry& block)
+    {
+        if (block.executions == 0)
+        {
+            return;
+        }
+
+        for (const auto id : block.instruction_ids)
+        {
+            this->instruction_counts_[id] += block.executions;
+        }
+
+        block.executions = 0;
+    }
+
+    void instruction_cache::clear()
+    {
+        for (auto& block : this->blocks_ | std::views::values)
+        {
+            this->retire_block(block);
+        }
+
+        this->blocks_.clear();
+        this->instructions_.clear();
+        this->page_generations_.clear();
+    }
+} // namespace sogen
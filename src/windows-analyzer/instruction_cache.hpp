@@ -0,0 +1,73 @@
+#pragma once
+
+#include "disassembler.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sogen
+{
+    // Decoded guest instructions, shared by the instruction summary and the tracing paths so code is read and
+    // disassembled once instead of on every visit. Entries remember the generation of the code pages they were
+    // decoded from. invalidate() moves pages to a new generation when they are written, reprotected or
+    // remapped, and the next lookup decodes them again.
+    class instruction_cache
+    {
+      public:
+        struct decoded_instruction
+        {
+            uint32_t id{};
+            uint8_t size{};
+            bool is_return{};
+            std::string text{};
+        };
+
+        const disassembler& get_disassembler() const
+        {
+            return this->disassembler_;
+        }
+
+        // nullptr if the address holds no valid instruction.
+        const decoded_instruction* get_instruction(x86_64_cpu& cpu, uint64_t address);
+
+        // Counts one execution of every instruction of the basic block, resp. of the single instruction.
+        void count_block(x86_64_cpu& cpu, uint64_t address, size_t size);
+        void count_instruction(x86_64_cpu& cpu, uint64_t address);
+
+        // Execution counts per capstone instruction id.
+        std::unordered_map<uint32_t, uint64_t> get_instruction_counts() const;
+
+        void invalidate(uint64_t address, uint64_t length);
+
+      private:
+        struct instruction_entry
+        {
+            uint64_t generation{};
+            uint16_t cs_selector{};
+            bool decoded{};
+            bool valid{};
+            decoded_instruction instruction{};
+        };
+
+        struct block_entry
+        {
+            uint64_t generation{};
+            uint16_t cs_selector{};
+            size_t size{};
+            std::vector<uint32_t> instruction_ids{};
+            uint64_t executions{};
+        };
+
+        disassembler disassembler_{};
+        uint64_t current_generation_{};
+        std::unordered_map<uint64_t, uint64_t> page_generations_{};
+        std::unordered_map<uint64_t, instruction_entry> instructions_{};
+        std::unordered_map<uint64_t, block_entry> blocks_{};
+        std::unordered_map<uint32_t, uint64_t> instruction_counts_{};
+
+        uint64_t get_generation(uint64_t address, uint64_t size) const;
+        void retire_block(block_entry& block);
+        void clear();
+    };
+} // namespace sogen
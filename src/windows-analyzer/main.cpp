@@ -32,6 +32,9 @@ namespace sogen
 {
     namespace
     {
+        // Binary trace recorded while emulating, converted to the Tenet text log afterwards.
+        constexpr auto TENET_TRACE_FILE = "tenet_trace.bin";
+
         std::filesystem::path get_current_binary_dir()
         {
 #ifdef _WIN32
@@ -67,6 +70,7 @@ namespace sogen
             std::filesystem::path minidump_path{};
             std::filesystem::path report_path{};
             std::filesystem::path stdout_path{};
+            std::filesystem::path capture_path{};
             std::string report_format{"jsonl"};
             std::string whp_execution_hook_mode{"auto"};
             std::optional<backend_type> backend{};
@@ -266,7 +270,7 @@ namespace sogen
 
             watch_object(win_emu, modules, *win_emu.current_thread().teb64, verbose, emit_object_access);
             watch_object(win_emu, modules, win_emu.process.peb64, verbose, emit_object_access);
-            watch_object<KUSER_SHARED_DATA64>(win_emu, modules, kusd_mmio::address(), verbose, emit_object_access);
+            watch_object<KUSER_SHARED_DATA64>(win_emu, modules, kusd_page::address(), verbose, emit_object_access);
 
             auto state = std::make_shared<analysis_state>(c, modules, verbose, concise);
 
@@ -320,7 +324,7 @@ namespace sogen
         {
             std::map<uint64_t, std::vector<uint32_t>> instruction_counts{};
 
-            for (const auto& [instruction, count] : c.instructions)
+            for (const auto& [instruction, count] : c.code_cache.get_instruction_counts())
             {
                 instruction_counts[count].push_back(instruction);
             }
@@ -333,7 +337,7 @@ namespace sogen
                     const auto& e = c.win_emu;
                     auto& emu = e->emu();
                     const auto reg_cs = emu.reg<uint16_t>(x86_register::cs);
-                    const auto handle = c.d.resolve_handle(emu, reg_cs);
+                    const auto handle = c.code_cache.get_disassembler().resolve_handle(emu, reg_cs);
                     const auto* mnemonic = cs_insn_name(handle, instruction);
                     entries.emplace_back(instruction_summary_entry{.mnemonic = mnemonic ? mnemonic : "<N/A>", .count = count});
                 }
@@ -499,6 +503,7 @@ namespace sogen
                 .use_instruction_precision = !options.disable_instruction_precision,
                 .emulation_root = options.emulation_root,
                 .registry_directory = options.registry_path,
+                .registry_files = options.registry_files,
                 .path_mappings = options.path_mappings,
             };
         }
@@ -526,10 +531,23 @@ namespace sogen
             return emu;
         }
 
+        emulator_interfaces create_emulator_interfaces(const analysis_options& options)
+        {
+            emulator_interfaces interfaces{};
+
+            if (!options.capture_path.empty())
+            {
+                interfaces.ui = create_capture_ui_backend(options.capture_path);
+            }
+
+            return interfaces;
+        }
+
         std::unique_ptr<windows_emulator> create_empty_emulator(const analysis_options& options)
         {
             const auto settings = create_emulator_settings(options);
-            return std::make_unique<windows_emulator>(create_configured_backend(options), settings);
+            return std::make_unique<windows_emulator>(create_configured_backend(options), settings, emulator_callbacks{},
+                                                      create_emulator_interfaces(options));
         }
 
         std::unique_ptr<windows_emulator> create_application_emulator(const analysis_options& options,
@@ -547,9 +565,11 @@ namespace sogen
             };
 
             const auto settings = create_emulator_settings(options);
-            return std::make_unique<windows_emulator>(create_configured_backend(options), std::move(app_settings), settings);
+            return std::make_unique<windows_emulator>(create_configured_backend(options), std::move(app_settings), settings,
+                                                      emulator_callbacks{}, create_emulator_interfaces(options));
         }
 
+        // Loading a snapshot replaces the registry state the emulator applied the .reg files to.
         void apply_registry_files(windows_emulator& win_emu, const analysis_options& options)
         {
             for (const auto& file : options.registry_files)
@@ -565,6 +585,7 @@ namespace sogen
                 // load snapshot
                 auto win_emu = create_empty_emulator(options);
                 snapshot::load_emulator_snapshot(*win_emu, options.dump);
+                apply_registry_files(*win_emu, options);
                 return win_emu;
             }
             if (!options.minidump_path.empty())
@@ -615,7 +636,6 @@ namespace sogen
 
             const auto concise_logging = options.concise_logging;
             const auto win_emu = setup_emulator(options, args);
-            apply_registry_files(*win_emu, options);
             context.win_emu = win_emu.get();
 
             std::vector<std::unique_ptr<analysis_reporter>> reporters{};
@@ -679,9 +699,29 @@ namespace sogen
             if (options.tenet_trace)
             {
                 win_emu->log.log("Tenet Tracer enabled. Output: tenet_trace.log\n");
-                tenet_tracer.emplace(*win_emu, "tenet_trace.log");
+                tenet_tracer.emplace(*win_emu, TENET_TRACE_FILE);
             }
 
+            // Also runs when the emulation throws: the trace up to the failure is the interesting part.
+            const auto _ = utils::finally([&] {
+                if (!tenet_tracer)
+                {
+                    return;
+                }
+
+                tenet_tracer.reset();
+
+                try
+                {
+                    convert_tenet_trace(TENET_TRACE_FILE, "tenet_trace.log");
+                    std::filesystem::remove(TENET_TRACE_FILE);
+                }
+                catch (const std::exception& e)
+                {
+                    win_emu->log.error("Failed to convert the Tenet trace: %s\n", e.what());
+                }
+            });
+
             register_analysis_callbacks(context);
             watch_system_objects(context, options.modules, options.verbose_logging, options.concise_logging);
 
@@ -898,6 +938,8 @@ namespace sogen
             app.add_flag("--reproducible", options.reproducible, "Stub clocks and other mechanisms to make executions reproducible");
             app.add_flag("--no-inst-precision", options.disable_instruction_precision,
                          "Disable per-instruction precision (faster, less precise)");
+            app.add_flag("--trace-every-inst", options.trace_every_instruction,
+                         "Trace every instruction instead of every basic block (slower, for comparing the two)");
             app.add_flag("--call-count", options.prepend_call_count, "Prefix function and syscall lines with a traced-call count");
 #if defined(OS_EMSCRIPTEN) && !defined(SOGEN_EMSCRIPTEN_SUPPORT_NODEJS)
             app.add_flag("--break-start", options.pause_before_start, "Pause before executing the first instruction");
@@ -909,6 +951,7 @@ namespace sogen
             app.add_option("--report", options.report_path, "Write machine-readable analysis events to a file");
             app.add_option("--report-format", options.report_format, "Report format (supported: jsonl)")->capture_default_str();
             app.add_option("--stdout", options.stdout_path, "Write guest console output to a file");
+            app.add_option("--capture", options.capture_path, "Record guest windows into a frame capture file instead of showing them");
             app.add_option("--whp-exec-hook", options.whp_execution_hook_mode, "WHP memory execution hook mode")
                 ->capture_default_str()
                 ->check(CLI::IsMember({"auto", "int3"}));
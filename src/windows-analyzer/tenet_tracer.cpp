@@ -1,74 +1,317 @@
 #include "std_include.hpp"
 #include "tenet_tracer.hpp"
-#include <utils/finally.hpp>
-
-#include <iomanip>
+#include <utils/compression.hpp>
 
 namespace sogen
 {
 
     namespace
     {
-        std::string format_hex(uint64_t value)
+        // File layout: trace_header, then frames of a uint32_t compressed size followed by one zstd frame.
+        // Decompressed frames hold a sequence of records, each starting with a record_type byte:
+        //   instruction:  uint64_t rip, uint16_t changed register mask, one uint64_t per set mask bit
+        //   memory_read:  uint64_t address, uint32_t size, size data bytes
+        //   memory_write: same as memory_read
+        // Memory records belong to the next instruction record, like the mr/mw entries of a Tenet line.
+        constexpr std::array<char, 8> TRACE_MAGIC{'S', 'G', 'N', 'T', 'E', 'N', 'E', 'T'};
+        constexpr uint32_t TRACE_VERSION = 1;
+
+        constexpr size_t CHUNK_SIZE = 1 << 20;
+        constexpr size_t CHUNK_COUNT = 4;
+
+        namespace record_type
+        {
+            constexpr uint8_t instruction = 0;
+            constexpr uint8_t memory_read = 1;
+            constexpr uint8_t memory_write = 2;
+        }
+
+        struct trace_header
+        {
+            std::array<char, 8> magic{};
+            uint32_t version{};
+            uint32_t register_count{};
+            uint64_t executable_start{};
+            uint64_t executable_end{};
+        };
+
+        static_assert(GPRs_TO_TRACE.size() <= 16, "Register mask must fit into 16 bits");
+
+        class record_reader
+        {
+          public:
+            explicit record_reader(const std::span<const std::byte> data)
+                : data_(data)
+            {
+            }
+
+            bool empty() const
+            {
+                return this->offset_ >= this->data_.size();
+            }
+
+            template <typename T>
+            T read()
+            {
+                T value{};
+                std::memcpy(&value, this->read_bytes(sizeof(T)).data(), sizeof(T));
+                return value;
+            }
+
+            std::span<const std::byte> read_bytes(const size_t size)
+            {
+                if (size > this->data_.size() - this->offset_)
+                {
+                    throw std::runtime_error("TenetTracer: Truncated trace record");
+                }
+
+                const auto bytes = this->data_.subspan(this->offset_, size);
+                this->offset_ += size;
+                return bytes;
+            }
+
+          private:
+            std::span<const std::byte> data_{};
+            size_t offset_{0};
+        };
+
+        void append_hex(std::string& text, const uint64_t value)
         {
-            std::stringstream ss;
-            ss << "0x" << std::hex << value;
-            return ss.str();
+            std::array<char, 18> buffer{'0', 'x'};
+            const auto result = std::to_chars(buffer.data() + 2, buffer.data() + buffer.size(), value, 16);
+            text.append(buffer.data(), result.ptr);
         }
 
-        std::string format_byte_array(const uint8_t* data, size_t size)
+        void append_byte_array(std::string& text, const std::span<const std::byte> data)
         {
-            std::stringstream ss;
-            for (size_t i = 0; i < size; ++i)
+            constexpr std::string_view digits = "0123456789abcdef";
+
+            for (const auto value : data)
             {
-                ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i]);
+                const auto byte = static_cast<uint8_t>(value);
+                text.push_back(digits[byte >> 4]);
+                text.push_back(digits[byte & 0xF]);
             }
-            return ss.str();
         }
 
-        void parse_and_accumulate_changes(const std::string& line, std::map<std::string, std::string>& changes)
+        struct trace_line
         {
-            size_t start = 0;
-            while (start < line.length())
+            uint16_t register_mask{};
+            std::array<uint64_t, GPRs_TO_TRACE.size()> registers{};
+            uint64_t rip{};
+            std::string memory_reads{};
+            std::string memory_writes{};
+
+            void append_to(std::string& text) const
             {
-                size_t end = line.find(',', start);
-                if (end == std::string::npos)
+                bool first_entry = true;
+                const auto append_key = [&](const std::string_view key) {
+                    if (!first_entry)
+                    {
+                        text.push_back(',');
+                    }
+
+                    first_entry = false;
+                    text.append(key);
+                    text.push_back('=');
+                };
+
+                for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
                 {
-                    end = line.length();
+                    if (this->register_mask & (1u << i))
+                    {
+                        append_key(GPRs_TO_TRACE[i].second);
+                        append_hex(text, this->registers[i]);
+                    }
                 }
 
-                std::string pair_str = line.substr(start, end - start);
-                size_t equals_pos = pair_str.find('=');
-                if (equals_pos != std::string::npos)
+                append_key("rip");
+                append_hex(text, this->rip);
+
+                if (!this->memory_reads.empty())
                 {
-                    std::string key = pair_str.substr(0, equals_pos);
-                    std::string value = pair_str.substr(equals_pos + 1);
-                    changes[key] = value;
+                    append_key("mr");
+                    text.append(this->memory_reads);
                 }
 
-                start = end + 1;
+                if (!this->memory_writes.empty())
+                {
+                    append_key("mw");
+                    text.append(this->memory_writes);
+                }
             }
-        }
+        };
+
+        // Writes lines inside the executable as they are. A run of lines outside of it collapses into one line
+        // holding the last value of every key, written before the next line inside the executable.
+        class tenet_log_writer
+        {
+          public:
+            tenet_log_writer(std::ofstream& log_file, const uint64_t executable_start, const uint64_t executable_end)
+                : log_file_(log_file),
+                  executable_start_(executable_start),
+                  executable_end_(executable_end)
+            {
+            }
+
+            void write(const trace_line& line)
+            {
+                const auto filter = this->executable_start_ < this->executable_end_;
+                const auto is_first_line = std::exchange(this->is_first_line_, false);
+
+                if (!filter || is_first_line)
+                {
+                    this->write_line(line);
+                    return;
+                }
+
+                const auto is_line_inside = this->executable_start_ <= line.rip && line.rip < this->executable_end_;
+                const auto was_outside = std::exchange(this->currently_outside_, !is_line_inside);
+
+                if (!is_line_inside)
+                {
+                    this->accumulate(line);
+                    return;
+                }
+
+                if (was_outside && !this->accumulated_changes_.empty())
+                {
+                    this->write_summary();
+                }
+
+                this->write_line(line);
+            }
+
+          private:
+            std::ofstream& log_file_;
+            uint64_t executable_start_{};
+            uint64_t executable_end_{};
+
+            bool is_first_line_{true};
+            bool currently_outside_{false};
+            std::map<std::string_view, std::string> accumulated_changes_{};
+            std::string text_{};
+
+            void write_line(const trace_line& line)
+            {
+                this->text_.clear();
+                line.append_to(this->text_);
+                this->text_.push_back('\n');
+                this->log_file_.write(this->text_.data(), static_cast<std::streamsize>(this->text_.size()));
+            }
+
+            void accumulate(const trace_line& line)
+            {
+                const auto set_hex = [this](const std::string_view key, const uint64_t value) {
+                    auto& entry = this->accumulated_changes_[key];
+                    entry.clear();
+                    append_hex(entry, value);
+                };
+
+                for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
+                {
+                    if (line.register_mask & (1u << i))
+                    {
+                        set_hex(GPRs_TO_TRACE[i].second, line.registers[i]);
+                    }
+                }
+
+                set_hex("rip", line.rip);
+
+                if (!line.memory_reads.empty())
+                {
+                    this->accumulated_changes_["mr"] = line.memory_reads;
+                }
+
+                if (!line.memory_writes.empty())
+                {
+                    this->accumulated_changes_["mw"] = line.memory_writes;
+                }
+            }
+
+            void write_summary()
+            {
+                std::string last_rip{};
+                if (const auto rip = this->accumulated_changes_.find("rip"); rip != this->accumulated_changes_.end())
+                {
+                    last_rip = std::move(rip->second);
+                    this->accumulated_changes_.erase(rip);
+                }
+
+                this->text_.clear();
+
+                for (const auto& [key, value] : this->accumulated_changes_)
+                {
+                    if (!this->text_.empty())
+                    {
+                        this->text_.push_back(',');
+                    }
+
+                    this->text_.append(key);
+                    this->text_.push_back('=');
+                    this->text_.append(value);
+                }
+
+                if (!last_rip.empty())
+                {
+                    if (!this->text_.empty())
+                    {
+                        this->text_.push_back(',');
+                    }
+
+                    this->text_.append("rip=");
+                    this->text_.append(last_rip);
+                }
+
+                this->text_.push_back('\n');
+                this->log_file_.write(this->text_.data(), static_cast<std::streamsize>(this->text_.size()));
+                this->accumulated_changes_.clear();
+            }
+        };
     }
 
-    tenet_tracer::tenet_tracer(windows_emulator& win_emu, const std::filesystem::path& log_filename)
+    tenet_tracer::tenet_tracer(windows_emulator& win_emu, const std::filesystem::path& trace_filename)
         : win_emu_(win_emu),
-          log_file_(log_filename)
+          trace_file_(trace_filename, std::ios::binary)
     {
-        if (!log_file_)
+        if (!trace_file_)
         {
-            throw std::runtime_error("TenetTracer: Failed to open log file -> " + log_filename.string());
+            throw std::runtime_error("TenetTracer: Failed to open trace file -> " + trace_filename.string());
         }
 
+        trace_header header{
+            .magic = TRACE_MAGIC,
+            .version = TRACE_VERSION,
+            .register_count = static_cast<uint32_t>(GPRs_TO_TRACE.size()),
+        };
+
+        if (const auto* exe_module = win_emu_.mod_manager.executable)
+        {
+            header.executable_start = exe_module->image_base;
+            header.executable_end = exe_module->image_base + exe_module->size_of_image;
+        }
+
+        trace_file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        chunk_.reserve(CHUNK_SIZE);
+        for (size_t i = 1; i < CHUNK_COUNT; ++i)
+        {
+            free_chunks_.emplace_back().reserve(CHUNK_SIZE);
+        }
+
+        writer_ = std::thread([this] {
+            this->run_writer(); //
+        });
+
         auto& emu = win_emu_.emu();
 
         auto* read_hook = emu.hook_memory_read(0, 0xFFFFFFFFFFFFFFFF, [this](cpu_interface&, uint64_t a, const void* d, size_t s) {
-            this->log_memory_read(a, d, s); //
+            this->log_memory_access(record_type::memory_read, a, d, s); //
         });
         read_hook_ = scoped_hook(emu, read_hook);
 
         auto* write_hook = emu.hook_memory_write(0, 0xFFFFFFFFFFFFFFFF, [this](cpu_interface&, uint64_t a, const void* d, size_t s) {
-            this->log_memory_write(a, d, s); //
+            this->log_memory_access(record_type::memory_write, a, d, s); //
         });
         write_hook_ = scoped_hook(emu, write_hook);
 
@@ -80,195 +323,226 @@ namespace sogen
 
     tenet_tracer::~tenet_tracer()
     {
-        filter_and_write_buffer();
+        if (!chunk_.empty())
+        {
+            submit_chunk(false);
+        }
 
-        if (log_file_.is_open())
         {
-            log_file_.close();
+            std::scoped_lock lock{mutex_};
+            stop_writer_ = true;
         }
+
+        chunks_changed_.notify_all();
+        writer_.join();
     }
 
-    void tenet_tracer::filter_and_write_buffer()
+    void tenet_tracer::log_memory_access(const uint8_t type, const uint64_t address, const void* data, const size_t size)
     {
-        if (raw_log_buffer_.empty())
-        {
-            return;
-        }
+        const auto length = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+
+        reserve_space(sizeof(type) + sizeof(address) + sizeof(length) + length);
+        append(&type, sizeof(type));
+        append(&address, sizeof(address));
+        append(&length, sizeof(length));
+        append(data, length);
+    }
 
-        const auto* exe_module = win_emu_.mod_manager.executable;
-        if (!exe_module)
+    void tenet_tracer::process_instruction(const uint64_t address)
+    {
+        auto& emu = win_emu_.emu();
+
+        std::array<uint64_t, GPRs_TO_TRACE.size()> current_regs{};
+        uint16_t register_mask = 0;
+
+        for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
         {
-            for (const auto& line : raw_log_buffer_)
+            current_regs[i] = emu.reg<uint64_t>(GPRs_TO_TRACE[i].first);
+
+            if (is_first_instruction_ || previous_registers_[i] != current_regs[i])
             {
-                log_file_ << line << '\n';
+                register_mask |= static_cast<uint16_t>(1u << i);
             }
-
-            return;
         }
 
-        if (!raw_log_buffer_.empty())
-        {
-            log_file_ << raw_log_buffer_.front() << '\n';
-        }
+        is_first_instruction_ = false;
+        previous_registers_ = current_regs;
 
-        bool currently_outside = false;
-        std::map<std::string, std::string> accumulated_changes;
+        const auto type = record_type::instruction;
+        reserve_space(sizeof(type) + sizeof(address) + sizeof(register_mask) + sizeof(current_regs));
+        append(&type, sizeof(type));
+        append(&address, sizeof(address));
+        append(&register_mask, sizeof(register_mask));
 
-        for (size_t i = 1; i < raw_log_buffer_.size(); ++i)
+        for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
         {
-            const auto& line = raw_log_buffer_[i];
-
-            size_t rip_pos = line.find("rip=0x");
-            if (rip_pos == std::string::npos)
+            if (register_mask & (1u << i))
             {
-                continue;
+                append(&current_regs[i], sizeof(current_regs[i]));
             }
+        }
+    }
 
-            char* end_ptr = nullptr;
-            uint64_t address = std::strtoull(line.c_str() + rip_pos + 6, &end_ptr, 16);
+    void tenet_tracer::append(const void* data, const size_t size)
+    {
+        const auto offset = chunk_.size();
+        chunk_.resize(offset + size);
+        std::memcpy(chunk_.data() + offset, data, size);
+    }
 
-            bool is_line_inside = exe_module->contains(address);
-            const auto _1 = utils::finally([&] {
-                currently_outside = !is_line_inside; //
-            });
+    // Records never straddle chunks. One larger than a whole chunk gets a chunk of its own.
+    void tenet_tracer::reserve_space(const size_t size)
+    {
+        if (!chunk_.empty() && chunk_.size() + size > CHUNK_SIZE)
+        {
+            submit_chunk(true);
+        }
+    }
 
-            if (!is_line_inside)
-            {
-                parse_and_accumulate_changes(line, accumulated_changes);
-                continue;
-            }
+    void tenet_tracer::submit_chunk(const bool wait_for_free_chunk)
+    {
+        std::unique_lock lock{mutex_};
+        pending_chunks_.push_back(std::move(chunk_));
+        chunks_changed_.notify_all();
 
-            const auto _2 = utils::finally([&] {
-                log_file_ << line << '\n'; //
-            });
+        if (!wait_for_free_chunk)
+        {
+            chunk_ = {};
+            return;
+        }
 
-            if (!currently_outside || accumulated_changes.empty())
-            {
-                continue;
-            }
+        // Blocks emulation while the writer is behind, which is what bounds the memory use.
+        chunks_changed_.wait(lock, [this] {
+            return !free_chunks_.empty(); //
+        });
 
-            std::stringstream summary_line;
-            bool first = true;
+        chunk_ = std::move(free_chunks_.back());
+        free_chunks_.pop_back();
+        chunk_.clear();
+    }
 
-            auto rip_it = accumulated_changes.find("rip");
-            std::string last_rip;
-            if (rip_it != accumulated_changes.end())
-            {
-                last_rip = rip_it->second;
-                accumulated_changes.erase(rip_it);
-            }
+    void tenet_tracer::run_writer()
+    {
+        while (true)
+        {
+            std::vector<std::byte> chunk{};
 
-            for (const auto& pair : accumulated_changes)
             {
-                if (!first)
+                std::unique_lock lock{mutex_};
+                chunks_changed_.wait(lock, [this] {
+                    return stop_writer_ || !pending_chunks_.empty(); //
+                });
+
+                if (pending_chunks_.empty())
                 {
-                    summary_line << ",";
+                    return;
                 }
-                summary_line << pair.first << "=" << pair.second;
-                first = false;
+
+                chunk = std::move(pending_chunks_.front());
+                pending_chunks_.pop_front();
             }
 
-            if (!last_rip.empty())
+            const auto compressed = utils::compression::zstd::compress(chunk, 3);
+            const auto compressed_size = static_cast<uint32_t>(compressed.size());
+
+            trace_file_.write(reinterpret_cast<const char*>(&compressed_size), sizeof(compressed_size));
+            trace_file_.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+
             {
-                if (!first)
-                {
-                    summary_line << ",";
-                }
-                summary_line << "rip=" << last_rip;
+                std::scoped_lock lock{mutex_};
+                free_chunks_.push_back(std::move(chunk));
             }
 
-            log_file_ << summary_line.str() << '\n';
-            accumulated_changes.clear();
+            chunks_changed_.notify_all();
         }
-
-        raw_log_buffer_.clear();
     }
 
-    void tenet_tracer::log_memory_read(uint64_t address, const void* data, size_t size)
+    void convert_tenet_trace(const std::filesystem::path& trace_filename, const std::filesystem::path& log_filename)
     {
-        if (!mem_read_log_.str().empty())
+        std::ifstream trace_file{trace_filename, std::ios::binary};
+        if (!trace_file)
         {
-            mem_read_log_ << ";";
+            throw std::runtime_error("TenetTracer: Failed to open trace file -> " + trace_filename.string());
         }
 
-        mem_read_log_ << format_hex(address) << ":" << format_byte_array(static_cast<const uint8_t*>(data), size);
-    }
+        trace_header header{};
+        trace_file.read(reinterpret_cast<char*>(&header), sizeof(header));
 
-    void tenet_tracer::log_memory_write(uint64_t address, const void* data, size_t size)
-    {
-        if (!mem_write_log_.str().empty())
+        if (!trace_file || header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+            header.register_count != GPRs_TO_TRACE.size())
         {
-            mem_write_log_ << ";";
+            throw std::runtime_error("TenetTracer: Unsupported trace file -> " + trace_filename.string());
         }
 
-        mem_write_log_ << format_hex(address) << ":" << format_byte_array(static_cast<const uint8_t*>(data), size);
-    }
-
-    void tenet_tracer::process_instruction(const uint64_t address)
-    {
-        auto& emu = win_emu_.emu();
-        std::stringstream trace_line;
-
-        std::array<uint64_t, GPRs_TO_TRACE.size()> current_regs{};
-        for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
+        std::ofstream log_file{log_filename};
+        if (!log_file)
         {
-            current_regs[i] = emu.reg<uint64_t>(GPRs_TO_TRACE[i].first);
+            throw std::runtime_error("TenetTracer: Failed to open log file -> " + log_filename.string());
         }
 
-        bool first_entry = true;
-        auto append_separator = [&] {
-            if (!first_entry)
+        tenet_log_writer writer{log_file, header.executable_start, header.executable_end};
+        trace_line line{};
+        std::vector<std::byte> compressed{};
+
+        uint32_t compressed_size{};
+        while (trace_file.read(reinterpret_cast<char*>(&compressed_size), sizeof(compressed_size)))
+        {
+            compressed.resize(compressed_size);
+            if (!trace_file.read(reinterpret_cast<char*>(compressed.data()), compressed_size))
             {
-                trace_line << ",";
+                throw std::runtime_error("TenetTracer: Truncated trace file");
             }
-            first_entry = false;
-        };
 
-        if (is_first_instruction_)
-        {
-            for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
+            const auto chunk = utils::compression::zstd::decompress(compressed);
+            if (chunk.empty())
             {
-                append_separator();
-                trace_line << GPRs_TO_TRACE[i].second << "=" << format_hex(current_regs[i]);
+                throw std::runtime_error("TenetTracer: Corrupted trace chunk");
             }
-            is_first_instruction_ = false;
-        }
-        else
-        {
-            for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
+
+            record_reader reader{chunk};
+            while (!reader.empty())
             {
-                if (previous_registers_[i] != current_regs[i])
+                const auto type = reader.read<uint8_t>();
+
+                if (type == record_type::instruction)
                 {
-                    append_separator();
-                    trace_line << GPRs_TO_TRACE[i].second << "=" << format_hex(current_regs[i]);
+                    line.rip = reader.read<uint64_t>();
+                    line.register_mask = reader.read<uint16_t>();
+
+                    for (size_t i = 0; i < GPRs_TO_TRACE.size(); ++i)
+                    {
+                        if (line.register_mask & (1u << i))
+                        {
+                            line.registers[i] = reader.read<uint64_t>();
+                        }
+                    }
+
+                    writer.write(line);
+                    line.memory_reads.clear();
+                    line.memory_writes.clear();
+                    continue;
                 }
-            }
-        }
-
-        append_separator();
-        trace_line << "rip=" << format_hex(address);
 
-        const auto mem_reads = mem_read_log_.str();
-        if (!mem_reads.empty())
-        {
-            append_separator();
-            trace_line << "mr=" << mem_reads;
-        }
+                if (type != record_type::memory_read && type != record_type::memory_write)
+                {
+                    throw std::runtime_error("TenetTracer: Unknown trace record");
+                }
 
-        const auto mem_writes = mem_write_log_.str();
-        if (!mem_writes.empty())
-        {
-            append_separator();
-            trace_line << "mw=" << mem_writes;
-        }
+                const auto address = reader.read<uint64_t>();
+                const auto size = reader.read<uint32_t>();
+                const auto data = reader.read_bytes(size);
 
-        raw_log_buffer_.push_back(trace_line.str());
-        previous_registers_ = current_regs;
+                auto& accesses = type == record_type::memory_read ? line.memory_reads : line.memory_writes;
+                if (!accesses.empty())
+                {
+                    accesses.push_back(';');
+                }
 
-        mem_read_log_.str("");
-        mem_read_log_.clear();
-        mem_write_log_.str("");
-        mem_write_log_.clear();
+                append_hex(accesses, address);
+                accesses.push_back(':');
+                append_byte_array(accesses, data);
+            }
+        }
     }
 
 } // namespace sogen
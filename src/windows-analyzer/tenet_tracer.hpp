@@ -28,10 +28,14 @@ namespace sogen
         },
     };
 
+    // Records a Tenet trace into a compact binary file while the emulator runs. Hooks append fixed-layout
+    // records to a chunk from a small fixed pool; full chunks are zstd-compressed and written by a
+    // background thread, so memory use is bounded and no text is formatted during emulation. Once
+    // tracing is done, convert_tenet_trace turns the file into Tenet's text format.
     class tenet_tracer
     {
       public:
-        tenet_tracer(windows_emulator& win_emu, const std::filesystem::path& log_filename);
+        tenet_tracer(windows_emulator& win_emu, const std::filesystem::path& trace_filename);
         ~tenet_tracer();
 
         tenet_tracer(tenet_tracer&) = delete;
@@ -40,24 +44,36 @@ namespace sogen
         tenet_tracer& operator=(const tenet_tracer&) = delete;
 
       private:
-        void filter_and_write_buffer();
-        void log_memory_read(uint64_t address, const void* data, size_t size);
-        void log_memory_write(uint64_t address, const void* data, size_t size);
+        void log_memory_access(uint8_t type, uint64_t address, const void* data, size_t size);
         void process_instruction(uint64_t address);
 
+        void append(const void* data, size_t size);
+        void reserve_space(size_t size);
+        void submit_chunk(bool wait_for_free_chunk);
+        void run_writer();
+
         windows_emulator& win_emu_;
-        std::ofstream log_file_;
+        std::ofstream trace_file_;
 
-        std::vector<std::string> raw_log_buffer_;
         std::array<uint64_t, GPRs_TO_TRACE.size()> previous_registers_{};
         bool is_first_instruction_ = true;
 
-        std::stringstream mem_read_log_;
-        std::stringstream mem_write_log_;
+        std::vector<std::byte> chunk_{};
+
+        std::mutex mutex_{};
+        std::condition_variable chunks_changed_{};
+        std::deque<std::vector<std::byte>> pending_chunks_{};
+        std::vector<std::vector<std::byte>> free_chunks_{};
+        bool stop_writer_{false};
+        std::thread writer_{};
 
         scoped_hook read_hook_;
         scoped_hook write_hook_;
         scoped_hook execute_hook_;
     };
 
+    // Converts a binary trace written by tenet_tracer into a Tenet text log. Instructions outside of the
+    // traced executable are folded into one summary line per excursion, keeping the log focused on it.
+    void convert_tenet_trace(const std::filesystem::path& trace_filename, const std::filesystem::path& log_filename);
+
 } // namespace sogen
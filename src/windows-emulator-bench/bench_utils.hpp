@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#include <windows_emulator.hpp>
+#include <backend_selection.hpp>
+
+#include <network/static_socket_factory.hpp>
+
+namespace sogen::bench
+{
+    // Runs `fn` `iterations` times and returns the rate per second.
+    template <typename Fn>
+    double measure_rate(const size_t iterations, Fn&& fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(iterations) / std::max(seconds, 1e-9);
+    }
+
+    inline void report(const std::string_view benchmark, const std::string_view metric, const double value, const std::string_view unit)
+    {
+        (void)printf("%.*s: %.*s %.1f %.*s\n", static_cast<int>(benchmark.size()), benchmark.data(), static_cast<int>(metric.size()),
+                     metric.data(), value, static_cast<int>(unit.size()), unit.data());
+    }
+
+    inline std::filesystem::path get_emulator_root()
+    {
+        const auto* root = getenv("EMULATOR_ROOT");
+        if (!root)
+        {
+            throw std::runtime_error("No EMULATOR_ROOT set!");
+        }
+
+        return root;
+    }
+
+    // test-sample from the emulation root in EMULATOR_ROOT, set up like the emulation tests do.
+    inline windows_emulator create_sample_emulator(const std::optional<backend_type> backend = std::nullopt)
+    {
+        emulator_settings settings{
+            .disable_logging = true,
+            .use_relative_time = true,
+            .emulation_root = get_emulator_root(),
+        };
+
+        emulator_interfaces interfaces{};
+        interfaces.socket_factory = network::create_static_socket_factory();
+        interfaces.ui = std::make_unique<null_ui_backend>();
+
+        return windows_emulator{
+            backend ? create_x86_64_emulator(*backend) : create_x86_64_emulator_from_environment(),
+            application_settings{.application = "C:\\test-sample.exe"},
+            std::move(settings),
+            {},
+            std::move(interfaces),
+        };
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace sogen::bench
+{
+    // Each benchmark prints its measurements and throws when it cannot run.
+    void context_switch();
+    void fuzzer_throughput();
+    void gdb_dump();
+    void gdi_blit();
+    void memory_storm();
+    void registry_startup();
+    void syscall_dispatch();
+}
@@ -0,0 +1,70 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <array>
+#include <string>
+
+namespace sogen::bench
+{
+    namespace
+    {
+        // Switches per second on the main thread of test-sample while `waiter_count` other threads wait on
+        // one event that is never signaled.
+        double measure_switch_rate(const size_t waiter_count)
+        {
+            constexpr size_t switch_count = 100'000;
+
+            auto emu = create_sample_emulator();
+            auto& process = emu.process;
+            auto& vcpu = emu.vcpu(0);
+
+            auto* main_thread = vcpu.active_thread;
+            if (!main_thread)
+            {
+                throw std::runtime_error("test-sample has no main thread");
+            }
+
+            event e{};
+            e.type = NotificationEvent;
+            const auto event_handle = process.events.store(std::move(e));
+
+            for (size_t i = 0; i < waiter_count; ++i)
+            {
+                auto* thread = process.threads.get(process.create_thread(emu.memory, main_thread->start_address, 0, 0x10000, 0));
+                if (!thread)
+                {
+                    throw std::runtime_error("Failed to create a waiting thread");
+                }
+
+                thread->await_objects = {event_handle};
+                thread->await_any = true;
+            }
+
+            // The first switch finds every waiter blocked and parks it.
+            (void)emu.perform_thread_switch(vcpu);
+
+            const auto rate = measure_rate(switch_count, [&] {
+                (void)emu.perform_thread_switch(vcpu); //
+            });
+
+            if (vcpu.active_thread != main_thread || process.scheduler.get_parked_count() != waiter_count)
+            {
+                throw std::runtime_error("A blocked thread was scheduled");
+            }
+
+            return rate;
+        }
+    }
+
+    // Context switch cost against the number of threads blocked on one event. Parked threads should not be
+    // visited by a switch, so the rate should not drop as the count grows.
+    void context_switch()
+    {
+        constexpr std::array<size_t, 3> waiter_counts{0, 100, 1'000};
+
+        for (const auto waiter_count : waiter_counts)
+        {
+            report("context-switch", std::to_string(waiter_count) + " blocked threads", measure_switch_rate(waiter_count), "switches/s");
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <array>
+
+namespace sogen::bench
+{
+    namespace
+    {
+        struct named_backend
+        {
+            std::string_view name{};
+            backend_type type{};
+        };
+
+        constexpr std::array<named_backend, 5> BACKENDS{{
+            {"unicorn", backend_type::unicorn},
+            {"icicle", backend_type::icicle},
+            {"whp", backend_type::whp},
+            {"kvm", backend_type::kvm},
+            {"fex", backend_type::fex},
+        }};
+
+        bool is_backend_available(const backend_type backend)
+        {
+            try
+            {
+                return create_x86_64_emulator(backend) != nullptr;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Executions per second of a fuzzing-style loop on every backend available on this host: each execution
+    // resets test-sample to a snapshot and runs a fixed slice of it, as a fuzzing worker does per input.
+    void fuzzer_throughput()
+    {
+        constexpr size_t executions = 50;
+        constexpr size_t instructions_per_execution = 20'000;
+
+        for (const auto& backend : BACKENDS)
+        {
+            if (!is_backend_available(backend.type))
+            {
+                report("fuzzer-throughput", backend.name, 0.0, "(backend not available)");
+                continue;
+            }
+
+            auto emu = create_sample_emulator(backend.type);
+            emu.start(100);
+            emu.save_snapshot();
+
+            const auto rate = measure_rate(executions, [&] {
+                emu.restore_snapshot();
+                emu.start(instructions_per_execution);
+            });
+
+            report("fuzzer-throughput", backend.name, rate, "executions/s");
+        }
+    }
+}
@@ -0,0 +1,382 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <gdb_stub.hpp>
+#include <checksum.hpp>
+#include <stream_processor.hpp>
+
+#include <network/tcp_client_socket.hpp>
+#include <network/tcp_server_socket.hpp>
+#include <utils/string.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace sogen::bench
+{
+    namespace
+    {
+        constexpr uint64_t memory_base = 0x10000000;
+        constexpr size_t memory_size = 16 * 1024 * 1024;
+
+        // Serves a flat block of pseudo-random memory, so every byte value that needs escaping shows up.
+        class memory_debugging_handler : public gdb_stub::debugging_handler
+        {
+          public:
+            memory_debugging_handler()
+            {
+                this->memory_.resize(memory_size);
+
+                uint32_t state = 0x12345678;
+                for (auto& value : this->memory_)
+                {
+                    state = state * 1664525 + 1013904223;
+                    value = static_cast<std::byte>(state >> 24);
+                }
+            }
+
+            const std::vector<std::byte>& get_memory() const
+            {
+                return this->memory_;
+            }
+
+            void stop()
+            {
+                this->stop_ = true;
+            }
+
+            gdb_stub::action run() override
+            {
+                return gdb_stub::action::resume;
+            }
+
+            gdb_stub::action singlestep() override
+            {
+                return gdb_stub::action::resume;
+            }
+
+            size_t get_register_count() override
+            {
+                return 0;
+            }
+
+            size_t get_max_register_size() override
+            {
+                return 8;
+            }
+
+            size_t read_register(size_t, void*, size_t) override
+            {
+                return 0;
+            }
+
+            size_t write_register(size_t, const void*, size_t) override
+            {
+                return 0;
+            }
+
+            bool read_memory(const uint64_t address, void* data, const size_t length) override
+            {
+                if (address < memory_base || address - memory_base > memory_size || length > memory_size - (address - memory_base))
+                {
+                    return false;
+                }
+
+                memcpy(data, this->memory_.data() + (address - memory_base), length);
+                return true;
+            }
+
+            bool write_memory(uint64_t, const void*, size_t) override
+            {
+                return false;
+            }
+
+            bool set_breakpoint(gdb_stub::breakpoint_type, uint64_t, size_t) override
+            {
+                return false;
+            }
+
+            bool delete_breakpoint(gdb_stub::breakpoint_type, uint64_t, size_t) override
+            {
+                return false;
+            }
+
+            void on_interrupt() override
+            {
+            }
+
+            std::string get_target_description(std::string_view) override
+            {
+                return {};
+            }
+
+            bool switch_to_thread(uint32_t) override
+            {
+                return true;
+            }
+
+            uint32_t get_current_thread_id() override
+            {
+                return 1;
+            }
+
+            std::vector<uint32_t> get_thread_ids() override
+            {
+                return {1};
+            }
+
+            std::optional<uint32_t> get_exit_code() override
+            {
+                return std::nullopt;
+            }
+
+            bool should_stop() override
+            {
+                return this->stop_;
+            }
+
+            std::vector<gdb_stub::memory_region> get_memory_regions() override
+            {
+                return {{.address = memory_base, .length = memory_size}};
+            }
+
+          private:
+            std::vector<std::byte> memory_{};
+            std::atomic_bool stop_{false};
+        };
+
+        std::string make_packet(const std::string_view payload)
+        {
+            return "$" + std::string(payload) + "#" + utils::string::to_hex_string(gdb_stub::compute_checksum(payload));
+        }
+
+        std::string expand_runs(const std::string_view data)
+        {
+            std::string result{};
+            result.reserve(data.size());
+
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                if (data[i] == '*' && i + 1 < data.size() && !result.empty())
+                {
+                    result.append(static_cast<size_t>(data[++i] - 29), result.back());
+                }
+                else
+                {
+                    result.push_back(data[i]);
+                }
+            }
+
+            return result;
+        }
+
+        std::string unescape_binary(const std::string_view data)
+        {
+            std::string result{};
+            result.reserve(data.size());
+
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                result.push_back(data[i] == '}' && i + 1 < data.size() ? static_cast<char>(data[++i] ^ 0x20) : data[i]);
+            }
+
+            return result;
+        }
+
+        // Debugger side of a loopback session, acknowledging replies like gdb does until no-ack mode is on.
+        class gdb_client
+        {
+          public:
+            explicit gdb_client(const network::address& address)
+                : socket_(address.get_family())
+            {
+                const auto deadline = std::chrono::steady_clock::now() + 10s;
+                while (!this->socket_.connect(address))
+                {
+                    if (std::chrono::steady_clock::now() > deadline)
+                    {
+                        throw std::runtime_error("Failed to connect to gdb stub");
+                    }
+
+                    std::this_thread::sleep_for(10ms);
+                    this->socket_ = network::tcp_client_socket(address.get_family());
+                }
+
+                (void)this->socket_.set_no_delay(true);
+            }
+
+            std::string request(const std::string_view payload)
+            {
+                (void)this->socket_.send(make_packet(payload));
+
+                while (!this->processor_.has_packet())
+                {
+                    const auto data = this->socket_.receive();
+                    if (!data)
+                    {
+                        throw std::runtime_error("gdb stub closed the connection");
+                    }
+
+                    this->processor_.push_stream_data(*data);
+                }
+
+                if (!this->no_ack_mode_)
+                {
+                    (void)this->socket_.send("+");
+                }
+
+                return expand_runs(this->processor_.get_next_packet());
+            }
+
+            void start_no_ack_mode()
+            {
+                this->no_ack_mode_ = this->request("QStartNoAckMode") == "OK";
+            }
+
+            void send(const std::string_view payload)
+            {
+                (void)this->socket_.send(make_packet(payload));
+            }
+
+          private:
+            network::tcp_client_socket socket_{};
+            gdb_stub::stream_processor processor_{};
+            bool no_ack_mode_{false};
+        };
+
+        network::address get_free_loopback_address()
+        {
+            network::address address{"127.0.0.1:0"};
+
+            network::tcp_server_socket server{address.get_family()};
+            if (!server.bind(address))
+            {
+                throw std::runtime_error("Failed to bind loopback socket");
+            }
+
+            address.set_port(server.get_port());
+            return address;
+        }
+
+        size_t get_packet_size(const std::string_view supported)
+        {
+            const auto start = supported.find("PacketSize=");
+            if (start == std::string_view::npos)
+            {
+                return 0;
+            }
+
+            return strtoull(std::string(supported.substr(start + 11)).c_str(), nullptr, 16);
+        }
+
+        // Runs the stub on its own thread for the lifetime of the object.
+        class stub_session
+        {
+          public:
+            stub_session(memory_debugging_handler& handler, const network::address& address)
+                : handler_(&handler),
+                  thread_([&handler, address] {
+                      (void)gdb_stub::run_gdb_stub(address, handler); //
+                  })
+            {
+            }
+
+            ~stub_session()
+            {
+                this->handler_->stop();
+                this->thread_.join();
+            }
+
+            stub_session(stub_session&&) = delete;
+            stub_session(const stub_session&) = delete;
+            stub_session& operator=(stub_session&&) = delete;
+            stub_session& operator=(const stub_session&) = delete;
+
+          private:
+            memory_debugging_handler* handler_{};
+            std::thread thread_{};
+        };
+
+        // Dumps the whole memory with `packet` ('m' or 'x') in chunks of `chunk_size`.
+        std::vector<std::byte> dump_memory(gdb_client& client, const char packet, const size_t chunk_size)
+        {
+            std::vector<std::byte> dump{};
+            dump.reserve(memory_size);
+
+            while (dump.size() < memory_size)
+            {
+                const auto size = std::min(chunk_size, memory_size - dump.size());
+                const auto reply = client.request(packet + utils::string::to_hex_number(memory_base + dump.size()) + "," +
+                                                  utils::string::to_hex_number(size));
+
+                if (packet == 'm')
+                {
+                    const auto data = utils::string::from_hex_string(reply);
+                    dump.insert(dump.end(), data.begin(), data.end());
+                    continue;
+                }
+
+                if (reply.empty() || reply.front() != 'b')
+                {
+                    throw std::runtime_error("Binary read failed");
+                }
+
+                const auto data = unescape_binary(std::string_view(reply).substr(1));
+                if (data.empty())
+                {
+                    throw std::runtime_error("Binary read returned no data");
+                }
+
+                const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+                dump.insert(dump.end(), bytes, bytes + data.size());
+            }
+
+            return dump;
+        }
+    }
+
+    // Bulk memory dump over a loopback gdb session, the way older clients do it (acknowledged hex m packets of
+    // 16 KiB) and with what the stub negotiates (no-ack mode, binary x packets up to PacketSize).
+    void gdb_dump()
+    {
+        memory_debugging_handler handler{};
+        const auto address = get_free_loopback_address();
+
+        const stub_session session{handler, address};
+        gdb_client client{address};
+
+        const auto packet_size = get_packet_size(client.request("qSupported:multiprocess+;xmlRegisters=i386"));
+        if (packet_size == 0)
+        {
+            throw std::runtime_error("The stub advertised no PacketSize");
+        }
+
+        const auto megabytes = static_cast<double>(memory_size) / (1024.0 * 1024.0);
+        std::vector<std::byte> hex_dump{};
+        std::vector<std::byte> binary_dump{};
+
+        const auto hex_rate = measure_rate(1, [&] {
+            hex_dump = dump_memory(client, 'm', 0x4000); //
+        });
+
+        client.start_no_ack_mode();
+
+        const auto binary_rate = measure_rate(1, [&] {
+            binary_dump = dump_memory(client, 'x', packet_size); //
+        });
+
+        client.send("D");
+
+        if (hex_dump != handler.get_memory() || binary_dump != handler.get_memory())
+        {
+            throw std::runtime_error("Dumped memory does not match");
+        }
+
+        report("gdb-dump", "hex m, acknowledged", hex_rate * megabytes, "MB/s");
+        report("gdb-dump", "binary x, no-ack", binary_rate * megabytes, "MB/s");
+    }
+}
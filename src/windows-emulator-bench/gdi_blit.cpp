@@ -0,0 +1,86 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <gdi_raster.hpp>
+
+#include <random>
+#include <vector>
+
+namespace sogen::bench
+{
+    namespace
+    {
+        constexpr int32_t width = 1280;
+        constexpr int32_t height = 720;
+        constexpr uint32_t pattern = 0x00808080u;
+        constexpr uint8_t rop3_srcinvert = 0x66;
+
+        // How the GDI syscalls drew before the raster layer: every pixel through the generic ROP3 truth table.
+        uint32_t per_pixel_rop3(const uint8_t rop3, const uint32_t src, const uint32_t dst, const uint32_t pat)
+        {
+            uint32_t out = 0;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                if (((rop3 >> i) & 1u) == 0)
+                {
+                    continue;
+                }
+
+                uint32_t mask = (i & 0x01u) ? dst : ~dst;
+                mask &= (i & 0x02u) ? src : ~src;
+                mask &= (i & 0x04u) ? pat : ~pat;
+                out |= mask;
+            }
+
+            return out;
+        }
+
+        gdi_raster::surface_view view(std::vector<uint32_t>& pixels)
+        {
+            return {
+                .pixels = pixels.data(),
+                .stride = static_cast<size_t>(width),
+                .width = width,
+                .height = height,
+            };
+        }
+    }
+
+    // Full-surface blits at a typical window size, through the raster kernels and through the per-pixel path.
+    void gdi_blit()
+    {
+        constexpr size_t iterations = 20;
+        constexpr auto pixels = static_cast<double>(width) * height;
+
+        std::vector<uint32_t> source(static_cast<size_t>(width) * height);
+        std::mt19937 rng{1};
+        for (auto& pixel : source)
+        {
+            pixel = rng();
+        }
+
+        const auto measure = [&](const uint8_t rop3, const bool use_kernels) {
+            std::vector<uint32_t> target(source.size(), 0xFFFFFFFFu);
+            const auto target_view = view(target);
+            const auto source_view = view(source);
+
+            return measure_rate(iterations, [&] {
+                if (use_kernels)
+                {
+                    gdi_raster::bit_blt(target_view, 0, 0, width, height, &source_view, 0, 0, rop3, pattern);
+                    return;
+                }
+
+                for (size_t i = 0; i < target.size(); ++i)
+                {
+                    target[i] = per_pixel_rop3(rop3, source[i], target[i], pattern) | gdi_raster::opaque_alpha;
+                }
+            });
+        };
+
+        report("gdi-blit", "srccopy", measure(gdi_raster::rop3_srccopy, true) * pixels / 1e6, "MPix/s");
+        report("gdi-blit", "srcinvert", measure(rop3_srcinvert, true) * pixels / 1e6, "MPix/s");
+        report("gdi-blit", "per-pixel srccopy", measure(gdi_raster::rop3_srccopy, false) * pixels / 1e6, "MPix/s");
+        report("gdi-blit", "per-pixel srcinvert", measure(rop3_srcinvert, false) * pixels / 1e6, "MPix/s");
+    }
+}
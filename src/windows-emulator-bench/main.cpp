@@ -0,0 +1,70 @@
+#include <array>
+#include <cstdio>
+#include <exception>
+#include <string_view>
+
+#include "benchmarks.hpp"
+
+namespace
+{
+    struct benchmark
+    {
+        std::string_view name{};
+        void (*run)(){};
+    };
+
+    constexpr std::array BENCHMARKS{
+        benchmark{"context-switch", &sogen::bench::context_switch},
+        benchmark{"fuzzer-throughput", &sogen::bench::fuzzer_throughput},
+        benchmark{"gdb-dump", &sogen::bench::gdb_dump},
+        benchmark{"gdi-blit", &sogen::bench::gdi_blit},
+        benchmark{"memory-storm", &sogen::bench::memory_storm},
+        benchmark{"registry-startup", &sogen::bench::registry_startup},
+        benchmark{"syscall-dispatch", &sogen::bench::syscall_dispatch},
+    };
+
+    bool should_run(const std::string_view name, const int argc, char** argv)
+    {
+        if (argc < 2)
+        {
+            return true;
+        }
+
+        for (int i = 1; i < argc; ++i)
+        {
+            if (name == argv[i])
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+// Throughput measurements that are too slow or too noisy for the unit tests. Runs every benchmark, or only
+// the ones named on the command line.
+int main(const int argc, char** argv)
+{
+    int result = 0;
+
+    for (const auto& benchmark : BENCHMARKS)
+    {
+        if (!should_run(benchmark.name, argc, argv))
+        {
+            continue;
+        }
+
+        try
+        {
+            benchmark.run();
+        }
+        catch (const std::exception& e)
+        {
+            (void)fprintf(stderr, "%.*s failed: %s\n", static_cast<int>(benchmark.name.size()), benchmark.name.data(), e.what());
+            result = 1;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,159 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <memory_manager.hpp>
+#include <address_utils.hpp>
+
+#include <vector>
+
+namespace sogen::bench
+{
+    namespace
+    {
+        // Guest memory that is never accessed; only memory_manager's bookkeeping is measured.
+        class null_memory : public memory_interface
+        {
+          public:
+            void read_memory(uint64_t, void*, size_t) const override
+            {
+            }
+
+            bool try_read_memory(uint64_t, void*, size_t) const override
+            {
+                return true;
+            }
+
+            void write_memory(uint64_t, const void*, size_t) override
+            {
+            }
+
+            bool try_write_memory(uint64_t, const void*, size_t) override
+            {
+                return true;
+            }
+
+          private:
+            void map_mmio(uint64_t, size_t, mmio_read_callback, mmio_write_callback) override
+            {
+            }
+
+            void map_memory(uint64_t, size_t, memory_permission) override
+            {
+            }
+
+            void unmap_memory(uint64_t, size_t) override
+            {
+            }
+
+            void apply_memory_protection(uint64_t, size_t, memory_permission) override
+            {
+            }
+        };
+
+        // The search over all reservations that the free-gap index replaced, as the "before" number.
+        uint64_t find_free_base_by_scan(const memory_manager& mm, const size_t size)
+        {
+            auto address = align_up(MIN_ALLOCATION_ADDRESS, ALLOCATION_GRANULARITY);
+
+            while (address + size - 1 <= MAX_ALLOCATION_ADDRESS)
+            {
+                bool conflict = false;
+
+                for (const auto& [region_start, region] : mm.get_reserved_regions())
+                {
+                    const auto region_end = region_start + region.length;
+                    if (region_end <= address)
+                    {
+                        continue;
+                    }
+
+                    if (region_start < address + size)
+                    {
+                        conflict = true;
+                        address = align_up(region_end, ALLOCATION_GRANULARITY);
+                    }
+
+                    break;
+                }
+
+                if (!conflict)
+                {
+                    return address;
+                }
+            }
+
+            return 0;
+        }
+    }
+
+    // VirtualAlloc/VirtualQuery storms against a fragmented address space, the pattern of JITs and browsers:
+    // thousands of live reservations with every other one released.
+    void memory_storm()
+    {
+        constexpr size_t live_allocations = 20'000;
+        constexpr size_t storm_allocations = 20'000;
+        constexpr size_t storm_queries = 1'000'000;
+        constexpr size_t free_base_lookups = 1'000;
+        constexpr size_t storm_size = 0x20000;
+
+        const nt_memory_permission read_write{memory_permission::read_write};
+
+        null_memory memory{};
+        memory_manager mm{memory};
+
+        std::vector<uint64_t> allocations{};
+        for (size_t i = 0; i < live_allocations; ++i)
+        {
+            allocations.push_back(mm.allocate_memory(0x1000, read_write));
+            if (!allocations.back())
+            {
+                throw std::runtime_error("Failed to set up the live allocations");
+            }
+        }
+
+        for (size_t i = 0; i < live_allocations; i += 2)
+        {
+            (void)mm.release_memory(allocations[i], 0);
+        }
+
+        const auto allocation_rate = measure_rate(storm_allocations, [&] {
+            const auto base = mm.allocate_memory(storm_size, read_write);
+            if (!base || !mm.release_memory(base, 0))
+            {
+                throw std::runtime_error("Storm allocation failed");
+            }
+        });
+
+        size_t query = 0;
+        size_t committed_queries = 0;
+        const auto query_rate = measure_rate(storm_queries, [&] {
+            committed_queries += mm.get_region_info(allocations[query++ % live_allocations] + 0x800).is_committed ? 1 : 0;
+        });
+
+        if (committed_queries != storm_queries / 2)
+        {
+            throw std::runtime_error("Queries saw the wrong committed pages");
+        }
+
+        uint64_t index_base = 0;
+        const auto index_rate = measure_rate(free_base_lookups, [&] {
+            index_base =
+                mm.find_free_allocation_base(storm_size, 0, ALLOCATION_GRANULARITY, MIN_ALLOCATION_ADDRESS, MAX_ALLOCATION_ADDRESS);
+        });
+
+        uint64_t scan_base = 0;
+        const auto scan_rate = measure_rate(free_base_lookups, [&] {
+            scan_base = find_free_base_by_scan(mm, storm_size); //
+        });
+
+        if (index_base != scan_base)
+        {
+            throw std::runtime_error("Free-gap index and full scan disagree");
+        }
+
+        report("memory-storm", "VirtualAlloc+VirtualFree", allocation_rate, "allocations/s");
+        report("memory-storm", "VirtualQuery", query_rate, "queries/s");
+        report("memory-storm", "free base, gap index", index_rate, "lookups/s");
+        report("memory-storm", "free base, full scan", scan_rate, "lookups/s");
+    }
+}
@@ -0,0 +1,51 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+#include <registry/registry_manager.hpp>
+
+#include <array>
+
+namespace sogen::bench
+{
+    // Time to open the standard hives and resolve the paths every process start touches.
+    void registry_startup()
+    {
+        constexpr size_t iterations = 100;
+        const std::array<std::u16string_view, 6> paths{
+            uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion)",
+            uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion\ProfileList)",
+            uR"(\Registry\Machine\System\CurrentControlSet\Control\Session Manager)",
+            uR"(\Registry\Machine\System\CurrentControlSet\Control\Nls\CodePage)",
+            uR"(\Registry\Machine\Software\Classes\CLSID)",
+            uR"(\Registry\Machine\Software\Microsoft\Cryptography)",
+        };
+
+        const auto hive_path = get_emulator_root() / "registry";
+        size_t values = 0;
+
+        const auto rate = measure_rate(iterations, [&] {
+            registry_manager registry{hive_path};
+
+            for (const auto path : paths)
+            {
+                const auto key = registry.get_key(utils::path_key{path});
+                if (!key)
+                {
+                    continue;
+                }
+
+                for (size_t value = 0; value < registry.get_value_count(*key); ++value)
+                {
+                    values += registry.get_value(*key, value).has_value() ? 1 : 0;
+                }
+            }
+        });
+
+        if (values == 0)
+        {
+            throw std::runtime_error("None of the startup paths resolved");
+        }
+
+        report("registry-startup", "startup", 1000.0 / rate, "ms");
+    }
+}
@@ -0,0 +1,44 @@
+#include "benchmarks.hpp"
+#include "bench_utils.hpp"
+
+namespace sogen::bench
+{
+    // Throughput of syscall_dispatcher::dispatch alone: a side-effect free syscall is dispatched directly,
+    // without executing guest code, so the number reflects lookup and callback overhead.
+    void syscall_dispatch()
+    {
+        constexpr size_t iterations = 200'000;
+
+        auto emu = create_sample_emulator();
+        emu.start(100);
+
+        const auto syscall_id = emu.dispatcher.find_syscall_id("NtGetCurrentProcessorNumber");
+        if (!syscall_id)
+        {
+            throw std::runtime_error("NtGetCurrentProcessorNumber is not in the syscall table");
+        }
+
+        size_t observed_syscalls = 0;
+        emu.callbacks.on_syscall = [&](uint32_t, std::string_view) {
+            ++observed_syscalls;
+            return instruction_hook_continuation::run_instruction;
+        };
+
+        auto& vcpu = emu.vcpu(0);
+        double rate = 0.0;
+
+        emu.dispatch_on_cpu(vcpu.cpu, [&] {
+            rate = measure_rate(iterations, [&] {
+                vcpu.cpu.reg<uint64_t>(x86_register::rax, *syscall_id);
+                emu.dispatcher.dispatch(emu, vcpu);
+            });
+        });
+
+        if (observed_syscalls != iterations)
+        {
+            throw std::runtime_error("Not every syscall reached the dispatcher callbacks");
+        }
+
+        report("syscall-dispatch", "NtGetCurrentProcessorNumber", rate, "syscalls/s");
+    }
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <corpus.hpp>
+
+#include <map>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+namespace sogen::test
+{
+    namespace
+    {
+        std::vector<uint8_t> make_input(const size_t size, const uint8_t tag)
+        {
+            return std::vector<uint8_t>(size, tag);
+        }
+
+        // Counts how often each entry is selected, keyed by its tag byte.
+        std::map<uint8_t, size_t> count_selections(fuzzer::corpus_scheduler& scheduler, const size_t rounds)
+        {
+            fuzzer::random_generator rng{};
+            std::map<uint8_t, size_t> selections{};
+
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                const auto* entry = scheduler.select(rng);
+                if (!entry)
+                {
+                    throw std::runtime_error("Nothing to select");
+                }
+
+                ++selections[entry->data.front()];
+            }
+
+            return selections;
+        }
+    }
+
+    TEST(CorpusTest, SchedulerWithoutEntriesSelectsNothing)
+    {
+        const fuzzer::corpus shared{};
+        fuzzer::corpus_scheduler scheduler{};
+        fuzzer::random_generator rng{};
+
+        scheduler.sync(shared);
+        EXPECT_EQ(scheduler.select(rng), nullptr);
+        EXPECT_EQ(scheduler.get_favored_count(), 0u);
+    }
+
+    // Every edge is won by the smallest entry covering it. The entries winning at least one edge that is not
+    // yet covered by an earlier winner form the favored set, so an entry whose edges all went to smaller ones
+    // is culled.
+    TEST(CorpusTest, CullingFavorsTheSmallestEntryPerEdge)
+    {
+        fuzzer::corpus shared{};
+        shared.add(make_input(10, 'a'), {1, 2});
+        shared.add(make_input(5, 'b'), {1});
+        shared.add(make_input(3, 'c'), {2});
+        shared.add(make_input(20, 'd'), {3});
+
+        fuzzer::corpus_scheduler scheduler{};
+        scheduler.sync(shared);
+
+        const auto selections = count_selections(scheduler, 4'000);
+        EXPECT_EQ(scheduler.get_favored_count(), 3u);
+
+        // Favored entries are picked nine times out of ten.
+        const auto culled = selections.contains('a') ? selections.at('a') : 0;
+        EXPECT_LT(culled * 3, selections.at('b'));
+        EXPECT_LT(culled * 3, selections.at('c'));
+        EXPECT_LT(culled * 3, selections.at('d'));
+
+        // One smaller entry covering everything replaces the whole favored set.
+        shared.add(make_input(2, 'e'), {1, 2, 3});
+        scheduler.sync(shared);
+
+        (void)count_selections(scheduler, 1);
+        EXPECT_EQ(scheduler.get_favored_count(), 1u);
+    }
+
+    TEST(CorpusTest, EqualSizedEntriesKeepTheFirstWinner)
+    {
+        fuzzer::corpus shared{};
+        shared.add(make_input(4, 'a'), {7, 8});
+        shared.add(make_input(4, 'b'), {7, 8});
+
+        fuzzer::corpus_scheduler scheduler{};
+        scheduler.sync(shared);
+
+        (void)count_selections(scheduler, 1);
+        EXPECT_EQ(scheduler.get_favored_count(), 1u);
+    }
+
+    // Workers append to the shared corpus while others sync from it. Every worker has to see each entry exactly
+    // once and complete, including across segment boundaries.
+    TEST(CorpusTest, ConcurrentAppendsAreSyncedExactlyOnce)
+    {
+        constexpr size_t writer_count = 4;
+        constexpr size_t reader_count = 4;
+        constexpr size_t entries_per_writer = 1'500;
+        constexpr size_t total_entries = writer_count * entries_per_writer;
+
+        static_assert(total_entries < fuzzer::COVERAGE_MAP_SIZE, "Every entry needs an edge of its own");
+
+        fuzzer::corpus shared{};
+        std::atomic_size_t writers_done{0};
+
+        std::vector<std::thread> writers{};
+        for (size_t writer = 0; writer < writer_count; ++writer)
+        {
+            writers.emplace_back([&, writer] {
+                for (size_t i = 0; i < entries_per_writer; ++i)
+                {
+                    const auto id = static_cast<uint32_t>(writer * entries_per_writer + i);
+
+                    std::vector<uint8_t> data(sizeof(id) + 1 + i % 16, static_cast<uint8_t>(writer));
+                    memcpy(data.data(), &id, sizeof(id));
+
+                    shared.add(std::move(data), {id});
+                }
+
+                ++writers_done;
+            });
+        }
+
+        std::vector<fuzzer::corpus_scheduler> schedulers(reader_count);
+        std::vector<std::vector<size_t>> seen(reader_count, std::vector<size_t>(total_entries, 0));
+        std::vector<size_t> broken_entries(reader_count, 0);
+
+        std::vector<std::thread> readers{};
+        for (size_t reader = 0; reader < reader_count; ++reader)
+        {
+            readers.emplace_back([&, reader] {
+                auto& scheduler = schedulers[reader];
+                size_t observed = 0;
+
+                const auto catch_up = [&] {
+                    scheduler.sync(shared);
+
+                    const auto published = shared.size();
+                    for (; observed < published; ++observed)
+                    {
+                        const auto& entry = shared.get(observed);
+
+                        uint32_t id{};
+                        if (entry.data.size() < sizeof(id) || entry.edges.size() != 1)
+                        {
+                            ++broken_entries[reader];
+                            continue;
+                        }
+
+                        memcpy(&id, entry.data.data(), sizeof(id));
+                        if (id >= total_entries || entry.edges.front() != id ||
+                            entry.data.back() != static_cast<uint8_t>(id / entries_per_writer))
+                        {
+                            ++broken_entries[reader];
+                            continue;
+                        }
+
+                        ++seen[reader][id];
+                    }
+                };
+
+                while (writers_done < writer_count)
+                {
+                    catch_up();
+                }
+
+                catch_up();
+            });
+        }
+
+        for (auto& thread : writers)
+        {
+            thread.join();
+        }
+
+        for (auto& thread : readers)
+        {
+            thread.join();
+        }
+
+        ASSERT_EQ(shared.size(), total_entries);
+
+        for (size_t reader = 0; reader < reader_count; ++reader)
+        {
+            EXPECT_EQ(broken_entries[reader], 0u);
+            EXPECT_EQ(std::ranges::count(seen[reader], 1u), static_cast<ptrdiff_t>(total_entries));
+
+            // Each entry owns one edge, so a skipped entry would also be missing from the favored set.
+            fuzzer::random_generator rng{};
+            ASSERT_NE(schedulers[reader].select(rng), nullptr);
+            EXPECT_EQ(schedulers[reader].get_entry_count(), total_entries);
+            EXPECT_EQ(schedulers[reader].get_favored_count(), total_entries);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <coverage_map.hpp>
+
+#include <array>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr uint64_t block_address = 0x140001000;
+
+        // Edge of a block jumping to itself, as in a tight loop.
+        uint32_t find_loop_edge()
+        {
+            fuzzer::coverage_trace trace{};
+            trace.on_basic_block(block_address);
+            const auto entry_edges = trace.collect_edges();
+
+            trace.on_basic_block(block_address);
+            for (const auto edge : trace.collect_edges())
+            {
+                if (std::ranges::find(entry_edges, edge) == entry_edges.end())
+                {
+                    return edge;
+                }
+            }
+
+            throw std::runtime_error("Loop edge collides with the entry edge");
+        }
+
+        // A trace that enters the block once and then takes its loop edge `iterations` times.
+        fuzzer::coverage_trace run_loop(const size_t iterations)
+        {
+            fuzzer::coverage_trace trace{};
+            trace.on_basic_block(block_address);
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                trace.on_basic_block(block_address);
+            }
+
+            return trace;
+        }
+    }
+
+    TEST(CoverageMapTest, ClassifyFoldsHitCountsIntoBuckets)
+    {
+        const auto loop_edge = find_loop_edge();
+
+        constexpr std::array<std::pair<size_t, uint8_t>, 16> expected_buckets{{
+            {1, 1},
+            {2, 2},
+            {3, 4},
+            {4, 8},
+            {7, 8},
+            {8, 16},
+            {15, 16},
+            {16, 32},
+            {31, 32},
+            {32, 64},
+            {127, 64},
+            {128, 128},
+            {255, 128},
+            {256, 128},
+            {1000, 128},
+            {0, 0},
+        }};
+
+        for (const auto& [iterations, bucket] : expected_buckets)
+        {
+            auto trace = run_loop(iterations);
+            EXPECT_EQ(trace.get_map()[loop_edge], std::min<size_t>(iterations, 0xFF)) << iterations << " iterations";
+
+            trace.classify();
+            EXPECT_EQ(trace.get_map()[loop_edge], bucket) << iterations << " iterations";
+        }
+    }
+
+    TEST(CoverageMapTest, ResetClearsTheMapAndThePreviousBlock)
+    {
+        auto trace = run_loop(10);
+        trace.reset();
+
+        EXPECT_TRUE(trace.collect_edges().empty());
+
+        // After a reset the next block is an entry again, not the target of the last edge.
+        trace.on_basic_block(block_address);
+        EXPECT_EQ(trace.collect_edges(), run_loop(0).collect_edges());
+    }
+
+    TEST(CoverageMapTest, GlobalCoverageReportsNewEdgesAndNewBuckets)
+    {
+        fuzzer::global_coverage coverage{};
+
+        auto once = run_loop(1);
+        once.classify();
+        EXPECT_EQ(coverage.merge(once), fuzzer::coverage_novelty::new_edge);
+        EXPECT_EQ(coverage.get_edge_count(), 2u);
+        EXPECT_EQ(coverage.merge(once), fuzzer::coverage_novelty::none);
+
+        // Same edges, but the loop count moved to another bucket.
+        auto three_times = run_loop(3);
+        three_times.classify();
+        EXPECT_EQ(coverage.merge(three_times), fuzzer::coverage_novelty::new_hit_count);
+        EXPECT_EQ(coverage.get_edge_count(), 2u);
+
+        // Within a bucket that was already seen.
+        auto four_times = run_loop(4);
+        auto five_times = run_loop(5);
+        four_times.classify();
+        five_times.classify();
+        EXPECT_EQ(coverage.merge(four_times), fuzzer::coverage_novelty::new_hit_count);
+        EXPECT_EQ(coverage.merge(five_times), fuzzer::coverage_novelty::none);
+
+        fuzzer::coverage_trace other_block{};
+        other_block.on_basic_block(block_address + 0x40);
+        other_block.classify();
+        EXPECT_EQ(coverage.merge(other_block), fuzzer::coverage_novelty::new_edge);
+        EXPECT_EQ(coverage.get_edge_count(), 3u);
+    }
+}
@@ -50,6 +50,8 @@ namespace sogen::test
     struct sample_configuration
     {
         bool print_time{false};
+        // Backend to run the sample on, instead of the one selected by the environment.
+        std::optional<backend_type> backend{};
     };
 
     namespace
@@ -185,7 +187,7 @@ namespace sogen::test
         }
 
         return windows_emulator{
-            create_x86_64_emulator_from_environment(),
+            config.backend ? create_x86_64_emulator(*config.backend) : create_x86_64_emulator_from_environment(),
             get_sample_app_settings(config),
             settings,
             std::move(callbacks),
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <ui_backends/frame_capture.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <random>
+
+namespace sogen::test
+{
+    namespace
+    {
+        class FrameCaptureTest : public testing::Test
+        {
+          protected:
+            void SetUp() override
+            {
+                static std::atomic_uint64_t counter{};
+                const auto timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+                path_ = std::filesystem::temp_directory_path() /
+                        ("sogen-frame-capture-test-" + std::to_string(timestamp) + "-" + std::to_string(counter++));
+            }
+
+            void TearDown() override
+            {
+                std::error_code ec{};
+                std::filesystem::remove(path_, ec);
+            }
+
+            std::filesystem::path path_{};
+        };
+
+        struct test_image
+        {
+            int width{};
+            int height{};
+            std::vector<uint32_t> pixels{};
+
+            test_image(const int w, const int h)
+                : width(w),
+                  height(h),
+                  pixels(static_cast<size_t>(w) * static_cast<size_t>(h))
+            {
+                std::mt19937 rng{static_cast<uint32_t>(w * 31 + h)};
+                for (auto& pixel : this->pixels)
+                {
+                    pixel = rng();
+                }
+            }
+
+            uint32_t& at(const int x, const int y)
+            {
+                return this->pixels[static_cast<size_t>(y) * static_cast<size_t>(this->width) + static_cast<size_t>(x)];
+            }
+
+            ui_surface_desc desc(const std::optional<RECT>& damage = std::nullopt) const
+            {
+                return {
+                    .width = this->width,
+                    .height = this->height,
+                    .stride = this->width * 4,
+                    .format = ui_surface_format::bgra8,
+                    .pixels = this->pixels.data(),
+                    .damage = damage,
+                };
+            }
+        };
+
+        std::vector<frame_capture::decoded_frame> decode_all(const std::filesystem::path& path,
+                                                             std::vector<std::vector<uint32_t>>& contents)
+        {
+            frame_capture::decoder decoder{path};
+            std::vector<frame_capture::decoded_frame> frames{};
+
+            while (const auto frame = decoder.next())
+            {
+                frames.push_back(*frame);
+                contents.emplace_back(frame->pixels.begin(), frame->pixels.end());
+            }
+
+            return frames;
+        }
+    }
+
+    TEST_F(FrameCaptureTest, EncodesOnlyDamagedTilesThatChanged)
+    {
+        test_image image{300, 200};
+        std::vector<std::vector<uint32_t>> expected{};
+
+        {
+            frame_capture::encoder encoder{path_, 0};
+            const auto& stats = encoder.get_statistics();
+
+            encoder.encode(1, 0, image.desc(), std::nullopt);
+            expected.push_back(image.pixels);
+            EXPECT_EQ(stats.keyframes, 1u);
+
+            image.at(70, 70) = 0;
+            image.at(10, 150) = 0;
+            const std::array<RECT, 2> damage{RECT{66, 66, 80, 80}, RECT{0, 140, 20, 160}};
+            encoder.encode(1, 10, image.desc(), damage);
+            expected.push_back(image.pixels);
+            EXPECT_EQ(stats.compared_tiles, 2u);
+            EXPECT_EQ(stats.encoded_tiles, 2u);
+
+            // Damage without changes compares, but writes nothing.
+            const std::array<RECT, 1> unchanged{RECT{0, 0, 300, 64}};
+            encoder.encode(1, 20, image.desc(), unchanged);
+            EXPECT_EQ(stats.compared_tiles, 7u);
+            EXPECT_EQ(stats.frames, 2u);
+
+            // Unknown damage compares every tile.
+            image.at(299, 199) = 0;
+            encoder.encode(1, 30, image.desc(), std::nullopt);
+            expected.push_back(image.pixels);
+            EXPECT_EQ(stats.compared_tiles, 27u);
+            EXPECT_EQ(stats.encoded_tiles, 3u);
+
+            test_image resized{100, 50};
+            encoder.encode(1, 40, resized.desc(), std::nullopt);
+            expected.push_back(resized.pixels);
+            EXPECT_EQ(stats.keyframes, 2u);
+            EXPECT_EQ(stats.frames, 4u);
+        }
+
+        std::vector<std::vector<uint32_t>> contents{};
+        const auto frames = decode_all(path_, contents);
+
+        ASSERT_EQ(frames.size(), 4u);
+        EXPECT_EQ(frames[0].header.type, frame_capture::frame_type::keyframe);
+        EXPECT_EQ(frames[1].header.type, frame_capture::frame_type::delta);
+        EXPECT_EQ(frames[1].header.tile_count, 2u);
+        EXPECT_EQ(frames[1].header.timestamp_us, 10u);
+        EXPECT_EQ(frames[2].header.tile_count, 1u);
+        EXPECT_EQ(frames[3].header.type, frame_capture::frame_type::keyframe);
+        EXPECT_EQ(frames[3].header.width, 100u);
+        EXPECT_EQ(contents, expected);
+    }
+
+    TEST_F(FrameCaptureTest, BackendCombinesInvalidationsAndSurfaceDamage)
+    {
+        constexpr hwnd window = 0x10020;
+        constexpr hwnd other_window = 0x10030;
+
+        test_image image{256, 128};
+        test_image other{64, 64};
+        std::vector<std::vector<uint32_t>> expected{};
+
+        {
+            const auto backend = create_capture_ui_backend(path_);
+            EXPECT_FALSE(backend->needs_pumping());
+
+            backend->present_surface(window, image.desc(RECT{0, 0, 256, 128}));
+            expected.push_back(image.pixels);
+
+            backend->present_surface(other_window, other.desc());
+            expected.push_back(other.pixels);
+
+            image.at(5, 5) = 1;
+            image.at(200, 100) = 2;
+            backend->invalidate(window, RECT{0, 0, 10, 10});
+            backend->present_surface(window, image.desc(RECT{200, 100, 201, 101}));
+            expected.push_back(image.pixels);
+
+            // A destroyed window starts over with a keyframe.
+            backend->destroy_window(other_window);
+            backend->present_surface(other_window, other.desc());
+            expected.push_back(other.pixels);
+        }
+
+        std::vector<std::vector<uint32_t>> contents{};
+        const auto frames = decode_all(path_, contents);
+
+        ASSERT_EQ(frames.size(), 4u);
+        EXPECT_EQ(frames[2].header.window, window);
+        EXPECT_EQ(frames[2].header.tile_count, 2u);
+        EXPECT_EQ(frames[3].header.type, frame_capture::frame_type::keyframe);
+        EXPECT_EQ(contents, expected);
+    }
+
+    TEST_F(FrameCaptureTest, WritesUncompressedPng)
+    {
+        const std::array<uint32_t, 6> pixels{0xFF112233, 0xFF445566, 0xFF778899, 0x00AABBCC, 0xFFDDEEFF, 0xFF000000};
+        frame_capture::write_png(path_, 3, 2, pixels, frame_capture::pixel_format::bgra8);
+
+        std::ifstream file{path_, std::ios::binary};
+        const std::vector<uint8_t> png{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+        // Signature, IHDR (8 + 13 + 4 bytes), then IDAT with a zlib header and a single stored block.
+        constexpr size_t idat_data = 8 + 25 + 8;
+        ASSERT_GT(png.size(), idat_data + 7 + 20);
+
+        EXPECT_EQ(std::vector<uint8_t>(png.begin(), png.begin() + 8), (std::vector<uint8_t>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'}));
+        EXPECT_EQ(std::string(png.begin() + 12, png.begin() + 16), "IHDR");
+        EXPECT_EQ(png[19], 3);
+        EXPECT_EQ(png[23], 2);
+        EXPECT_EQ(std::string(png.begin() + 37, png.begin() + 41), "IDAT");
+        EXPECT_EQ(png[idat_data + 2], 1); // final stored block
+
+        const std::vector<uint8_t> scanlines(png.begin() + idat_data + 7, png.begin() + idat_data + 7 + 20);
+        const std::vector<uint8_t> expected{
+            0, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, //
+            0, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00, 0x00, 0x00, //
+        };
+        EXPECT_EQ(scanlines, expected);
+    }
+}
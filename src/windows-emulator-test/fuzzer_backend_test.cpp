@@ -0,0 +1,81 @@
+#include "emulation_test_utils.hpp"
+
+#include <array>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr std::array BACKENDS{
+            backend_type::unicorn, backend_type::icicle, backend_type::whp, backend_type::kvm, backend_type::fex,
+        };
+
+        std::string get_backend_name(const backend_type backend)
+        {
+            switch (backend)
+            {
+            case backend_type::unicorn:
+                return "unicorn";
+            case backend_type::icicle:
+                return "icicle";
+            case backend_type::whp:
+                return "whp";
+            case backend_type::kvm:
+                return "kvm";
+            case backend_type::fex:
+                return "fex";
+            }
+
+            return "unknown";
+        }
+
+        bool is_backend_available(const backend_type backend)
+        {
+            try
+            {
+                return create_x86_64_emulator(backend) != nullptr;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+    }
+
+    class FuzzerBackendTest : public testing::TestWithParam<backend_type>
+    {
+    };
+
+    // The fuzzing loop on every backend: each execution resets test-sample to a snapshot and runs a fixed slice
+    // of it, as a fuzzing worker does per input. Throughput is measured by windows-emulator-bench.
+    TEST_P(FuzzerBackendTest, SnapshotResetExecutions)
+    {
+        constexpr size_t executions = 3;
+        constexpr size_t instructions_per_execution = 20'000;
+
+        const auto backend = GetParam();
+        if (!is_backend_available(backend))
+        {
+            GTEST_SKIP() << get_backend_name(backend) << " backend is not available on this host";
+        }
+
+        auto emu = create_sample_emulator({.backend = backend});
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        emu.save_snapshot();
+        const auto snapshot_ip = emu.emu().read_instruction_pointer();
+
+        for (size_t i = 0; i < executions; ++i)
+        {
+            emu.restore_snapshot();
+            ASSERT_EQ(emu.emu().read_instruction_pointer(), snapshot_ip);
+
+            emu.start(instructions_per_execution);
+            ASSERT_NOT_TERMINATED(emu);
+        }
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Backends, FuzzerBackendTest, testing::ValuesIn(BACKENDS),
+                             [](const testing::TestParamInfo<backend_type>& info) { return get_backend_name(info.param); });
+} // namespace sogen::test
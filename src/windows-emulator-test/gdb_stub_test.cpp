@@ -0,0 +1,418 @@
+#include <gtest/gtest.h>
+
+#include <gdb_stub.hpp>
+#include <checksum.hpp>
+#include <stream_processor.hpp>
+
+#include <network/tcp_client_socket.hpp>
+#include <network/tcp_server_socket.hpp>
+#include <utils/string.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace std::literals;
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr uint64_t memory_base = 0x10000000;
+        constexpr size_t memory_size = 0x4000;
+        constexpr size_t zero_run_offset = 0x2000;
+        constexpr size_t escaped_run_offset = 0x3000;
+        constexpr size_t run_length = 0x800;
+
+        // Serves a flat block of memory, filled so that every byte value that needs escaping shows up, with
+        // long runs of a plain and of an escaped byte for the run-length encoding.
+        class memory_debugging_handler : public gdb_stub::debugging_handler
+        {
+          public:
+            memory_debugging_handler()
+            {
+                this->memory_.resize(memory_size);
+
+                uint32_t state = 0x12345678;
+                for (auto& value : this->memory_)
+                {
+                    state = state * 1664525 + 1013904223;
+                    value = static_cast<std::byte>(state >> 24);
+                }
+
+                std::fill_n(this->memory_.begin() + zero_run_offset, run_length, std::byte{0});
+                std::fill_n(this->memory_.begin() + escaped_run_offset, run_length, std::byte{'}'});
+            }
+
+            const std::vector<std::byte>& get_memory() const
+            {
+                return this->memory_;
+            }
+
+            void stop()
+            {
+                this->stop_ = true;
+            }
+
+            gdb_stub::action run() override
+            {
+                return gdb_stub::action::resume;
+            }
+
+            gdb_stub::action singlestep() override
+            {
+                return gdb_stub::action::resume;
+            }
+
+            size_t get_register_count() override
+            {
+                return 0;
+            }
+
+            size_t get_max_register_size() override
+            {
+                return 8;
+            }
+
+            size_t read_register(size_t, void*, size_t) override
+            {
+                return 0;
+            }
+
+            size_t write_register(size_t, const void*, size_t) override
+            {
+                return 0;
+            }
+
+            bool read_memory(const uint64_t address, void* data, const size_t length) override
+            {
+                if (address < memory_base || address - memory_base > memory_size || length > memory_size - (address - memory_base))
+                {
+                    return false;
+                }
+
+                memcpy(data, this->memory_.data() + (address - memory_base), length);
+                return true;
+            }
+
+            bool write_memory(uint64_t, const void*, size_t) override
+            {
+                return false;
+            }
+
+            bool set_breakpoint(gdb_stub::breakpoint_type, uint64_t, size_t) override
+            {
+                return false;
+            }
+
+            bool delete_breakpoint(gdb_stub::breakpoint_type, uint64_t, size_t) override
+            {
+                return false;
+            }
+
+            void on_interrupt() override
+            {
+            }
+
+            std::string get_target_description(std::string_view) override
+            {
+                return {};
+            }
+
+            bool switch_to_thread(uint32_t) override
+            {
+                return true;
+            }
+
+            uint32_t get_current_thread_id() override
+            {
+                return 1;
+            }
+
+            std::vector<uint32_t> get_thread_ids() override
+            {
+                return {1};
+            }
+
+            std::optional<uint32_t> get_exit_code() override
+            {
+                return std::nullopt;
+            }
+
+            bool should_stop() override
+            {
+                return this->stop_;
+            }
+
+            std::vector<gdb_stub::memory_region> get_memory_regions() override
+            {
+                return {{.address = memory_base, .length = memory_size}};
+            }
+
+          private:
+            std::vector<std::byte> memory_{};
+            std::atomic_bool stop_{false};
+        };
+
+        std::string make_packet(const std::string_view payload)
+        {
+            return "$" + std::string(payload) + "#" + utils::string::to_hex_string(gdb_stub::compute_checksum(payload));
+        }
+
+        std::string expand_runs(const std::string_view data)
+        {
+            std::string result{};
+            result.reserve(data.size());
+
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                if (data[i] == '*' && i + 1 < data.size() && !result.empty())
+                {
+                    result.append(static_cast<size_t>(data[++i] - 29), result.back());
+                }
+                else
+                {
+                    result.push_back(data[i]);
+                }
+            }
+
+            return result;
+        }
+
+        std::string unescape_binary(const std::string_view data)
+        {
+            std::string result{};
+            result.reserve(data.size());
+
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                result.push_back(data[i] == '}' && i + 1 < data.size() ? static_cast<char>(data[++i] ^ 0x20) : data[i]);
+            }
+
+            return result;
+        }
+
+        // Debugger side of a loopback session, acknowledging replies like gdb does until no-ack mode is on.
+        class gdb_client
+        {
+          public:
+            explicit gdb_client(const network::address& address)
+                : socket_(address.get_family())
+            {
+                const auto deadline = std::chrono::steady_clock::now() + 10s;
+                while (!this->socket_.connect(address))
+                {
+                    if (std::chrono::steady_clock::now() > deadline)
+                    {
+                        throw std::runtime_error("Failed to connect to gdb stub");
+                    }
+
+                    std::this_thread::sleep_for(10ms);
+                    this->socket_ = network::tcp_client_socket(address.get_family());
+                }
+
+                (void)this->socket_.set_no_delay(true);
+            }
+
+            std::string request(const std::string_view payload)
+            {
+                (void)this->socket_.send(make_packet(payload));
+
+                while (!this->processor_.has_packet())
+                {
+                    const auto data = this->socket_.receive();
+                    if (!data)
+                    {
+                        throw std::runtime_error("gdb stub closed the connection");
+                    }
+
+                    this->processor_.push_stream_data(*data);
+                }
+
+                if (!this->no_ack_mode_)
+                {
+                    (void)this->socket_.send("+");
+                }
+
+                const auto reply = this->processor_.get_next_packet();
+                this->received_runs_ |= reply.find('*') != std::string::npos;
+                return expand_runs(reply);
+            }
+
+            // Whether a reply used run-length encoding since the last call.
+            bool take_received_runs()
+            {
+                return std::exchange(this->received_runs_, false);
+            }
+
+            void start_no_ack_mode()
+            {
+                this->no_ack_mode_ = this->request("QStartNoAckMode") == "OK";
+            }
+
+            void send(const std::string_view payload)
+            {
+                (void)this->socket_.send(make_packet(payload));
+            }
+
+          private:
+            network::tcp_client_socket socket_{};
+            gdb_stub::stream_processor processor_{};
+            bool no_ack_mode_{false};
+            bool received_runs_{false};
+        };
+
+        network::address get_free_loopback_address()
+        {
+            network::address address{"127.0.0.1:0"};
+
+            network::tcp_server_socket server{address.get_family()};
+            if (!server.bind(address))
+            {
+                throw std::runtime_error("Failed to bind loopback socket");
+            }
+
+            address.set_port(server.get_port());
+            return address;
+        }
+
+        size_t get_packet_size(const std::string_view supported)
+        {
+            const auto start = supported.find("PacketSize=");
+            if (start == std::string_view::npos)
+            {
+                return 0;
+            }
+
+            return strtoull(std::string(supported.substr(start + 11)).c_str(), nullptr, 16);
+        }
+
+        // Runs the stub on its own thread for the lifetime of the object.
+        class stub_session
+        {
+          public:
+            stub_session(memory_debugging_handler& handler, const network::address& address)
+                : handler_(&handler),
+                  thread_([&handler, address] {
+                      (void)gdb_stub::run_gdb_stub(address, handler); //
+                  })
+            {
+            }
+
+            ~stub_session()
+            {
+                this->handler_->stop();
+                this->thread_.join();
+            }
+
+            stub_session(stub_session&&) = delete;
+            stub_session(const stub_session&) = delete;
+            stub_session& operator=(stub_session&&) = delete;
+            stub_session& operator=(const stub_session&) = delete;
+
+          private:
+            memory_debugging_handler* handler_{};
+            std::thread thread_{};
+        };
+    }
+
+    TEST(GdbStubTest, StreamProcessorSplitsPackets)
+    {
+        gdb_stub::stream_processor processor{};
+
+        const auto first = make_packet("m1000,4");
+        const auto second = make_packet("X1000,2:}\x03}]");
+
+        auto bad_checksum = make_packet("g");
+        bad_checksum.back() = bad_checksum.back() == '0' ? '1' : '0';
+
+        const auto stream = "+\x03" + first + "+" + bad_checksum + second;
+
+        for (const auto ch : stream)
+        {
+            processor.push_stream_data(std::string_view(&ch, 1));
+        }
+
+        ASSERT_TRUE(processor.has_packet());
+        EXPECT_EQ(processor.get_next_packet(), "m1000,4");
+        ASSERT_TRUE(processor.has_packet());
+        EXPECT_EQ(processor.get_next_packet(), "X1000,2:}\x03}]");
+        EXPECT_FALSE(processor.has_packet());
+
+        processor.push_stream_data(make_packet("c") + make_packet("s"));
+
+        ASSERT_TRUE(processor.has_packet());
+        EXPECT_EQ(processor.get_next_packet(), "c");
+        ASSERT_TRUE(processor.has_packet());
+        EXPECT_EQ(processor.get_next_packet(), "s");
+        EXPECT_FALSE(processor.has_packet());
+    }
+
+    // Dumps the same memory over a loopback connection the way older clients do (hex m packets, acknowledged)
+    // and with what the stub now negotiates (no-ack mode, binary x packets), both run-length encoded.
+    TEST(GdbStubTest, LoopbackMemoryDump)
+    {
+        constexpr size_t chunk_size = 0x1000;
+
+        memory_debugging_handler handler{};
+        const auto address = get_free_loopback_address();
+
+        const stub_session session{handler, address};
+
+        gdb_client client{address};
+        const auto& expected = handler.get_memory();
+
+        const auto supported = client.request("qSupported:multiprocess+;xmlRegisters=i386");
+        EXPECT_NE(supported.find("QStartNoAckMode+"), std::string::npos);
+        EXPECT_NE(supported.find("qXfer:memory-map:read+"), std::string::npos);
+
+        const auto packet_size = get_packet_size(supported);
+        ASSERT_GE(packet_size, chunk_size);
+
+        const auto memory_map = client.request("qXfer:memory-map:read::0,1000");
+        EXPECT_NE(memory_map.find("start=\"0x10000000\" length=\"0x4000\""), std::string::npos);
+
+        std::vector<std::byte> hex_dump{};
+        while (hex_dump.size() < memory_size)
+        {
+            const auto size = std::min(chunk_size, memory_size - hex_dump.size());
+            const auto reply = client.request("m" + utils::string::to_hex_number(memory_base + hex_dump.size()) + "," +
+                                              utils::string::to_hex_number(size));
+
+            const auto data = utils::string::from_hex_string(reply);
+            ASSERT_EQ(data.size(), size);
+            hex_dump.insert(hex_dump.end(), data.begin(), data.end());
+        }
+
+        EXPECT_TRUE(client.take_received_runs());
+
+        client.start_no_ack_mode();
+
+        std::vector<std::byte> binary_dump{};
+        while (binary_dump.size() < memory_size)
+        {
+            const auto size = std::min(chunk_size, memory_size - binary_dump.size());
+            const auto reply = client.request("x" + utils::string::to_hex_number(memory_base + binary_dump.size()) + "," +
+                                              utils::string::to_hex_number(size));
+
+            ASSERT_FALSE(reply.empty());
+            ASSERT_EQ(reply.front(), 'b');
+
+            const auto data = unescape_binary(std::string_view(reply).substr(1));
+            ASSERT_FALSE(data.empty());
+            ASSERT_LE(data.size(), size);
+
+            const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+            binary_dump.insert(binary_dump.end(), bytes, bytes + data.size());
+        }
+
+        EXPECT_TRUE(client.take_received_runs());
+
+        EXPECT_EQ(client.request("x0,10"), "E01");
+        client.send("D");
+
+        EXPECT_TRUE(hex_dump == expected);
+        EXPECT_TRUE(binary_dump == expected);
+    }
+} // namespace sogen::test
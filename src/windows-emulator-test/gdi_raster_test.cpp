@@ -0,0 +1,409 @@
+#include <gtest/gtest.h>
+#include <gdi_raster.hpp>
+
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace sogen::test
+{
+    namespace
+    {
+        struct test_surface
+        {
+            int32_t width{};
+            int32_t height{};
+            std::vector<uint32_t> pixels{};
+
+            test_surface(const int32_t w, const int32_t h, const uint32_t fill = 0)
+                : width(w),
+                  height(h),
+                  pixels(static_cast<size_t>(w) * static_cast<size_t>(h), fill)
+            {
+            }
+
+            gdi_raster::surface_view view()
+            {
+                return {
+                    .pixels = this->pixels.data(),
+                    .stride = static_cast<size_t>(this->width),
+                    .width = this->width,
+                    .height = this->height,
+                };
+            }
+
+            uint32_t& at(const int64_t x, const int64_t y)
+            {
+                return this->pixels[static_cast<size_t>(y) * static_cast<size_t>(this->width) + static_cast<size_t>(x)];
+            }
+
+            bool contains(const int64_t x, const int64_t y) const
+            {
+                return x >= 0 && y >= 0 && x < this->width && y < this->height;
+            }
+        };
+
+        // Per-pixel versions of the kernels, written the way the GDI syscalls drew before the raster layer.
+
+        uint32_t reference_rop3(const uint8_t rop3, const uint32_t src, const uint32_t dst, const uint32_t pat)
+        {
+            uint32_t out = 0;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                if (((rop3 >> i) & 1u) == 0)
+                {
+                    continue;
+                }
+
+                uint32_t mask = (i & 0x01u) ? dst : ~dst;
+                mask &= (i & 0x02u) ? src : ~src;
+                mask &= (i & 0x04u) ? pat : ~pat;
+                out |= mask;
+            }
+
+            return out;
+        }
+
+        bool reference_uses_source(const uint8_t rop3)
+        {
+            for (uint32_t p = 0; p <= 1; ++p)
+            {
+                for (uint32_t d = 0; d <= 1; ++d)
+                {
+                    const uint32_t i0 = (p << 2) | d;
+                    const uint32_t i1 = (p << 2) | 0x02u | d;
+                    if (((rop3 >> i0) & 1u) != ((rop3 >> i1) & 1u))
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        void reference_fill(test_surface& surface, const int64_t left, const int64_t top, const int64_t right, const int64_t bottom,
+                            const uint32_t color)
+        {
+            for (auto y = top; y < bottom; ++y)
+            {
+                for (auto x = left; x < right; ++x)
+                {
+                    if (surface.contains(x, y))
+                    {
+                        surface.at(x, y) = color;
+                    }
+                }
+            }
+        }
+
+        // Snapshots source and destination first, like the BitBlt syscall did.
+        void reference_bit_blt(test_surface& dst, const int64_t x_dst, const int64_t y_dst, const int64_t width, const int64_t height,
+                               test_surface* src, const int64_t x_src, const int64_t y_src, const uint8_t rop3, const uint32_t pattern)
+        {
+            const bool needs_source = reference_uses_source(rop3);
+            const auto dst_copy = dst;
+            const auto src_copy = src ? *src : test_surface(0, 0);
+
+            for (int64_t y = 0; y < height; ++y)
+            {
+                for (int64_t x = 0; x < width; ++x)
+                {
+                    if (!dst.contains(x_dst + x, y_dst + y) || (needs_source && !src_copy.contains(x_src + x, y_src + y)))
+                    {
+                        continue;
+                    }
+
+                    const auto s = needs_source ? src_copy.pixels[static_cast<size_t>((y_src + y) * src_copy.width + x_src + x)] : 0;
+                    const auto d = dst_copy.pixels[static_cast<size_t>((y_dst + y) * dst_copy.width + x_dst + x)];
+                    dst.at(x_dst + x, y_dst + y) = reference_rop3(rop3, s, d, pattern) | gdi_raster::opaque_alpha;
+                }
+            }
+        }
+
+        void reference_stretch_blt(test_surface& dst, const int x_dst, const int y_dst, const int dst_width, const int dst_height,
+                                   test_surface* src, const int x_src, const int y_src, const int src_width, const int src_height,
+                                   const uint8_t rop3, const uint32_t pattern)
+        {
+            const bool needs_source = reference_uses_source(rop3);
+            const int dst_w = std::abs(dst_width);
+            const int dst_h = std::abs(dst_height);
+            const int src_w = std::abs(src_width);
+            const int src_h = std::abs(src_height);
+
+            for (int dy = 0; dy < dst_h; ++dy)
+            {
+                const int out_y = y_dst + (dst_height < 0 ? (dst_h - 1 - dy) : dy);
+                const int src_dy = static_cast<int>(static_cast<int64_t>(dy) * src_h / dst_h);
+                const int sy = y_src + (src_height < 0 ? (src_h - 1 - src_dy) : src_dy);
+
+                for (int dx = 0; dx < dst_w; ++dx)
+                {
+                    const int out_x = x_dst + (dst_width < 0 ? (dst_w - 1 - dx) : dx);
+                    const int src_dx = static_cast<int>(static_cast<int64_t>(dx) * src_w / dst_w);
+                    const int sx = x_src + (src_width < 0 ? (src_w - 1 - src_dx) : src_dx);
+
+                    if (!dst.contains(out_x, out_y) || (needs_source && !src->contains(sx, sy)))
+                    {
+                        continue;
+                    }
+
+                    const auto s = needs_source ? src->at(sx, sy) : 0;
+                    dst.at(out_x, out_y) = reference_rop3(rop3, s, dst.at(out_x, out_y), pattern) | gdi_raster::opaque_alpha;
+                }
+            }
+        }
+
+        void reference_glyph(test_surface& surface, const int x, const int y, const std::vector<uint8_t>& rows, const uint32_t color,
+                             const RECT* clip)
+        {
+            for (size_t row = 0; row < rows.size(); ++row)
+            {
+                for (int col = 0; col < 8; ++col)
+                {
+                    const auto px = x + col;
+                    const auto py = y + static_cast<int>(row);
+                    const bool clipped = clip && (px < clip->left || px >= clip->right || py < clip->top || py >= clip->bottom);
+
+                    if ((rows[row] & (1u << col)) != 0 && !clipped && surface.contains(px, py))
+                    {
+                        surface.at(px, py) = color;
+                    }
+                }
+            }
+        }
+
+        // One character per pixel, looked up in `palette` (pairs of character and color).
+        std::vector<uint32_t> parse_image(const std::vector<std::string_view>& rows, const std::vector<std::pair<char, uint32_t>>& palette)
+        {
+            std::vector<uint32_t> pixels{};
+
+            for (const auto row : rows)
+            {
+                for (const auto ch : row)
+                {
+                    const auto entry = std::ranges::find(palette, ch, &std::pair<char, uint32_t>::first);
+                    pixels.push_back(entry != palette.end() ? entry->second : 0);
+                }
+            }
+
+            return pixels;
+        }
+
+        constexpr uint32_t white = 0xFFFFFFFFu;
+        constexpr uint32_t black = 0xFF000000u;
+        constexpr uint32_t red = 0xFFFF0000u;
+        constexpr uint32_t green = 0xFF00FF00u;
+        constexpr uint32_t blue = 0xFF0000FFu;
+
+        const std::vector<std::pair<char, uint32_t>> golden_palette{{'.', white}, {'#', black}, {'r', red}, {'g', green}, {'b', blue}};
+    }
+
+    TEST(GdiRasterTest, Rop3MatchesTruthTables)
+    {
+        std::mt19937 rng{0x6d1};
+
+        for (uint32_t rop = 0; rop < 256; ++rop)
+        {
+            const auto rop3 = static_cast<uint8_t>(rop);
+            EXPECT_EQ(gdi_raster::rop3_uses_source(rop3), reference_uses_source(rop3)) << "rop " << rop;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                const auto s = rng();
+                const auto d = rng();
+                const auto p = rng();
+                ASSERT_EQ(gdi_raster::apply_rop3(rop3, s, d, p), reference_rop3(rop3, s, d, p)) << "rop " << rop;
+            }
+        }
+    }
+
+    TEST(GdiRasterTest, GoldenImage)
+    {
+        test_surface surface{16, 8, white};
+        auto view = surface.view();
+
+        gdi_raster::fill_rect(view, 2, 1, 6, 4, red);
+        gdi_raster::bit_blt(view, 4, 3, 4, 3, &view, 2, 1, gdi_raster::rop3_srccopy, 0);
+        gdi_raster::bit_blt(view, -1, 6, 4, 5, nullptr, 0, 0, 0x55 /* DSTINVERT */, 0);
+
+        const std::vector<uint8_t> exclamation{0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00};
+        gdi_raster::draw_glyph(view, 9, 0, exclamation, black);
+
+        const RECT clip{.left = 0, .top = 0, .right = 3, .bottom = 8};
+        gdi_raster::draw_glyph(view, -2, 1, exclamation, blue, &clip);
+
+        const auto expected = parse_image(
+            {
+                "............##..", //
+                ".bbrrr.....####.", //
+                "bbbrrr.....####.", //
+                "bbbrrrrr....##..", //
+                ".bb.rrrr....##..", //
+                ".bb.rrrr........", //
+                "###.........##..", //
+                "#bb.............", //
+            },
+            golden_palette);
+
+        EXPECT_EQ(surface.pixels, expected);
+    }
+
+    TEST(GdiRasterTest, GoldenStretchImage)
+    {
+        test_surface source{2, 2};
+        source.pixels = {red, green, blue, black};
+        auto source_view = source.view();
+
+        test_surface surface{6, 5, white};
+        auto view = surface.view();
+
+        // Mirrored horizontally and clipped at the bottom.
+        gdi_raster::stretch_blt(view, 1, 1, -4, 6, &source_view, 0, 0, 2, 2, gdi_raster::rop3_srccopy, 0);
+
+        const auto expected = parse_image(
+            {
+                "......", //
+                ".ggrr.", //
+                ".ggrr.", //
+                ".ggrr.", //
+                ".##bb.", //
+            },
+            golden_palette);
+
+        EXPECT_EQ(surface.pixels, expected);
+    }
+
+    TEST(GdiRasterTest, RandomOperationsMatchReference)
+    {
+        std::mt19937 rng{0x5eed};
+        const auto random = [&](const int low, const int high) {
+            return std::uniform_int_distribution<int>(low, high)(rng); //
+        };
+
+        constexpr std::array<uint8_t, 9> rops{0xCC, 0xF0, 0x00, 0xFF, 0x55, 0x66, 0x88, 0xEE, 0x5A};
+
+        test_surface canvas{67, 41};
+        test_surface other{29, 23};
+
+        for (auto* surface : {&canvas, &other})
+        {
+            for (auto& pixel : surface->pixels)
+            {
+                pixel = rng();
+            }
+        }
+
+        auto expected_canvas = canvas;
+        auto expected_other = other;
+
+        for (int step = 0; step < 2000; ++step)
+        {
+            const auto color = static_cast<uint32_t>(rng());
+            const auto rop3 = random(0, 3) == 0 ? static_cast<uint8_t>(rng()) : rops[static_cast<size_t>(random(0, rops.size() - 1))];
+            const bool self = random(0, 1) == 0;
+
+            auto canvas_view = canvas.view();
+            auto other_view = other.view();
+            auto& source = self ? canvas : other;
+            auto& expected_source = self ? expected_canvas : expected_other;
+            auto* source_view = self ? &canvas_view : &other_view;
+
+            switch (random(0, 3))
+            {
+            case 0: {
+                const auto left = random(-10, 70);
+                const auto top = random(-10, 45);
+                const auto right = left + random(-2, 40);
+                const auto bottom = top + random(-2, 30);
+                gdi_raster::fill_rect(canvas_view, left, top, right, bottom, color);
+                reference_fill(expected_canvas, left, top, right, bottom, color);
+                break;
+            }
+            case 1: {
+                const auto x = random(-10, 70);
+                const auto y = random(-10, 45);
+                const auto sx = random(-10, source.width);
+                const auto sy = random(-10, source.height);
+                const auto w = random(1, 50);
+                const auto h = random(1, 30);
+                gdi_raster::bit_blt(canvas_view, x, y, w, h, source_view, sx, sy, rop3, color);
+                reference_bit_blt(expected_canvas, x, y, w, h, &expected_source, sx, sy, rop3, color);
+                break;
+            }
+            case 2: {
+                const auto x = random(-20, 70);
+                const auto y = random(-20, 45);
+                const auto sx = random(-5, other.width);
+                const auto sy = random(-5, other.height);
+                const auto dw = random(-60, 60) | 1;
+                const auto dh = random(-40, 40) | 1;
+                const auto sw = random(-30, 30) | 1;
+                const auto sh = random(-25, 25) | 1;
+                gdi_raster::stretch_blt(canvas_view, x, y, dw, dh, &other_view, sx, sy, sw, sh, rop3, color);
+                reference_stretch_blt(expected_canvas, x, y, dw, dh, &expected_other, sx, sy, sw, sh, rop3, color);
+                break;
+            }
+            default: {
+                std::vector<uint8_t> rows(static_cast<size_t>(random(1, 12)));
+                for (auto& row : rows)
+                {
+                    row = static_cast<uint8_t>(rng());
+                }
+
+                const auto x = random(-9, 68);
+                const auto y = random(-12, 42);
+                const RECT clip{.left = random(-5, 60), .top = random(-5, 35), .right = random(0, 70), .bottom = random(0, 45)};
+                const auto* clip_rect = random(0, 1) == 0 ? &clip : nullptr;
+
+                gdi_raster::draw_glyph(canvas_view, x, y, rows, color, clip_rect);
+                reference_glyph(expected_canvas, x, y, rows, color, clip_rect);
+                break;
+            }
+            }
+
+            ASSERT_EQ(canvas.pixels, expected_canvas.pixels) << "step " << step;
+        }
+    }
+
+    TEST(GdiRasterTest, PixelFormatConversion)
+    {
+        std::mt19937 rng{0xc0de};
+
+        for (size_t count = 0; count < 70; ++count)
+        {
+            std::vector<uint8_t> bgr(count * 3);
+            std::vector<uint8_t> bgrx(count * 4);
+            for (auto& value : bgr)
+            {
+                value = static_cast<uint8_t>(rng());
+            }
+            for (auto& value : bgrx)
+            {
+                value = static_cast<uint8_t>(rng());
+            }
+
+            std::vector<uint32_t> expected_from_bgr(count);
+            std::vector<uint32_t> expected_from_bgrx(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                expected_from_bgr[i] = bgr[i * 3] | (bgr[i * 3 + 1] << 8) | (bgr[i * 3 + 2] << 16) | gdi_raster::opaque_alpha;
+                expected_from_bgrx[i] = bgrx[i * 4] | (bgrx[i * 4 + 1] << 8) | (bgrx[i * 4 + 2] << 16) | gdi_raster::opaque_alpha;
+            }
+
+            std::vector<uint32_t> pixels(count);
+            gdi_raster::convert_bgr24_to_bgra(bgr.data(), pixels.data(), count);
+            EXPECT_EQ(pixels, expected_from_bgr) << count;
+
+            gdi_raster::convert_bgrx32_to_bgra(bgrx.data(), pixels.data(), count);
+            EXPECT_EQ(pixels, expected_from_bgrx) << count;
+
+            // Back to 24 bits; the byte after the row must stay untouched.
+            std::vector<uint8_t> packed(count * 3 + 1, 0xA5);
+            gdi_raster::convert_bgra_to_bgr24(expected_from_bgr.data(), packed.data(), count);
+            EXPECT_TRUE(std::equal(bgr.begin(), bgr.end(), packed.begin())) << count;
+            EXPECT_EQ(packed.back(), 0xA5) << count;
+        }
+    }
+} // namespace sogen::test
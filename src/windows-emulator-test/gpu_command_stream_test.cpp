@@ -0,0 +1,480 @@
+#include <gtest/gtest.h>
+
+#include <command_stream.hpp>
+#include <devices/gpu_command_replay.hpp>
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Every host command the replay can issue, recorded with the command buffer it targets.
+#define RECORDING_HOST_COMMAND(name)                            \
+    template <typename... Args>                                 \
+    int32_t name(const uint64_t command_buffer, const Args&...) \
+    {                                                           \
+        return this->record(#name, command_buffer);             \
+    }
+
+namespace sogen::test
+{
+    namespace gb = gpu_bridge;
+
+    namespace
+    {
+        constexpr int32_t vk_error_initialization_failed = -3;
+        constexpr int32_t vk_error_device_lost = -4;
+
+        // Stands in for vulkan_host behind the real replay code and records what it was asked to do, in order.
+        struct recording_host
+        {
+            struct call
+            {
+                std::string_view name{};
+                uint64_t object{};
+                uint64_t fence{};
+                std::vector<uint64_t> command_buffers{};
+                std::vector<gb::submit2_semaphore_entry> waits{};
+                std::vector<gb::submit2_semaphore_entry> signals{};
+            };
+
+            std::vector<call> calls{};
+
+            // Results to return for a command on a given object instead of VK_SUCCESS.
+            std::map<std::pair<std::string_view, uint64_t>, int32_t> failures{};
+
+            int32_t record(const std::string_view name, const uint64_t object)
+            {
+                this->calls.push_back({.name = name, .object = object});
+                return this->result_for(name, object);
+            }
+
+            int32_t result_for(const std::string_view name, const uint64_t object) const
+            {
+                const auto failure = this->failures.find({name, object});
+                return failure == this->failures.end() ? 0 : failure->second;
+            }
+
+            int32_t queue_submit(const uint64_t queue, const uint64_t command_buffer, const uint64_t fence)
+            {
+                this->calls.push_back({.name = "queue_submit", .object = queue, .fence = fence, .command_buffers = {command_buffer}});
+                return this->result_for("queue_submit", queue);
+            }
+
+            int32_t queue_submit2(const uint64_t queue, const uint64_t fence, const void* wait_entries, const uint32_t wait_count,
+                                  const void* command_buffer_ids, const uint32_t command_buffer_count, const void* signal_entries,
+                                  const uint32_t signal_count)
+            {
+                const auto* waits = static_cast<const gb::submit2_semaphore_entry*>(wait_entries);
+                const auto* command_buffers = static_cast<const uint64_t*>(command_buffer_ids);
+                const auto* signals = static_cast<const gb::submit2_semaphore_entry*>(signal_entries);
+
+                this->calls.push_back({
+                    .name = "queue_submit2",
+                    .object = queue,
+                    .fence = fence,
+                    .command_buffers = {command_buffers, command_buffers + command_buffer_count},
+                    .waits = {waits, waits + wait_count},
+                    .signals = {signals, signals + signal_count},
+                });
+                return this->result_for("queue_submit2", queue);
+            }
+
+            RECORDING_HOST_COMMAND(begin_command_buffer)
+            RECORDING_HOST_COMMAND(end_command_buffer)
+            RECORDING_HOST_COMMAND(cmd_begin_query)
+            RECORDING_HOST_COMMAND(cmd_begin_query_indexed)
+            RECORDING_HOST_COMMAND(cmd_begin_render_pass)
+            RECORDING_HOST_COMMAND(cmd_begin_rendering)
+            RECORDING_HOST_COMMAND(cmd_begin_transform_feedback)
+            RECORDING_HOST_COMMAND(cmd_bind_descriptor_sets)
+            RECORDING_HOST_COMMAND(cmd_bind_index_buffer)
+            RECORDING_HOST_COMMAND(cmd_bind_pipeline)
+            RECORDING_HOST_COMMAND(cmd_bind_transform_feedback_buffers)
+            RECORDING_HOST_COMMAND(cmd_bind_vertex_buffers)
+            RECORDING_HOST_COMMAND(cmd_bind_vertex_buffers2)
+            RECORDING_HOST_COMMAND(cmd_blit_image)
+            RECORDING_HOST_COMMAND(cmd_clear_attachments)
+            RECORDING_HOST_COMMAND(cmd_clear_color_image)
+            RECORDING_HOST_COMMAND(cmd_clear_depth_stencil_image)
+            RECORDING_HOST_COMMAND(cmd_copy_buffer)
+            RECORDING_HOST_COMMAND(cmd_copy_buffer_to_image)
+            RECORDING_HOST_COMMAND(cmd_copy_image)
+            RECORDING_HOST_COMMAND(cmd_copy_image_to_buffer)
+            RECORDING_HOST_COMMAND(cmd_copy_query_pool_results)
+            RECORDING_HOST_COMMAND(cmd_dispatch)
+            RECORDING_HOST_COMMAND(cmd_dispatch_indirect)
+            RECORDING_HOST_COMMAND(cmd_draw)
+            RECORDING_HOST_COMMAND(cmd_draw_indexed)
+            RECORDING_HOST_COMMAND(cmd_draw_indexed_indirect)
+            RECORDING_HOST_COMMAND(cmd_draw_indexed_indirect_count)
+            RECORDING_HOST_COMMAND(cmd_draw_indirect)
+            RECORDING_HOST_COMMAND(cmd_draw_indirect_byte_count)
+            RECORDING_HOST_COMMAND(cmd_draw_indirect_count)
+            RECORDING_HOST_COMMAND(cmd_end_query)
+            RECORDING_HOST_COMMAND(cmd_end_query_indexed)
+            RECORDING_HOST_COMMAND(cmd_end_render_pass)
+            RECORDING_HOST_COMMAND(cmd_end_rendering)
+            RECORDING_HOST_COMMAND(cmd_end_transform_feedback)
+            RECORDING_HOST_COMMAND(cmd_execute_commands)
+            RECORDING_HOST_COMMAND(cmd_fill_buffer)
+            RECORDING_HOST_COMMAND(cmd_next_subpass)
+            RECORDING_HOST_COMMAND(cmd_pipeline_barrier)
+            RECORDING_HOST_COMMAND(cmd_push_constants)
+            RECORDING_HOST_COMMAND(cmd_reset_query_pool)
+            RECORDING_HOST_COMMAND(cmd_resolve_image)
+            RECORDING_HOST_COMMAND(cmd_set_blend_constants)
+            RECORDING_HOST_COMMAND(cmd_set_depth_bias)
+            RECORDING_HOST_COMMAND(cmd_set_depth_bounds)
+            RECORDING_HOST_COMMAND(cmd_set_dynamic_u32)
+            RECORDING_HOST_COMMAND(cmd_set_line_width)
+            RECORDING_HOST_COMMAND(cmd_set_scissor)
+            RECORDING_HOST_COMMAND(cmd_set_stencil)
+            RECORDING_HOST_COMMAND(cmd_set_stencil_op)
+            RECORDING_HOST_COMMAND(cmd_set_viewport)
+            RECORDING_HOST_COMMAND(cmd_update_buffer)
+            RECORDING_HOST_COMMAND(cmd_write_timestamp)
+            RECORDING_HOST_COMMAND(cmd_write_timestamp2)
+        };
+
+        // Both ends of the bridge: the guest's command_batcher sends each stream, which replay_command_stream
+        // replays into the recording host just like handle_record_commands does for an ioctl_record_commands.
+        struct test_bridge
+        {
+            recording_host host{};
+            size_t ioctls{};
+            size_t submits{};
+            std::vector<uint32_t> unsupported{};
+            gpu_command_replay_hooks hooks{};
+            gb::command_batcher batcher;
+
+            test_bridge()
+                : batcher([this](const std::span<const uint8_t> stream) { return this->replay(stream); })
+            {
+                this->hooks.before_submit = [this] {
+                    ++this->submits; //
+                };
+                this->hooks.unsupported_command = [this](const uint32_t command) {
+                    this->unsupported.push_back(command); //
+                };
+            }
+
+            test_bridge(const test_bridge&) = delete;
+            test_bridge& operator=(const test_bridge&) = delete;
+
+            int32_t replay(const std::span<const uint8_t> stream)
+            {
+                ++this->ioctls;
+                return replay_command_stream(this->host, this->hooks, std::as_bytes(stream));
+            }
+        };
+
+        std::vector<uint8_t> record_command_buffer(const gb::object_id command_buffer, const uint32_t draws)
+        {
+            std::vector<uint8_t> stream{};
+
+            gb::begin_command_buffer_request begin{};
+            begin.command_buffer = command_buffer;
+            gb::append_command_record(stream, gb::command::begin_command_buffer, &begin, sizeof(begin));
+
+            for (uint32_t i = 0; i < draws; ++i)
+            {
+                const gb::cmd_draw_request draw{
+                    .command_buffer = command_buffer, .vertex_count = 3, .instance_count = 1, .first_vertex = 0, .first_instance = 0};
+                gb::append_command_record(stream, gb::command::cmd_draw, &draw, sizeof(draw));
+            }
+
+            const gb::end_command_buffer_request end{.command_buffer = command_buffer};
+            gb::append_command_record(stream, gb::command::end_command_buffer, &end, sizeof(end));
+
+            return stream;
+        }
+
+        gb::queue_submit_request submit_request(const gb::object_id queue, const gb::object_id command_buffer,
+                                                const gb::object_id fence = gb::null_object)
+        {
+            return {.queue = queue, .command_buffer = command_buffer, .fence = fence};
+        }
+
+        std::vector<std::string_view> call_names(const recording_host& host)
+        {
+            std::vector<std::string_view> names{};
+            names.reserve(host.calls.size());
+            for (const auto& call : host.calls)
+            {
+                names.push_back(call.name);
+            }
+
+            return names;
+        }
+    }
+
+    TEST(GpuCommandStreamTest, FrameReplaysInIssueOrderWithOneIoctlPerSubmit)
+    {
+        constexpr gb::object_id queue = 0x10;
+        constexpr gb::object_id fence = 0x20;
+        constexpr std::array<gb::object_id, 3> command_buffers{0x31, 0x32, 0x33};
+        constexpr uint32_t draws = 200;
+        constexpr size_t frames = 4;
+
+        test_bridge bridge{};
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            for (const auto command_buffer : command_buffers)
+            {
+                bridge.batcher.add_recording(record_command_buffer(command_buffer, draws));
+            }
+
+            for (size_t i = 0; i < command_buffers.size(); ++i)
+            {
+                const bool last = i + 1 == command_buffers.size();
+                bridge.batcher.add_submit(submit_request(queue, command_buffers[i], last ? fence : gb::null_object));
+            }
+
+            EXPECT_EQ(bridge.ioctls, frame);
+            EXPECT_EQ(bridge.batcher.submit(), 0);
+            EXPECT_EQ(bridge.ioctls, frame + 1);
+        }
+
+        EXPECT_TRUE(bridge.batcher.empty());
+        EXPECT_EQ(bridge.submits, command_buffers.size() * frames);
+
+        const auto& calls = bridge.host.calls;
+        const size_t calls_per_frame = command_buffers.size() * (draws + 2) + command_buffers.size();
+        ASSERT_EQ(calls.size(), calls_per_frame * frames);
+
+        // Recordings replay in issue order, followed by their submissions with the fence on the last one.
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            const auto* call = calls.data() + frame * calls_per_frame;
+            for (const auto command_buffer : command_buffers)
+            {
+                EXPECT_EQ(call->name, "begin_command_buffer");
+                EXPECT_EQ(call->object, command_buffer);
+                ++call;
+
+                for (uint32_t draw = 0; draw < draws; ++draw, ++call)
+                {
+                    EXPECT_EQ(call->name, "cmd_draw");
+                    EXPECT_EQ(call->object, command_buffer);
+                }
+
+                EXPECT_EQ(call->name, "end_command_buffer");
+                EXPECT_EQ(call->object, command_buffer);
+                ++call;
+            }
+
+            for (size_t i = 0; i < command_buffers.size(); ++i, ++call)
+            {
+                EXPECT_EQ(call->name, "queue_submit");
+                EXPECT_EQ(call->object, queue);
+                EXPECT_EQ(call->command_buffers, std::vector<uint64_t>{command_buffers[i]});
+                EXPECT_EQ(call->fence, i + 1 == command_buffers.size() ? fence : gb::null_object);
+            }
+        }
+    }
+
+    TEST(GpuCommandStreamTest, FlushSendsPendingRecordingsAheadOfOtherCalls)
+    {
+        test_bridge bridge{};
+        bridge.batcher.add_recording(record_command_buffer(0x41, 1));
+        bridge.batcher.add_recording(record_command_buffer(0x42, 0));
+        EXPECT_EQ(bridge.ioctls, 0u);
+
+        // What the shim does before any other bridge call, e.g. vkQueuePresentKHR.
+        bridge.batcher.flush();
+        EXPECT_EQ(bridge.ioctls, 1u);
+        EXPECT_TRUE(bridge.batcher.empty());
+        EXPECT_EQ(call_names(bridge.host), (std::vector<std::string_view>{"begin_command_buffer", "cmd_draw", "end_command_buffer",
+                                                                           "begin_command_buffer", "end_command_buffer"}));
+
+        // Nothing pending: no empty IOCTL.
+        bridge.batcher.flush();
+        EXPECT_EQ(bridge.ioctls, 1u);
+
+        // A later submit of the already-flushed recording carries only the submission.
+        bridge.batcher.add_submit(submit_request(0x10, 0x41));
+        EXPECT_EQ(bridge.batcher.submit(), 0);
+        EXPECT_EQ(bridge.ioctls, 2u);
+        ASSERT_EQ(bridge.host.calls.size(), 6u);
+        EXPECT_EQ(bridge.host.calls.back().name, "queue_submit");
+        EXPECT_EQ(bridge.host.calls.back().command_buffers, std::vector<uint64_t>{0x41});
+    }
+
+    TEST(GpuCommandStreamTest, Submit2ReplaysItsTrailingArrays)
+    {
+        const std::array<gb::submit2_semaphore_entry, 2> waits{gb::submit2_semaphore_entry{.semaphore = 1, .value = 5, .stage_mask = 0x8},
+                                                               gb::submit2_semaphore_entry{.semaphore = 2, .value = 6, .stage_mask = 0x10}};
+        const std::array<gb::object_id, 2> command_buffers{0x51, 0x52};
+        const std::array<gb::submit2_semaphore_entry, 1> signals{
+            gb::submit2_semaphore_entry{.semaphore = 3, .value = 7, .stage_mask = 0x20}};
+
+        test_bridge bridge{};
+        bridge.batcher.add_recording(record_command_buffer(0x51, 0));
+        bridge.batcher.add_recording(record_command_buffer(0x52, 0));
+        bridge.batcher.add_submit2({.queue = 0x10,
+                                    .fence = 0x20,
+                                    .wait_count = static_cast<uint32_t>(waits.size()),
+                                    .command_buffer_count = static_cast<uint32_t>(command_buffers.size()),
+                                    .signal_count = static_cast<uint32_t>(signals.size()),
+                                    .reserved = 0},
+                                   waits, command_buffers, signals);
+
+        EXPECT_EQ(bridge.batcher.submit(), 0);
+        EXPECT_EQ(bridge.ioctls, 1u);
+        EXPECT_EQ(bridge.submits, 1u);
+
+        ASSERT_EQ(bridge.host.calls.size(), 5u);
+        const auto& submit = bridge.host.calls.back();
+        EXPECT_EQ(submit.name, "queue_submit2");
+        EXPECT_EQ(submit.object, 0x10u);
+        EXPECT_EQ(submit.fence, 0x20u);
+        EXPECT_EQ(submit.command_buffers, std::vector<uint64_t>(command_buffers.begin(), command_buffers.end()));
+
+        ASSERT_EQ(submit.waits.size(), waits.size());
+        for (size_t i = 0; i < waits.size(); ++i)
+        {
+            EXPECT_EQ(submit.waits[i].semaphore, waits[i].semaphore);
+            EXPECT_EQ(submit.waits[i].value, waits[i].value);
+            EXPECT_EQ(submit.waits[i].stage_mask, waits[i].stage_mask);
+        }
+
+        ASSERT_EQ(submit.signals.size(), 1u);
+        EXPECT_EQ(submit.signals[0].semaphore, 3u);
+        EXPECT_EQ(submit.signals[0].value, 7u);
+    }
+
+    TEST(GpuCommandStreamTest, Submit2WithArraysPastItsRecordIsRejected)
+    {
+        // Claims four command buffers but carries one.
+        const gb::queue_submit2_request request{
+            .queue = 0x10, .fence = 0x20, .wait_count = 0, .command_buffer_count = 4, .signal_count = 0, .reserved = 0};
+        const gb::object_id command_buffer = 0x61;
+
+        std::vector<uint8_t> payload(sizeof(request) + sizeof(command_buffer));
+        std::memcpy(payload.data(), &request, sizeof(request));
+        std::memcpy(payload.data() + sizeof(request), &command_buffer, sizeof(command_buffer));
+
+        std::vector<uint8_t> stream{};
+        gb::append_command_record(stream, gb::command::queue_submit2, payload.data(), payload.size());
+
+        // The records behind it still replay.
+        const gb::end_command_buffer_request end{.command_buffer = 0x62};
+        gb::append_command_record(stream, gb::command::end_command_buffer, &end, sizeof(end));
+
+        test_bridge bridge{};
+        EXPECT_EQ(bridge.replay(stream), vk_error_initialization_failed);
+        EXPECT_EQ(bridge.submits, 0u);
+        EXPECT_EQ(call_names(bridge.host), std::vector<std::string_view>{"end_command_buffer"});
+    }
+
+    TEST(GpuCommandStreamTest, FailureOfAnEarlierBatchIsReportedAtTheNextSubmit)
+    {
+        test_bridge bridge{};
+        bridge.host.failures[{"end_command_buffer", 0x71}] = vk_error_device_lost;
+        bridge.host.failures[{"cmd_draw", 0x72}] = vk_error_initialization_failed;
+
+        bridge.batcher.add_recording(record_command_buffer(0x71, 1));
+        bridge.batcher.flush();
+        bridge.batcher.add_recording(record_command_buffer(0x72, 1));
+        bridge.batcher.flush();
+        EXPECT_EQ(bridge.ioctls, 2u);
+
+        // Both batches replayed in full; the submit reports the first failure and clears it.
+        bridge.batcher.add_submit(submit_request(0x10, 0x71));
+        EXPECT_EQ(bridge.batcher.submit(), vk_error_device_lost);
+        EXPECT_EQ(bridge.host.calls.size(), 7u);
+
+        bridge.batcher.add_submit(submit_request(0x10, 0x72));
+        EXPECT_EQ(bridge.batcher.submit(), 0);
+
+        // A failure inside the submit's own batch is reported by that submit.
+        bridge.host.failures[{"queue_submit", 0x10}] = vk_error_device_lost;
+        bridge.batcher.add_submit(submit_request(0x10, 0x72));
+        EXPECT_EQ(bridge.batcher.submit(), vk_error_device_lost);
+    }
+
+    TEST(GpuCommandStreamTest, OversizedBatchIsSentBeforeTheSubmit)
+    {
+        // Recordings of 64 KiB updates, 1 MiB each.
+        constexpr size_t update_bytes = 64 * 1024;
+        constexpr size_t updates_per_recording = 16;
+
+        const auto record_updates = [&](const gb::object_id command_buffer) {
+            std::vector<uint8_t> stream = record_command_buffer(command_buffer, 0);
+            stream.resize(stream.size() - sizeof(gb::command_record_header) - sizeof(gb::end_command_buffer_request));
+
+            std::vector<uint8_t> payload(sizeof(gb::cmd_update_buffer_request) + update_bytes);
+            const gb::cmd_update_buffer_request update{
+                .command_buffer = command_buffer, .buffer = 0x90, .offset = 0, .size = update_bytes, .reserved = 0};
+            std::memcpy(payload.data(), &update, sizeof(update));
+
+            for (size_t i = 0; i < updates_per_recording; ++i)
+            {
+                gb::append_command_record(stream, gb::command::cmd_update_buffer, payload.data(), payload.size());
+            }
+
+            const gb::end_command_buffer_request end{.command_buffer = command_buffer};
+            gb::append_command_record(stream, gb::command::end_command_buffer, &end, sizeof(end));
+            return stream;
+        };
+
+        test_bridge bridge{};
+        size_t pending = 0;
+        gb::object_id command_buffer = 0x100;
+
+        while (true)
+        {
+            const auto recording = record_updates(++command_buffer);
+            pending += recording.size();
+            bridge.batcher.add_recording(recording);
+
+            if (pending > gb::max_command_batch_bytes)
+            {
+                break;
+            }
+
+            EXPECT_EQ(bridge.ioctls, 0u);
+        }
+
+        // The recording that crossed the limit went out with the rest, ahead of any submit.
+        EXPECT_EQ(bridge.ioctls, 1u);
+        EXPECT_TRUE(bridge.batcher.empty());
+        EXPECT_EQ(bridge.host.calls.size(), (command_buffer - 0x100) * (updates_per_recording + 2));
+        EXPECT_EQ(bridge.host.calls.back().name, "end_command_buffer");
+        EXPECT_EQ(bridge.host.calls.back().object, command_buffer);
+
+        bridge.batcher.add_submit(submit_request(0x10, command_buffer));
+        EXPECT_EQ(bridge.batcher.submit(), 0);
+        EXPECT_EQ(bridge.ioctls, 2u);
+        EXPECT_EQ(bridge.host.calls.back().name, "queue_submit");
+    }
+
+    TEST(GpuCommandStreamTest, UnsupportedCommandFailsWithoutStoppingTheReplay)
+    {
+        constexpr uint32_t unknown_command = 0xFFFF;
+        const uint64_t payload = 0x81;
+
+        std::vector<uint8_t> stream{};
+        gb::append_command_record(stream, static_cast<gb::command>(unknown_command), &payload, sizeof(payload));
+        const auto recording = record_command_buffer(0x81, 1);
+        stream.insert(stream.end(), recording.begin(), recording.end());
+
+        test_bridge bridge{};
+        EXPECT_EQ(bridge.replay(stream), vk_error_initialization_failed);
+        EXPECT_EQ(bridge.unsupported, std::vector<uint32_t>{unknown_command});
+        EXPECT_EQ(call_names(bridge.host), (std::vector<std::string_view>{"begin_command_buffer", "cmd_draw", "end_command_buffer"}));
+    }
+
+    TEST(GpuCommandStreamTest, TruncatedRecordIsDropped)
+    {
+        auto stream = record_command_buffer(0x61, 2);
+        stream.resize(stream.size() - 1);
+
+        test_bridge bridge{};
+        EXPECT_EQ(bridge.replay(stream), 0);
+        EXPECT_EQ(call_names(bridge.host), (std::vector<std::string_view>{"begin_command_buffer", "cmd_draw", "cmd_draw"}));
+    }
+}
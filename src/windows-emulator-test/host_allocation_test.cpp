@@ -185,7 +185,7 @@ namespace sogen::test
         ASSERT_TRUE(mm.host_window_is_free(host_base, size));
     }
 
-    // allocate_mmio may claim an address inside a recorded host_reserved range (the KUSD MMIO page lives
+    // allocate_mmio may claim an address inside a recorded host_reserved range (the KUSD page falls back to MMIO
     // inside the __PAGEZERO carve-out on FEX/Apple). If the entries nested, a query above the small MMIO
     // entry would see only that entry as its predecessor and miss the larger host_reserved range still
     // covering the queried address, so the coverage must be split around the hole instead.
@@ -0,0 +1,184 @@
+#include "emulation_test_utils.hpp"
+
+#include <analysis.hpp>
+
+#include <array>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr uint64_t page_size = 0x1000;
+        constexpr uint64_t writer_offset = 0x100;
+
+        constexpr uint8_t nop = 0x90;
+        constexpr uint8_t cdq = 0x99;
+        constexpr uint8_t cwde = 0x98;
+        constexpr uint8_t hlt = 0xF4;
+
+        // mov byte ptr [code], cdq; hlt -- placed at code + writer_offset, so the target is rip-relative.
+        std::array<uint8_t, 8> make_writer()
+        {
+            constexpr auto displacement = -static_cast<int32_t>(writer_offset + 7);
+            const auto disp = static_cast<uint32_t>(displacement);
+
+            return {
+                0xC6,
+                0x05,
+                static_cast<uint8_t>(disp),
+                static_cast<uint8_t>(disp >> 8),
+                static_cast<uint8_t>(disp >> 16),
+                static_cast<uint8_t>(disp >> 24),
+                cdq,
+                hlt,
+            };
+        }
+
+        void run_one_instruction(x86_64_emulator& cpu, const uint64_t address)
+        {
+            cpu.reg(x86_register::rip, address);
+            cpu.start(1);
+        }
+
+        uint64_t get_count(const analysis_context& c, const uint32_t instruction_id)
+        {
+            const auto counts = c.code_cache.get_instruction_counts();
+            const auto entry = counts.find(instruction_id);
+            return entry == counts.end() ? 0 : entry->second;
+        }
+
+        struct loop_counts
+        {
+            std::unordered_map<uint32_t, uint64_t> counts{};
+            uint32_t inc_id{};
+            uint32_t hlt_id{};
+        };
+
+        // Runs a counting loop outside of any module up to its final nop and returns the instruction summary.
+        loop_counts count_loop_instructions(const bool trace_every_instruction)
+        {
+            // mov ecx, 100; loop: inc eax; dec ecx; jnz loop; nop; hlt
+            constexpr std::array<uint8_t, 13> loop = {0xB9, 0x64, 0x00, 0x00, 0x00, 0xFF, 0xC0, 0xFF, 0xC9, 0x75, 0xFA, nop, hlt};
+            constexpr uint64_t inc_offset = 5;
+            constexpr uint64_t hlt_offset = loop.size() - 1;
+            constexpr size_t executed_instructions = 1 + 3 * 100 + 1;
+
+            auto emu = create_sample_emulator();
+            emu.start(100);
+
+            analysis_settings settings{};
+            settings.instruction_summary = true;
+            settings.silent = true;
+            settings.trace_every_instruction = trace_every_instruction;
+
+            analysis_context c{};
+            c.settings = &settings;
+            c.win_emu = &emu;
+            register_analysis_callbacks(c);
+
+            auto& cpu = emu.emu();
+            const auto code = emu.memory.allocate_memory(page_size, memory_permission::read | memory_permission::exec);
+            cpu.write_memory(code, loop.data(), loop.size());
+
+            cpu.reg(x86_register::rip, code);
+            cpu.start(executed_instructions);
+
+            const auto* inc = c.code_cache.get_instruction(cpu, code + inc_offset);
+            const auto* halt = c.code_cache.get_instruction(cpu, code + hlt_offset);
+
+            return {
+                .counts = c.code_cache.get_instruction_counts(),
+                .inc_id = inc ? inc->id : 0,
+                .hlt_id = halt ? halt->id : 0,
+            };
+        }
+    }
+
+    // Code on a page that is writable and executable at once can change under the analyzer without any
+    // protection change. Both the decoded instruction and the per-block counts must follow the new bytes, after
+    // a guest write as well as after the page is reprotected.
+    TEST(InstructionCacheTest, SelfModifyingCodeIsDecodedAgain)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        analysis_settings settings{};
+        settings.instruction_summary = true;
+        settings.silent = true;
+
+        analysis_context c{};
+        c.settings = &settings;
+        c.win_emu = &emu;
+        register_analysis_callbacks(c);
+
+        auto& cpu = emu.emu();
+        const auto code = emu.memory.allocate_memory(page_size, memory_permission::all);
+        ASSERT_NE(code, 0u);
+        emu.callbacks.on_memory_allocate(code, page_size, memory_permission::all, true);
+
+        const std::array<uint8_t, 2> target = {nop, hlt};
+        const auto writer = make_writer();
+        cpu.write_memory(code, target.data(), target.size());
+        cpu.write_memory(code + writer_offset, writer.data(), writer.size());
+
+        const auto* instruction = c.code_cache.get_instruction(cpu, code);
+        ASSERT_NE(instruction, nullptr);
+        EXPECT_EQ(instruction->text, "nop");
+        const auto nop_id = instruction->id;
+
+        run_one_instruction(cpu, code);
+        EXPECT_EQ(get_count(c, nop_id), 1u);
+
+        // The guest rewrites the nop in place.
+        run_one_instruction(cpu, code + writer_offset);
+        ASSERT_EQ(cpu.read_memory<uint8_t>(code), cdq);
+
+        instruction = c.code_cache.get_instruction(cpu, code);
+        ASSERT_NE(instruction, nullptr);
+        EXPECT_EQ(instruction->text, "cdq");
+        const auto cdq_id = instruction->id;
+        EXPECT_NE(cdq_id, nop_id);
+
+        run_one_instruction(cpu, code);
+        EXPECT_EQ(get_count(c, nop_id), 1u);
+        EXPECT_EQ(get_count(c, cdq_id), 1u);
+
+        // Host writes are not seen by the write hooks; the reprotect alone has to drop the stale decode.
+        cpu.write_memory(code, &cwde, sizeof(cwde));
+        const auto read_exec = memory_permission::read | memory_permission::exec;
+        ASSERT_TRUE(emu.memory.protect_memory(code, page_size, read_exec));
+        emu.callbacks.on_memory_protect(code, page_size, read_exec);
+
+        instruction = c.code_cache.get_instruction(cpu, code);
+        ASSERT_NE(instruction, nullptr);
+        EXPECT_EQ(instruction->text, "cwde");
+        const auto cwde_id = instruction->id;
+
+        run_one_instruction(cpu, code);
+        EXPECT_EQ(get_count(c, nop_id), 1u);
+        EXPECT_EQ(get_count(c, cdq_id), 1u);
+        EXPECT_EQ(get_count(c, cwde_id), 1u);
+    }
+
+    // Block tracing counts a block in full when it is entered, the instruction path one instruction at a time.
+    // For code that runs to a block boundary both must agree; here only the final block's hlt is entered but
+    // never executed.
+    TEST(InstructionCacheTest, BlockAndInstructionTracingCountTheSame)
+    {
+        const auto per_instruction = count_loop_instructions(true);
+        auto per_block = count_loop_instructions(false);
+
+        ASSERT_NE(per_instruction.inc_id, 0u);
+        EXPECT_EQ(per_instruction.counts.at(per_instruction.inc_id), 100u);
+        EXPECT_FALSE(per_instruction.counts.contains(per_instruction.hlt_id));
+
+        if (per_block.counts.contains(per_block.hlt_id))
+        {
+            EXPECT_EQ(per_block.counts.at(per_block.hlt_id), 1u);
+            per_block.counts.erase(per_block.hlt_id);
+        }
+
+        EXPECT_EQ(per_block.counts, per_instruction.counts);
+    }
+}
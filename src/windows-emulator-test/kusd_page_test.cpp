@@ -0,0 +1,221 @@
+#include "emulation_test_utils.hpp"
+
+namespace sogen::test
+{
+    namespace
+    {
+        // Advances only when the test says so, one tick per millisecond.
+        struct manual_clock : utils::tick_clock
+        {
+            uint64_t now_ms{};
+
+            manual_clock()
+                : tick_clock(1000)
+            {
+            }
+
+            uint64_t ticks() override
+            {
+                return this->now_ms;
+            }
+        };
+
+        struct kusd_times
+        {
+            uint64_t interrupt_time{};
+            uint64_t tick_count{};
+        };
+
+        // Reads the time fields the way the guest sees them, from the page rather than from kusd_page.
+        kusd_times read_kusd_times(const windows_emulator& emu)
+        {
+            const auto read_quad = [&](const size_t offset) {
+                return emu.memory.read_memory<uint64_t>(kusd_page::address() + offset + offsetof(KSYSTEM_TIME, LowPart));
+            };
+
+            return {
+                .interrupt_time = read_quad(offsetof(KUSER_SHARED_DATA64, InterruptTime)),
+                .tick_count = read_quad(offsetof(KUSER_SHARED_DATA64, TickCount)),
+            };
+        }
+
+        bool is_kusd_kind(const memory_region_kind kind)
+        {
+            // Backends that can not map 0x7ffe0000 fall back to MMIO, which the guest can not free either.
+            return kind == memory_region_kind::shared_user_data || kind == memory_region_kind::mmio;
+        }
+
+        // Runs a syscall as the guest would issue it, with the pointer arguments in a scratch page, and returns
+        // its status. The fifth argument goes on a stack inside the same page.
+        class guest_syscalls
+        {
+          public:
+            explicit guest_syscalls(windows_emulator& emu)
+                : emu_(&emu),
+                  scratch_(emu.memory.allocate_memory(0x1000, nt_memory_permission{memory_permission::read_write}))
+            {
+            }
+
+            uint64_t pointer_to(const size_t slot, const uint64_t value) const
+            {
+                const auto address = this->scratch_ + slot * sizeof(uint64_t);
+                this->emu_->memory.write_memory(address, &value, sizeof(value));
+                return address;
+            }
+
+            NTSTATUS call(const std::string_view name, const std::array<uint64_t, 5>& args) const
+            {
+                const auto syscall_id = this->emu_->dispatcher.find_syscall_id(name);
+                if (!syscall_id)
+                {
+                    ADD_FAILURE() << "unknown syscall " << name;
+                    return STATUS_NOT_SUPPORTED;
+                }
+
+                const auto stack = this->scratch_ + 0x800;
+                this->emu_->memory.write_memory(stack + 5 * sizeof(uint64_t), &args[4], sizeof(args[4]));
+
+                auto& vcpu = this->emu_->vcpu(0);
+                NTSTATUS status{};
+
+                this->emu_->dispatch_on_cpu(vcpu.cpu, [&] {
+                    auto& cpu = vcpu.cpu;
+                    const auto saved_rsp = cpu.reg(x86_register::rsp);
+
+                    cpu.reg<uint64_t>(x86_register::rsp, stack);
+                    cpu.reg<uint64_t>(x86_register::r10, args[0]);
+                    cpu.reg<uint64_t>(x86_register::rdx, args[1]);
+                    cpu.reg<uint64_t>(x86_register::r8, args[2]);
+                    cpu.reg<uint64_t>(x86_register::r9, args[3]);
+                    cpu.reg<uint64_t>(x86_register::rax, *syscall_id);
+
+                    this->emu_->dispatcher.dispatch(*this->emu_, vcpu);
+
+                    status = static_cast<NTSTATUS>(cpu.reg<uint64_t>(x86_register::rax));
+                    cpu.reg<uint64_t>(x86_register::rsp, saved_rsp);
+                });
+
+                return status;
+            }
+
+          private:
+            windows_emulator* emu_{};
+            uint64_t scratch_{};
+        };
+
+        windows_emulator create_kusd_emulator(manual_clock*& clock)
+        {
+            auto owned_clock = std::make_unique<manual_clock>();
+            clock = owned_clock.get();
+
+            emulator_interfaces interfaces{};
+            interfaces.clock = std::move(owned_clock);
+
+            return create_sample_emulator({}, {}, {}, std::move(interfaces));
+        }
+    }
+
+    TEST(KusdPageTest, GuestCanNotFreeOrReprotectThePage)
+    {
+        manual_clock* clock{};
+        auto emu = create_kusd_emulator(clock);
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        const auto address = kusd_page::address();
+        const auto kind = emu.memory.get_region_kind(address);
+        ASSERT_TRUE(is_kusd_kind(kind));
+
+        const guest_syscalls guest{emu};
+        const auto process = CURRENT_PROCESS.bits;
+
+        EXPECT_EQ(guest.call("NtFreeVirtualMemory", {process, guest.pointer_to(0, address), guest.pointer_to(1, 0), MEM_RELEASE, 0}),
+                  STATUS_INVALID_PARAMETER);
+        EXPECT_EQ(
+            guest.call("NtFreeVirtualMemory", {process, guest.pointer_to(0, address), guest.pointer_to(1, 0x1000), MEM_DECOMMIT, 0}),
+            STATUS_INVALID_PARAMETER);
+        EXPECT_EQ(guest.call("NtProtectVirtualMemory",
+                             {process, guest.pointer_to(0, address), guest.pointer_to(1, 0x1000), PAGE_READWRITE, guest.pointer_to(2, 0)}),
+                  STATUS_INVALID_PAGE_PROTECTION);
+
+        const auto region = emu.memory.get_region_info(address);
+        EXPECT_EQ(region.kind, kind);
+        EXPECT_TRUE(region.is_committed);
+        EXPECT_EQ(region.permissions, nt_memory_permission{memory_permission::read});
+
+        // The next quantum still publishes into the page.
+        clock->now_ms += 20;
+        EXPECT_NO_THROW(emu.process.kusd.refresh());
+    }
+
+    TEST(KusdPageTest, RefreshAdvancesTheTimeFields)
+    {
+        manual_clock* clock{};
+        auto emu = create_kusd_emulator(clock);
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        emu.process.kusd.refresh();
+        const auto before = read_kusd_times(emu);
+
+        clock->now_ms += 1000;
+
+        // The page only changes at refresh; the MMIO fallback recomputes on every read instead.
+        if (emu.memory.get_region_kind(kusd_page::address()) == memory_region_kind::shared_user_data)
+        {
+            const auto stale = read_kusd_times(emu);
+            EXPECT_EQ(stale.interrupt_time, before.interrupt_time);
+            EXPECT_EQ(stale.tick_count, before.tick_count);
+        }
+
+        emu.process.kusd.refresh();
+        const auto after = read_kusd_times(emu);
+
+        EXPECT_GT(after.interrupt_time, before.interrupt_time);
+        EXPECT_GT(after.tick_count, before.tick_count);
+
+        // The clock starts at zero: InterruptTime counts 100 ns units, TickCountQuad milliseconds scaled by
+        // TickCountMultiplier.
+        const auto multiplier = emu.process.kusd.access([](const KUSER_SHARED_DATA64& kusd) {
+            return kusd.TickCountMultiplier; //
+        });
+        EXPECT_EQ(after.interrupt_time, clock->now_ms * 10'000);
+        EXPECT_EQ(after.tick_count, (clock->now_ms << 24) / multiplier);
+    }
+
+    TEST(KusdPageTest, PageComesBackAfterSnapshotRestore)
+    {
+        manual_clock* clock{};
+        auto emu = create_kusd_emulator(clock);
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        const auto address = kusd_page::address();
+        const auto kind = emu.memory.get_region_kind(address);
+        ASSERT_TRUE(is_kusd_kind(kind));
+
+        emu.save_snapshot();
+
+        // Drop the page behind the emulator's back; the restore must bring it back as the same region.
+        if (kind == memory_region_kind::shared_user_data)
+        {
+            ASSERT_TRUE(emu.memory.release_memory(address, 0x1000));
+            ASSERT_EQ(emu.memory.get_region_kind(address), memory_region_kind::free);
+        }
+
+        emu.restore_snapshot();
+        EXPECT_EQ(emu.memory.get_region_kind(address), kind);
+
+        const guest_syscalls guest{emu};
+        EXPECT_EQ(guest.call("NtFreeVirtualMemory",
+                             {CURRENT_PROCESS.bits, guest.pointer_to(0, address), guest.pointer_to(1, 0), MEM_RELEASE, 0}),
+                  STATUS_INVALID_PARAMETER);
+
+        emu.process.kusd.refresh();
+        const auto before = read_kusd_times(emu);
+
+        clock->now_ms += 50;
+        emu.process.kusd.refresh();
+        EXPECT_EQ(read_kusd_times(emu).interrupt_time - before.interrupt_time, 500'000u);
+    }
+}
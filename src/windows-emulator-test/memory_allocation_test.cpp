@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <memory_manager.hpp>
+#include <address_utils.hpp>
+
+#include <random>
+#include <vector>
+
+namespace sogen::test
+{
+    namespace
+    {
+        // Guest memory that is never accessed; only memory_manager's bookkeeping is under test.
+        class null_memory : public memory_interface
+        {
+          public:
+            void read_memory(uint64_t, void*, size_t) const override
+            {
+            }
+
+            bool try_read_memory(uint64_t, void*, size_t) const override
+            {
+                return true;
+            }
+
+            void write_memory(uint64_t, const void*, size_t) override
+            {
+            }
+
+            bool try_write_memory(uint64_t, const void*, size_t) override
+            {
+                return true;
+            }
+
+          private:
+            void map_mmio(uint64_t, size_t, mmio_read_callback, mmio_write_callback) override
+            {
+            }
+
+            void map_memory(uint64_t, size_t, memory_permission) override
+            {
+            }
+
+            void unmap_memory(uint64_t, size_t) override
+            {
+            }
+
+            void apply_memory_protection(uint64_t, size_t, memory_permission) override
+            {
+            }
+        };
+
+        // The straightforward search over all reservations that the gap index replaces.
+        uint64_t find_free_base_by_scan(const memory_manager& mm, const size_t size, const uint64_t start, const uint64_t alignment,
+                                        const uint64_t highest_address)
+        {
+            auto address = align_up(std::max<uint64_t>(start, MIN_ALLOCATION_ADDRESS), alignment);
+
+            while (address + size - 1 <= highest_address)
+            {
+                bool conflict = false;
+
+                for (const auto& [region_start, region] : mm.get_reserved_regions())
+                {
+                    const auto region_end = region_start + region.length;
+                    if (region_end <= address)
+                    {
+                        continue;
+                    }
+
+                    if (region_start < address + size)
+                    {
+                        conflict = true;
+                        address = align_up(region_end, alignment);
+                    }
+
+                    break;
+                }
+
+                if (!conflict)
+                {
+                    return address;
+                }
+            }
+
+            return 0;
+        }
+
+        const nt_memory_permission read_write{memory_permission::read_write};
+    }
+
+    TEST(MemoryAllocationTest, FreeBaseMatchesFullScanUnderRandomLayouts)
+    {
+        std::mt19937_64 rng{1};
+
+        for (int round = 0; round < 4; ++round)
+        {
+            null_memory memory{};
+            memory_manager mm{memory};
+            std::vector<uint64_t> allocations{};
+
+            for (int i = 0; i < 2000; ++i)
+            {
+                const auto operation = rng() % 10;
+
+                if (operation < 5)
+                {
+                    const auto size = static_cast<size_t>((rng() % 64 + 1) * 0x1000);
+                    const auto start = rng() % 4 ? DEFAULT_ALLOCATION_ADDRESS_64BIT : MIN_ALLOCATION_ADDRESS + (rng() % 0x100000) * 0x1000;
+                    const auto alignment = rng() % 5 ? ALLOCATION_GRANULARITY : 0x100000ULL;
+                    const auto highest_address = rng() % 3 ? MAX_ALLOCATION_ADDRESS : 0x1FFFFFFFFULL;
+
+                    const auto base = mm.find_free_allocation_base(size, start, alignment, MIN_ALLOCATION_ADDRESS, highest_address);
+                    ASSERT_EQ(base, find_free_base_by_scan(mm, size, start, alignment, highest_address));
+
+                    if (base && mm.allocate_memory(base, size, read_write, rng() % 2 == 0))
+                    {
+                        allocations.push_back(base);
+                    }
+                }
+                else if (operation < 7 && !allocations.empty())
+                {
+                    const auto index = rng() % allocations.size();
+                    ASSERT_TRUE(mm.release_memory(allocations[index], 0));
+                    allocations.erase(allocations.begin() + static_cast<ptrdiff_t>(index));
+                }
+                else if (operation < 8 && !allocations.empty())
+                {
+                    // Punches a hole into the middle of an allocation, which splits the reservation.
+                    const auto base = allocations[rng() % allocations.size()];
+                    if (mm.get_region_info(base).allocation_length > 0x2000)
+                    {
+                        mm.release_memory(base + 0x1000, 0x1000);
+                    }
+                }
+                else if (operation < 9)
+                {
+                    const auto address = MIN_ALLOCATION_ADDRESS + (rng() % 0x200000) * 0x1000;
+                    if (mm.allocate_memory(address, static_cast<size_t>((rng() % 16 + 1) * 0x1000), read_write, true))
+                    {
+                        allocations.push_back(address);
+                    }
+                }
+                else
+                {
+                    mm.allocate_mmio(MIN_ALLOCATION_ADDRESS + (rng() % 0x200000) * 0x1000, 0x1000, {}, {});
+                }
+            }
+        }
+    }
+
+    // Allocation-heavy guests (JITs, browsers) leave thousands of page-sized reservations behind and keep
+    // allocating and querying around them, like a VirtualAlloc/VirtualFree/VirtualQuery storm.
+    TEST(MemoryAllocationTest, AllocationStormAroundFragmentedReservations)
+    {
+        constexpr size_t live_allocations = 2'000;
+        constexpr size_t storm_allocations = 500;
+
+        null_memory memory{};
+        memory_manager mm{memory};
+
+        std::vector<uint64_t> allocations{};
+        for (size_t i = 0; i < live_allocations; ++i)
+        {
+            allocations.push_back(mm.allocate_memory(0x1000, read_write));
+            ASSERT_NE(allocations.back(), 0u);
+        }
+
+        for (size_t i = 0; i < live_allocations; i += 2)
+        {
+            ASSERT_TRUE(mm.release_memory(allocations[i], 0));
+        }
+
+        // The freed single pages are too small, so every storm allocation lands in a gap that fits it whole.
+        for (size_t i = 0; i < storm_allocations; ++i)
+        {
+            const auto base = mm.allocate_memory(0x20000, read_write);
+            ASSERT_NE(base, 0u);
+            ASSERT_EQ(base % ALLOCATION_GRANULARITY, 0u);
+
+            for (size_t j = 1; j < live_allocations; j += 2)
+            {
+                ASSERT_FALSE(allocations[j] + 0x1000 > base && allocations[j] < base + 0x20000);
+            }
+
+            ASSERT_TRUE(mm.release_memory(base, 0));
+        }
+
+        size_t committed_queries = 0;
+        for (size_t i = 0; i < live_allocations; ++i)
+        {
+            committed_queries += mm.get_region_info(allocations[i] + 0x800).is_committed ? 1 : 0;
+        }
+
+        EXPECT_EQ(committed_queries, live_allocations / 2);
+    }
+} // namespace sogen::test
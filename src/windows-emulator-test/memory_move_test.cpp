@@ -0,0 +1,196 @@
+#include "emulation_test_utils.hpp"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace sogen::test
+{
+    namespace
+    {
+        // Flat guest memory at address 0 that counts accesses and can optionally hand out host spans.
+        class flat_memory : public memory_interface
+        {
+          public:
+            std::vector<std::byte> data{};
+            bool host_spans{false};
+            mutable size_t reads{0};
+            size_t writes{0};
+
+            explicit flat_memory(const size_t size)
+                : data(size)
+            {
+            }
+
+            void read_memory(const uint64_t address, void* buffer, const size_t size) const override
+            {
+                if (!this->try_read_memory(address, buffer, size))
+                {
+                    throw std::runtime_error("Out of bounds read");
+                }
+            }
+
+            bool try_read_memory(const uint64_t address, void* buffer, const size_t size) const override
+            {
+                if (!this->contains(address, size))
+                {
+                    return false;
+                }
+
+                ++this->reads;
+                std::memcpy(buffer, this->data.data() + address, size);
+                return true;
+            }
+
+            void write_memory(const uint64_t address, const void* buffer, const size_t size) override
+            {
+                if (!this->try_write_memory(address, buffer, size))
+                {
+                    throw std::runtime_error("Out of bounds write");
+                }
+            }
+
+            bool try_write_memory(const uint64_t address, const void* buffer, const size_t size) override
+            {
+                if (!this->contains(address, size))
+                {
+                    return false;
+                }
+
+                ++this->writes;
+                std::memcpy(this->data.data() + address, buffer, size);
+                return true;
+            }
+
+            std::span<const std::byte> get_host_span(const uint64_t address, const size_t size) const override
+            {
+                if (!this->host_spans || !this->contains(address, size))
+                {
+                    return {};
+                }
+
+                return {this->data.data() + address, size};
+            }
+
+            std::span<std::byte> get_writable_host_span(const uint64_t address, const size_t size) override
+            {
+                if (!this->host_spans || !this->contains(address, size))
+                {
+                    return {};
+                }
+
+                return {this->data.data() + address, size};
+            }
+
+          private:
+            bool contains(const uint64_t address, const size_t size) const
+            {
+                return address <= this->data.size() && size <= this->data.size() - address;
+            }
+
+            void map_mmio(uint64_t, size_t, mmio_read_callback, mmio_write_callback) override
+            {
+            }
+
+            void map_memory(uint64_t, size_t, memory_permission) override
+            {
+            }
+
+            void unmap_memory(uint64_t, size_t) override
+            {
+            }
+
+            void apply_memory_protection(uint64_t, size_t, memory_permission) override
+            {
+            }
+        };
+
+        void fill_random(std::vector<std::byte>& data, std::mt19937_64& rng)
+        {
+            for (auto& value : data)
+            {
+                value = static_cast<std::byte>(rng());
+            }
+        }
+    }
+
+    TEST(MemoryMoveTest, MoveMatchesMemmoveForOverlappingRanges)
+    {
+        constexpr size_t memory_size = 0x10000;
+        std::mt19937_64 rng{1};
+
+        for (const auto host_spans : {false, true})
+        {
+            flat_memory memory{memory_size};
+            memory.host_spans = host_spans;
+
+            for (int i = 0; i < 500; ++i)
+            {
+                fill_random(memory.data, rng);
+                auto expected = memory.data;
+
+                // Sizes up to a few chunks, with sources and destinations that often overlap.
+                const auto size = static_cast<size_t>(rng() % 0x3800);
+                const auto src = static_cast<uint64_t>(rng() % (memory_size - size + 1));
+                const auto dst = static_cast<uint64_t>(rng() % 2 ? rng() % (memory_size - size + 1)
+                                                                  : std::min<uint64_t>(src + rng() % 0x1800, memory_size - size));
+
+                std::memmove(expected.data() + dst, expected.data() + src, size);
+                memory.move_memory(dst, src, size);
+
+                ASSERT_EQ(memory.data, expected) << "dst 0x" << std::hex << dst << ", src 0x" << src << ", size 0x" << size;
+            }
+        }
+    }
+
+    TEST(MemoryMoveTest, MoveAndFillTouchMemoryInChunks)
+    {
+        constexpr size_t size = 0x100000;
+
+        flat_memory memory{size * 2};
+        memory.move_memory(0x800, 0, size);
+        EXPECT_LE(memory.reads, size / 0x1000 + 1);
+        EXPECT_LE(memory.writes, size / 0x1000 + 1);
+
+        memory.writes = 0;
+        memory.set_memory(0x10, 0xCC, size);
+        EXPECT_LE(memory.writes, size / 0x1000 + 1);
+        EXPECT_EQ(memory.data[0x10], std::byte{0xCC});
+        EXPECT_EQ(memory.data[0x10 + size - 1], std::byte{0xCC});
+        EXPECT_EQ(memory.data[0x10 + size], std::byte{0});
+
+        memory.host_spans = true;
+        memory.reads = 0;
+        memory.writes = 0;
+        memory.set_memory(0, 0x11, size);
+        memory.move_memory(0x1000, 0, size);
+        EXPECT_EQ(memory.reads + memory.writes, 0u);
+        EXPECT_EQ(memory.data[size + 0xFFF], std::byte{0x11});
+    }
+
+    // Guest memory moves and fills through the emulator's backend, as done for RtlMoveMemory-style syscall
+    // paths, including overlapping moves in both directions.
+    TEST(MemoryMoveTest, BulkMoveThroughBackend)
+    {
+        constexpr size_t size = 0x40000;
+        constexpr uint64_t shift = 0x1234;
+
+        auto emu = create_sample_emulator();
+        const auto buffer = emu.memory.allocate_memory(size * 2, memory_permission::read_write);
+        ASSERT_NE(buffer, 0u);
+
+        std::mt19937_64 rng{1};
+        std::vector<std::byte> pattern(size);
+        fill_random(pattern, rng);
+        emu.emu().write_memory(buffer, pattern.data(), pattern.size());
+
+        emu.emu().move_memory(buffer + shift, buffer, size);
+        ASSERT_EQ(emu.emu().read_memory(buffer + shift, size), pattern);
+
+        emu.emu().move_memory(buffer, buffer + shift, size);
+        ASSERT_EQ(emu.emu().read_memory(buffer, size), pattern);
+
+        emu.emu().set_memory(buffer, 0, size * 2);
+        ASSERT_EQ(emu.emu().read_memory(buffer, size * 2), std::vector<std::byte>(size * 2));
+    }
+} // namespace sogen::test
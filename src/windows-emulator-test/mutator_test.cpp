@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <mutator.hpp>
+
+#include <array>
+#include <optional>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr size_t havoc_rounds = 2'000;
+
+        const fuzzer::dictionary tokens{
+            {'G', 'E', 'T', ' '},
+            {0xFF, 0xFE},
+            std::vector<uint8_t>(0x200, 'A'),
+        };
+
+        const fuzzer::dictionary no_tokens{};
+
+        // Splice keeps the head of the input and takes the tail of the other one. Returns the last cut that
+        // explains the result, if any does.
+        std::optional<size_t> find_splice_cut(const std::vector<uint8_t>& result, const std::vector<uint8_t>& input,
+                                              const std::vector<uint8_t>& other)
+        {
+            if (result.size() != other.size())
+            {
+                return std::nullopt;
+            }
+
+            for (auto split = std::min(input.size(), other.size()) + 1; split-- > 0;)
+            {
+                if (std::equal(result.begin(), result.begin() + static_cast<ptrdiff_t>(split), input.begin()) &&
+                    std::equal(result.begin() + static_cast<ptrdiff_t>(split), result.end(), other.begin() + static_cast<ptrdiff_t>(split)))
+                {
+                    return split;
+                }
+            }
+
+            return std::nullopt;
+        }
+    }
+
+    TEST(MutatorTest, HavocKeepsInputsWithinBounds)
+    {
+        fuzzer::random_generator rng{};
+        fuzzer::mutator mutator{rng, tokens};
+
+        const std::array<std::vector<uint8_t>, 4> seeds{
+            std::vector<uint8_t>{},
+            std::vector<uint8_t>{0x41},
+            std::vector<uint8_t>(3, 0x00),
+            std::vector<uint8_t>(fuzzer::mutator::MAX_INPUT_SIZE, 0x90),
+        };
+
+        for (const auto& seed : seeds)
+        {
+            auto input = seed;
+
+            for (size_t i = 0; i < havoc_rounds; ++i)
+            {
+                mutator.havoc(input);
+
+                ASSERT_FALSE(input.empty());
+                ASSERT_LE(input.size(), fuzzer::mutator::MAX_INPUT_SIZE);
+            }
+        }
+    }
+
+    TEST(MutatorTest, HavocChangesItsInput)
+    {
+        fuzzer::random_generator rng{};
+        fuzzer::mutator mutator{rng, no_tokens};
+
+        const std::vector<uint8_t> seed(64, 0x00);
+        size_t unchanged = 0;
+
+        for (size_t i = 0; i < havoc_rounds; ++i)
+        {
+            auto input = seed;
+            mutator.havoc(input);
+            unchanged += input == seed ? 1 : 0;
+        }
+
+        // Two or more stacked mutations rarely cancel out.
+        EXPECT_LT(unchanged, havoc_rounds / 20);
+    }
+
+    TEST(MutatorTest, SpliceCutsBetweenTheFirstAndLastDifference)
+    {
+        fuzzer::random_generator rng{};
+        fuzzer::mutator mutator{rng, no_tokens};
+
+        const std::vector<uint8_t> input{1, 2, 3, 4, 5, 6, 7, 8};
+        const std::vector<uint8_t> other{1, 2, 9, 9, 9, 9, 7, 8, 10, 11};
+
+        // They differ in [2, 6).
+        for (size_t i = 0; i < 100; ++i)
+        {
+            auto result = input;
+            ASSERT_TRUE(mutator.splice(result, other));
+
+            const auto cut = find_splice_cut(result, input, other);
+            ASSERT_TRUE(cut.has_value());
+            EXPECT_GE(*cut, 2u);
+            EXPECT_LT(*cut, 6u);
+        }
+
+        // Here in [3, 5), and the result takes the length of the other input.
+        const std::vector<uint8_t> shorter{1, 2, 3, 9, 9};
+        auto result = input;
+        ASSERT_TRUE(mutator.splice(result, shorter));
+
+        const auto cut = find_splice_cut(result, input, shorter);
+        ASSERT_TRUE(cut.has_value());
+        EXPECT_GE(*cut, 3u);
+        EXPECT_LT(*cut, 5u);
+    }
+
+    TEST(MutatorTest, SpliceRejectsInputsThatDifferTooLittle)
+    {
+        fuzzer::random_generator rng{};
+        fuzzer::mutator mutator{rng, no_tokens};
+
+        const std::vector<uint8_t> input{1, 2, 3, 4, 5, 6};
+        const std::array<std::vector<uint8_t>, 4> others{
+            input,
+            std::vector<uint8_t>{1, 2, 3, 0, 5, 6},
+            std::vector<uint8_t>{},
+            std::vector<uint8_t>{1, 2, 3},
+        };
+
+        for (const auto& other : others)
+        {
+            auto result = input;
+            EXPECT_FALSE(mutator.splice(result, other));
+            EXPECT_EQ(result, input);
+        }
+    }
+}
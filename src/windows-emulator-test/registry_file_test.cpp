@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <registry/registry_cache.hpp>
 #include <registry/registry_file.hpp>
 
 #include <atomic>
@@ -139,6 +140,11 @@ namespace sogen::test
                 return *registry_;
             }
 
+            const std::filesystem::path& directory() const
+            {
+                return directory_;
+            }
+
             registry_key get_key(const std::filesystem::path& path)
             {
                 auto key = registry().get_key(utils::path_key{path});
@@ -312,4 +318,91 @@ namespace sogen::test
         EXPECT_FALSE(registry().can_create_key(path));
         EXPECT_FALSE(registry().create_key(path).has_value());
     }
+
+    TEST_F(RegistryFileTest, CompiledCacheServesHivesAndOverlays)
+    {
+        const auto reg_file = directory() / "overlay.reg";
+        ASSERT_TRUE(write_hive(reg_file, encode_utf8_with_bom(R"(Windows Registry Editor Version 5.00
+
+[HKLM\Software\Microsoft\Cached]
+"Number"=dword:00000007
+)")));
+
+        const auto cache_file = directory() / registry_cache::file_name;
+        registry_cache::compile(directory(), std::span{&reg_file, 1}, cache_file);
+        ASSERT_NE(registry_cache::open(cache_file, std::span{&reg_file, 1}), nullptr);
+
+        registry_manager cached{directory(), {reg_file}};
+        EXPECT_TRUE(cached.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion\ProfileList)"}));
+
+        const auto key = cached.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft\Cached)"});
+        ASSERT_TRUE(key.has_value());
+        const auto number = cached.get_value(*key, "number");
+        ASSERT_TRUE(number.has_value());
+        EXPECT_EQ(number->as_dword(), 7u);
+
+        // Hive and overlay sub keys keep their enumeration order and display names.
+        const auto microsoft = cached.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft)"});
+        ASSERT_TRUE(microsoft.has_value());
+        ASSERT_EQ(cached.get_sub_key_count(*microsoft), 2u);
+        EXPECT_EQ(cached.get_sub_key_name(*microsoft, 0), "Windows NT");
+        EXPECT_EQ(cached.get_sub_key_name(*microsoft, 1), "Cached");
+
+        // A run without the overlay must not see it, the cache does not match and the raw hives are used.
+        EXPECT_EQ(registry_cache::open(cache_file), nullptr);
+        registry_manager plain{directory()};
+        EXPECT_TRUE(plain.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion\ProfileList)"}));
+        EXPECT_FALSE(plain.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft\Cached)"}));
+
+        // Any change to a source makes the cache stale.
+        ASSERT_TRUE(write_hive(reg_file, encode_utf8_with_bom("Windows Registry Editor Version 5.00\n")));
+        EXPECT_EQ(registry_cache::open(cache_file, std::span{&reg_file, 1}), nullptr);
+    }
+
+    TEST_F(RegistryFileTest, CacheOnlyServesItsOverlayList)
+    {
+        const auto first = directory() / "first.reg";
+        const auto second = directory() / "second.reg";
+        ASSERT_TRUE(write_hive(first, encode_utf8_with_bom(R"(Windows Registry Editor Version 5.00
+
+[HKLM\Software\Microsoft\Ordered]
+"Value"=dword:00000001
+)")));
+        ASSERT_TRUE(write_hive(second, encode_utf8_with_bom(R"(Windows Registry Editor Version 5.00
+
+[HKLM\Software\Microsoft\Ordered]
+"Value"=dword:00000002
+)")));
+
+        const std::array compiled{first, second};
+        const std::array reversed{second, first};
+
+        const auto cache_file = directory() / registry_cache::file_name;
+        registry_cache::compile(directory(), compiled, cache_file);
+
+        EXPECT_NE(registry_cache::open(cache_file, compiled), nullptr);
+        EXPECT_EQ(registry_cache::open(cache_file, reversed), nullptr);
+        EXPECT_EQ(registry_cache::open(cache_file, std::span{&first, 1}), nullptr);
+
+        // Without a matching cache the overlays are imported at runtime, in the requested order.
+        const auto read_ordered = [&](registry_manager& registry) -> std::optional<uint32_t> {
+            const auto key = registry.get_key(utils::path_key{uR"(\Registry\Machine\Software\Microsoft\Ordered)"});
+            if (!key)
+            {
+                return std::nullopt;
+            }
+
+            const auto value = registry.get_value(*key, "Value");
+            return value ? std::optional{value->as_dword()} : std::nullopt;
+        };
+
+        registry_manager cached{directory(), {compiled.begin(), compiled.end()}};
+        EXPECT_EQ(read_ordered(cached), 2u);
+
+        registry_manager runtime{directory(), {reversed.begin(), reversed.end()}};
+        EXPECT_EQ(read_ordered(runtime), 1u);
+
+        registry_manager first_only{directory(), {first}};
+        EXPECT_EQ(read_ordered(first_only), 1u);
+    }
 } // namespace sogen::test
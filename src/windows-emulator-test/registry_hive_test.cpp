@@ -0,0 +1,135 @@
+#include "emulation_test_utils.hpp"
+
+#include <registry/registry_manager.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr size_t hive_data_offset = 0x1000;
+        constexpr size_t root_key_offset = hive_data_offset + 0x20;
+
+        void write_bytes(std::vector<std::byte>& data, const size_t offset, const void* value, const size_t size)
+        {
+            memcpy(data.data() + offset, value, size);
+        }
+
+        template <typename T>
+        void write_value(std::vector<std::byte>& data, const size_t offset, const T value)
+        {
+            write_bytes(data, offset, &value, sizeof(value));
+        }
+
+        // Root key with one value list holding an inline DWORD and a string stored in its own data cell.
+        std::vector<std::byte> create_value_hive()
+        {
+            std::vector<std::byte> data(hive_data_offset + 0x400);
+            write_bytes(data, 0, "regf", 4);
+
+            write_value<int32_t>(data, root_key_offset + 40, 2);
+            write_value<int32_t>(data, root_key_offset + 44, 0x100);
+            write_value<int32_t>(data, hive_data_offset + 0x104, 0x200);
+            write_value<int32_t>(data, hive_data_offset + 0x108, 0x300);
+
+            const auto dword_value = hive_data_offset + 0x200;
+            write_value<int16_t>(data, dword_value + 6, 5);
+            write_value<uint32_t>(data, dword_value + 8, 0x80000004);
+            write_value<uint32_t>(data, dword_value + 12, 0x1234ABCD);
+            write_value<uint32_t>(data, dword_value + 16, REG_DWORD);
+            write_bytes(data, dword_value + 24, "Count", 5);
+
+            const auto string_value = hive_data_offset + 0x300;
+            write_value<int16_t>(data, string_value + 6, 4);
+            write_value<uint32_t>(data, string_value + 8, 6);
+            write_value<int32_t>(data, string_value + 12, 0x380);
+            write_value<uint32_t>(data, string_value + 16, REG_SZ);
+            write_bytes(data, string_value + 24, "Name", 4);
+            write_bytes(data, hive_data_offset + 0x384, u"ab", 6);
+
+            return data;
+        }
+
+        std::filesystem::path write_temporary_hive(const std::span<const std::byte> data)
+        {
+            static std::atomic_uint64_t counter{};
+            const auto timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto path = std::filesystem::temp_directory_path() /
+                        ("sogen-hive-test-" + std::to_string(timestamp) + "-" + std::to_string(counter++));
+
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            return path;
+        }
+    }
+
+    TEST(RegistryHiveTest, ValuesAreViewsIntoTheMappedHive)
+    {
+        const auto path = write_temporary_hive(create_value_hive());
+
+        {
+            hive_parser parser{path};
+
+            const auto* count = parser.get_value({}, "count");
+            ASSERT_NE(count, nullptr);
+            EXPECT_EQ(count->type, static_cast<uint32_t>(REG_DWORD));
+            EXPECT_EQ(count->name, "Count");
+            ASSERT_EQ(count->data.size(), 4u);
+
+            uint32_t dword{};
+            memcpy(&dword, count->data.data(), sizeof(dword));
+            EXPECT_EQ(dword, 0x1234ABCDu);
+
+            const auto* name = parser.get_value({}, 1);
+            ASSERT_NE(name, nullptr);
+            EXPECT_EQ(name->name, "Name");
+            EXPECT_EQ(std::u16string_view(reinterpret_cast<const char16_t*>(name->data.data()), 2), u"ab");
+
+            const auto file = parser.get_file().get_span();
+            EXPECT_GE(name->data.data(), file.data());
+            EXPECT_LE(name->data.data() + name->data.size(), file.data() + file.size());
+
+            EXPECT_EQ(parser.get_sub_key("Missing"), nullptr);
+            EXPECT_EQ(parser.get_sub_key("Missing"), nullptr);
+        }
+
+        std::error_code error{};
+        std::filesystem::remove(path, error);
+    }
+
+    // Opening the standard hives and resolving the paths every process start touches.
+    TEST(RegistryHiveTest, StartupResolvesCommonPaths)
+    {
+        const std::array<std::u16string_view, 6> paths{
+            uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion)",
+            uR"(\Registry\Machine\Software\Microsoft\Windows NT\CurrentVersion\ProfileList)",
+            uR"(\Registry\Machine\System\CurrentControlSet\Control\Session Manager)",
+            uR"(\Registry\Machine\System\CurrentControlSet\Control\Nls\CodePage)",
+            uR"(\Registry\Machine\Software\Classes\CLSID)",
+            uR"(\Registry\Machine\Software\Microsoft\Cryptography)",
+        };
+
+        registry_manager registry{get_emulator_root() / "registry"};
+        size_t resolved = 0;
+
+        for (const auto path : paths)
+        {
+            const auto key = registry.get_key(utils::path_key{path});
+            if (!key)
+            {
+                continue;
+            }
+
+            ++resolved;
+            for (size_t value = 0; value < registry.get_value_count(*key); ++value)
+            {
+                EXPECT_TRUE(registry.get_value(*key, value).has_value());
+            }
+        }
+
+        EXPECT_GT(resolved, 0u);
+    }
+} // namespace sogen::test
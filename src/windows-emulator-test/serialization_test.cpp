@@ -2,6 +2,9 @@
 
 #include <utils/io.hpp>
 
+#include <array>
+#include <cstring>
+
 namespace sogen::test
 {
     namespace
@@ -116,4 +119,109 @@ namespace sogen::test
 
         dump_and_expect_equal("DeserializedEmulatorBehavesLikeSource", serializer1.get_buffer(), serializer2.get_buffer());
     }
+
+    TEST(SerializationTest, RestoredSnapshotBehavesLikeSource)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+
+        emu.save_snapshot();
+
+        emu.start();
+        ASSERT_TERMINATED_SUCCESSFULLY(emu);
+
+        utils::buffer_serializer serializer1{};
+        emu.serialize(serializer1);
+
+        emu.restore_snapshot();
+
+        emu.start();
+        ASSERT_TERMINATED_SUCCESSFULLY(emu);
+
+        utils::buffer_serializer serializer2{};
+        emu.serialize(serializer2);
+
+        dump_and_expect_equal("RestoredSnapshotBehavesLikeSource", serializer1.get_buffer(), serializer2.get_buffer());
+    }
+
+    // Without a dirty-page log restore_snapshot compares every committed page with the snapshot. With one, it
+    // rewrites exactly the pages written since the snapshot: a page the guest rewrote with its old contents
+    // counts, the untouched rest of the reservation does not.
+    TEST(SerializationTest, SnapshotRestoreRewritesOnlyWrittenPages)
+    {
+        constexpr uint64_t page_size = 0x1000;
+        constexpr size_t data_size = 0x40000;
+
+        auto emu = create_sample_emulator();
+        emu.start(100);
+
+        auto& cpu = emu.emu();
+        if (!cpu.supports_dirty_page_tracking())
+        {
+            GTEST_SKIP() << cpu.get_name() << " has no dirty-page log";
+        }
+
+        const auto data = emu.memory.allocate_memory(data_size, memory_permission::read_write);
+        const auto code = emu.memory.allocate_memory(page_size, memory_permission::read | memory_permission::exec);
+        ASSERT_NE(data, 0u);
+        ASSERT_NE(code, 0u);
+
+        const auto target = data + 5 * page_size;
+        const auto rewritten = data + 9 * page_size;
+
+        // mov rax, target; mov byte ptr [rax], 0x42
+        std::array<uint8_t, 13> writer{0x48, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0xC6, 0x00, 0x42};
+        memcpy(writer.data() + 2, &target, sizeof(target));
+        emu.memory.write_memory(code, writer.data(), writer.size());
+
+        emu.memory.save_snapshot();
+
+        cpu.reg(x86_register::rip, code);
+        cpu.start(2);
+        ASSERT_EQ(emu.memory.read_memory<uint8_t>(target), 0x42);
+
+        constexpr uint8_t zero = 0;
+        emu.memory.write_memory(rewritten, &zero, sizeof(zero));
+
+        const auto stats = emu.memory.restore_snapshot();
+
+        EXPECT_EQ(stats.restored_pages, 2u);
+        EXPECT_EQ(stats.remapped_regions, 0u);
+        EXPECT_EQ(emu.memory.read_memory<uint8_t>(target), 0);
+    }
+
+    TEST(SerializationTest, ForkedEmulatorBehavesLikeSource)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+
+        const auto image = emu.create_fork_image();
+
+        auto forked_emu = create_empty_emulator();
+        forked_emu.fork_from(*image);
+
+        forked_emu.start();
+        ASSERT_TERMINATED_SUCCESSFULLY(forked_emu);
+
+        emu.start();
+        ASSERT_TERMINATED_SUCCESSFULLY(emu);
+
+        utils::buffer_serializer serializer1{};
+        utils::buffer_serializer serializer2{};
+
+        emu.serialize(serializer1);
+        forked_emu.serialize(serializer2);
+
+        dump_and_expect_equal("ForkedEmulatorBehavesLikeSource", serializer1.get_buffer(), serializer2.get_buffer());
+
+        // The image is the fork's snapshot, so restoring replays the same run.
+        forked_emu.restore_snapshot();
+        forked_emu.start();
+        ASSERT_TERMINATED_SUCCESSFULLY(forked_emu);
+
+        utils::buffer_serializer serializer3{};
+        forked_emu.serialize(serializer3);
+
+        dump_and_expect_equal("ForkedEmulatorRestoresToForkPoint", serializer1.get_buffer(), serializer3.get_buffer());
+    }
 } // namespace sogen::test
@@ -0,0 +1,103 @@
+#include "emulation_test_utils.hpp"
+
+namespace sogen::test
+{
+    namespace
+    {
+        struct observed_syscall
+        {
+            uint32_t id{};
+            std::string name{};
+        };
+
+        // Dispatches the syscall in rax directly, without executing guest code, and returns what on_syscall saw.
+        std::vector<observed_syscall> dispatch_directly(windows_emulator& emu, const uint64_t rax, const size_t count = 1)
+        {
+            std::vector<observed_syscall> observed{};
+            emu.callbacks.on_syscall = [&](const uint32_t id, const std::string_view name) {
+                observed.push_back({.id = id, .name = std::string(name)});
+                return instruction_hook_continuation::run_instruction;
+            };
+
+            auto& vcpu = emu.vcpu(0);
+            emu.dispatch_on_cpu(vcpu.cpu, [&] {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    vcpu.cpu.reg<uint64_t>(x86_register::rax, rax);
+                    emu.dispatcher.dispatch(emu, vcpu);
+                }
+            });
+
+            emu.callbacks.on_syscall = {};
+            return observed;
+        }
+    }
+
+    TEST(SyscallDispatchTest, DispatchesKnownSyscallThroughTable)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        const auto syscall_id = emu.dispatcher.find_syscall_id("NtGetCurrentProcessorNumber");
+        ASSERT_TRUE(syscall_id.has_value());
+
+        const auto stop_reason_before = emu.last_stop_reason();
+        const auto observed = dispatch_directly(emu, *syscall_id, 3);
+
+        ASSERT_EQ(observed.size(), 3u);
+        for (const auto& call : observed)
+        {
+            EXPECT_EQ(call.id, *syscall_id);
+            EXPECT_EQ(call.name, "NtGetCurrentProcessorNumber");
+        }
+
+        EXPECT_EQ(emu.vcpu(0).cpu.reg<uint64_t>(x86_register::rax), 0u);
+        EXPECT_EQ(emu.last_stop_reason(), stop_reason_before);
+    }
+
+    TEST(SyscallDispatchTest, IgnoresBitsAboveTheSyscallIndex)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        const auto syscall_id = emu.dispatcher.find_syscall_id("NtGetCurrentProcessorNumber");
+        ASSERT_TRUE(syscall_id.has_value());
+
+        // WOW64 encodes extra bits above the 14-bit index.
+        const auto observed = dispatch_directly(emu, *syscall_id | 0x4000 | 0x10000);
+
+        ASSERT_EQ(observed.size(), 1u);
+        EXPECT_EQ(observed[0].id, *syscall_id);
+        EXPECT_EQ(observed[0].name, "NtGetCurrentProcessorNumber");
+    }
+
+    TEST(SyscallDispatchTest, UnknownSyscallStopsEmulation)
+    {
+        auto emu = create_sample_emulator();
+        emu.start(100);
+        ASSERT_NOT_TERMINATED(emu);
+
+        std::optional<uint64_t> unknown_id{};
+        for (uint64_t id = 0x3FFF; id > 0 && !unknown_id; --id)
+        {
+            try
+            {
+                (void)emu.dispatcher.get_syscall_name(id);
+            }
+            catch (const std::out_of_range&)
+            {
+                unknown_id = id;
+            }
+        }
+
+        ASSERT_TRUE(unknown_id.has_value());
+
+        const auto observed = dispatch_directly(emu, *unknown_id);
+
+        EXPECT_TRUE(observed.empty());
+        EXPECT_EQ(emu.last_stop_reason(), stop_reason::unknown_syscall);
+        EXPECT_EQ(emu.vcpu(0).cpu.reg<uint64_t>(x86_register::rax), static_cast<uint64_t>(STATUS_NOT_SUPPORTED));
+    }
+} // namespace sogen::test
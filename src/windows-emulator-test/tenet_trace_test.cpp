@@ -0,0 +1,195 @@
+#include "emulation_test_utils.hpp"
+
+#include <tenet_tracer.hpp>
+
+#include <utils/compression.hpp>
+#include <utils/io.hpp>
+
+#include <array>
+#include <cstring>
+
+namespace sogen::test
+{
+    namespace
+    {
+        constexpr uint64_t executable_start = 0x140001000;
+        constexpr uint64_t executable_end = 0x140002000;
+
+        constexpr uint16_t rax_bit = 1 << 0;
+        constexpr uint16_t rbx_bit = 1 << 1;
+        constexpr uint16_t rcx_bit = 1 << 2;
+
+        // Builds a trace file the way tenet_tracer lays it out, so the on-disk format is pinned down as well.
+        class trace_builder
+        {
+          public:
+            void instruction(const uint64_t rip, const uint16_t register_mask, const std::vector<uint64_t>& registers)
+            {
+                this->append<uint8_t>(0);
+                this->append(rip);
+                this->append(register_mask);
+
+                for (const auto value : registers)
+                {
+                    this->append(value);
+                }
+            }
+
+            void memory_access(const bool is_write, const uint64_t address, const std::vector<uint8_t>& data)
+            {
+                this->append<uint8_t>(is_write ? 2 : 1);
+                this->append(address);
+                this->append(static_cast<uint32_t>(data.size()));
+                this->append_bytes(data.data(), data.size());
+            }
+
+            void unknown_record(const uint8_t type)
+            {
+                this->append(type);
+            }
+
+            // Ends the current zstd frame; records never straddle frames.
+            void end_frame()
+            {
+                const auto compressed = utils::compression::zstd::compress(this->frame_);
+                const auto compressed_size = static_cast<uint32_t>(compressed.size());
+
+                append_raw(this->file_, &compressed_size, sizeof(compressed_size));
+                append_raw(this->file_, compressed.data(), compressed.size());
+                this->frame_.clear();
+            }
+
+            std::vector<std::byte> finish()
+            {
+                if (!this->frame_.empty())
+                {
+                    this->end_frame();
+                }
+
+                std::vector<std::byte> result{};
+                constexpr std::array<char, 8> magic{'S', 'G', 'N', 'T', 'E', 'N', 'E', 'T'};
+                constexpr uint32_t version = 1;
+                constexpr auto register_count = static_cast<uint32_t>(GPRs_TO_TRACE.size());
+
+                append_raw(result, magic.data(), magic.size());
+                append_raw(result, &version, sizeof(version));
+                append_raw(result, &register_count, sizeof(register_count));
+                append_raw(result, &executable_start, sizeof(executable_start));
+                append_raw(result, &executable_end, sizeof(executable_end));
+                append_raw(result, this->file_.data(), this->file_.size());
+
+                return result;
+            }
+
+          private:
+            std::vector<std::byte> frame_{};
+            std::vector<std::byte> file_{};
+
+            template <typename T>
+            void append(const T value)
+            {
+                this->append_bytes(&value, sizeof(value));
+            }
+
+            void append_bytes(const void* data, const size_t size)
+            {
+                append_raw(this->frame_, data, size);
+            }
+
+            static void append_raw(std::vector<std::byte>& buffer, const void* data, const size_t size)
+            {
+                const auto offset = buffer.size();
+                buffer.resize(offset + size);
+                memcpy(buffer.data() + offset, data, size);
+            }
+        };
+
+        std::string convert(const std::vector<std::byte>& trace)
+        {
+            const auto name = "sogen-tenet-test-" + std::to_string(getpid());
+            const auto trace_file = std::filesystem::temp_directory_path() / (name + ".bin");
+            const auto log_file = std::filesystem::temp_directory_path() / (name + ".log");
+
+            EXPECT_TRUE(utils::io::write_file(trace_file, trace));
+
+            std::string log{};
+
+            try
+            {
+                convert_tenet_trace(trace_file, log_file);
+                const auto data = utils::io::read_file(log_file);
+                log.assign(reinterpret_cast<const char*>(data.data()), data.size());
+            }
+            catch (...)
+            {
+                std::filesystem::remove(trace_file);
+                std::filesystem::remove(log_file);
+                throw;
+            }
+
+            std::filesystem::remove(trace_file);
+            std::filesystem::remove(log_file);
+
+            return log;
+        }
+    }
+
+    TEST(TenetTraceTest, ConvertsRecordsToTenetLines)
+    {
+        trace_builder trace{};
+
+        trace.instruction(executable_start, rax_bit, {1});
+        trace.memory_access(false, 0x5000, {0xAB, 0xCD});
+        trace.memory_access(false, 0x5008, {0x01});
+        trace.instruction(executable_start + 4, rbx_bit, {2});
+        trace.end_frame();
+
+        // An excursion into a DLL: every key keeps its last value, memory included.
+        trace.instruction(0x7FF800001000, rax_bit, {3});
+        trace.memory_access(true, 0x6000, {0x11});
+        trace.instruction(0x7FF800001004, rcx_bit | rax_bit, {4, 5});
+        trace.memory_access(true, 0x6100, {0x22, 0x33});
+        trace.instruction(0x7FF800001008, 0, {});
+
+        trace.instruction(executable_start + 8, 0, {});
+        trace.memory_access(true, 0x6200, {0x44});
+        trace.instruction(executable_start + 12, 0, {});
+
+        EXPECT_EQ(convert(trace.finish()),                              //
+                  "rax=0x1,rip=0x140001000\n"                           //
+                  "rbx=0x2,rip=0x140001004,mr=0x5000:abcd;0x5008:01\n"  //
+                  "mw=0x6100:2233,rax=0x4,rcx=0x5,rip=0x7ff800001008\n" //
+                  "rip=0x140001008\n"                                   //
+                  "rip=0x14000100c,mw=0x6200:44\n");
+    }
+
+    TEST(TenetTraceTest, FirstLineIsKeptOutsideTheExecutable)
+    {
+        trace_builder trace{};
+
+        trace.instruction(0x7FF800001000, rax_bit, {1});
+        trace.instruction(0x7FF800001004, rbx_bit, {2});
+        trace.instruction(executable_start, 0, {});
+
+        EXPECT_EQ(convert(trace.finish()),       //
+                  "rax=0x1,rip=0x7ff800001000\n" //
+                  "rbx=0x2,rip=0x7ff800001004\n" //
+                  "rip=0x140001000\n");
+    }
+
+    TEST(TenetTraceTest, RejectsBrokenTraces)
+    {
+        trace_builder bad_record{};
+        bad_record.instruction(executable_start, 0, {});
+        bad_record.unknown_record(7);
+        EXPECT_THROW(convert(bad_record.finish()), std::runtime_error);
+
+        trace_builder truncated{};
+        truncated.instruction(executable_start, rax_bit, {});
+        EXPECT_THROW(convert(truncated.finish()), std::runtime_error);
+
+        auto wrong_version = trace_builder{}.finish();
+        wrong_version[8] = std::byte{2};
+        EXPECT_THROW(convert(wrong_version), std::runtime_error);
+    }
+}
@@ -0,0 +1,153 @@
+#include "emulation_test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace sogen::test
+{
+    namespace
+    {
+        using namespace std::chrono_literals;
+
+        const handle first_event = make_handle(1, handle_types::event, false);
+        const handle second_event = make_handle(2, handle_types::event, false);
+    }
+
+    TEST(ThreadSchedulerTest, ParkedThreadsWakeOnObjectOrTimeout)
+    {
+        thread_scheduler scheduler{};
+        const thread_scheduler::time_point now{1s};
+
+        for (uint32_t thread_id = 8; thread_id <= 20; thread_id += 4)
+        {
+            scheduler.add(thread_id);
+        }
+
+        const std::vector both_events{first_event, second_event};
+        scheduler.park(8, both_events, std::nullopt, now);
+        scheduler.park(12, std::span{&second_event, 1}, now + 5ms, now);
+        scheduler.park(16, {}, now + 300ms, now);
+
+        EXPECT_EQ(scheduler.get_runnable(), (std::set<uint32_t>{20}));
+        EXPECT_EQ(scheduler.get_parked_count(), 3u);
+
+        // Any object a thread waits on wakes it, its entries on the other objects go stale.
+        scheduler.notify_object(first_event);
+        EXPECT_EQ(scheduler.get_runnable(), (std::set<uint32_t>{8, 20}));
+
+        scheduler.notify_object(second_event);
+        EXPECT_EQ(scheduler.get_runnable(), (std::set<uint32_t>{8, 12, 20}));
+        EXPECT_TRUE(scheduler.is_parked(16));
+
+        // The wheel only has 256 one-millisecond slots, later deadlines survive passing their slot.
+        scheduler.expire_timeouts(now + 299ms);
+        EXPECT_TRUE(scheduler.is_parked(16));
+
+        scheduler.expire_timeouts(now + 300ms);
+        EXPECT_FALSE(scheduler.is_parked(16));
+
+        // A thread parked again after a wake-up must not be released by its old timer.
+        scheduler.park(12, {}, now + 400ms, now + 300ms);
+        scheduler.park(12, {}, std::nullopt, now + 300ms);
+        scheduler.expire_timeouts(now + 1s);
+        EXPECT_TRUE(scheduler.is_parked(12));
+
+        scheduler.terminate(20);
+        EXPECT_EQ(scheduler.take_terminated(), std::vector<uint32_t>{20});
+        EXPECT_FALSE(scheduler.get_runnable().contains(20));
+
+        scheduler.wake_all();
+        EXPECT_EQ(scheduler.get_parked_count(), 0u);
+        EXPECT_EQ(scheduler.get_runnable(), (std::set<uint32_t>{8, 12, 16}));
+    }
+
+    // An idle vCPU blocks on host_wakeup until its deadline, a host thread waking a parked guest thread must cut
+    // that short.
+    TEST(ThreadSchedulerTest, WakeCallbackEndsIdleWait)
+    {
+        host_wakeup wakeup{};
+        thread_scheduler scheduler{};
+        scheduler.set_wake_callback([&] { wakeup.notify(); });
+
+        scheduler.add(8);
+        scheduler.park(8, std::span{&first_event, 1}, std::nullopt, {});
+
+        const auto stale_generation = wakeup.get_generation();
+        scheduler.notify_object(second_event);
+        EXPECT_EQ(wakeup.get_generation(), stale_generation);
+
+        const auto start = std::chrono::steady_clock::now();
+        std::thread signaler([&] {
+            std::this_thread::sleep_for(20ms);
+            scheduler.notify_object(first_event);
+        });
+
+        const auto woken = wakeup.wait_until(stale_generation, start + 10s);
+        const auto waited = std::chrono::steady_clock::now() - start;
+        signaler.join();
+
+        EXPECT_TRUE(woken);
+        EXPECT_LT(waited, 5s);
+        EXPECT_FALSE(scheduler.is_parked(8));
+
+        // A notification that arrived before the wait started is not lost.
+        EXPECT_TRUE(wakeup.wait_until(stale_generation, std::chrono::steady_clock::now() + 10s));
+    }
+
+    // A thread pool parked on a single event: blocked threads must not be looked at on every context switch,
+    // and signaling the event has to release all of them.
+    TEST(ThreadSchedulerTest, ManyThreadsWaitingOnOneEvent)
+    {
+        constexpr size_t waiter_count = 1'000;
+        constexpr size_t switch_count = 100;
+
+        auto emu = create_sample_emulator();
+        auto& process = emu.process;
+        auto& vcpu = emu.vcpu(0);
+
+        auto* main_thread = vcpu.active_thread;
+        ASSERT_NE(main_thread, nullptr);
+
+        event e{};
+        e.type = NotificationEvent;
+        const auto event_handle = process.events.store(std::move(e));
+
+        std::vector<uint32_t> waiters{};
+        for (size_t i = 0; i < waiter_count; ++i)
+        {
+            auto* thread = process.threads.get(process.create_thread(emu.memory, main_thread->start_address, 0, 0x10000, 0));
+            ASSERT_NE(thread, nullptr);
+
+            thread->await_objects = {event_handle};
+            thread->await_any = true;
+            waiters.push_back(thread->id);
+        }
+
+        // The first switch finds every waiter blocked and parks it.
+        ASSERT_TRUE(emu.perform_thread_switch(vcpu));
+        ASSERT_EQ(vcpu.active_thread, main_thread);
+        ASSERT_EQ(process.scheduler.get_parked_count(), waiter_count);
+
+        // Parked waiters stay parked: further switches keep returning to the main thread without waking them.
+        for (size_t i = 0; i < switch_count; ++i)
+        {
+            ASSERT_TRUE(emu.perform_thread_switch(vcpu));
+            ASSERT_EQ(vcpu.active_thread, main_thread);
+        }
+
+        EXPECT_EQ(process.scheduler.get_parked_count(), waiter_count);
+
+        process.events.get(event_handle)->signaled = true;
+        process.scheduler.notify_object(event_handle);
+        EXPECT_EQ(process.scheduler.get_parked_count(), 0u);
+
+        // The waiters run round robin after the main thread, each one satisfied by the notification event.
+        for (const auto thread_id : waiters)
+        {
+            ASSERT_TRUE(emu.perform_thread_switch(vcpu));
+            ASSERT_EQ(vcpu.active_thread->id, thread_id);
+            EXPECT_EQ(vcpu.active_thread->pending_status, STATUS_WAIT_0);
+        }
+    }
+} // namespace sogen::test
@@ -468,13 +468,8 @@ namespace sogen
                 return STATUS_PENDING;
             }
 
-            void work(windows_emulator& win_emu) override
+            network::poll_entry get_poll_entry() const
             {
-                if (!this->s_ || (!this->delayed_ioctl_ && !this->event_select_mask_))
-                {
-                    return;
-                }
-
                 network::poll_entry pfd{};
                 pfd.s = this->s_.get();
 
@@ -488,6 +483,43 @@ namespace sogen
                 }
                 pfd.revents = pfd.events;
 
+                return pfd;
+            }
+
+            void collect_wait(io_device_wait& wait) override
+            {
+                if (!this->s_ || (!this->delayed_ioctl_ && !this->event_select_mask_))
+                {
+                    return;
+                }
+
+                // A pending request that is not tied to this socket's readiness (AFD_POLL over several
+                // endpoints) only completes by work() re-executing it.
+                if (this->delayed_ioctl_ && !this->require_poll_.has_value())
+                {
+                    wait.needs_polling = true;
+                }
+
+                if (this->timeout_ && (!wait.deadline || *this->timeout_ < *wait.deadline))
+                {
+                    wait.deadline = this->timeout_;
+                }
+
+                if (const auto pfd = this->get_poll_entry(); pfd.events != 0)
+                {
+                    wait.sockets.push_back(pfd);
+                }
+            }
+
+            void work(windows_emulator& win_emu) override
+            {
+                if (!this->s_ || (!this->delayed_ioctl_ && !this->event_select_mask_))
+                {
+                    return;
+                }
+
+                auto pfd = this->get_poll_entry();
+
                 if (pfd.events != 0)
                 {
                     win_emu.socket_factory().poll_sockets(std::span{&pfd, 1});
@@ -508,6 +540,7 @@ namespace sogen
                         if (auto* event = win_emu.process.events.get(*this->event_select_event_))
                         {
                             event->signaled = true;
+                            win_emu.process.scheduler.notify_object(*this->event_select_event_);
                         }
                     }
                 }
@@ -546,6 +579,7 @@ namespace sogen
                     if (e)
                     {
                         e->signaled = true;
+                        win_emu.process.scheduler.notify_object(this->delayed_ioctl_->event);
                     }
 
                     this->clear_pending_state();
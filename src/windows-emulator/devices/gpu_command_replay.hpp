@@ -0,0 +1,843 @@
+#pragma once
+
+#include "vulkan_host.hpp"
+
+#include <command_stream.hpp>
+#include <gpu_bridge_protocol.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <vector>
+
+// Host-side replay of ioctl_record_commands streams. The decoding is templated on the host so the GPU bridge
+// replays into vulkan_host while tests replay into a recording double with the same cmd_*/queue_submit*
+// members, exercising the exact same code.
+
+namespace sogen
+{
+    struct gpu_command_replay_hooks
+    {
+        // Runs before every queue submission, e.g. to make guest writes to host-aliased memory visible.
+        std::function<void()> before_submit{};
+        std::function<void(uint32_t command)> unsupported_command{};
+    };
+
+    inline vulkan_host::subresource_range to_host_range(const gpu_bridge::image_subresource_range& range)
+    {
+        return vulkan_host::subresource_range{
+            .aspect_mask = range.aspect_mask,
+            .base_mip_level = range.base_mip_level,
+            .level_count = range.level_count,
+            .base_array_layer = range.base_array_layer,
+            .layer_count = range.layer_count,
+        };
+    }
+
+    // Executes one recorded command-buffer command from a batch (see ioctl_record_commands). The
+    // payload is the command's normal request struct. Returns the VkResult.
+    template <typename Host>
+    int32_t execute_recorded_command(Host& host, const gpu_command_replay_hooks& hooks, const uint32_t command, const std::byte* payload,
+                                     const size_t size)
+    {
+        constexpr int32_t vk_error_initialization_failed = -3; // VK_ERROR_INITIALIZATION_FAILED (no vulkan.h here)
+        const auto read = [&](auto& req) {
+            if (size < sizeof(req))
+            {
+                return false;
+            }
+            std::memcpy(&req, payload, sizeof(req));
+            return true;
+        };
+
+        switch (static_cast<gpu_bridge::command>(command))
+        {
+        case gpu_bridge::command::begin_command_buffer: {
+            gpu_bridge::begin_command_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<uint32_t> color_formats;
+            if (req.is_secondary && req.inherit_color_count > 0)
+            {
+                const size_t formats_bytes = static_cast<size_t>(req.inherit_color_count) * sizeof(uint32_t);
+                if (formats_bytes > size - sizeof(req))
+                {
+                    return vk_error_initialization_failed;
+                }
+                color_formats.resize(req.inherit_color_count);
+                std::memcpy(color_formats.data(), payload + sizeof(req), formats_bytes);
+            }
+            return host.begin_command_buffer(req.command_buffer, req.flags, req.is_secondary != 0, req.inherit_view_mask, color_formats,
+                                             req.inherit_depth_format, req.inherit_stencil_format, req.inherit_rasterization_samples,
+                                             req.inherit_rendering_flags);
+        }
+        case gpu_bridge::command::cmd_execute_commands: {
+            gpu_bridge::cmd_execute_commands_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t ids_bytes = static_cast<size_t>(req.count) * sizeof(gpu_bridge::object_id);
+            if (ids_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<uint64_t> secondaries(req.count);
+            if (req.count > 0)
+            {
+                std::memcpy(secondaries.data(), payload + sizeof(req), ids_bytes);
+            }
+            return host.cmd_execute_commands(req.command_buffer, secondaries);
+        }
+        case gpu_bridge::command::cmd_set_viewport: {
+            gpu_bridge::cmd_set_viewport_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            static_assert(sizeof(vulkan_host::viewport_entry) == sizeof(gpu_bridge::viewport_entry));
+            const size_t bytes = static_cast<size_t>(req.count) * sizeof(vulkan_host::viewport_entry);
+            if (bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<vulkan_host::viewport_entry> entries(req.count);
+            if (req.count > 0)
+            {
+                std::memcpy(entries.data(), payload + sizeof(req), bytes);
+            }
+            return host.cmd_set_viewport(req.command_buffer, req.first, req.with_count != 0, entries);
+        }
+        case gpu_bridge::command::cmd_set_scissor: {
+            gpu_bridge::cmd_set_scissor_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            static_assert(sizeof(vulkan_host::scissor_entry) == sizeof(gpu_bridge::scissor_entry));
+            const size_t bytes = static_cast<size_t>(req.count) * sizeof(vulkan_host::scissor_entry);
+            if (bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<vulkan_host::scissor_entry> entries(req.count);
+            if (req.count > 0)
+            {
+                std::memcpy(entries.data(), payload + sizeof(req), bytes);
+            }
+            return host.cmd_set_scissor(req.command_buffer, req.first, req.with_count != 0, entries);
+        }
+        case gpu_bridge::command::cmd_set_depth_bias: {
+            gpu_bridge::cmd_set_depth_bias_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_depth_bias(req.command_buffer, req.constant_factor, req.clamp, req.slope_factor);
+        }
+        case gpu_bridge::command::cmd_set_blend_constants: {
+            gpu_bridge::cmd_set_blend_constants_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_blend_constants(req.command_buffer, req.constants);
+        }
+        case gpu_bridge::command::cmd_set_depth_bounds: {
+            gpu_bridge::cmd_set_depth_bounds_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_depth_bounds(req.command_buffer, req.min_depth_bounds, req.max_depth_bounds);
+        }
+        case gpu_bridge::command::cmd_set_line_width: {
+            gpu_bridge::cmd_set_line_width_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_line_width(req.command_buffer, req.line_width);
+        }
+        case gpu_bridge::command::cmd_set_stencil: {
+            gpu_bridge::cmd_set_stencil_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_stencil(req.command_buffer, req.which, req.face_mask, req.value);
+        }
+        case gpu_bridge::command::cmd_set_stencil_op: {
+            gpu_bridge::cmd_set_stencil_op_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_stencil_op(req.command_buffer, req.face_mask, req.fail_op, req.pass_op, req.depth_fail_op, req.compare_op);
+        }
+        case gpu_bridge::command::cmd_set_dynamic_u32: {
+            gpu_bridge::cmd_set_dynamic_u32_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_set_dynamic_u32(req.command_buffer, req.state, req.value);
+        }
+        case gpu_bridge::command::end_command_buffer: {
+            gpu_bridge::end_command_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.end_command_buffer(req.command_buffer);
+        }
+        case gpu_bridge::command::queue_submit: {
+            gpu_bridge::queue_submit_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            hooks.before_submit();
+            return host.queue_submit(req.queue, req.command_buffer, req.fence);
+        }
+        case gpu_bridge::command::queue_submit2: {
+            gpu_bridge::queue_submit2_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t wait_bytes = static_cast<size_t>(req.wait_count) * sizeof(gpu_bridge::submit2_semaphore_entry);
+            const size_t cmd_bytes = static_cast<size_t>(req.command_buffer_count) * sizeof(uint64_t);
+            const size_t signal_bytes = static_cast<size_t>(req.signal_count) * sizeof(gpu_bridge::submit2_semaphore_entry);
+            if (wait_bytes + cmd_bytes + signal_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const std::byte* waits_begin = payload + sizeof(req);
+            const std::byte* cmds_begin = waits_begin + wait_bytes;
+            const std::byte* signals_begin = cmds_begin + cmd_bytes;
+            std::vector<gpu_bridge::submit2_semaphore_entry> waits(req.wait_count);
+            std::vector<uint64_t> command_buffers(req.command_buffer_count);
+            std::vector<gpu_bridge::submit2_semaphore_entry> signals(req.signal_count);
+            std::copy_n(waits_begin, wait_bytes, reinterpret_cast<std::byte*>(waits.data()));
+            std::copy_n(cmds_begin, cmd_bytes, reinterpret_cast<std::byte*>(command_buffers.data()));
+            std::copy_n(signals_begin, signal_bytes, reinterpret_cast<std::byte*>(signals.data()));
+            hooks.before_submit();
+            return host.queue_submit2(req.queue, req.fence, waits.data(), req.wait_count, command_buffers.data(), req.command_buffer_count,
+                                      signals.data(), req.signal_count);
+        }
+        case gpu_bridge::command::cmd_begin_render_pass: {
+            gpu_bridge::cmd_begin_render_pass_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_begin_render_pass(req.command_buffer, req.render_pass, req.framebuffer, req.width, req.height, req.clear_r,
+                                              req.clear_g, req.clear_b, req.clear_a, req.clear_depth);
+        }
+        case gpu_bridge::command::cmd_bind_pipeline: {
+            gpu_bridge::cmd_bind_pipeline_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_bind_pipeline(req.command_buffer, req.pipeline, req.bind_point);
+        }
+        case gpu_bridge::command::cmd_copy_buffer: {
+            gpu_bridge::cmd_copy_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t regions_bytes = static_cast<size_t>(req.region_count) * sizeof(gpu_bridge::buffer_copy_region);
+            if (regions_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<vulkan_host::buffer_copy> regions(req.region_count);
+            size_t region_offset = sizeof(req);
+            for (auto& region : regions)
+            {
+                gpu_bridge::buffer_copy_region r{};
+                std::memcpy(&r, payload + region_offset, sizeof(r));
+                region_offset += sizeof(r);
+                region = vulkan_host::buffer_copy{.src_offset = r.src_offset, .dst_offset = r.dst_offset, .size = r.size};
+            }
+            return host.cmd_copy_buffer(req.command_buffer, req.src_buffer, req.dst_buffer, regions);
+        }
+        case gpu_bridge::command::cmd_reset_query_pool: {
+            gpu_bridge::cmd_reset_query_pool_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_reset_query_pool(req.command_buffer, req.query_pool, req.first_query, req.query_count);
+        }
+        case gpu_bridge::command::cmd_begin_query: {
+            gpu_bridge::cmd_begin_query_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_begin_query(req.command_buffer, req.query_pool, req.query, req.flags);
+        }
+        case gpu_bridge::command::cmd_end_query: {
+            gpu_bridge::cmd_end_query_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_end_query(req.command_buffer, req.query_pool, req.query);
+        }
+        case gpu_bridge::command::cmd_begin_query_indexed: {
+            gpu_bridge::cmd_begin_query_indexed_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_begin_query_indexed(req.command_buffer, req.query_pool, req.query, req.flags, req.index);
+        }
+        case gpu_bridge::command::cmd_end_query_indexed: {
+            gpu_bridge::cmd_end_query_indexed_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_end_query_indexed(req.command_buffer, req.query_pool, req.query, req.index);
+        }
+        case gpu_bridge::command::cmd_bind_transform_feedback_buffers: {
+            gpu_bridge::cmd_bind_transform_feedback_buffers_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t bindings_bytes = size - sizeof(req);
+            if (bindings_bytes % sizeof(gpu_bridge::transform_feedback_buffer_binding) != 0 ||
+                req.binding_count != bindings_bytes / sizeof(gpu_bridge::transform_feedback_buffer_binding))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<uint64_t> buffers(req.binding_count);
+            std::vector<uint64_t> offsets(req.binding_count);
+            std::vector<uint64_t> sizes(req.binding_count);
+            size_t cursor = sizeof(req);
+            for (uint32_t i = 0; i < req.binding_count; ++i)
+            {
+                gpu_bridge::transform_feedback_buffer_binding binding{};
+                std::memcpy(&binding, payload + cursor, sizeof(binding));
+                cursor += sizeof(binding);
+                buffers[i] = binding.buffer;
+                offsets[i] = binding.offset;
+                sizes[i] = binding.size;
+            }
+            return host.cmd_bind_transform_feedback_buffers(req.command_buffer, req.first_binding, buffers, offsets, sizes);
+        }
+        case gpu_bridge::command::cmd_begin_transform_feedback:
+        case gpu_bridge::command::cmd_end_transform_feedback: {
+            gpu_bridge::cmd_transform_feedback_request req{};
+            if (!read(req) || req.has_counter_buffers > 1 || req.has_counter_buffer_offsets > 1)
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t counters_bytes = size - sizeof(req);
+            if (counters_bytes % sizeof(gpu_bridge::transform_feedback_counter_buffer) != 0 ||
+                req.counter_buffer_count != counters_bytes / sizeof(gpu_bridge::transform_feedback_counter_buffer))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<uint64_t> buffers(req.counter_buffer_count);
+            std::vector<uint64_t> offsets(req.counter_buffer_count);
+            size_t cursor = sizeof(req);
+            for (uint32_t i = 0; i < req.counter_buffer_count; ++i)
+            {
+                gpu_bridge::transform_feedback_counter_buffer counter{};
+                std::memcpy(&counter, payload + cursor, sizeof(counter));
+                cursor += sizeof(counter);
+                buffers[i] = counter.buffer;
+                offsets[i] = counter.offset;
+            }
+            if (static_cast<gpu_bridge::command>(command) == gpu_bridge::command::cmd_begin_transform_feedback)
+            {
+                return host.cmd_begin_transform_feedback(req.command_buffer, req.first_counter_buffer, buffers, offsets,
+                                                         req.has_counter_buffers != 0, req.has_counter_buffer_offsets != 0);
+            }
+            return host.cmd_end_transform_feedback(req.command_buffer, req.first_counter_buffer, buffers, offsets,
+                                                   req.has_counter_buffers != 0, req.has_counter_buffer_offsets != 0);
+        }
+        case gpu_bridge::command::cmd_draw_indirect_byte_count: {
+            gpu_bridge::cmd_draw_indirect_byte_count_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indirect_byte_count(req.command_buffer, req.instance_count, req.first_instance, req.counter_buffer,
+                                                     req.counter_buffer_offset, req.counter_offset, req.vertex_stride);
+        }
+        case gpu_bridge::command::cmd_write_timestamp: {
+            gpu_bridge::cmd_write_timestamp_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_write_timestamp(req.command_buffer, req.query_pool, req.query, req.pipeline_stage);
+        }
+        case gpu_bridge::command::cmd_write_timestamp2: {
+            gpu_bridge::cmd_write_timestamp2_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_write_timestamp2(req.command_buffer, req.query_pool, req.query, req.pipeline_stage);
+        }
+        case gpu_bridge::command::cmd_copy_query_pool_results: {
+            gpu_bridge::cmd_copy_query_pool_results_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_copy_query_pool_results(req.command_buffer, req.query_pool, req.first_query, req.query_count,
+                                                    req.destination_buffer, req.destination_offset, req.stride, req.flags);
+        }
+        case gpu_bridge::command::cmd_dispatch: {
+            gpu_bridge::cmd_dispatch_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_dispatch(req.command_buffer, req.group_count_x, req.group_count_y, req.group_count_z);
+        }
+        case gpu_bridge::command::cmd_dispatch_indirect: {
+            gpu_bridge::cmd_dispatch_indirect_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_dispatch_indirect(req.command_buffer, req.buffer, req.offset);
+        }
+        case gpu_bridge::command::cmd_push_constants: {
+            gpu_bridge::cmd_push_constants_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const auto data_bytes = std::min<uint64_t>(req.size, size - sizeof(req));
+            return host.cmd_push_constants(req.command_buffer, req.pipeline_layout, req.stage_flags, req.offset,
+                                           static_cast<uint32_t>(data_bytes), payload + sizeof(req));
+        }
+        case gpu_bridge::command::cmd_draw: {
+            gpu_bridge::cmd_draw_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw(req.command_buffer, req.vertex_count, req.instance_count, req.first_vertex, req.first_instance);
+        }
+        case gpu_bridge::command::cmd_bind_vertex_buffers: {
+            gpu_bridge::cmd_bind_vertex_buffers_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t bindings_bytes = static_cast<size_t>(req.binding_count) * sizeof(gpu_bridge::vertex_buffer_binding);
+            if (bindings_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            std::vector<uint64_t> buffer_ids(req.binding_count);
+            std::vector<uint64_t> offsets(req.binding_count);
+            auto buffer_id_out = buffer_ids.begin();
+            auto offset_out = offsets.begin();
+            size_t binding_offset = sizeof(req);
+            for (uint32_t i = 0; i < req.binding_count; ++i)
+            {
+                gpu_bridge::vertex_buffer_binding vb{};
+                std::memcpy(&vb, payload + binding_offset, sizeof(vb));
+                binding_offset += sizeof(vb);
+                *buffer_id_out = vb.buffer;
+                *offset_out = vb.offset;
+                ++buffer_id_out;
+                ++offset_out;
+            }
+            return host.cmd_bind_vertex_buffers(req.command_buffer, req.first_binding, req.binding_count, buffer_ids.data(),
+                                                offsets.data());
+        }
+        case gpu_bridge::command::cmd_bind_vertex_buffers2: {
+            gpu_bridge::cmd_bind_vertex_buffers2_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t bindings_bytes = static_cast<size_t>(req.binding_count) * sizeof(gpu_bridge::vertex_buffer_binding2);
+            if (bindings_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            // Reused scratch (single emulator thread, no reentrancy) - this path runs ~40k times/s
+            // in heavy scenes, so a per-call heap allocation here is pure overhead.
+            static thread_local std::vector<uint64_t> buffer_ids;
+            static thread_local std::vector<uint64_t> offsets;
+            static thread_local std::vector<uint64_t> sizes;
+            static thread_local std::vector<uint64_t> strides;
+            buffer_ids.resize(req.binding_count);
+            offsets.resize(req.binding_count);
+            sizes.resize(req.binding_count);
+            strides.resize(req.binding_count);
+            auto buffer_id_out = buffer_ids.begin();
+            auto offset_out = offsets.begin();
+            auto size_out = sizes.begin();
+            auto stride_out = strides.begin();
+            size_t binding_offset = sizeof(req);
+            for (uint32_t i = 0; i < req.binding_count; ++i)
+            {
+                gpu_bridge::vertex_buffer_binding2 vb{};
+                std::memcpy(&vb, payload + binding_offset, sizeof(vb));
+                binding_offset += sizeof(vb);
+                *buffer_id_out = vb.buffer;
+                *offset_out = vb.offset;
+                *size_out = vb.size;
+                *stride_out = vb.stride;
+                ++buffer_id_out;
+                ++offset_out;
+                ++size_out;
+                ++stride_out;
+            }
+            return host.cmd_bind_vertex_buffers2(req.command_buffer, req.first_binding, req.binding_count, buffer_ids.data(),
+                                                 offsets.data(), req.has_sizes ? sizes.data() : nullptr,
+                                                 req.has_strides ? strides.data() : nullptr);
+        }
+        case gpu_bridge::command::cmd_bind_index_buffer: {
+            gpu_bridge::cmd_bind_index_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_bind_index_buffer(req.command_buffer, req.buffer, req.offset, req.index_type);
+        }
+        case gpu_bridge::command::cmd_draw_indexed: {
+            gpu_bridge::cmd_draw_indexed_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indexed(req.command_buffer, req.index_count, req.instance_count, req.first_index, req.vertex_offset,
+                                         req.first_instance);
+        }
+        case gpu_bridge::command::cmd_draw_indexed_indirect: {
+            gpu_bridge::cmd_draw_indexed_indirect_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indexed_indirect(req.command_buffer, req.buffer, req.offset, req.draw_count, req.stride);
+        }
+        case gpu_bridge::command::cmd_draw_indexed_indirect_count: {
+            gpu_bridge::cmd_draw_indexed_indirect_count_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indexed_indirect_count(req.command_buffer, req.buffer, req.offset, req.count_buffer,
+                                                        req.count_buffer_offset, req.max_draw_count, req.stride);
+        }
+        case gpu_bridge::command::cmd_draw_indirect: {
+            gpu_bridge::cmd_draw_indirect_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indirect(req.command_buffer, req.buffer, req.offset, req.draw_count, req.stride);
+        }
+        case gpu_bridge::command::cmd_draw_indirect_count: {
+            gpu_bridge::cmd_draw_indirect_count_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_draw_indirect_count(req.command_buffer, req.buffer, req.offset, req.count_buffer, req.count_buffer_offset,
+                                                req.max_draw_count, req.stride);
+        }
+        case gpu_bridge::command::cmd_bind_descriptor_sets: {
+            gpu_bridge::cmd_bind_descriptor_sets_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t ids_bytes = static_cast<size_t>(req.set_count) * sizeof(gpu_bridge::object_id);
+            const size_t offsets_bytes = static_cast<size_t>(req.dynamic_offset_count) * sizeof(uint32_t);
+            if (ids_bytes + offsets_bytes > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            // Reused scratch (single emulator thread, no reentrancy) - this path runs ~100k times/s
+            // in heavy scenes, so a per-call heap allocation here is pure overhead.
+            static thread_local std::vector<uint64_t> sets;
+            static thread_local std::vector<uint32_t> dynamic_offsets;
+            sets.resize(req.set_count);
+            if (req.set_count > 0)
+            {
+                std::memcpy(sets.data(), payload + sizeof(req), ids_bytes);
+            }
+            dynamic_offsets.resize(req.dynamic_offset_count);
+            if (req.dynamic_offset_count > 0)
+            {
+                std::memcpy(dynamic_offsets.data(), payload + sizeof(req) + ids_bytes, offsets_bytes);
+            }
+            return host.cmd_bind_descriptor_sets(req.command_buffer, req.pipeline_layout, req.first_set, sets, req.bind_point,
+                                                 dynamic_offsets);
+        }
+        case gpu_bridge::command::cmd_end_render_pass: {
+            gpu_bridge::cmd_end_render_pass_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_end_render_pass(req.command_buffer);
+        }
+        case gpu_bridge::command::cmd_next_subpass: {
+            gpu_bridge::cmd_next_subpass_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_next_subpass(req.command_buffer, req.contents);
+        }
+        case gpu_bridge::command::cmd_begin_rendering: {
+            gpu_bridge::cmd_begin_rendering_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const size_t total =
+                static_cast<size_t>(req.color_attachment_count) + (req.has_depth ? 1u : 0u) + (req.has_stencil ? 1u : 0u);
+            if (total * sizeof(gpu_bridge::rendering_attachment) > size - sizeof(req))
+            {
+                return vk_error_initialization_failed;
+            }
+
+            const auto convert = [&](size_t index) {
+                gpu_bridge::rendering_attachment w{};
+                std::memcpy(&w, payload + sizeof(req) + index * sizeof(w), sizeof(w));
+                vulkan_host::rendering_attachment a{};
+                a.image_view = w.image_view;
+                a.resolve_image_view = w.resolve_image_view;
+                a.image_layout = w.image_layout;
+                a.resolve_image_layout = w.resolve_image_layout;
+                a.resolve_mode = w.resolve_mode;
+                a.load_op = w.load_op;
+                a.store_op = w.store_op;
+                std::memcpy(a.clear_value.data(), w.clear_value.data(), sizeof(a.clear_value));
+                return a;
+            };
+
+            size_t next = 0;
+            std::vector<vulkan_host::rendering_attachment> color(req.color_attachment_count);
+            for (auto& attachment : color)
+            {
+                attachment = convert(next++);
+            }
+            vulkan_host::rendering_attachment depth{};
+            vulkan_host::rendering_attachment stencil{};
+            if (req.has_depth)
+            {
+                depth = convert(next++);
+            }
+            if (req.has_stencil)
+            {
+                stencil = convert(next++);
+            }
+
+            return host.cmd_begin_rendering(req.command_buffer, req.render_area_x, req.render_area_y, req.render_area_width,
+                                            req.render_area_height, req.layer_count, req.view_mask, req.flags, color,
+                                            req.has_depth ? &depth : nullptr, req.has_stencil ? &stencil : nullptr);
+        }
+        case gpu_bridge::command::cmd_end_rendering: {
+            gpu_bridge::cmd_end_rendering_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_end_rendering(req.command_buffer);
+        }
+        case gpu_bridge::command::cmd_fill_buffer: {
+            gpu_bridge::cmd_fill_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_fill_buffer(req.command_buffer, req.buffer, req.offset, req.size, req.data);
+        }
+        case gpu_bridge::command::cmd_pipeline_barrier: {
+            gpu_bridge::cmd_pipeline_barrier_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_pipeline_barrier(req.command_buffer, req.image, req.src_stage_mask, req.dst_stage_mask, req.src_access_mask,
+                                             req.dst_access_mask, req.old_layout, req.new_layout, to_host_range(req.subresource));
+        }
+        case gpu_bridge::command::cmd_clear_color_image: {
+            gpu_bridge::cmd_clear_color_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_clear_color_image(req.command_buffer, req.image, req.image_layout, req.color_r, req.color_g, req.color_b,
+                                              req.color_a, to_host_range(req.subresource));
+        }
+        case gpu_bridge::command::cmd_clear_attachments: {
+            gpu_bridge::cmd_clear_attachments_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_clear_attachments(req.command_buffer, req.attachment_count, req.rect_count, payload + sizeof(req),
+                                              size - sizeof(req));
+        }
+        case gpu_bridge::command::cmd_clear_depth_stencil_image: {
+            gpu_bridge::cmd_clear_depth_stencil_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_clear_depth_stencil_image(req.command_buffer, req.image, req.image_layout, req.depth, req.stencil,
+                                                      to_host_range(req.subresource));
+        }
+        case gpu_bridge::command::cmd_copy_image_to_buffer: {
+            gpu_bridge::cmd_copy_image_to_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_copy_image_to_buffer(req.command_buffer, req.image, req.image_layout, req.buffer, req.width, req.height,
+                                                 req.aspect_mask);
+        }
+        case gpu_bridge::command::cmd_copy_buffer_to_image: {
+            gpu_bridge::cmd_copy_buffer_to_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const vulkan_host::buffer_image_copy_region region{
+                .buffer_offset = req.buffer_offset,
+                .buffer_row_length = req.buffer_row_length,
+                .buffer_image_height = req.buffer_image_height,
+                .image_offset_x = req.image_offset_x,
+                .image_offset_y = req.image_offset_y,
+                .image_offset_z = req.image_offset_z,
+                .width = req.width,
+                .height = req.height,
+                .depth = req.depth,
+                .mip_level = req.mip_level,
+                .base_array_layer = req.base_array_layer,
+                .layer_count = req.layer_count,
+                .aspect_mask = req.aspect_mask,
+            };
+            return host.cmd_copy_buffer_to_image(req.command_buffer, req.buffer, req.image, req.image_layout, region);
+        }
+        case gpu_bridge::command::cmd_resolve_image: {
+            gpu_bridge::cmd_resolve_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            return host.cmd_resolve_image(req.command_buffer, req.src_image, req.src_layout, req.dst_image, req.dst_layout, req.width,
+                                          req.height, req.aspect_mask);
+        }
+        case gpu_bridge::command::cmd_copy_image: {
+            gpu_bridge::cmd_copy_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const vulkan_host::image_copy_region region{
+                .src_aspect_mask = req.src_aspect_mask,
+                .src_mip_level = req.src_mip_level,
+                .src_base_array_layer = req.src_base_array_layer,
+                .src_layer_count = req.src_layer_count,
+                .src_offset_x = req.src_offset_x,
+                .src_offset_y = req.src_offset_y,
+                .src_offset_z = req.src_offset_z,
+                .dst_aspect_mask = req.dst_aspect_mask,
+                .dst_mip_level = req.dst_mip_level,
+                .dst_base_array_layer = req.dst_base_array_layer,
+                .dst_layer_count = req.dst_layer_count,
+                .dst_offset_x = req.dst_offset_x,
+                .dst_offset_y = req.dst_offset_y,
+                .dst_offset_z = req.dst_offset_z,
+                .width = req.width,
+                .height = req.height,
+                .depth = req.depth,
+            };
+            return host.cmd_copy_image(req.command_buffer, req.src_image, req.src_layout, req.dst_image, req.dst_layout, region);
+        }
+        case gpu_bridge::command::cmd_blit_image: {
+            gpu_bridge::cmd_blit_image_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const vulkan_host::image_blit_region region{
+                .src_aspect_mask = req.src_aspect_mask,
+                .src_mip_level = req.src_mip_level,
+                .src_base_array_layer = req.src_base_array_layer,
+                .src_layer_count = req.src_layer_count,
+                .src_offset_x0 = req.src_offset_x0,
+                .src_offset_y0 = req.src_offset_y0,
+                .src_offset_z0 = req.src_offset_z0,
+                .src_offset_x1 = req.src_offset_x1,
+                .src_offset_y1 = req.src_offset_y1,
+                .src_offset_z1 = req.src_offset_z1,
+                .dst_aspect_mask = req.dst_aspect_mask,
+                .dst_mip_level = req.dst_mip_level,
+                .dst_base_array_layer = req.dst_base_array_layer,
+                .dst_layer_count = req.dst_layer_count,
+                .dst_offset_x0 = req.dst_offset_x0,
+                .dst_offset_y0 = req.dst_offset_y0,
+                .dst_offset_z0 = req.dst_offset_z0,
+                .dst_offset_x1 = req.dst_offset_x1,
+                .dst_offset_y1 = req.dst_offset_y1,
+                .dst_offset_z1 = req.dst_offset_z1,
+                .filter = req.filter,
+            };
+            return host.cmd_blit_image(req.command_buffer, req.src_image, req.src_layout, req.dst_image, req.dst_layout, region);
+        }
+        case gpu_bridge::command::cmd_update_buffer: {
+            gpu_bridge::cmd_update_buffer_request req{};
+            if (!read(req))
+            {
+                return vk_error_initialization_failed;
+            }
+            const auto data_bytes = std::min<uint64_t>(req.size, size - sizeof(req));
+            return host.cmd_update_buffer(req.command_buffer, req.buffer, req.offset, payload + sizeof(req),
+                                          static_cast<uint32_t>(data_bytes));
+        }
+        default:
+            hooks.unsupported_command(command);
+            return vk_error_initialization_failed;
+        }
+    }
+
+    // Replays a batched command stream in order: the finished command-buffer recordings of a frame together
+    // with the submissions that follow them. Returns the first failure, so the guest sees it at its next
+    // submit. A truncated trailing record is dropped; everything before it has been replayed.
+    template <typename Host>
+    int32_t replay_command_stream(Host& host, const gpu_command_replay_hooks& hooks, const std::span<const std::byte> stream)
+    {
+        int32_t result = 0; // VK_SUCCESS
+        const auto replay = [&](const uint32_t command, const std::byte* payload, const size_t size) {
+            const int32_t r = execute_recorded_command(host, hooks, command, payload, size);
+            if (r != 0 && result == 0)
+            {
+                result = r; // report the first failure
+            }
+        };
+
+        (void)gpu_bridge::for_each_command_record(stream.data(), stream.size(), replay);
+        return result;
+    }
+}
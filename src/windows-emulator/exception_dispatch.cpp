@@ -260,7 +260,7 @@ namespace sogen
         CONTEXT64 ctx{};
         ctx.ContextFlags = CONTEXT64_ALL;
         cpu_context::save(vcpu.cpu, ctx);
-        ctx.Rip = win_emu.uses_instruction_precision() //
+        ctx.Rip = win_emu.tracks_current_instruction() //
                       ? thread.current_ip
                       : vcpu.cpu.read_instruction_pointer();
 
@@ -0,0 +1,378 @@
+#include "std_include.hpp"
+#include "free_gap_index.hpp"
+
+namespace sogen
+{
+    namespace
+    {
+        std::optional<uint64_t> checked_align_up(const uint64_t value, const uint64_t alignment)
+        {
+            if (value > UINT64_MAX - (alignment - 1))
+            {
+                return std::nullopt;
+            }
+
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    void free_gap_index::reset(const uint64_t begin, const uint64_t end, const uint64_t granularity)
+    {
+        this->nodes_.clear();
+        this->free_nodes_.clear();
+        this->root_ = NO_NODE;
+        this->count_ = 0;
+        this->begin_ = begin;
+        this->end_ = end;
+        this->granularity_ = granularity;
+
+        if (begin < end)
+        {
+            this->insert(begin, end);
+        }
+    }
+
+    void free_gap_index::reserve(uint64_t start, uint64_t end)
+    {
+        start = std::max(start, this->begin_);
+        end = std::min(end, this->end_);
+
+        if (start >= end)
+        {
+            return;
+        }
+
+        auto first = start;
+        if (const auto* previous = this->find_last_at_or_below(start); previous && previous->end > start)
+        {
+            first = previous->start;
+        }
+
+        for (const auto& gap : this->extract(first, end))
+        {
+            if (gap.start < start)
+            {
+                this->insert(gap.start, start);
+            }
+
+            if (gap.end > end)
+            {
+                this->insert(end, gap.end);
+            }
+        }
+    }
+
+    void free_gap_index::release(uint64_t start, uint64_t end)
+    {
+        start = std::max(start, this->begin_);
+        end = std::min(end, this->end_);
+
+        if (start >= end)
+        {
+            return;
+        }
+
+        // Gaps touching the released range on either side merge with it.
+        auto merged_start = start;
+        auto merged_end = end;
+
+        if (const auto* previous = this->find_last_at_or_below(start); previous && previous->end >= start)
+        {
+            merged_start = previous->start;
+        }
+
+        for (const auto& gap : this->extract(merged_start, end + 1))
+        {
+            merged_start = std::min(merged_start, gap.start);
+            merged_end = std::max(merged_end, gap.end);
+        }
+
+        this->insert(merged_start, merged_end);
+    }
+
+    std::optional<uint64_t> free_gap_index::find(const uint64_t from, const uint64_t size, const uint64_t alignment,
+                                                 uint64_t limit) const
+    {
+        limit = std::min(limit, this->end_);
+
+        if (size == 0 || size > limit)
+        {
+            return std::nullopt;
+        }
+
+        // Candidates only grow from gap to gap, so the first one ending past the limit ends the search.
+        bool exhausted = false;
+        const auto try_gap = [&](const uint64_t gap_start, const uint64_t gap_end) -> std::optional<uint64_t> {
+            const auto candidate = checked_align_up(std::max(gap_start, from), alignment);
+            if (!candidate || *candidate > limit - size)
+            {
+                exhausted = true;
+                return std::nullopt;
+            }
+
+            if (*candidate >= gap_end || gap_end - *candidate < size)
+            {
+                return std::nullopt;
+            }
+
+            return candidate;
+        };
+
+        if (const auto* containing = this->find_last_at_or_below(from); containing && containing->end > from)
+        {
+            if (const auto address = try_gap(containing->start, containing->end); address || exhausted)
+            {
+                return address;
+            }
+        }
+
+        auto after = from;
+        while (true)
+        {
+            const auto index = this->find_first_fit(this->root_, after, size);
+            if (index == NO_NODE)
+            {
+                return std::nullopt;
+            }
+
+            // Only granularity-aligned lengths are indexed, a coarser alignment may still not fit.
+            const auto& entry = this->nodes_[index];
+            if (const auto address = try_gap(entry.start, entry.end); address || exhausted)
+            {
+                return address;
+            }
+
+            after = entry.start;
+        }
+    }
+
+    std::vector<free_gap_index::gap> free_gap_index::get_gaps() const
+    {
+        std::vector<gap> gaps{};
+        gaps.reserve(this->count_);
+
+        std::vector<uint32_t> stack{};
+        auto current = this->root_;
+
+        while (current != NO_NODE || !stack.empty())
+        {
+            while (current != NO_NODE)
+            {
+                stack.push_back(current);
+                current = this->nodes_[current].left;
+            }
+
+            current = stack.back();
+            stack.pop_back();
+
+            gaps.push_back({.start = this->nodes_[current].start, .end = this->nodes_[current].end});
+            current = this->nodes_[current].right;
+        }
+
+        return gaps;
+    }
+
+    uint64_t free_gap_index::get_usable_length(const uint64_t start, const uint64_t end) const
+    {
+        const auto aligned_start = checked_align_up(start, this->granularity_);
+        if (!aligned_start || *aligned_start >= end)
+        {
+            return 0;
+        }
+
+        return end - *aligned_start;
+    }
+
+    uint32_t free_gap_index::allocate_node(const uint64_t start, const uint64_t end)
+    {
+        // xorshift32, the priorities only need to be spread well enough to keep the tree balanced.
+        this->seed_ ^= this->seed_ << 13;
+        this->seed_ ^= this->seed_ >> 17;
+        this->seed_ ^= this->seed_ << 5;
+
+        const node entry{
+            .start = start,
+            .end = end,
+            .max_usable_length = this->get_usable_length(start, end),
+            .priority = this->seed_,
+        };
+
+        if (!this->free_nodes_.empty())
+        {
+            const auto index = this->free_nodes_.back();
+            this->free_nodes_.pop_back();
+            this->nodes_[index] = entry;
+            return index;
+        }
+
+        this->nodes_.push_back(entry);
+        return static_cast<uint32_t>(this->nodes_.size() - 1);
+    }
+
+    void free_gap_index::update(const uint32_t index)
+    {
+        auto& entry = this->nodes_[index];
+        entry.max_usable_length = this->get_usable_length(entry.start, entry.end);
+
+        if (entry.left != NO_NODE)
+        {
+            entry.max_usable_length = std::max(entry.max_usable_length, this->nodes_[entry.left].max_usable_length);
+        }
+
+        if (entry.right != NO_NODE)
+        {
+            entry.max_usable_length = std::max(entry.max_usable_length, this->nodes_[entry.right].max_usable_length);
+        }
+    }
+
+    void free_gap_index::split(const uint32_t tree, const uint64_t key, uint32_t& left, uint32_t& right)
+    {
+        if (tree == NO_NODE)
+        {
+            left = NO_NODE;
+            right = NO_NODE;
+            return;
+        }
+
+        auto& entry = this->nodes_[tree];
+        if (entry.start < key)
+        {
+            this->split(entry.right, key, entry.right, right);
+            left = tree;
+        }
+        else
+        {
+            this->split(entry.left, key, left, entry.left);
+            right = tree;
+        }
+
+        this->update(tree);
+    }
+
+    uint32_t free_gap_index::merge(const uint32_t left, const uint32_t right)
+    {
+        if (left == NO_NODE)
+        {
+            return right;
+        }
+
+        if (right == NO_NODE)
+        {
+            return left;
+        }
+
+        if (this->nodes_[left].priority > this->nodes_[right].priority)
+        {
+            this->nodes_[left].right = this->merge(this->nodes_[left].right, right);
+            this->update(left);
+            return left;
+        }
+
+        this->nodes_[right].left = this->merge(left, this->nodes_[right].left);
+        this->update(right);
+        return right;
+    }
+
+    void free_gap_index::insert(const uint64_t start, const uint64_t end)
+    {
+        const auto index = this->allocate_node(start, end);
+
+        uint32_t left{};
+        uint32_t right{};
+        this->split(this->root_, start, left, right);
+
+        this->root_ = this->merge(this->merge(left, index), right);
+        ++this->count_;
+    }
+
+    std::vector<free_gap_index::gap> free_gap_index::extract(const uint64_t begin, const uint64_t end)
+    {
+        uint32_t left{};
+        uint32_t rest{};
+        uint32_t middle{};
+        uint32_t right{};
+
+        this->split(this->root_, begin, left, rest);
+        this->split(rest, end, middle, right);
+        this->root_ = this->merge(left, right);
+
+        std::vector<gap> gaps{};
+        std::vector<uint32_t> stack{};
+        if (middle != NO_NODE)
+        {
+            stack.push_back(middle);
+        }
+
+        while (!stack.empty())
+        {
+            const auto index = stack.back();
+            stack.pop_back();
+
+            const auto& entry = this->nodes_[index];
+            gaps.push_back({.start = entry.start, .end = entry.end});
+
+            if (entry.left != NO_NODE)
+            {
+                stack.push_back(entry.left);
+            }
+
+            if (entry.right != NO_NODE)
+            {
+                stack.push_back(entry.right);
+            }
+
+            this->free_nodes_.push_back(index);
+        }
+
+        this->count_ -= gaps.size();
+        return gaps;
+    }
+
+    const free_gap_index::node* free_gap_index::find_last_at_or_below(const uint64_t address) const
+    {
+        const node* result = nullptr;
+        auto current = this->root_;
+
+        while (current != NO_NODE)
+        {
+            const auto& entry = this->nodes_[current];
+            if (entry.start <= address)
+            {
+                result = &entry;
+                current = entry.right;
+            }
+            else
+            {
+                current = entry.left;
+            }
+        }
+
+        return result;
+    }
+
+    uint32_t free_gap_index::find_first_fit(const uint32_t tree, const uint64_t after, const uint64_t size) const
+    {
+        if (tree == NO_NODE || this->nodes_[tree].max_usable_length < size)
+        {
+            return NO_NODE;
+        }
+
+        const auto& entry = this->nodes_[tree];
+        if (entry.start <= after)
+        {
+            return this->find_first_fit(entry.right, after, size);
+        }
+
+        if (const auto result = this->find_first_fit(entry.left, after, size); result != NO_NODE)
+        {
+            return result;
+        }
+
+        if (this->get_usable_length(entry.start, entry.end) >= size)
+        {
+            return tree;
+        }
+
+        return this->find_first_fit(entry.right, after, size);
+    }
+} // namespace sogen
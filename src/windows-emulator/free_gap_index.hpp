@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace sogen
+{
+    // The unreserved parts of an address range, kept as a treap of gaps keyed by start address. Every node
+    // also knows the largest gap in its subtree, so the lowest gap that can hold an allocation is found in
+    // logarithmic time instead of walking every reservation below it. Gap sizes are measured from the start
+    // aligned to the allocation granularity: page-sized reservations leave lots of sub-granularity slack
+    // behind, which must not look usable. Nodes live in one vector and refer to each other by index.
+    class free_gap_index
+    {
+      public:
+        struct gap
+        {
+            uint64_t start{};
+            uint64_t end{};
+        };
+
+        // Marks all of [begin, end) free. Reservations outside of it are ignored later on.
+        void reset(uint64_t begin, uint64_t end, uint64_t granularity);
+
+        void reserve(uint64_t start, uint64_t end);
+        void release(uint64_t start, uint64_t end);
+
+        // Lowest address >= from, aligned to `alignment` (a power of two, at least the granularity), where
+        // [address, address + size) is free and ends at or below `limit`.
+        std::optional<uint64_t> find(uint64_t from, uint64_t size, uint64_t alignment, uint64_t limit) const;
+
+        std::vector<gap> get_gaps() const;
+
+        size_t size() const
+        {
+            return this->count_;
+        }
+
+      private:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        struct node
+        {
+            uint64_t start{};
+            uint64_t end{};
+            uint64_t max_usable_length{};
+            uint32_t priority{};
+            uint32_t left{NO_NODE};
+            uint32_t right{NO_NODE};
+        };
+
+        std::vector<node> nodes_{};
+        std::vector<uint32_t> free_nodes_{};
+        uint32_t root_{NO_NODE};
+        size_t count_{};
+        uint64_t begin_{};
+        uint64_t end_{};
+        uint64_t granularity_{1};
+        uint32_t seed_{0x9E3779B9};
+
+        uint64_t get_usable_length(uint64_t start, uint64_t end) const;
+        uint32_t allocate_node(uint64_t start, uint64_t end);
+        void update(uint32_t index);
+
+        // Splits the tree into gaps starting below `key` and gaps starting at or above it.
+        void split(uint32_t tree, uint64_t key, uint32_t& left, uint32_t& right);
+        uint32_t merge(uint32_t left, uint32_t right);
+
+        void insert(uint64_t start, uint64_t end);
+        std::vector<gap> extract(uint64_t begin, uint64_t end);
+
+        const node* find_last_at_or_below(uint64_t address) const;
+        uint32_t find_first_fit(uint32_t tree, uint64_t after, uint64_t size) const;
+    };
+} // namespace sogen
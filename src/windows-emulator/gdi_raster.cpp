@@ -0,0 +1,629 @@
+#include "std_include.hpp"
+#include "gdi_raster.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX2__)
+#define SOGEN_GDI_RASTER_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOGEN_GDI_RASTER_SSE2 1
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define SOGEN_GDI_RASTER_SSSE3 1
+#endif
+
+#if defined(SOGEN_GDI_RASTER_AVX2) || defined(SOGEN_GDI_RASTER_SSE2)
+#include <immintrin.h>
+#endif
+
+namespace sogen::gdi_raster
+{
+    namespace
+    {
+        uint32_t bit_and(const uint32_t a, const uint32_t b)
+        {
+            return a & b;
+        }
+
+        uint32_t bit_or(const uint32_t a, const uint32_t b)
+        {
+            return a | b;
+        }
+
+        uint32_t bit_not(const uint32_t a)
+        {
+            return ~a;
+        }
+
+        uint32_t zero_like(uint32_t)
+        {
+            return 0;
+        }
+
+#if defined(SOGEN_GDI_RASTER_AVX2)
+#define SOGEN_GDI_RASTER_VECTOR 1
+
+        using pixel_vector = __m256i;
+        constexpr size_t vector_pixels = 8;
+
+        pixel_vector load(const uint32_t* pixels)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+        }
+
+        void store(uint32_t* pixels, const pixel_vector value)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value);
+        }
+
+        pixel_vector broadcast(const uint32_t value)
+        {
+            return _mm256_set1_epi32(static_cast<int>(value));
+        }
+
+        pixel_vector bit_and(const pixel_vector a, const pixel_vector b)
+        {
+            return _mm256_and_si256(a, b);
+        }
+
+        pixel_vector bit_or(const pixel_vector a, const pixel_vector b)
+        {
+            return _mm256_or_si256(a, b);
+        }
+
+        pixel_vector bit_not(const pixel_vector a)
+        {
+            return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+        }
+
+        pixel_vector zero_like(pixel_vector)
+        {
+            return _mm256_setzero_si256();
+        }
+
+        // Lanes whose bit in `mask` is set, lane 0 in bit 0.
+        pixel_vector expand_mask(const uint8_t mask)
+        {
+            const auto bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(mask), bits), bits);
+        }
+
+        pixel_vector select(const pixel_vector mask, const pixel_vector if_set, const pixel_vector if_clear)
+        {
+            return _mm256_blendv_epi8(if_clear, if_set, mask);
+        }
+#elif defined(SOGEN_GDI_RASTER_SSE2)
+#define SOGEN_GDI_RASTER_VECTOR 1
+
+        using pixel_vector = __m128i;
+        constexpr size_t vector_pixels = 4;
+
+        pixel_vector load(const uint32_t* pixels)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        }
+
+        void store(uint32_t* pixels, const pixel_vector value)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), value);
+        }
+
+        pixel_vector broadcast(const uint32_t value)
+        {
+            return _mm_set1_epi32(static_cast<int>(value));
+        }
+
+        pixel_vector bit_and(const pixel_vector a, const pixel_vector b)
+        {
+            return _mm_and_si128(a, b);
+        }
+
+        pixel_vector bit_or(const pixel_vector a, const pixel_vector b)
+        {
+            return _mm_or_si128(a, b);
+        }
+
+        pixel_vector bit_not(const pixel_vector a)
+        {
+            return _mm_xor_si128(a, _mm_set1_epi32(-1));
+        }
+
+        pixel_vector zero_like(pixel_vector)
+        {
+            return _mm_setzero_si128();
+        }
+
+        // Lanes whose bit in `mask` is set, lane 0 in bit 0. Only the low four bits are used.
+        pixel_vector expand_mask(const uint8_t mask)
+        {
+            const auto bits = _mm_setr_epi32(1, 2, 4, 8);
+            return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(mask), bits), bits);
+        }
+
+        pixel_vector select(const pixel_vector mask, const pixel_vector if_set, const pixel_vector if_clear)
+        {
+            return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+        }
+#endif
+
+        // Shared by the scalar and the vector paths so both compute exactly the same function.
+        template <typename T>
+        T evaluate_rop3(const uint8_t rop3, const T src, const T dst, const T pat)
+        {
+            const T not_dst = bit_not(dst);
+            const T not_src = bit_not(src);
+            const T not_pat = bit_not(pat);
+
+            T out = zero_like(dst);
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                if (((rop3 >> i) & 1u) != 0)
+                {
+                    const T d = (i & 1u) ? dst : not_dst;
+                    const T s = (i & 2u) ? src : not_src;
+                    const T p = (i & 4u) ? pat : not_pat;
+                    out = bit_or(out, bit_and(bit_and(d, s), p));
+                }
+            }
+
+            return out;
+        }
+
+        void fill_row(uint32_t* dst, const size_t count, const uint32_t color)
+        {
+            size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_VECTOR)
+            const auto value = broadcast(color);
+            for (; i + vector_pixels <= count; i += vector_pixels)
+            {
+                store(dst + i, value);
+            }
+#endif
+
+            for (; i < count; ++i)
+            {
+                dst[i] = color;
+            }
+        }
+
+        void copy_row_opaque(uint32_t* dst, const uint32_t* src, const size_t count)
+        {
+            size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_VECTOR)
+            const auto alpha = broadcast(opaque_alpha);
+            for (; i + vector_pixels <= count; i += vector_pixels)
+            {
+                store(dst + i, bit_or(load(src + i), alpha));
+            }
+#endif
+
+            for (; i < count; ++i)
+            {
+                dst[i] = src[i] | opaque_alpha;
+            }
+        }
+
+        // dst = rop3(src, dst, pattern) | opaque_alpha. A null src reads as zero, for ROPs that ignore it.
+        void rop_row(uint32_t* dst, const uint32_t* src, const size_t count, const uint8_t rop3, const uint32_t pattern)
+        {
+            switch (rop3)
+            {
+            case rop3_srccopy:
+                copy_row_opaque(dst, src, count);
+                return;
+            case rop3_patcopy:
+                fill_row(dst, count, pattern | opaque_alpha);
+                return;
+            case 0x00:
+                fill_row(dst, count, opaque_alpha);
+                return;
+            case 0xFF:
+                fill_row(dst, count, 0xFFFFFFFFu);
+                return;
+            default:
+                break;
+            }
+
+            size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_VECTOR)
+            const auto pat = broadcast(pattern);
+            const auto alpha = broadcast(opaque_alpha);
+            const auto no_source = broadcast(0);
+
+            for (; i + vector_pixels <= count; i += vector_pixels)
+            {
+                const auto s = src ? load(src + i) : no_source;
+                store(dst + i, bit_or(evaluate_rop3(rop3, s, load(dst + i), pat), alpha));
+            }
+#endif
+
+            for (; i < count; ++i)
+            {
+                dst[i] = evaluate_rop3<uint32_t>(rop3, src ? src[i] : 0, dst[i], pattern) | opaque_alpha;
+            }
+        }
+
+        uint32_t* row_at(const surface_view& surface, const int64_t x, const int64_t y)
+        {
+            return surface.pixels + static_cast<size_t>(y) * surface.stride + static_cast<size_t>(x);
+        }
+
+        // Range of `count` consecutive steps whose target position base + step (or, mirrored,
+        // base + count - 1 - step) lies within [0, limit).
+        std::pair<int64_t, int64_t> clip_steps(const int64_t base, const int64_t count, const bool mirrored, const int64_t limit)
+        {
+            if (mirrored)
+            {
+                return {std::max<int64_t>(0, base + count - limit), std::min<int64_t>(count, base + count)};
+            }
+
+            return {std::max<int64_t>(0, -base), std::min<int64_t>(count, limit - base)};
+        }
+    }
+
+    bool rop3_uses_source(const uint8_t rop3)
+    {
+        // If changing S can change the output for any D/P pair, the source is required.
+        return ((rop3 >> 2) & 0x33u) != (rop3 & 0x33u);
+    }
+
+    uint32_t apply_rop3(const uint8_t rop3, const uint32_t src, const uint32_t dst, const uint32_t pat)
+    {
+        return evaluate_rop3(rop3, src, dst, pat);
+    }
+
+    void fill_rect(const surface_view& surface, int64_t left, int64_t top, int64_t right, int64_t bottom, const uint32_t color)
+    {
+        left = std::max<int64_t>(left, 0);
+        top = std::max<int64_t>(top, 0);
+        right = std::min<int64_t>(right, surface.width);
+        bottom = std::min<int64_t>(bottom, surface.height);
+
+        if (left >= right || top >= bottom)
+        {
+            return;
+        }
+
+        for (auto y = top; y < bottom; ++y)
+        {
+            fill_row(row_at(surface, left, y), static_cast<size_t>(right - left), color);
+        }
+    }
+
+    void bit_blt(const surface_view& dst, int64_t x_dst, int64_t y_dst, int64_t width, int64_t height, const surface_view* src,
+                 int64_t x_src, int64_t y_src, const uint8_t rop3, const uint32_t pattern)
+    {
+        const bool needs_source = rop3_uses_source(rop3);
+        if (needs_source && !src)
+        {
+            return;
+        }
+
+        const auto clip_axis = [&](int64_t& d, int64_t& s, int64_t& length, const int64_t limit) {
+            if (d < 0)
+            {
+                s -= d;
+                length += d;
+                d = 0;
+            }
+
+            length = std::min(length, limit - d);
+        };
+
+        clip_axis(x_dst, x_src, width, dst.width);
+        clip_axis(y_dst, y_src, height, dst.height);
+
+        if (needs_source)
+        {
+            clip_axis(x_src, x_dst, width, src->width);
+            clip_axis(y_src, y_dst, height, src->height);
+        }
+
+        if (width <= 0 || height <= 0)
+        {
+            return;
+        }
+
+        // On a shared surface, rows are processed away from the source so none is overwritten before it was
+        // read, and a row overlapping its own source is copied out first.
+        const bool same_surface = needs_source && src->pixels == dst.pixels;
+        const bool bottom_up = same_surface && y_dst > y_src;
+        const auto count = static_cast<size_t>(width);
+
+        std::vector<uint32_t> row_copy{};
+
+        for (int64_t i = 0; i < height; ++i)
+        {
+            const auto row = bottom_up ? height - 1 - i : i;
+            auto* dst_row = row_at(dst, x_dst, y_dst + row);
+            const uint32_t* src_row = needs_source ? row_at(*src, x_src, y_src + row) : nullptr;
+
+            if (same_surface && src_row < dst_row + count && dst_row < src_row + count)
+            {
+                row_copy.assign(src_row, src_row + count);
+                src_row = row_copy.data();
+            }
+
+            rop_row(dst_row, src_row, count, rop3, pattern);
+        }
+    }
+
+    void stretch_blt(const surface_view& dst, const int32_t x_dst, const int32_t y_dst, const int32_t dst_width, const int32_t dst_height,
+                     const surface_view* src, const int32_t x_src, const int32_t y_src, const int32_t src_width, const int32_t src_height,
+                     const uint8_t rop3, const uint32_t pattern)
+    {
+        const bool needs_source = rop3_uses_source(rop3);
+        if ((needs_source && !src) || dst_width == 0 || dst_height == 0 || src_width == 0 || src_height == 0)
+        {
+            return;
+        }
+
+        const int64_t dst_w = std::abs(static_cast<int64_t>(dst_width));
+        const int64_t dst_h = std::abs(static_cast<int64_t>(dst_height));
+        const int64_t src_w = std::abs(static_cast<int64_t>(src_width));
+        const int64_t src_h = std::abs(static_cast<int64_t>(src_height));
+        const bool flip_x = dst_width < 0;
+        const bool flip_y = dst_height < 0;
+        const bool flip_src_x = src_width < 0;
+        const bool flip_src_y = src_height < 0;
+
+        const auto [first_x, end_x] = clip_steps(x_dst, dst_w, flip_x, dst.width);
+        const auto [first_y, end_y] = clip_steps(y_dst, dst_h, flip_y, dst.height);
+        if (first_x >= end_x || first_y >= end_y)
+        {
+            return;
+        }
+
+        // Source column for each destination column in [out_x, out_x + columns); the sampled source columns of
+        // a row form one contiguous run of destination columns, since sampling is monotonic.
+        std::vector<int32_t> source_columns{};
+        int64_t out_x = 0;
+
+        if (needs_source)
+        {
+            int64_t first_out = INT64_MAX;
+            int64_t last_out = INT64_MIN;
+
+            source_columns.reserve(static_cast<size_t>(end_x - first_x));
+
+            for (auto dx = first_x; dx < end_x; ++dx)
+            {
+                const auto src_dx = dx * src_w / dst_w;
+                const auto sx = x_src + (flip_src_x ? src_w - 1 - src_dx : src_dx);
+                if (sx < 0 || sx >= src->width)
+                {
+                    continue;
+                }
+
+                const auto target = x_dst + (flip_x ? dst_w - 1 - dx : dx);
+                first_out = std::min(first_out, target);
+                last_out = std::max(last_out, target);
+                source_columns.push_back(static_cast<int32_t>(sx));
+            }
+
+            if (source_columns.empty())
+            {
+                return;
+            }
+
+            if (flip_x)
+            {
+                std::reverse(source_columns.begin(), source_columns.end());
+            }
+
+            out_x = first_out;
+            assert(static_cast<size_t>(last_out - first_out + 1) == source_columns.size());
+        }
+        else
+        {
+            out_x = flip_x ? x_dst + dst_w - end_x : x_dst + first_x;
+        }
+
+        const auto columns = needs_source ? source_columns.size() : static_cast<size_t>(end_x - first_x);
+
+        // Sampling from the surface being drawn to reads a copy, so earlier rows can't feed later ones.
+        std::vector<uint32_t> source_copy{};
+        surface_view source{};
+        if (needs_source)
+        {
+            source = *src;
+
+            if (src->pixels == dst.pixels)
+            {
+                source_copy.assign(src->pixels, src->pixels + static_cast<size_t>(src->height) * src->stride);
+                source.pixels = source_copy.data();
+            }
+        }
+
+        std::vector<uint32_t> gathered(needs_source ? columns : 0);
+
+        for (auto dy = first_y; dy < end_y; ++dy)
+        {
+            const auto out_y = y_dst + (flip_y ? dst_h - 1 - dy : dy);
+
+            if (needs_source)
+            {
+                const auto src_dy = dy * src_h / dst_h;
+                const auto sy = y_src + (flip_src_y ? src_h - 1 - src_dy : src_dy);
+                if (sy < 0 || sy >= source.height)
+                {
+                    continue;
+                }
+
+                const auto* src_row = row_at(source, 0, sy);
+                for (size_t i = 0; i < columns; ++i)
+                {
+                    gathered[i] = src_row[source_columns[i]];
+                }
+            }
+
+            rop_row(row_at(dst, out_x, out_y), needs_source ? gathered.data() : nullptr, columns, rop3, pattern);
+        }
+    }
+
+    void draw_glyph(const surface_view& surface, const int32_t x, const int32_t y, const std::span<const uint8_t> rows,
+                    const uint32_t color, const RECT* clip)
+    {
+        constexpr int32_t glyph_width = 8;
+
+        // Columns left visible by the surface and the clip rectangle, as a mask over the glyph's row bits.
+        auto left = std::max<int64_t>(x, 0);
+        auto right = std::min<int64_t>(static_cast<int64_t>(x) + glyph_width, surface.width);
+        auto top = std::max<int64_t>(y, 0);
+        auto bottom = std::min<int64_t>(static_cast<int64_t>(y) + static_cast<int64_t>(rows.size()), surface.height);
+
+        if (clip)
+        {
+            left = std::max<int64_t>(left, clip->left);
+            right = std::min<int64_t>(right, clip->right);
+            top = std::max<int64_t>(top, clip->top);
+            bottom = std::min<int64_t>(bottom, clip->bottom);
+        }
+
+        if (left >= right || top >= bottom)
+        {
+            return;
+        }
+
+        const auto visible = static_cast<uint8_t>(((1u << (right - left)) - 1u) << (left - x));
+        const bool whole_span = left == x && right == static_cast<int64_t>(x) + glyph_width;
+
+        for (auto row_y = top; row_y < bottom; ++row_y)
+        {
+            const auto bits = static_cast<uint8_t>(rows[static_cast<size_t>(row_y - y)] & visible);
+            if (bits == 0)
+            {
+                continue;
+            }
+
+            auto* dst = row_at(surface, x, row_y);
+
+#if defined(SOGEN_GDI_RASTER_VECTOR)
+            if (whole_span)
+            {
+                const auto value = broadcast(color);
+                for (size_t i = 0; i < glyph_width; i += vector_pixels)
+                {
+                    const auto mask = expand_mask(static_cast<uint8_t>(bits >> i));
+                    store(dst + i, select(mask, value, load(dst + i)));
+                }
+
+                continue;
+            }
+#else
+            (void)whole_span;
+#endif
+
+            for (int32_t col = 0; col < glyph_width; ++col)
+            {
+                if ((bits & (1u << col)) != 0)
+                {
+                    dst[col] = color;
+                }
+            }
+        }
+    }
+
+    void convert_bgr24_to_bgra(const uint8_t* src, uint32_t* dst, const size_t count)
+    {
+        size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_AVX2)
+        // Eight pixels per step from two 16-byte loads 12 bytes apart; the last one reads up to 28 bytes ahead.
+        const auto spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, //
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const auto alpha = _mm256_set1_epi32(static_cast<int>(opaque_alpha));
+
+        for (; i + 10 <= count; i += 8)
+        {
+            const auto* bytes = src + i * 3;
+            const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+            const auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 12));
+            const auto packed = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(packed, spread), alpha));
+        }
+#elif defined(SOGEN_GDI_RASTER_SSSE3)
+        const auto spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const auto alpha = _mm_set1_epi32(static_cast<int>(opaque_alpha));
+
+        for (; i + 6 <= count; i += 4)
+        {
+            const auto packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(packed, spread), alpha));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const auto* px = src + i * 3;
+            dst[i] = static_cast<uint32_t>(px[0]) | (static_cast<uint32_t>(px[1]) << 8) | (static_cast<uint32_t>(px[2]) << 16) |
+                     opaque_alpha;
+        }
+    }
+
+    void convert_bgrx32_to_bgra(const uint8_t* src, uint32_t* dst, const size_t count)
+    {
+        size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_VECTOR)
+        const auto alpha = broadcast(opaque_alpha);
+        for (; i + vector_pixels <= count; i += vector_pixels)
+        {
+            pixel_vector value{};
+            memcpy(&value, src + i * sizeof(uint32_t), sizeof(value));
+            store(dst + i, bit_or(value, alpha));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            uint32_t pixel{};
+            memcpy(&pixel, src + i * sizeof(uint32_t), sizeof(pixel));
+            dst[i] = pixel | opaque_alpha;
+        }
+    }
+
+    void convert_bgra_to_bgr24(const uint32_t* src, uint8_t* dst, const size_t count)
+    {
+        size_t i = 0;
+
+#if defined(SOGEN_GDI_RASTER_AVX2)
+        // Packs each lane's four pixels into its low 12 bytes, then moves the two runs together. Every store
+        // writes 32 bytes of which 24 are kept, so it stops while 32 bytes of the row are left.
+        const auto pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, //
+                                           0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const auto join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+        for (; i + 11 <= count; i += 8)
+        {
+            const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            const auto packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels, pack), join);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 3), packed);
+        }
+#elif defined(SOGEN_GDI_RASTER_SSSE3)
+        const auto pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+        for (; i + 6 <= count; i += 4)
+        {
+            const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(pixels, pack));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const auto pixel = src[i];
+            auto* px = dst + i * 3;
+            px[0] = static_cast<uint8_t>(pixel);
+            px[1] = static_cast<uint8_t>(pixel >> 8);
+            px[2] = static_cast<uint8_t>(pixel >> 16);
+        }
+    }
+}
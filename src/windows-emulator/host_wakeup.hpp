@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace sogen
+{
+    // What an idle vCPU blocks on instead of sleeping in fixed steps. Anything that can make a guest thread
+    // runnable from outside the idle vCPU (a host thread signaling a guest event, another vCPU waking a parked
+    // thread) calls notify(). Waiters take the generation before deciding to sleep, so a notification that
+    // lands in between is never lost.
+    class host_wakeup
+    {
+      public:
+        uint64_t get_generation() const
+        {
+            return this->generation_.load(std::memory_order_acquire);
+        }
+
+        void notify()
+        {
+            {
+                const std::scoped_lock lock(this->mutex_);
+                this->generation_.fetch_add(1, std::memory_order_release);
+            }
+
+            this->condition_.notify_all();
+        }
+
+        // Returns true if notified, false once the deadline passed.
+        bool wait_until(const uint64_t seen_generation, const std::chrono::steady_clock::time_point deadline)
+        {
+            std::unique_lock lock(this->mutex_);
+            return this->condition_.wait_until(lock, deadline, [&] {
+                return this->generation_.load(std::memory_order_relaxed) != seen_generation; //
+            });
+        }
+
+      private:
+        std::mutex mutex_{};
+        std::condition_variable condition_{};
+        std::atomic<uint64_t> generation_{0};
+    };
+} // namespace sogen
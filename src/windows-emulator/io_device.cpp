@@ -161,6 +161,7 @@ namespace sogen
             if (auto* e = win_emu.process.events.get(c.event); e)
             {
                 e->signaled = true;
+                win_emu.process.scheduler.notify_object(c.event);
             }
         }
 
@@ -180,6 +181,12 @@ namespace sogen
         this->device_->work(win_emu);
     }
 
+    void io_device_container::collect_wait(io_device_wait& wait)
+    {
+        this->assert_validity();
+        this->device_->collect_wait(wait);
+    }
+
     void io_device_container::serialize_object(utils::buffer_serializer& buffer) const
     {
         this->assert_validity();
@@ -8,6 +8,7 @@
 
 #include "emulator_utils.hpp"
 #include "handles.hpp"
+#include "network/socket_factory.hpp"
 
 namespace sogen
 {
@@ -94,6 +95,14 @@ namespace sogen
         return status;
     }
 
+    // What an idle vCPU has to wait for on behalf of a device before its work() has something to do.
+    struct io_device_wait
+    {
+        std::vector<network::poll_entry> sockets{};
+        std::optional<std::chrono::steady_clock::time_point> deadline{};
+        bool needs_polling{};
+    };
+
     struct io_device : ref_counted_object
     {
         io_device() = default;
@@ -118,6 +127,11 @@ namespace sogen
             (void)win_emu;
         }
 
+        virtual void collect_wait(io_device_wait& wait)
+        {
+            (void)wait;
+        }
+
         NTSTATUS execute_ioctl(windows_emulator& win_emu, const io_device_context& c);
     };
 
@@ -170,6 +184,7 @@ namespace sogen
         }
 
         void work(windows_emulator& win_emu) override;
+        void collect_wait(io_device_wait& wait) override;
         NTSTATUS io_control(windows_emulator& win_emu, const io_device_context& context) override;
 
         void serialize_object(utils::buffer_serializer& buffer) const override;
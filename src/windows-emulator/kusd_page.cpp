@@ -1,5 +1,5 @@
 #include "std_include.hpp"
-#include "kusd_mmio.hpp"
+#include "kusd_page.hpp"
 #include <utils/time.hpp>
 #include <utils/string.hpp>
 #include "windows_emulator.hpp"
@@ -120,42 +120,60 @@ namespace sogen
         }
     }
 
-    kusd_mmio::kusd_mmio(memory_manager& memory, utils::clock& clock)
+    kusd_page::kusd_page(memory_manager& memory, utils::clock& clock)
         : memory_(&memory),
           clock_(&clock)
     {
     }
 
-    kusd_mmio::~kusd_mmio()
+    kusd_page::~kusd_page()
     {
-        this->deregister_mmio();
+        this->unmap();
     }
 
-    kusd_mmio::kusd_mmio(utils::buffer_deserializer& buffer)
-        : kusd_mmio(buffer.read<memory_manager_wrapper>(), buffer.read<clock_wrapper>())
+    kusd_page::kusd_page(utils::buffer_deserializer& buffer)
+        : kusd_page(buffer.read<memory_manager_wrapper>(), buffer.read<clock_wrapper>())
     {
     }
 
-    void kusd_mmio::setup(const windows_version_manager& version, const fake_environment_config& fake_env)
+    void kusd_page::setup(const windows_version_manager& version, const fake_environment_config& fake_env)
     {
         setup_kusd(this->kusd_, version, fake_env);
-        this->register_mmio();
+        this->map();
     }
 
-    void kusd_mmio::serialize(utils::buffer_serializer& buffer) const
+    void kusd_page::serialize(utils::buffer_serializer& buffer) const
     {
         buffer.write(this->kusd_);
     }
 
-    void kusd_mmio::deserialize(utils::buffer_deserializer& buffer)
+    void kusd_page::deserialize(utils::buffer_deserializer& buffer)
     {
         buffer.read(this->kusd_);
 
-        this->deregister_mmio();
-        this->register_mmio();
+        // Memory is restored first: the page comes back with it, while MMIO regions are dropped and
+        // must be registered again.
+        switch (this->memory_->get_region_kind(KUSD_ADDRESS))
+        {
+        case memory_region_kind::free:
+            this->backing_ = backing::none;
+            this->map();
+            break;
+
+        case memory_region_kind::mmio:
+            this->backing_ = backing::mmio;
+            break;
+
+        default:
+            this->backing_ = backing::page;
+            break;
+        }
+
+        const std::lock_guard lock{this->mutex_};
+        this->publish(0, KUSD_SIZE);
     }
 
-    void kusd_mmio::read(const uint64_t addr, void* data, const size_t size)
+    void kusd_page::read(const uint64_t addr, void* data, const size_t size)
     {
         const std::scoped_lock lock(this->mutex_);
 
@@ -174,12 +192,25 @@ namespace sogen
         memcpy(data, kusd_buffer + addr, static_cast<size_t>(real_size));
     }
 
-    uint64_t kusd_mmio::address()
+    uint64_t kusd_page::address()
     {
         return KUSD_ADDRESS;
     }
 
-    void kusd_mmio::update()
+    void kusd_page::refresh()
+    {
+        if (this->backing_ != backing::page)
+        {
+            return;
+        }
+
+        const std::lock_guard lock{this->mutex_};
+
+        this->update();
+        this->publish_time();
+    }
+
+    void kusd_page::update()
     {
         const auto time = this->clock_->system_now();
         utils::convert_to_ksystem_time(&this->kusd_.SystemTime, time);
@@ -197,14 +228,50 @@ namespace sogen
         this->kusd_.InterruptTime.High1Time = static_cast<int32_t>(duration_100ns >> 32);
     }
 
-    void kusd_mmio::register_mmio()
+    void kusd_page::publish(const size_t offset, const size_t size)
     {
-        if (this->registered_)
+        if (this->backing_ != backing::page)
         {
             return;
         }
 
-        this->registered_ = true;
+        const auto* kusd_buffer = reinterpret_cast<const uint8_t*>(&this->kusd_);
+        this->memory_->write_memory(KUSD_ADDRESS + offset, kusd_buffer + offset, size);
+    }
+
+    void kusd_page::publish_time()
+    {
+        // Other vCPUs may be reading while this runs. They read High1Time, LowPart and then High2Time and retry
+        // until both high parts match, so like the kernel, High2Time goes first and LowPart with High1Time
+        // follows as one 8-byte write (which also keeps TickCountQuad whole).
+        for (const auto time : {offsetof(KUSER_SHARED_DATA64, InterruptTime), offsetof(KUSER_SHARED_DATA64, SystemTime),
+                                offsetof(KUSER_SHARED_DATA64, TickCount)})
+        {
+            this->publish(time + offsetof(KSYSTEM_TIME, High2Time), sizeof(KSYSTEM_TIME::High2Time));
+            this->publish(time + offsetof(KSYSTEM_TIME, LowPart), sizeof(KSYSTEM_TIME::LowPart) + sizeof(KSYSTEM_TIME::High1Time));
+        }
+    }
+
+    void kusd_page::map()
+    {
+        if (this->backing_ != backing::none)
+        {
+            return;
+        }
+
+        if (this->memory_->allocate_memory(KUSD_ADDRESS, KUSD_BUFFER_SIZE, memory_permission::read, false,
+                                          memory_region_kind::shared_user_data))
+        {
+            this->backing_ = backing::page;
+
+            const std::lock_guard lock{this->mutex_};
+            this->update();
+            this->publish(0, KUSD_SIZE);
+            return;
+        }
+
+        // The address lies in a range the backend reserves for the host; MMIO does not need it backed.
+        this->backing_ = backing::mmio;
 
         this->memory_->allocate_mmio(
             KUSD_ADDRESS, KUSD_BUFFER_SIZE,
@@ -216,11 +283,11 @@ namespace sogen
             });
     }
 
-    void kusd_mmio::deregister_mmio()
+    void kusd_page::unmap()
     {
-        if (this->registered_)
+        if (this->backing_ != backing::none)
         {
-            this->registered_ = false;
+            this->backing_ = backing::none;
             this->memory_->release_memory(KUSD_ADDRESS, KUSD_BUFFER_SIZE);
         }
     }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "std_include.hpp"
+#include <serialization.hpp>
+
+#include "arch_emulator.hpp"
+
+#include <mutex>
+#include <utils/finally.hpp>
+#include <utils/time.hpp>
+
+namespace sogen
+{
+
+    struct process_context;
+    struct fake_environment_config;
+    class windows_emulator;
+    class windows_version_manager;
+
+    // KUSER_SHARED_DATA, backed by a read-only guest page at 0x7ffe0000 that every backend reads natively,
+    // without a trap or a lock. The time fields are only written at refresh(): the scheduler calls it at each
+    // quantum, which the interrupt thread's host timer ends in real time and the instruction count in
+    // reproducible mode, as well as when idling advances the reproducible clock. A guest therefore sees
+    // SystemTime, InterruptTime and TickCount at most one quantum behind the emulator clock (~20 ms in real
+    // time, one time slice of instructions in reproducible mode); the real kernel updates them on its 15.6 ms
+    // clock tick, so callers already expect that granularity.
+    //
+    // The page is a shared_user_data region, which the guest can neither free nor reprotect.
+    //
+    // Backends that can not map guest memory at this address (host reserved ranges on FEX) fall back to MMIO,
+    // where every read recomputes the time fields as before.
+    class kusd_page
+    {
+      public:
+        kusd_page(memory_manager& memory, utils::clock& clock);
+        ~kusd_page();
+
+        kusd_page(utils::buffer_deserializer& buffer);
+
+        kusd_page(kusd_page&&) = delete;
+        kusd_page(const kusd_page&) = delete;
+        kusd_page& operator=(kusd_page&& obj) = delete;
+        kusd_page& operator=(const kusd_page&) = delete;
+
+        void serialize(utils::buffer_serializer& buffer) const;
+        void deserialize(utils::buffer_deserializer& buffer);
+
+        // Locked access to the KUSD block. The MMIO fallback's read callback runs on backend worker threads,
+        // so callers must not touch kusd_ unsynchronized. Changes are written to the guest page afterwards;
+        // the functor's result is forwarded.
+        template <typename F>
+        decltype(auto) access(const F& functor)
+        {
+            const std::lock_guard lock{this->mutex_};
+            const auto _ = utils::finally([this] {
+                this->publish(0, sizeof(this->kusd_)); //
+            });
+
+            return functor(this->kusd_);
+        }
+
+        template <typename F>
+        decltype(auto) access(const F& functor) const
+        {
+            const std::lock_guard lock{this->mutex_};
+            return functor(this->kusd_);
+        }
+
+        static uint64_t address();
+
+        void setup(const windows_version_manager& version, const fake_environment_config& fake_env);
+
+        // Recomputes the time fields from the clock and writes them to the guest page.
+        void refresh();
+
+      private:
+        enum class backing : uint8_t
+        {
+            none,
+            page,
+            mmio,
+        };
+
+        memory_manager* memory_{};
+        utils::clock* clock_{};
+
+        backing backing_{backing::none};
+
+        // Guards update() and the snapshots handed to the MMIO fallback, so kusd_ is never torn.
+        mutable std::mutex mutex_{};
+
+        // NOLINTNEXTLINE(bugprone-invalid-enum-default-initialization)
+        KUSER_SHARED_DATA64 kusd_{};
+
+        void read(uint64_t addr, void* data, size_t size);
+
+        void update();
+
+        void publish(size_t offset, size_t size);
+        void publish_time();
+
+        void map();
+        void unmap();
+    };
+
+} // namespace sogen
@@ -9,12 +9,15 @@
 #include <optional>
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
 
 namespace sogen
 {
 
     namespace
     {
+        constexpr size_t snapshot_page_size = 0x1000;
+
         void split_regions(memory_manager::committed_region_map& regions, const std::vector<uint64_t>& split_points)
         {
             for (auto i = regions.begin(); i != regions.end(); ++i)
@@ -108,6 +111,40 @@ namespace sogen
 #endif
     }
 
+    memory_manager::reserved_region_map::iterator memory_manager::insert_reserved_region(const uint64_t address, reserved_region region)
+    {
+        const auto length = region.length;
+        const auto [entry, inserted] = this->reserved_regions_.try_emplace(address, std::move(region));
+
+        if (inserted)
+        {
+            this->free_gaps_.reserve(address, address + length);
+        }
+
+        return entry;
+    }
+
+    memory_manager::reserved_region_map::iterator memory_manager::erase_reserved_region(const reserved_region_map::iterator entry)
+    {
+        this->free_gaps_.release(entry->first, entry->first + entry->second.length);
+        return this->reserved_regions_.erase(entry);
+    }
+
+    void memory_manager::rebuild_free_gaps()
+    {
+        this->free_gaps_.reset(0, MAX_ALLOCATION_END_EXCL, ALLOCATION_GRANULARITY);
+
+        for (const auto& [address, region] : this->reserved_regions_)
+        {
+            this->free_gaps_.reserve(address, address + region.length);
+        }
+    }
+
+    void memory_manager::renew_mapping_generation(reserved_region& region)
+    {
+        region.mapping_generation = ++this->next_mapping_generation_;
+    }
+
     memory_stats memory_manager::compute_memory_stats() const
     {
         memory_stats stats{};
@@ -208,6 +245,12 @@ namespace sogen
         buffer.read(this->default_allocation_address_);
         buffer.read(this->dep_enabled_);
         buffer.read_map(this->reserved_regions_);
+        this->rebuild_free_gaps();
+
+        for (auto& reserved_region : this->reserved_regions_ | std::views::values)
+        {
+            this->renew_mapping_generation(reserved_region);
+        }
 
         if (is_snapshot)
         {
@@ -221,7 +264,7 @@ namespace sogen
             auto& reserved_region = i->second;
             if (reserved_region.kind == memory_region_kind::mmio)
             {
-                i = this->reserved_regions_.erase(i);
+                i = this->erase_reserved_region(i);
                 continue;
             }
 
@@ -240,6 +283,304 @@ namespace sogen
         }
     }
 
+    std::shared_ptr<const memory_manager::memory_image> memory_manager::create_memory_image() const
+    {
+        auto image = std::make_shared<memory_image>();
+        image->layout_version = this->get_layout_version();
+        image->default_allocation_address = this->default_allocation_address_;
+        image->dep_enabled = this->dep_enabled_;
+
+        size_t total_size = 0;
+
+        for (const auto& [address, reserved_region] : this->reserved_regions_)
+        {
+            if (reserved_region.kind == memory_region_kind::mmio)
+            {
+                continue;
+            }
+
+            image->reserved_regions.emplace(address, reserved_region);
+
+            for (const auto& region : reserved_region.committed_regions | std::views::values)
+            {
+                total_size += static_cast<size_t>(page_align_up(region.length));
+            }
+        }
+
+        image->storage = std::make_unique<utils::shared_memory>(total_size);
+
+        size_t offset = 0;
+
+        for (const auto& reserved_region : image->reserved_regions | std::views::values)
+        {
+            for (const auto& [region_address, region] : reserved_region.committed_regions)
+            {
+                auto* data = image->storage->data() + offset;
+                this->read_memory(region_address, data, region.length);
+
+                image->committed_data.emplace(region_address, std::span<const std::byte>{data, region.length});
+                offset += static_cast<size_t>(page_align_up(region.length));
+            }
+        }
+
+        return image;
+    }
+
+    void memory_manager::fork_memory_image(std::shared_ptr<const memory_image> image)
+    {
+        if (!this->reserved_regions_.empty())
+        {
+            throw std::runtime_error("Memory image can only be forked into an empty address space");
+        }
+
+        const auto use_host_mapping = this->memory_->supports_host_memory_mapping();
+
+        std::byte* view_data = nullptr;
+        if (use_host_mapping)
+        {
+            view_data = this->image_views_.emplace_back(image->storage->map_copy_on_write()).data();
+        }
+
+        this->layout_version_.store(image->layout_version, std::memory_order_relaxed);
+        this->default_allocation_address_ = image->default_allocation_address;
+        this->dep_enabled_ = image->dep_enabled;
+
+        for (const auto& [address, reserved_region] : image->reserved_regions)
+        {
+            for (const auto& [region_address, region] : reserved_region.committed_regions)
+            {
+                const auto data = image->committed_data.at(region_address);
+                const auto permissions = this->get_effective_permissions(region.permissions);
+
+                if (use_host_mapping)
+                {
+                    const auto offset = static_cast<size_t>(data.data() - image->storage->data());
+                    this->map_host_memory(region_address, region.length, view_data + offset, permissions);
+                }
+                else
+                {
+                    this->map_memory(region_address, region.length, permissions);
+                    this->write_memory(region_address, data.data(), data.size());
+                }
+            }
+
+            this->insert_reserved_region(address, reserved_region);
+
+            // Generations come from the instance that created the image; keep ours ahead of them.
+            this->next_mapping_generation_ = std::max(this->next_mapping_generation_, reserved_region.mapping_generation);
+        }
+
+        this->snapshot_ = std::move(image);
+
+        if (this->memory_->supports_dirty_page_tracking())
+        {
+            this->memory_->start_dirty_page_tracking();
+        }
+    }
+
+    void memory_manager::save_snapshot()
+    {
+        this->snapshot_ = this->create_memory_image();
+
+        if (this->memory_->supports_dirty_page_tracking())
+        {
+            this->memory_->start_dirty_page_tracking();
+        }
+    }
+
+    memory_manager::snapshot_restore_stats memory_manager::restore_snapshot()
+    {
+        if (!this->snapshot_)
+        {
+            throw std::runtime_error("No memory snapshot saved");
+        }
+
+        const auto& snapshot = *this->snapshot_;
+        snapshot_restore_stats stats{};
+
+        // Collected before anything below writes guest memory itself.
+        const auto use_dirty_log = this->memory_->supports_dirty_page_tracking();
+        const auto dirty_pages = use_dirty_log ? this->memory_->collect_dirty_pages() : std::vector<uint64_t>{};
+
+        const auto dep_changed = this->dep_enabled_ != snapshot.dep_enabled;
+        this->dep_enabled_ = snapshot.dep_enabled;
+        this->default_allocation_address_ = snapshot.default_allocation_address;
+
+        // A reservation still carrying the snapshot's mapping generation holds the very pages that were
+        // captured, so only its written pages and protections need restoring. Everything else - new
+        // reservations, remapped ones and all MMIO, whose owners re-register on restore - is unmapped.
+        for (auto i = this->reserved_regions_.begin(); i != this->reserved_regions_.end();)
+        {
+            const auto& [address, reserved_region] = *i;
+            const auto snapshot_entry = snapshot.reserved_regions.find(address);
+
+            if (snapshot_entry != snapshot.reserved_regions.end() && reserved_region.kind != memory_region_kind::mmio &&
+                reserved_region.mapping_generation == snapshot_entry->second.mapping_generation &&
+                reserved_region.length == snapshot_entry->second.length && reserved_region.kind == snapshot_entry->second.kind)
+            {
+                ++i;
+                continue;
+            }
+
+            for (const auto& [region_address, region] : reserved_region.committed_regions)
+            {
+                this->unmap_memory(region_address, region.length);
+            }
+
+            i = this->erase_reserved_region(i);
+        }
+
+        for (auto& [address, reserved_region] : this->reserved_regions_)
+        {
+            const auto& snapshot_region = snapshot.reserved_regions.at(address);
+
+            if (dep_changed || reserved_region.committed_regions != snapshot_region.committed_regions)
+            {
+                for (const auto& [region_address, region] : snapshot_region.committed_regions)
+                {
+                    this->apply_memory_protection(region_address, region.length, this->get_effective_permissions(region.permissions));
+                }
+            }
+
+            if (!use_dirty_log)
+            {
+                stats.restored_pages += this->restore_changed_snapshot_pages(snapshot_region);
+            }
+
+            reserved_region = snapshot_region;
+        }
+
+        if (use_dirty_log)
+        {
+            stats.restored_pages += this->restore_snapshot_pages(dirty_pages);
+        }
+
+        for (const auto& [address, reserved_region] : snapshot.reserved_regions)
+        {
+            if (!this->reserved_regions_.contains(address))
+            {
+                this->restore_snapshot_region(address, reserved_region);
+                ++stats.remapped_regions;
+            }
+        }
+
+        // Like deserialize_memory_state, so a restored run is indistinguishable from the original one.
+        this->layout_version_.store(snapshot.layout_version, std::memory_order_relaxed);
+
+        if (use_dirty_log)
+        {
+            this->memory_->start_dirty_page_tracking();
+        }
+
+        return stats;
+    }
+
+    void memory_manager::restore_snapshot_region(const uint64_t address, const reserved_region& region)
+    {
+        const auto& committed_data = this->snapshot_->committed_data;
+
+        for (const auto& [region_address, committed] : region.committed_regions)
+        {
+            const auto& data = committed_data.at(region_address);
+            this->map_memory(region_address, committed.length, this->get_effective_permissions(committed.permissions));
+            this->write_memory(region_address, data.data(), data.size());
+        }
+
+        this->insert_reserved_region(address, region);
+    }
+
+    size_t memory_manager::restore_snapshot_pages(const std::vector<uint64_t>& pages)
+    {
+        const auto& committed_data = this->snapshot_->committed_data;
+        size_t restored_pages = 0;
+
+        for (const auto page : pages)
+        {
+            // Pages of remapped reservations were already rewritten in full; reservations created after the
+            // snapshot are gone.
+            const auto reserved_entry = this->find_reserved_region(page);
+            if (reserved_entry == this->reserved_regions_.end())
+            {
+                continue;
+            }
+
+            auto data_entry = committed_data.upper_bound(page);
+            if (data_entry == committed_data.begin())
+            {
+                continue;
+            }
+
+            --data_entry;
+            const auto offset = page - data_entry->first;
+            if (offset >= data_entry->second.size())
+            {
+                continue;
+            }
+
+            const auto length = std::min<size_t>(snapshot_page_size, static_cast<size_t>(data_entry->second.size() - offset));
+            this->write_memory(page, data_entry->second.data() + offset, length);
+            ++restored_pages;
+        }
+
+        return restored_pages;
+    }
+
+    size_t memory_manager::restore_changed_snapshot_pages(const reserved_region& region)
+    {
+        // Fallback for backends without a dirty-page log: still no remapping, but every committed page has
+        // to be read back and compared. Runs of changed pages are written back with one call each.
+        constexpr size_t chunk_size = 0x100000;
+
+        const auto& committed_data = this->snapshot_->committed_data;
+        std::vector<std::byte> current{};
+        size_t restored_pages = 0;
+
+        for (const auto& [region_address, committed] : region.committed_regions)
+        {
+            const auto& data = committed_data.at(region_address);
+
+            for (size_t chunk_offset = 0; chunk_offset < data.size(); chunk_offset += chunk_size)
+            {
+                const auto length = std::min(chunk_size, data.size() - chunk_offset);
+                current.resize(length);
+                this->read_memory(region_address + chunk_offset, current.data(), length);
+
+                size_t run_start = 0;
+                size_t run_length = 0;
+
+                const auto flush_run = [&] {
+                    if (run_length > 0)
+                    {
+                        this->write_memory(region_address + chunk_offset + run_start, data.data() + chunk_offset + run_start, run_length);
+                        run_length = 0;
+                    }
+                };
+
+                for (size_t offset = 0; offset < length; offset += snapshot_page_size)
+                {
+                    const auto page_length = std::min<size_t>(snapshot_page_size, length - offset);
+                    if (std::memcmp(current.data() + offset, data.data() + chunk_offset + offset, page_length) == 0)
+                    {
+                        flush_run();
+                        continue;
+                    }
+
+                    if (run_length == 0)
+                    {
+                        run_start = offset;
+                    }
+
+                    run_length += page_length;
+                    ++restored_pages;
+                }
+
+                flush_run();
+            }
+        }
+
+        return restored_pages;
+    }
+
     bool memory_manager::protect_memory(const uint64_t address, const size_t size, const nt_memory_permission permissions,
                                         nt_memory_permission* old_permissions)
     {
@@ -306,14 +647,12 @@ namespace sogen
         this->carve_host_reserved_hole(address, size);
         this->map_mmio(address, size, std::move(read_cb), std::move(write_cb));
 
-        const auto entry = this->reserved_regions_
-                               .try_emplace(address,
-                                            reserved_region{
-                                                .length = size,
-                                                .kind = memory_region_kind::mmio,
-                                            })
-                               .first;
+        const auto entry = this->insert_reserved_region(address, reserved_region{
+                                                                     .length = size,
+                                                                     .kind = memory_region_kind::mmio,
+                                                                 });
 
+        this->renew_mapping_generation(entry->second);
         entry->second.committed_regions[address] = committed_region{
             .length = size,
             .permissions = memory_permission::read_write,
@@ -334,14 +673,12 @@ namespace sogen
 
         this->map_host_memory(address, size, host_pointer, this->get_effective_permissions(permissions));
 
-        const auto entry = this->reserved_regions_
-                               .try_emplace(address,
-                                            reserved_region{
-                                                .length = size,
-                                                .kind = memory_region_kind::mmio,
-                                            })
-                               .first;
+        const auto entry = this->insert_reserved_region(address, reserved_region{
+                                                                     .length = size,
+                                                                     .kind = memory_region_kind::mmio,
+                                                                 });
 
+        this->renew_mapping_generation(entry->second);
         entry->second.committed_regions[address] = committed_region{
             .length = size,
             .permissions = permissions,
@@ -429,25 +766,22 @@ namespace sogen
             }
 
             assert(it->second.committed_regions.empty());
-            it = this->reserved_regions_.erase(it);
+            it = this->erase_reserved_region(it);
 
             if (region_start < address)
             {
-                this->reserved_regions_.try_emplace(region_start, reserved_region{
-                                                                      .length = static_cast<size_t>(address - region_start),
-                                                                      .kind = memory_region_kind::host_reserved,
-                                                                  });
+                this->insert_reserved_region(region_start, reserved_region{
+                                                               .length = static_cast<size_t>(address - region_start),
+                                                               .kind = memory_region_kind::host_reserved,
+                                                           });
             }
 
             if (region_end > end)
             {
-                it = this->reserved_regions_
-                         .try_emplace(end,
-                                      reserved_region{
-                                          .length = static_cast<size_t>(region_end - end),
-                                          .kind = memory_region_kind::host_reserved,
-                                      })
-                         .first;
+                it = this->insert_reserved_region(end, reserved_region{
+                                                           .length = static_cast<size_t>(region_end - end),
+                                                           .kind = memory_region_kind::host_reserved,
+                                                       });
                 ++it;
             }
         }
@@ -507,14 +841,13 @@ namespace sogen
             return false;
         }
 
-        const auto entry = this->reserved_regions_
-                               .try_emplace(address,
-                                            reserved_region{
-                                                .length = size,
-                                                .initial_permission = permissions,
-                                                .kind = kind,
-                                            })
-                               .first;
+        const auto entry = this->insert_reserved_region(address, reserved_region{
+                                                                     .length = size,
+                                                                     .initial_permission = permissions,
+                                                                     .kind = kind,
+                                                                 });
+
+        this->renew_mapping_generation(entry->second);
 
         if (!reserve_only)
         {
@@ -598,6 +931,7 @@ namespace sogen
                 if (map_length > 0)
                 {
                     this->map_memory(map_start, static_cast<size_t>(map_length), effective_permission);
+                    this->renew_mapping_generation(entry->second);
                     committed_regions[map_start] = committed_region{
                         .length = static_cast<size_t>(map_length),
                         .permissions = permissions,
@@ -619,6 +953,7 @@ namespace sogen
             const auto map_length = end - map_start;
 
             this->map_memory(map_start, static_cast<size_t>(map_length), effective_permission);
+            this->renew_mapping_generation(entry->second);
             committed_regions[map_start] = committed_region{
                 .length = static_cast<size_t>(map_length),
                 .permissions = permissions,
@@ -668,6 +1003,7 @@ namespace sogen
             if (i->first >= address && sub_region_end <= end)
             {
                 this->unmap_memory(i->first, i->second.length);
+                this->renew_mapping_generation(entry->second);
                 i = committed_regions.erase(i);
                 continue;
             }
@@ -728,7 +1064,7 @@ namespace sogen
                 i = committed_regions.erase(i);
             }
 
-            this->reserved_regions_.erase(entry);
+            this->erase_reserved_region(entry);
             this->release_host_claims(address + entry_length);
             this->update_layout_version();
             return true;
@@ -753,7 +1089,7 @@ namespace sogen
         }
 
         reserved_region region = std::move(entry->second);
-        this->reserved_regions_.erase(entry);
+        this->erase_reserved_region(entry);
 
         auto& committed_regions = region.committed_regions;
         split_regions(committed_regions, {aligned_start, aligned_end});
@@ -800,7 +1136,8 @@ namespace sogen
             left_region.kind = region.kind;
             left_region.mapped_filename = region.mapped_filename;
             left_region.committed_regions = std::move(left_committed);
-            this->reserved_regions_.try_emplace(reserved_start, std::move(left_region));
+            this->renew_mapping_generation(left_region);
+            this->insert_reserved_region(reserved_start, std::move(left_region));
         }
 
         if (aligned_end < reserved_end)
@@ -811,7 +1148,8 @@ namespace sogen
             right_region.kind = region.kind;
             right_region.mapped_filename = region.mapped_filename;
             right_region.committed_regions = std::move(right_committed);
-            this->reserved_regions_.try_emplace(aligned_end, std::move(right_region));
+            this->renew_mapping_generation(right_region);
+            this->insert_reserved_region(aligned_end, std::move(right_region));
         }
 
         this->release_host_claims(aligned_end);
@@ -830,6 +1168,8 @@ namespace sogen
         }
 
         this->reserved_regions_.clear();
+        this->free_gaps_.reset(0, MAX_ALLOCATION_END_EXCL, ALLOCATION_GRANULARITY);
+        this->image_views_.clear();
     }
 
     namespace
@@ -961,62 +1301,9 @@ namespace sogen
             return 0;
         }
 
-        uint64_t start_address = *aligned_start;
-
-        // Since reserved_regions_ is a sorted map, we can iterate through it
-        // and find gaps between regions
-        while (start_address <= highest_address)
-        {
-            const auto end_address = start_address + size;
-            if (end_address < start_address || end_address > MAX_ALLOCATION_END_EXCL || end_address - 1 > highest_address)
-            {
-                return 0;
-            }
-
-            bool conflict = false;
-
-            // Check if the proposed range [start_address, start_address+size) conflicts with any existing region
-            for (const auto& region : this->reserved_regions_)
-            {
-                const auto region_end = region.first + region.second.length;
-                if (region_end < region.first)
-                {
-                    return 0;
-                }
-
-                // If this region ends before our start, skip it
-                if (region_end <= start_address)
-                {
-                    continue;
-                }
-
-                // If this region starts after our end, we're done checking (map is sorted)
-                if (region.first >= end_address)
-                {
-                    break;
-                }
-
-                // Otherwise, we have a conflict
-                conflict = true;
-                // Move start_address past this conflicting region
-                aligned_start = checked_align_up(region_end, alignment);
-                if (!aligned_start.has_value())
-                {
-                    return 0;
-                }
-
-                start_address = *aligned_start;
-                break;
-            }
-
-            // If no conflict was found, we have our address
-            if (!conflict)
-            {
-                return start_address;
-            }
-        }
-
-        return 0;
+        // The gap index only holds unreserved space, so the first gap fitting the request is the answer; no
+        // reservation below it has to be looked at.
+        return this->free_gaps_.find(*aligned_start, size, alignment, highest_address + 1).value_or(0);
     }
 
     region_info memory_manager::get_region_info(const uint64_t address)
@@ -1247,6 +1534,16 @@ namespace sogen
         }
     }
 
+    std::span<const std::byte> memory_manager::get_host_span(const uint64_t address, const size_t size) const
+    {
+        return this->memory_->get_host_span(address, size);
+    }
+
+    std::span<std::byte> memory_manager::get_writable_host_span(const uint64_t address, const size_t size)
+    {
+        return this->memory_->get_writable_host_span(address, size);
+    }
+
     void memory_manager::map_mmio(const uint64_t address, const size_t size, mmio_read_callback read_cb, mmio_write_callback write_cb)
     {
         this->memory_->map_mmio(address, size, std::move(read_cb), std::move(write_cb));
@@ -1262,6 +1559,11 @@ namespace sogen
         this->memory_->map_host_memory(address, size, host_pointer, permissions);
     }
 
+    bool memory_manager::supports_host_memory_mapping() const
+    {
+        return this->memory_->supports_host_memory_mapping();
+    }
+
     bool memory_manager::host_memory_aliasing_is_coherent() const
     {
         return this->memory_->host_memory_aliasing_is_coherent();
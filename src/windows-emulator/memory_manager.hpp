@@ -3,14 +3,18 @@
 #include <map>
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
+#include "free_gap_index.hpp"
 #include "memory_permission_ext.hpp"
 #include "memory_region.hpp"
 #include "serialization.hpp"
 
 #include <memory_interface.hpp>
+#include <utils/shared_memory.hpp>
 
 namespace sogen
 {
@@ -31,6 +35,9 @@ namespace sogen
         section_image,
         mmio,
         host_reserved,
+        // KUSER_SHARED_DATA's read-only page. It belongs to the emulator, so the guest can neither free nor
+        // reprotect it.
+        shared_user_data,
     };
 
     // This maps to the `basic_memory_region` struct defined in
@@ -60,12 +67,15 @@ namespace sogen
         memory_manager(memory_interface& memory)
             : memory_(&memory)
         {
+            this->free_gaps_.reset(0, MAX_ALLOCATION_END_EXCL, ALLOCATION_GRANULARITY);
         }
 
         struct committed_region
         {
             size_t length{};
             nt_memory_permission permissions{};
+
+            bool operator==(const committed_region&) const = default;
         };
 
         using committed_region_map = std::map<uint64_t, committed_region>;
@@ -77,16 +87,43 @@ namespace sogen
             committed_region_map committed_regions{};
             memory_region_kind kind{memory_region_kind::private_allocation};
             std::u16string mapped_filename{};
+
+            // Runtime-only stamp, renewed whenever pages of this reservation are mapped or unmapped (not
+            // on protection changes). Two entries with equal stamps hold the same backing pages, which is
+            // what lets restore_snapshot skip regions the guest did not remap. Not serialized.
+            uint64_t mapping_generation{};
         };
 
         using reserved_region_map = std::map<uint64_t, reserved_region>;
 
+        // Layout and committed page contents captured into one shared host memory object. It is both the
+        // restore point of save_snapshot and the base fork_memory_image maps into other instances. MMIO
+        // regions are not captured; their owners re-register them when the rest of the process state is
+        // restored.
+        struct memory_image
+        {
+            reserved_region_map reserved_regions{};
+            std::map<uint64_t, std::span<const std::byte>> committed_data{};
+            std::unique_ptr<utils::shared_memory> storage{};
+            std::uint64_t layout_version{};
+            std::uint64_t default_allocation_address{};
+            bool dep_enabled{true};
+        };
+
+        struct snapshot_restore_stats
+        {
+            size_t restored_pages{};
+            size_t remapped_regions{};
+        };
+
         using memory_interface::read_memory;
 
         void read_memory(uint64_t address, void* data, size_t size) const final;
         bool try_read_memory(uint64_t address, void* data, size_t size) const final;
         void write_memory(uint64_t address, const void* data, size_t size) final;
         bool try_write_memory(uint64_t address, const void* data, size_t size) final;
+        std::span<const std::byte> get_host_span(uint64_t address, size_t size) const final;
+        std::span<std::byte> get_writable_host_span(uint64_t address, size_t size) final;
 
         bool protect_memory(uint64_t address, size_t size, nt_memory_permission permissions,
                             nt_memory_permission* old_permissions = nullptr);
@@ -117,6 +154,7 @@ namespace sogen
         // Backend coherency hooks for host-aliased memory (see memory_interface). Device emulation such as
         // the GPU bridge uses these to make guest writes visible to the host GPU on backends (e.g. KVM) that
         // alias host memory into the guest non-coherently.
+        bool supports_host_memory_mapping() const override;
         bool host_memory_aliasing_is_coherent() const override;
         void flush_host_memory_cache(const void* host_pointer, size_t size) override;
         bool allocate_memory(uint64_t address, size_t size, nt_memory_permission permissions, bool reserve_only = false,
@@ -183,6 +221,24 @@ namespace sogen
         void serialize_memory_state(utils::buffer_serializer& buffer, bool is_snapshot) const;
         void deserialize_memory_state(utils::buffer_deserializer& buffer, bool is_snapshot);
 
+        // In-memory snapshot for fast reset loops (fuzzing, replay). restore_snapshot only rewrites pages
+        // written since the snapshot - taken from the backend's dirty-page log when it has one, otherwise
+        // found by comparing page contents - and only remaps reservations whose layout changed.
+        void save_snapshot();
+        snapshot_restore_stats restore_snapshot();
+
+        bool has_snapshot() const
+        {
+            return this->snapshot_ != nullptr;
+        }
+
+        std::shared_ptr<const memory_image> create_memory_image() const;
+
+        // Populates this (empty) manager from an image, which also becomes its snapshot. Where the backend
+        // can alias host memory, committed pages are private copy-on-write views of the shared image, so
+        // every instance forked from it only pays for the pages it writes. Other backends get a copy.
+        void fork_memory_image(std::shared_ptr<const memory_image> image);
+
         memory_stats compute_memory_stats() const;
 
         void set_dep_enabled(bool enabled);
@@ -195,10 +251,16 @@ namespace sogen
       private:
         memory_interface* memory_{};
         reserved_region_map reserved_regions_{};
+        // Complement of reserved_regions_, for find_free_allocation_base. Only insert_reserved_region and
+        // erase_reserved_region may change reserved_regions_ so the two never drift apart.
+        free_gap_index free_gaps_{};
         std::atomic<std::uint64_t> layout_version_{0};
         std::uint64_t default_allocation_address_{0x100000000ULL};
         bool dep_enabled_{true};
         std::vector<uint64_t> host_reserved_addresses_{};
+        std::uint64_t next_mapping_generation_{0};
+        std::shared_ptr<const memory_image> snapshot_{};
+        std::vector<utils::copy_on_write_view> image_views_{};
 
         void map_mmio(uint64_t address, size_t size, mmio_read_callback read_cb, mmio_write_callback write_cb) final;
         void map_memory(uint64_t address, size_t size, memory_permission permissions) final;
@@ -207,6 +269,13 @@ namespace sogen
         void apply_memory_protection(uint64_t address, size_t size, memory_permission permissions) final;
 
         void update_layout_version();
+        reserved_region_map::iterator insert_reserved_region(uint64_t address, reserved_region region);
+        reserved_region_map::iterator erase_reserved_region(reserved_region_map::iterator entry);
+        void rebuild_free_gaps();
+        void renew_mapping_generation(reserved_region& region);
+        void restore_snapshot_region(uint64_t address, const reserved_region& region);
+        size_t restore_snapshot_pages(const std::vector<uint64_t>& pages);
+        size_t restore_changed_snapshot_pages(const reserved_region& region);
         bool commit_memory(uint64_t address, size_t size, nt_memory_permission permissions, bool allow_image_section);
         memory_permission get_effective_permissions(nt_memory_permission permissions) const;
 
@@ -254,6 +323,7 @@ namespace sogen
             switch (kind)
             {
             case memory_region_kind::private_allocation:
+            case memory_region_kind::shared_user_data:
                 return 1 << 0;
             case memory_region_kind::file_section_view:
                 return 1 << 1;
@@ -276,13 +346,23 @@ namespace sogen
                 return STATUS_UNABLE_TO_DELETE_SECTION;
             }
 
-            if (kind == memory_region_kind::mmio)
+            if (kind == memory_region_kind::mmio || kind == memory_region_kind::shared_user_data)
             {
                 return STATUS_INVALID_PARAMETER;
             }
 
             return STATUS_SUCCESS;
         }
+
+        constexpr NTSTATUS nt_protect_virtual_memory_denied_status(const memory_region_kind kind)
+        {
+            if (kind == memory_region_kind::mmio || kind == memory_region_kind::shared_user_data)
+            {
+                return STATUS_INVALID_PAGE_PROTECTION;
+            }
+
+            return STATUS_SUCCESS;
+        }
     }
 
 } // namespace sogen
@@ -553,6 +553,8 @@ namespace sogen
                     }
                 }
 
+                win_emu.process.reset_scheduler();
+
                 // Set active thread to first available thread
                 if (success_count > 0)
                 {
@@ -16,7 +16,7 @@ namespace sogen
             return std::make_unique<socket_wrapper>(af, type, protocol);
         }
 
-        int socket_factory::poll_sockets(const std::span<poll_entry> entries)
+        int socket_factory::poll_sockets(const std::span<poll_entry> entries, const std::chrono::milliseconds timeout)
         {
             std::vector<pollfd> poll_data{};
             poll_data.reserve(entries.size());
@@ -42,7 +42,7 @@ namespace sogen
                 poll_data.push_back(fd);
             }
 
-            const auto res = poll(poll_data.data(), static_cast<uint32_t>(poll_data.size()), 0);
+            const auto res = poll(poll_data.data(), static_cast<uint32_t>(poll_data.size()), static_cast<int>(timeout.count()));
 
             for (size_t i = 0; i < poll_data.size() && i < entries.size(); ++i)
             {
@@ -2,6 +2,7 @@
 
 #include "i_socket.hpp"
 
+#include <chrono>
 #include <memory>
 
 namespace sogen
@@ -22,7 +23,13 @@ namespace sogen
             virtual ~socket_factory() = default;
 
             virtual std::unique_ptr<i_socket> create_socket(int af, int type, int protocol);
-            virtual int poll_sockets(std::span<poll_entry> entries);
+            int poll_sockets(const std::span<poll_entry> entries)
+            {
+                return this->poll_sockets(entries, {});
+            }
+
+            // Blocks for up to `timeout` until one of the sockets is ready.
+            virtual int poll_sockets(std::span<poll_entry> entries, std::chrono::milliseconds timeout);
         };
     }
 
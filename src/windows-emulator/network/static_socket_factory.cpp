@@ -4,6 +4,7 @@
 #include <deque>
 #include <queue>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 
 #include <network/socket.hpp>
@@ -287,7 +288,7 @@ namespace sogen
                     return std::make_unique<static_socket>(*this, af);
                 }
 
-                int poll_sockets(std::span<poll_entry> entries) override
+                int poll_sockets(std::span<poll_entry> entries, const std::chrono::milliseconds timeout) override
                 {
                     int ready_count = 0;
                     for (auto& entry : entries)
@@ -350,6 +351,12 @@ namespace sogen
                         }
                     }
 
+                    // These sockets only become ready through the guest, which does not run while this waits.
+                    if (ready_count == 0 && timeout.count() > 0)
+                    {
+                        std::this_thread::sleep_for(timeout);
+                    }
+
                     return ready_count;
                 }
             };
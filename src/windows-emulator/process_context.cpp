@@ -822,6 +822,8 @@ namespace sogen
             this->thread_handles_by_id[thread.id] = this->threads.make_handle(index);
         }
 
+        this->reset_scheduler();
+
         active_thread = this->threads.get(buffer.read<uint64_t>());
     }
 
@@ -980,6 +982,7 @@ namespace sogen
         emulator_thread t{memory, *this, start_address, argument, stack_size, create_flags, thread_id, initial_thread};
         auto [h, thr] = this->threads.store_and_get(std::move(t));
         this->thread_handles_by_id[thr->id] = h;
+        this->scheduler.add(thr->id);
 
         // The desktop window is created during process setup, before any thread exists, so it has no owning
         // thread. GetWindowThreadProcessId(GetDesktopWindow()) must return a real thread id (DirectSound, for
@@ -1001,15 +1004,22 @@ namespace sogen
     void process_context::terminate_thread(emulator_thread& thread, const NTSTATUS thread_exit_status)
     {
         thread.exit_status = thread_exit_status;
+        this->scheduler.terminate(thread.id);
 
-        for (auto& mutant : this->mutants | std::views::values)
+        for (auto& [index, mutant] : this->mutants)
         {
             if (mutant.owning_thread_id == thread.id && mutant.locked_count > 0)
             {
                 mutant.abandon();
+                this->scheduler.notify_object(this->mutants.make_handle(index));
             }
         }
 
+        if (const auto entry = this->thread_handles_by_id.find(thread.id); entry != this->thread_handles_by_id.end())
+        {
+            this->scheduler.notify_object(entry->second);
+        }
+
         for (auto i = this->windows.begin(); i != this->windows.end();)
         {
             if (i->second.thread_id != thread.id)
@@ -1024,6 +1034,23 @@ namespace sogen
         }
     }
 
+    void process_context::reset_scheduler()
+    {
+        this->scheduler.reset();
+
+        for (const auto& thread : this->threads | std::views::values)
+        {
+            if (thread.is_terminated())
+            {
+                this->scheduler.terminate(thread.id);
+            }
+            else
+            {
+                this->scheduler.add(thread.id);
+            }
+        }
+    }
+
     std::optional<uint16_t> process_context::find_atom(const std::u16string_view name)
     {
         for (auto& entry : this->atoms)
@@ -10,10 +10,11 @@
 #include <arch_emulator.hpp>
 
 #include "io_device.hpp"
-#include "kusd_mmio.hpp"
+#include "kusd_page.hpp"
 #include "windows_objects.hpp"
 #include "emulator_thread.hpp"
 #include "port.hpp"
+#include "thread_scheduler.hpp"
 #include "user_handle_table.hpp"
 
 #include "apiset/apiset.hpp"
@@ -117,6 +118,67 @@ namespace sogen
         bool guest_top_down{};
         bool guest_owns_memory{};
 
+        // Pixels written since the surface was last presented, so UI backends can skip unchanged regions.
+        // New and restored surfaces count as fully damaged.
+        RECT damage{0, 0, std::numeric_limits<LONG>::max(), std::numeric_limits<LONG>::max()};
+
+        void add_damage(int64_t left, int64_t top, int64_t right, int64_t bottom)
+        {
+            if (right < left)
+            {
+                std::swap(left, right);
+            }
+
+            if (bottom < top)
+            {
+                std::swap(top, bottom);
+            }
+
+            left = std::max<int64_t>(left, 0);
+            top = std::max<int64_t>(top, 0);
+            right = std::min<int64_t>(right, this->width);
+            bottom = std::min<int64_t>(bottom, this->height);
+            if (left >= right || top >= bottom)
+            {
+                return;
+            }
+
+            if (this->damage.left >= this->damage.right || this->damage.top >= this->damage.bottom)
+            {
+                this->damage = {static_cast<LONG>(left), static_cast<LONG>(top), static_cast<LONG>(right), static_cast<LONG>(bottom)};
+                return;
+            }
+
+            this->damage.left = std::min(this->damage.left, static_cast<LONG>(left));
+            this->damage.top = std::min(this->damage.top, static_cast<LONG>(top));
+            this->damage.right = std::max(this->damage.right, static_cast<LONG>(right));
+            this->damage.bottom = std::max(this->damage.bottom, static_cast<LONG>(bottom));
+        }
+
+        void add_full_damage()
+        {
+            this->damage = {0, 0, static_cast<LONG>(this->width), static_cast<LONG>(this->height)};
+        }
+
+        // The damaged region clipped to the surface, empty if nothing changed. Resets the damage.
+        RECT take_damage()
+        {
+            RECT result{
+                .left = this->damage.left,
+                .top = this->damage.top,
+                .right = std::min(this->damage.right, static_cast<LONG>(std::min<uint32_t>(this->width, INT32_MAX))),
+                .bottom = std::min(this->damage.bottom, static_cast<LONG>(std::min<uint32_t>(this->height, INT32_MAX))),
+            };
+
+            if (result.left >= result.right || result.top >= result.bottom)
+            {
+                result = {};
+            }
+
+            this->damage = {};
+            return result;
+        }
+
         void serialize(utils::buffer_serializer& buffer) const
         {
             buffer.write(this->width);
@@ -139,6 +201,7 @@ namespace sogen
             buffer.read(this->guest_bpp);
             buffer.read(this->guest_top_down);
             buffer.read(this->guest_owns_memory);
+            this->add_full_damage();
         }
     };
 
@@ -401,6 +464,7 @@ namespace sogen
         handle create_thread(memory_manager& memory, uint64_t start_address, uint64_t argument, uint64_t stack_size, uint32_t create_flags,
                              bool initial_thread = false);
         void terminate_thread(emulator_thread& thread, NTSTATUS thread_exit_status);
+        void reset_scheduler();
 
         std::optional<uint16_t> find_atom(std::u16string_view name);
         uint16_t add_or_find_atom(std::u16string name);
@@ -448,7 +512,7 @@ namespace sogen
 
         emulator_object<PEB64> peb64;
         emulator_object<RTL_USER_PROCESS_PARAMETERS64> process_params64;
-        kusd_mmio kusd;
+        kusd_page kusd;
 
         uint64_t ntdll_image_base{};
         uint64_t ldr_initialize_thunk{};
@@ -545,7 +609,7 @@ namespace sogen
         handle_store<handle_types::timer, timer> timers{};
         user_handle_store<handle_types::accelerator_table, accelerator_table> accelerator_tables{user_handles};
         handle_store<handle_types::registry, registry_key, 2> registry_keys{};
-        std::map<uint32_t, handle> thread_handles_by_id{};
+        std::unordered_map<uint32_t, handle> thread_handles_by_id{};
         std::map<uint16_t, atom_entry> atoms{};
         utils::insensitive_u16string_map<class_entry> classes{};
 
@@ -562,6 +626,9 @@ namespace sogen
         uint32_t spawned_thread_count{0};
         handle_store<handle_types::thread, emulator_thread> threads{};
 
+        // Not serialized, rebuilt from the thread states by reset_scheduler().
+        thread_scheduler scheduler{};
+
         // Handles delivered with the most recent ALPC reply message (NtAlpcSendWaitReceivePort). rpcrt4's
         // system-handle import retrieves them via NtAlpcQueryInformationMessage(AlpcMessageHandleInformation)
         // rather than reading the handle attribute directly. Transient (valid only until the next reply).
@@ -1,5 +1,6 @@
 #include "../std_include.hpp"
 #include "hive_parser.hpp"
+#include "registry_cache.hpp"
 #include <utils/string.hpp>
 
 // Based on this implementation: https://github.com/reahly/windows-hive-parser
@@ -60,89 +61,55 @@ namespace sogen
 
         // NOLINTEND(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
 
-        bool read_file_data_safe(std::ifstream& file, const uint64_t offset, void* buffer, const size_t size)
+        // The parser maps fixed-size structs (key/value/subkey-list blocks) onto variable-size hive cells, so a
+        // full-size read of a cell near the end of the hive legitimately runs past EOF -- uncompacted hives leave
+        // trailing slack that absorbs it, but a compacted hive (e.g. produced by REG SAVE, which drops that slack)
+        // does not. Views are clipped to the file and objects zero-filled past its end; an offset wholly past EOF
+        // yields an empty view or a zeroed block that parses as empty rather than crashing.
+        std::span<const std::byte> get_file_data(const hive_file& file, const uint64_t offset, const size_t size)
         {
-            // The parser maps fixed-size structs (key/value/subkey-list blocks) onto variable-size hive
-            // cells, so a full-size read of a cell near the end of the hive legitimately runs past EOF --
-            // uncompacted hives leave trailing slack that absorbs it, but a compacted hive (e.g. produced
-            // by REG SAVE, which drops that slack) does not. Read whatever is available and zero-fill the
-            // remainder; callers only consume the real cell fields, and an offset wholly past EOF yields a
-            // zeroed block that parses as empty rather than crashing.
-            std::memset(buffer, 0, size);
-
-            if (file.bad())
+            const auto data = file.get_span();
+            if (offset >= data.size())
             {
-                return false;
+                return {};
             }
 
-            file.clear();
-
-            file.seekg(0, std::ios::end);
-            if (!file.good())
-            {
-                return false;
-            }
-
-            const auto file_size = static_cast<uint64_t>(file.tellg());
-            if (offset >= file_size)
-            {
-                return true; // wholly past EOF: leave the buffer zero-filled
-            }
-
-            const auto available = static_cast<size_t>(file_size - offset);
-            const auto to_read = size < available ? size : available;
-
-            file.seekg(static_cast<std::streamoff>(offset));
-            if (!file.good())
-            {
-                return false;
-            }
-
-            file.read(static_cast<char*>(buffer), static_cast<std::streamsize>(to_read));
-
-            return !file.bad();
+            return data.subspan(static_cast<size_t>(offset), std::min(size, static_cast<size_t>(data.size() - offset)));
         }
 
-        void read_file_data(std::ifstream& file, const uint64_t offset, void* buffer, const size_t size)
+        std::string_view get_file_string(const hive_file& file, const uint64_t offset, const size_t size)
         {
-            if (!read_file_data_safe(file, offset, buffer, size))
-            {
-                throw std::runtime_error("Failed to read file data");
-            }
-        }
-
-        std::vector<std::byte> read_file_data(std::ifstream& file, const uint64_t offset, const size_t size)
-        {
-            std::vector<std::byte> result{};
-            result.resize(size);
-
-            read_file_data(file, offset, result.data(), size);
-            return result;
-        }
-
-        std::string read_file_data_string(std::ifstream& file, const uint64_t offset, const size_t size)
-        {
-            std::string result{};
-            result.resize(size);
-
-            read_file_data(file, offset, result.data(), size);
-            return result;
+            const auto data = get_file_data(file, offset, size);
+            return {reinterpret_cast<const char*>(data.data()), data.size()};
         }
 
         template <typename T>
             requires(std::is_trivially_copyable_v<T>)
-        T read_file_object(std::ifstream& file, const uint64_t offset, const size_t array_index = 0)
+        T read_file_object(const hive_file& file, const uint64_t offset, const size_t array_index = 0)
         {
             T obj{};
-            read_file_data(file, offset + (array_index * sizeof(T)), &obj, sizeof(T));
+            const auto data = get_file_data(file, offset + (array_index * sizeof(T)), sizeof(T));
+            if (!data.empty())
+            {
+                memcpy(&obj, data.data(), data.size());
+            }
+
             return obj;
         }
 
-        hive_key parse_root_block(std::ifstream& file, const std::filesystem::path& file_path)
+        // Name of a key or value cell. Names are stored inline, so this is a view into the cell itself.
+        std::string_view get_cell_name(const hive_file& file, const uint64_t cell_offset, const size_t name_offset, const int16_t length,
+                                       const size_t max_length)
+        {
+            const auto name_length = length < 0 ? size_t{0} : std::min(static_cast<size_t>(length), max_length);
+            return get_file_string(file, cell_offset + name_offset, name_length);
+        }
+
+        hive_key parse_root_block(const hive_file& file, const std::filesystem::path& file_path)
         {
             try
             {
-                if (read_file_data_string(file, 0, 4) != "regf")
+                if (get_file_string(file, 0, 4) != "regf")
                 {
                     throw std::runtime_error("Invalid signature");
                 }
@@ -158,7 +125,7 @@ namespace sogen
         }
     }
 
-    const hive_value* hive_key::get_value(std::ifstream& file, const std::string_view name)
+    const hive_value* hive_key::get_value(const hive_file& file, const std::string_view name)
     {
         this->parse(file);
 
@@ -168,18 +135,10 @@ namespace sogen
             return nullptr;
         }
 
-        auto& value = entry->second;
-
-        if (!value.parsed)
-        {
-            value.data = read_file_data(file, MAIN_ROOT_OFFSET + value.data_offset, value.data_length);
-            value.parsed = true;
-        }
-
-        return &value;
+        return &entry->second;
     }
 
-    const hive_value* hive_key::get_value(std::ifstream& file, const size_t index)
+    const hive_value* hive_key::get_value(const hive_file& file, const size_t index)
     {
         this->parse(file);
 
@@ -191,7 +150,7 @@ namespace sogen
         return get_value(file, values_by_index_[index]);
     }
 
-    void hive_key::parse_subkey_list(std::ifstream& file, const int32_t block_offset, const bool allow_root_index)
+    void hive_key::parse_subkey_list(const hive_file& file, const int32_t block_offset, const bool allow_root_index)
     {
         const auto item = read_file_object<offsets_t>(file, MAIN_ROOT_OFFSET + block_offset);
 
@@ -210,11 +169,11 @@ namespace sogen
                 const auto offset_entry = read_file_object<offset_entry_t>(file, MAIN_ROOT_OFFSET + entry_offsets, i);
                 const auto subkey_block_offset = MAIN_ROOT_OFFSET + offset_entry.offset;
                 const auto subkey = read_file_object<key_block_t>(file, subkey_block_offset);
-                const auto subkey_name_len = subkey.len < 0 ? size_t{0} : std::min(static_cast<size_t>(subkey.len), sizeof(subkey.name));
-                std::string subkey_name(subkey.name, subkey_name_len);
+                const auto subkey_name =
+                    get_cell_name(file, subkey_block_offset, offsetof(key_block_t, name), subkey.len, sizeof(subkey.name));
 
                 const auto [it, inserted] =
-                    this->sub_keys_.emplace(std::move(subkey_name), hive_key{subkey.subkeys, subkey.value_count, subkey.offsets});
+                    this->sub_keys_.emplace(subkey_name, hive_key{subkey.subkeys, subkey.value_count, subkey.offsets});
                 if (inserted)
                 {
                     this->sub_keys_by_index_.emplace_back(it->first);
@@ -228,7 +187,44 @@ namespace sogen
         }
     }
 
-    void hive_key::parse(std::ifstream& file)
+    void hive_key::parse_cached()
+    {
+        const auto& cache = *this->cache_;
+
+        const auto value_count = cache.get_value_count(this->cache_index_);
+        for (size_t i = 0; i < value_count; ++i)
+        {
+            const auto value = cache.get_value(this->cache_index_, i);
+            if (!value)
+            {
+                continue;
+            }
+
+            const auto [it, inserted] = this->values_.emplace(value->name, *value);
+            if (inserted)
+            {
+                this->values_by_index_.emplace_back(it->first);
+            }
+        }
+
+        const auto sub_key_count = cache.get_sub_key_count(this->cache_index_);
+        for (size_t i = 0; i < sub_key_count; ++i)
+        {
+            const auto sub_key = cache.get_sub_key(this->cache_index_, i);
+            if (!sub_key)
+            {
+                continue;
+            }
+
+            const auto [it, inserted] = this->sub_keys_.emplace(cache.get_key_name(*sub_key), hive_key{cache, *sub_key});
+            if (inserted)
+            {
+                this->sub_keys_by_index_.emplace_back(it->first);
+            }
+        }
+    }
+
+    void hive_key::parse(const hive_file& file)
     {
         if (this->parsed_)
         {
@@ -237,6 +233,12 @@ namespace sogen
 
         this->parsed_ = true;
 
+        if (this->cache_)
+        {
+            this->parse_cached();
+            return;
+        }
+
         // Values
 
         for (auto i = 0; i < this->value_count_; i++)
@@ -244,22 +246,22 @@ namespace sogen
             const auto offset = read_file_object<int>(file, MAIN_ROOT_OFFSET + this->value_offsets_ + 4, i);
             const auto value = read_file_object<value_block_t>(file, MAIN_ROOT_OFFSET + offset);
 
-            const auto value_name_len = value.name_len < 0 ? size_t{0} : std::min(static_cast<size_t>(value.name_len), sizeof(value.name));
-            std::string value_name(value.name, value_name_len);
-
-            raw_hive_value raw_value{};
-            raw_value.parsed = false;
-            raw_value.type = value.value_type;
-            raw_value.name = value_name;
-            raw_value.data_length = value.size & 0xffff;
-            raw_value.data_offset = value.offset + 4;
+            const auto value_name =
+                get_cell_name(file, MAIN_ROOT_OFFSET + offset, offsetof(value_block_t, name), value.name_len, sizeof(value.name));
 
+            // Small values are stored inline, in place of the data cell offset.
+            auto data_offset = MAIN_ROOT_OFFSET + value.offset + 4;
             if (value.size & 1 << 31)
             {
-                raw_value.data_offset = offset + static_cast<int>(offsetof(value_block_t, offset));
+                data_offset = MAIN_ROOT_OFFSET + offset + offsetof(value_block_t, offset);
             }
 
-            const auto [it, inserted] = this->values_.emplace(std::move(value_name), std::move(raw_value));
+            hive_value entry{};
+            entry.type = value.value_type;
+            entry.name = value_name;
+            entry.data = get_file_data(file, data_offset, value.size & 0xffff);
+
+            const auto [it, inserted] = this->values_.emplace(value_name, entry);
             if (inserted)
             {
                 this->values_by_index_.emplace_back(it->first);
@@ -272,9 +274,69 @@ namespace sogen
     }
 
     hive_parser::hive_parser(const std::filesystem::path& file_path)
-        : file_(file_path, std::ios::binary),
+        : file_(file_path),
           root_key_(parse_root_block(file_, file_path))
     {
     }
 
+    hive_parser::hive_parser(std::shared_ptr<const registry_cache> cache, const uint32_t root_index, std::filesystem::path root_path)
+        : cache_(std::move(cache)),
+          cache_root_(std::move(root_path)),
+          root_key_(*this->cache_, root_index)
+    {
+    }
+
+    const hive_file& hive_parser::get_file() const
+    {
+        return this->cache_ ? this->cache_->get_file() : this->file_;
+    }
+
+    hive_key* hive_parser::get_sub_key(const std::filesystem::path& key)
+    {
+        constexpr size_t max_path_index_size = 0x10000;
+
+        if (this->cache_)
+        {
+            const auto index = this->cache_->find_key(registry_cache::make_path(this->cache_root_, key));
+            if (!index)
+            {
+                return nullptr;
+            }
+
+            return &this->cached_keys_.try_emplace(*index, *this->cache_, *index).first->second;
+        }
+
+        auto path = key.u16string();
+        if (const auto entry = this->path_index_.find(path); entry != this->path_index_.end())
+        {
+            return entry->second;
+        }
+
+        hive_key* current_key = &this->root_key_;
+
+        for (const auto& key_part : key)
+        {
+            if (key_part.empty())
+            {
+                continue;
+            }
+
+            if (!current_key)
+            {
+                break;
+            }
+
+            current_key = current_key->get_sub_key(this->file_, u16_to_u8(key_part.u16string()));
+        }
+
+        // Guests probing random paths must not grow the index without bound.
+        if (this->path_index_.size() >= max_path_index_size)
+        {
+            this->path_index_.clear();
+        }
+
+        this->path_index_.emplace(std::move(path), current_key);
+        return current_key;
+    }
+
 } // namespace sogen
@@ -1,22 +1,27 @@
 #pragma once
 
 #include <ranges>
-#include <fstream>
 #include <algorithm>
 
 #include <utils/container.hpp>
+#include <utils/mapped_file.hpp>
 #include <platform/unicode.hpp>
 
 namespace sogen
 {
 
+    // Names and data point into the mapped hive file and stay valid as long as the hive_parser does.
     struct hive_value
     {
         uint32_t type{};
-        std::string name{};
-        std::vector<std::byte> data{};
+        std::string_view name{};
+        std::span<const std::byte> data{};
     };
 
+    using hive_file = utils::mapped_file;
+
+    class registry_cache;
+
     class hive_key
     {
       public:
@@ -27,13 +32,22 @@ namespace sogen
         {
         }
 
-        utils::unordered_insensitive_string_map<hive_key>& get_sub_keys(std::ifstream& file)
+        // Key of a precompiled registry cache, the file passed to the accessors is not used then.
+        hive_key(const registry_cache& cache, const uint32_t cache_index)
+            : cache_(&cache),
+              cache_index_(cache_index)
+        {
+        }
+
+        using sub_key_map = std::unordered_map<std::string_view, hive_key, utils::insensitive_string_hash, utils::insensitive_string_equal>;
+
+        sub_key_map& get_sub_keys(const hive_file& file)
         {
             this->parse(file);
             return this->sub_keys_;
         }
 
-        const std::string_view* get_sub_key_name(std::ifstream& file, size_t index)
+        const std::string_view* get_sub_key_name(const hive_file& file, size_t index)
         {
             this->parse(file);
 
@@ -45,7 +59,7 @@ namespace sogen
             return &sub_keys_by_index_.at(index);
         }
 
-        hive_key* get_sub_key(std::ifstream& file, const std::string_view name)
+        hive_key* get_sub_key(const hive_file& file, const std::string_view name)
         {
             auto& sub_keys = this->get_sub_keys(file);
             const auto entry = sub_keys.find(name);
@@ -58,74 +72,54 @@ namespace sogen
             return &entry->second;
         }
 
-        hive_key* get_sub_key(std::ifstream& file, size_t index)
+        hive_key* get_sub_key(const hive_file& file, size_t index)
         {
             return get_sub_key(file, *this->get_sub_key_name(file, index));
         }
 
-        const hive_value* get_value(std::ifstream& file, std::string_view name);
-        const hive_value* get_value(std::ifstream& file, size_t index);
+        const hive_value* get_value(const hive_file& file, std::string_view name);
+        const hive_value* get_value(const hive_file& file, size_t index);
 
-        size_t get_sub_key_count(std::ifstream& file)
+        size_t get_sub_key_count(const hive_file& file)
         {
             this->parse(file);
             return this->sub_keys_.size();
         }
 
-        size_t get_value_count(std::ifstream& file)
+        size_t get_value_count(const hive_file& file)
         {
             this->parse(file);
             return this->values_.size();
         }
 
       private:
-        struct raw_hive_value : hive_value
-        {
-            bool parsed{false};
-            int data_offset{};
-            size_t data_length{};
-        };
+        using value_map = std::unordered_map<std::string_view, hive_value, utils::insensitive_string_hash, utils::insensitive_string_equal>;
 
         bool parsed_{false};
-        utils::unordered_insensitive_string_map<hive_key> sub_keys_{};
+        sub_key_map sub_keys_{};
         std::vector<std::string_view> sub_keys_by_index_{};
-        utils::unordered_insensitive_string_map<raw_hive_value> values_{};
+        value_map values_{};
         std::vector<std::string_view> values_by_index_{};
 
         const int subkey_block_offset_{};
         const int value_count_{};
         const int value_offsets_{};
 
-        void parse_subkey_list(std::ifstream& file, int32_t block_offset, bool allow_root_index);
-        void parse(std::ifstream& file);
+        const registry_cache* cache_{};
+        uint32_t cache_index_{};
+
+        void parse_subkey_list(const hive_file& file, int32_t block_offset, bool allow_root_index);
+        void parse_cached();
+        void parse(const hive_file& file);
     };
 
     class hive_parser
     {
       public:
         explicit hive_parser(const std::filesystem::path& file_path);
+        hive_parser(std::shared_ptr<const registry_cache> cache, uint32_t root_index, std::filesystem::path root_path);
 
-        [[nodiscard]] hive_key* get_sub_key(const std::filesystem::path& key)
-        {
-            hive_key* current_key = &this->root_key_;
-
-            for (const auto& key_part : key)
-            {
-                if (key_part.empty())
-                {
-                    continue;
-                }
-
-                if (!current_key)
-                {
-                    return nullptr;
-                }
-
-                current_key = current_key->get_sub_key(this->file_, u16_to_u8(key_part.u16string()));
-            }
-
-            return current_key;
-        }
+        [[nodiscard]] hive_key* get_sub_key(const std::filesystem::path& key);
 
         [[nodiscard]] const std::string_view* get_sub_key_name(const std::filesystem::path& key, size_t index)
         {
@@ -135,7 +129,7 @@ namespace sogen
                 return nullptr;
             }
 
-            return target_key->get_sub_key_name(this->file_, index);
+            return target_key->get_sub_key_name(this->get_file(), index);
         }
 
         [[nodiscard]] const hive_value* get_value(const std::filesystem::path& key, const std::string_view name)
@@ -146,7 +140,7 @@ namespace sogen
                 return nullptr;
             }
 
-            return sub_key->get_value(this->file_, name);
+            return sub_key->get_value(this->get_file(), name);
         }
 
         [[nodiscard]] const hive_value* get_value(const std::filesystem::path& key, size_t index)
@@ -157,17 +151,22 @@ namespace sogen
                 return nullptr;
             }
 
-            return sub_key->get_value(this->file_, index);
+            return sub_key->get_value(this->get_file(), index);
         }
 
-        std::ifstream& get_file()
-        {
-            return this->file_;
-        }
+        const hive_file& get_file() const;
 
       private:
-        std::ifstream file_{};
+        hive_file file_{};
+        std::shared_ptr<const registry_cache> cache_{};
+        std::filesystem::path cache_root_{};
         hive_key root_key_;
+
+        // Keys looked up through the hashed path table of the cache.
+        std::unordered_map<uint32_t, hive_key> cached_keys_{};
+
+        // Resolved paths, misses included. The hive is never modified, so entries never go stale.
+        utils::unordered_insensitive_u16string_map<hive_key*> path_index_{};
     };
 
 } // namespace sogen
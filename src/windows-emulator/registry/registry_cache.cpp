@@ -0,0 +1,638 @@
+#include "../std_include.hpp"
+#include "registry_cache.hpp"
+#include "registry_file.hpp"
+#include "registry_manager.hpp"
+
+#include <address_utils.hpp>
+#include <utils/io.hpp>
+#include <utils/string.hpp>
+
+namespace sogen
+{
+    namespace
+    {
+        constexpr std::array<char, 8> cache_magic{'S', 'O', 'G', 'E', 'N', 'R', 'E', 'G'};
+
+        struct cache_header
+        {
+            std::array<char, 8> magic{};
+            uint32_t version{};
+            uint32_t source_count{};
+            uint32_t overlay_count{};
+            uint32_t key_count{};
+            uint32_t value_count{};
+            uint32_t sub_key_count{};
+            uint32_t bucket_count{};
+            uint32_t reserved{};
+            uint64_t sources_offset{};
+            uint64_t overlays_offset{};
+            uint64_t keys_offset{};
+            uint64_t values_offset{};
+            uint64_t sub_keys_offset{};
+            uint64_t buckets_offset{};
+            uint64_t strings_offset{};
+            uint64_t strings_size{};
+            uint64_t blobs_offset{};
+            uint64_t blobs_size{};
+        };
+
+        // A file the cache was built from. Sources that did not exist are recorded too, so creating one
+        // (e.g. an optional hive) invalidates the cache as well.
+        struct cache_source
+        {
+            uint32_t path{};
+            uint32_t exists{};
+            uint64_t size{};
+            int64_t write_time{};
+        };
+
+        struct cache_key
+        {
+            uint32_t path{};
+            uint32_t name{};
+            uint32_t first_sub_key{};
+            uint32_t sub_key_count{};
+            uint32_t first_value{};
+            uint32_t value_count{};
+        };
+
+        struct cache_value
+        {
+            uint32_t name{};
+            uint32_t type{};
+            uint64_t data_offset{};
+            uint64_t data_size{};
+        };
+
+        uint64_t hash_path(const std::string_view path)
+        {
+            uint64_t hash = 0xcbf29ce484222325;
+            for (const auto c : path)
+            {
+                hash ^= static_cast<uint8_t>(utils::string::char_to_lower(c));
+                hash *= 0x100000001b3;
+            }
+
+            return hash;
+        }
+
+        std::optional<cache_source> get_source_stamp(const std::filesystem::path& file)
+        {
+            std::error_code ec{};
+            const auto size = std::filesystem::file_size(file, ec);
+            if (ec)
+            {
+                return std::nullopt;
+            }
+
+            const auto write_time = std::filesystem::last_write_time(file, ec);
+            if (ec)
+            {
+                return std::nullopt;
+            }
+
+            cache_source source{};
+            source.exists = 1;
+            source.size = size;
+            source.write_time = static_cast<int64_t>(write_time.time_since_epoch().count());
+            return source;
+        }
+
+        std::filesystem::path get_source_path(const std::filesystem::path& cache_file, const std::filesystem::path& source)
+        {
+            const auto directory = std::filesystem::absolute(cache_file).parent_path();
+            const auto relative = std::filesystem::absolute(source).lexically_relative(directory);
+            return relative.empty() ? std::filesystem::absolute(source) : relative;
+        }
+
+        template <typename T>
+            requires(std::is_trivially_copyable_v<T>)
+        std::optional<T> read_object(const std::span<const std::byte> data, const uint64_t offset)
+        {
+            if (offset > data.size() || data.size() - offset < sizeof(T))
+            {
+                return std::nullopt;
+            }
+
+            T obj{};
+            memcpy(&obj, data.data() + offset, sizeof(T));
+            return obj;
+        }
+
+        template <typename T>
+        std::optional<T> read_entry(const std::span<const std::byte> data, const uint64_t table_offset, const uint32_t count,
+                                    const uint64_t index)
+        {
+            if (index >= count)
+            {
+                return std::nullopt;
+            }
+
+            return read_object<T>(data, table_offset + (index * sizeof(T)));
+        }
+
+        class cache_builder
+        {
+          public:
+            uint32_t add_string(const std::string_view value)
+            {
+                const auto entry = this->string_refs_.find(value);
+                if (entry != this->string_refs_.end())
+                {
+                    return entry->second;
+                }
+
+                const auto ref = static_cast<uint32_t>(this->strings_.size());
+                const auto length = static_cast<uint32_t>(value.size());
+                this->strings_.resize(this->strings_.size() + sizeof(length) + value.size());
+                memcpy(this->strings_.data() + ref, &length, sizeof(length));
+                memcpy(this->strings_.data() + ref + sizeof(length), value.data(), value.size());
+
+                this->string_refs_.emplace(std::string{value}, ref);
+                return ref;
+            }
+
+            uint64_t add_blob(const std::span<const std::byte> data)
+            {
+                const std::string key(reinterpret_cast<const char*>(data.data()), data.size());
+                const auto entry = this->blob_refs_.find(key);
+                if (entry != this->blob_refs_.end())
+                {
+                    return entry->second;
+                }
+
+                const auto offset = static_cast<uint64_t>(this->blobs_.size());
+                this->blobs_.insert(this->blobs_.end(), data.begin(), data.end());
+                this->blob_refs_.emplace(key, offset);
+                return offset;
+            }
+
+            void add_source(const std::filesystem::path& cache_file, const std::filesystem::path& source)
+            {
+                auto stamp = get_source_stamp(source).value_or(cache_source{});
+                stamp.path = this->add_string(u16_to_u8(get_source_path(cache_file, source).generic_u16string()));
+                this->sources_.push_back(stamp);
+            }
+
+            // .reg file applied on top of the hives, in the order they were imported.
+            void add_overlay(const std::filesystem::path& cache_file, const std::filesystem::path& overlay)
+            {
+                this->overlays_.push_back(this->add_string(u16_to_u8(get_source_path(cache_file, overlay).generic_u16string())));
+            }
+
+            // Flattens one hive, breadth first, so that the sub keys of every key are stored next to each other.
+            void add_hive(registry_manager& registry, const utils::path_key& hive)
+            {
+                std::deque<std::pair<uint32_t, std::filesystem::path>> pending{};
+                pending.emplace_back(this->add_key(hive.get(), {}, {}), std::filesystem::path{});
+
+                while (!pending.empty())
+                {
+                    const auto [index, relative_path] = std::move(pending.front());
+                    pending.pop_front();
+
+                    registry_key key{};
+                    key.hive = hive;
+                    key.path = relative_path;
+
+                    this->keys_[index].first_value = static_cast<uint32_t>(this->values_.size());
+                    const auto value_count = registry.get_value_count(key);
+                    for (size_t i = 0; i < value_count; ++i)
+                    {
+                        const auto value = registry.get_value(key, i);
+                        if (!value)
+                        {
+                            continue;
+                        }
+
+                        cache_value entry{};
+                        entry.name = this->add_string(value->name);
+                        entry.type = value->type;
+                        entry.data_offset = this->add_blob(value->data);
+                        entry.data_size = value->data.size();
+                        this->values_.push_back(entry);
+                    }
+
+                    this->keys_[index].value_count = static_cast<uint32_t>(this->values_.size()) - this->keys_[index].first_value;
+
+                    std::vector<std::string> names{};
+                    const auto sub_key_count = registry.get_sub_key_count(key);
+                    for (size_t i = 0; i < sub_key_count; ++i)
+                    {
+                        if (const auto name = registry.get_sub_key_name(key, i))
+                        {
+                            names.emplace_back(*name);
+                        }
+                    }
+
+                    this->keys_[index].first_sub_key = static_cast<uint32_t>(this->sub_keys_.size());
+                    this->keys_[index].sub_key_count = static_cast<uint32_t>(names.size());
+
+                    for (const auto& name : names)
+                    {
+                        auto child_path = utils::path_key{relative_path / name}.get();
+                        const auto child = this->add_key(hive.get(), child_path, name);
+                        this->sub_keys_.push_back(child);
+                        pending.emplace_back(child, std::move(child_path));
+                    }
+                }
+            }
+
+            std::vector<std::byte> build() const
+            {
+                uint32_t bucket_count = 16;
+                while (bucket_count < this->keys_.size() * 2)
+                {
+                    bucket_count *= 2;
+                }
+
+                // Open addressing with linear probing, a slot holds key index + 1.
+                std::vector<uint32_t> buckets(bucket_count);
+                for (uint32_t i = 0; i < this->keys_.size(); ++i)
+                {
+                    auto slot = hash_path(this->paths_[i]) & (bucket_count - 1);
+                    while (buckets[slot] != 0)
+                    {
+                        slot = (slot + 1) & (bucket_count - 1);
+                    }
+
+                    buckets[slot] = i + 1;
+                }
+
+                cache_header header{};
+                header.magic = cache_magic;
+                header.version = registry_cache::version;
+                header.source_count = static_cast<uint32_t>(this->sources_.size());
+                header.overlay_count = static_cast<uint32_t>(this->overlays_.size());
+                header.key_count = static_cast<uint32_t>(this->keys_.size());
+                header.value_count = static_cast<uint32_t>(this->values_.size());
+                header.sub_key_count = static_cast<uint32_t>(this->sub_keys_.size());
+                header.bucket_count = bucket_count;
+
+                std::vector<std::byte> result{};
+                const auto append = [&result](const void* data, const size_t size) {
+                    const auto offset = static_cast<uint64_t>(result.size());
+                    result.resize(offset + size);
+                    if (size != 0)
+                    {
+                        memcpy(result.data() + offset, data, size);
+                    }
+
+                    result.resize(align_up(result.size(), 8));
+                    return offset;
+                };
+
+                append(&header, sizeof(header));
+                header.sources_offset = append(this->sources_.data(), this->sources_.size() * sizeof(cache_source));
+                header.overlays_offset = append(this->overlays_.data(), this->overlays_.size() * sizeof(uint32_t));
+                header.keys_offset = append(this->keys_.data(), this->keys_.size() * sizeof(cache_key));
+                header.values_offset = append(this->values_.data(), this->values_.size() * sizeof(cache_value));
+                header.sub_keys_offset = append(this->sub_keys_.data(), this->sub_keys_.size() * sizeof(uint32_t));
+                header.buckets_offset = append(buckets.data(), buckets.size() * sizeof(uint32_t));
+                header.strings_offset = append(this->strings_.data(), this->strings_.size());
+                header.strings_size = this->strings_.size();
+                header.blobs_offset = append(this->blobs_.data(), this->blobs_.size());
+                header.blobs_size = this->blobs_.size();
+
+                memcpy(result.data(), &header, sizeof(header));
+                return result;
+            }
+
+          private:
+            std::vector<cache_source> sources_{};
+            std::vector<uint32_t> overlays_{};
+            std::vector<cache_key> keys_{};
+            std::vector<std::string> paths_{};
+            std::vector<cache_value> values_{};
+            std::vector<uint32_t> sub_keys_{};
+            std::vector<std::byte> strings_{};
+            std::vector<std::byte> blobs_{};
+            utils::unordered_string_map<uint32_t> string_refs_{};
+            utils::unordered_string_map<uint64_t> blob_refs_{};
+
+            uint32_t add_key(const std::filesystem::path& hive, const std::filesystem::path& relative_path, const std::string_view name)
+            {
+                auto path = registry_cache::make_path(hive, relative_path);
+
+                cache_key key{};
+                key.path = this->add_string(path);
+                key.name = this->add_string(name);
+
+                this->keys_.push_back(key);
+                this->paths_.push_back(std::move(path));
+                return static_cast<uint32_t>(this->keys_.size() - 1);
+            }
+        };
+
+        std::optional<cache_header> read_header(const std::span<const std::byte> data)
+        {
+            const auto header = read_object<cache_header>(data, 0);
+            if (!header || header->magic != cache_magic || header->version != registry_cache::version)
+            {
+                return std::nullopt;
+            }
+
+            if (header->bucket_count == 0 || (header->bucket_count & (header->bucket_count - 1)) != 0)
+            {
+                return std::nullopt;
+            }
+
+            const auto fits = [&](const uint64_t offset, const uint64_t size) {
+                return offset <= data.size() && size <= data.size() - offset;
+            };
+
+            if (!fits(header->sources_offset, uint64_t{header->source_count} * sizeof(cache_source)) ||
+                !fits(header->overlays_offset, uint64_t{header->overlay_count} * sizeof(uint32_t)) ||
+                !fits(header->keys_offset, uint64_t{header->key_count} * sizeof(cache_key)) ||
+                !fits(header->values_offset, uint64_t{header->value_count} * sizeof(cache_value)) ||
+                !fits(header->sub_keys_offset, uint64_t{header->sub_key_count} * sizeof(uint32_t)) ||
+                !fits(header->buckets_offset, uint64_t{header->bucket_count} * sizeof(uint32_t)) ||
+                !fits(header->strings_offset, header->strings_size) || !fits(header->blobs_offset, header->blobs_size))
+            {
+                return std::nullopt;
+            }
+
+            return header;
+        }
+
+        std::string_view read_string(const std::span<const std::byte> data, const cache_header& header, const uint32_t ref)
+        {
+            if (header.strings_size < sizeof(uint32_t) || ref > header.strings_size - sizeof(uint32_t))
+            {
+                return {};
+            }
+
+            const auto length = read_object<uint32_t>(data, header.strings_offset + ref);
+            if (!length || header.strings_size - ref - sizeof(uint32_t) < *length)
+            {
+                return {};
+            }
+
+            return {reinterpret_cast<const char*>(data.data() + header.strings_offset + ref + sizeof(uint32_t)), *length};
+        }
+
+        bool sources_match(const std::filesystem::path& cache_file, const std::span<const std::byte> data, const cache_header& header)
+        {
+            const auto directory = std::filesystem::absolute(cache_file).parent_path();
+
+            for (uint32_t i = 0; i < header.source_count; ++i)
+            {
+                const auto source = read_entry<cache_source>(data, header.sources_offset, header.source_count, i);
+                if (!source)
+                {
+                    return false;
+                }
+
+                const std::filesystem::path path = u8_to_u16(read_string(data, header, source->path));
+                const auto current = get_source_stamp(path.is_absolute() ? path : directory / path);
+
+                if (!source->exists)
+                {
+                    if (current)
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if (!current || current->size != source->size || current->write_time != source->write_time)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool overlays_match(const std::filesystem::path& cache_file, const std::span<const std::byte> data, const cache_header& header,
+                            const std::span<const std::filesystem::path> registry_files)
+        {
+            if (header.overlay_count != registry_files.size())
+            {
+                return false;
+            }
+
+            for (uint32_t i = 0; i < header.overlay_count; ++i)
+            {
+                const auto overlay = read_entry<uint32_t>(data, header.overlays_offset, header.overlay_count, i);
+                if (!overlay)
+                {
+                    return false;
+                }
+
+                const auto requested = u16_to_u8(get_source_path(cache_file, registry_files[i]).generic_u16string());
+                if (read_string(data, header, *overlay) != requested)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        const cache_header& get_header(const hive_file& file)
+        {
+            // Only called on files that passed read_header in open().
+            return *reinterpret_cast<const cache_header*>(file.data());
+        }
+    }
+
+    registry_cache::registry_cache(hive_file file)
+        : file_(std::move(file))
+    {
+    }
+
+    std::shared_ptr<const registry_cache> registry_cache::open(const std::filesystem::path& file,
+                                                               const std::span<const std::filesystem::path> registry_files)
+    {
+        struct shared_entry
+        {
+            std::weak_ptr<const registry_cache> cache{};
+            cache_source stamp{};
+        };
+
+        static std::mutex mutex{};
+        static std::map<std::filesystem::path, shared_entry> shared_caches{};
+
+        const auto stamp = get_source_stamp(file);
+        if (!stamp)
+        {
+            return nullptr;
+        }
+
+        const auto path = std::filesystem::absolute(file);
+        const std::scoped_lock lock{mutex};
+
+        auto& entry = shared_caches[path];
+        auto cache = entry.cache.lock();
+
+        if (!cache || entry.stamp.size != stamp->size || entry.stamp.write_time != stamp->write_time)
+        {
+            try
+            {
+                hive_file mapping{path};
+                if (!read_header(mapping.get_span()))
+                {
+                    return nullptr;
+                }
+
+                cache = std::make_shared<const registry_cache>(std::move(mapping));
+            }
+            catch (const std::exception&)
+            {
+                return nullptr;
+            }
+
+            entry.cache = cache;
+            entry.stamp = *stamp;
+        }
+
+        const auto data = cache->get_file().get_span();
+        const auto& header = get_header(cache->get_file());
+        if (!overlays_match(path, data, header, registry_files) || !sources_match(path, data, header))
+        {
+            return nullptr;
+        }
+
+        return cache;
+    }
+
+    void registry_cache::compile(const std::filesystem::path& hive_path, const std::span<const std::filesystem::path> registry_files,
+                                 const std::filesystem::path& file)
+    {
+        registry_manager registry{hive_path, false};
+        for (const auto& registry_file : registry_files)
+        {
+            import_registry_file(registry, registry_file);
+        }
+
+        cache_builder builder{};
+
+        for (const auto& source : registry.get_hive_files())
+        {
+            builder.add_source(file, source);
+        }
+
+        for (const auto& registry_file : registry_files)
+        {
+            builder.add_source(file, registry_file);
+            builder.add_overlay(file, registry_file);
+        }
+
+        for (const auto& hive : registry.get_hive_paths())
+        {
+            builder.add_hive(registry, hive);
+        }
+
+        const auto data = builder.build();
+
+        // Replace the file instead of rewriting it, processes still using the old mapping keep their view.
+        auto temporary_file = file;
+        temporary_file += ".tmp";
+
+        if (!utils::io::write_file(temporary_file, data))
+        {
+            throw std::runtime_error("Failed to write registry cache: " + temporary_file.string());
+        }
+
+        std::filesystem::rename(temporary_file, file);
+    }
+
+    std::string registry_cache::make_path(const std::filesystem::path& hive, const std::filesystem::path& relative_path)
+    {
+        auto path = u16_to_u8(hive.generic_u16string());
+        const auto relative = u16_to_u8(relative_path.generic_u16string());
+
+        if (!relative.empty())
+        {
+            path += '/';
+            path += relative;
+        }
+
+        return utils::string::to_lower_consume(path);
+    }
+
+    std::optional<uint32_t> registry_cache::find_key(const std::string_view path) const
+    {
+        const auto data = this->file_.get_span();
+        const auto& header = get_header(this->file_);
+        const auto mask = header.bucket_count - 1;
+
+        auto slot = hash_path(path) & mask;
+        for (uint32_t i = 0; i < header.bucket_count; ++i, slot = (slot + 1) & mask)
+        {
+            const auto bucket = read_entry<uint32_t>(data, header.buckets_offset, header.bucket_count, slot).value_or(0);
+            if (bucket == 0)
+            {
+                break;
+            }
+
+            const auto key = read_entry<cache_key>(data, header.keys_offset, header.key_count, bucket - 1);
+            if (key && utils::string::equals_ignore_case(read_string(data, header, key->path), path))
+            {
+                return bucket - 1;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::string_view registry_cache::get_key_name(const uint32_t key) const
+    {
+        const auto data = this->file_.get_span();
+        const auto& header = get_header(this->file_);
+        const auto entry = read_entry<cache_key>(data, header.keys_offset, header.key_count, key);
+        return entry ? read_string(data, header, entry->name) : std::string_view{};
+    }
+
+    size_t registry_cache::get_sub_key_count(const uint32_t key) const
+    {
+        const auto& header = get_header(this->file_);
+        const auto entry = read_entry<cache_key>(this->file_.get_span(), header.keys_offset, header.key_count, key);
+        return entry ? entry->sub_key_count : 0;
+    }
+
+    std::optional<uint32_t> registry_cache::get_sub_key(const uint32_t key, const size_t index) const
+    {
+        const auto data = this->file_.get_span();
+        const auto& header = get_header(this->file_);
+        const auto entry = read_entry<cache_key>(data, header.keys_offset, header.key_count, key);
+        if (!entry || index >= entry->sub_key_count)
+        {
+            return std::nullopt;
+        }
+
+        return read_entry<uint32_t>(data, header.sub_keys_offset, header.sub_key_count, uint64_t{entry->first_sub_key} + index);
+    }
+
+    size_t registry_cache::get_value_count(const uint32_t key) const
+    {
+        const auto& header = get_header(this->file_);
+        const auto entry = read_entry<cache_key>(this->file_.get_span(), header.keys_offset, header.key_count, key);
+        return entry ? entry->value_count : 0;
+    }
+
+    std::optional<hive_value> registry_cache::get_value(const uint32_t key, const size_t index) const
+    {
+        const auto data = this->file_.get_span();
+        const auto& header = get_header(this->file_);
+        const auto entry = read_entry<cache_key>(data, header.keys_offset, header.key_count, key);
+        if (!entry || index >= entry->value_count)
+        {
+            return std::nullopt;
+        }
+
+        const auto value = read_entry<cache_value>(data, header.values_offset, header.value_count, uint64_t{entry->first_value} + index);
+        if (!value || value->data_offset > header.blobs_size || value->data_size > header.blobs_size - value->data_offset)
+        {
+            return std::nullopt;
+        }
+
+        hive_value result{};
+        result.type = value->type;
+        result.name = read_string(data, header, value->name);
+        result.data = data.subspan(header.blobs_offset + value->data_offset, value->data_size);
+        return result;
+    }
+} // namespace sogen
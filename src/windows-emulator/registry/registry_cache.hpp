@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../std_include.hpp"
+#include "hive_parser.hpp"
+
+namespace sogen
+{
+    class registry_manager;
+
+    // Precompiled registry: every key of the loaded hives, including imported .reg overlays, flattened into one
+    // mapped file with a hashed path table, interned strings and value blobs. Names and data handed out are
+    // views into the mapping, which is shared by all registry managers of the process that open the same cache.
+    // The ordered list of overlays is part of the cache, it only serves runs that request exactly that list.
+    class registry_cache
+    {
+      public:
+        static constexpr uint32_t version = 2;
+        static constexpr auto file_name = "registry.cache";
+
+        // Returns nullptr if there is no cache, it has a different version, any of its sources changed or it was
+        // compiled with other .reg files than registry_files, or in another order.
+        static std::shared_ptr<const registry_cache> open(const std::filesystem::path& file,
+                                                          std::span<const std::filesystem::path> registry_files = {});
+
+        // Writes a cache of all hives in hive_path with the given .reg files applied on top.
+        static void compile(const std::filesystem::path& hive_path, std::span<const std::filesystem::path> registry_files,
+                            const std::filesystem::path& file);
+
+        // Key of the table for a path relative to a hive root, both canonical as produced by utils::path_key.
+        static std::string make_path(const std::filesystem::path& hive, const std::filesystem::path& relative_path);
+
+        explicit registry_cache(hive_file file);
+
+        const hive_file& get_file() const
+        {
+            return this->file_;
+        }
+
+        std::optional<uint32_t> find_key(std::string_view path) const;
+
+        std::string_view get_key_name(uint32_t key) const;
+        size_t get_sub_key_count(uint32_t key) const;
+        std::optional<uint32_t> get_sub_key(uint32_t key, size_t index) const;
+        size_t get_value_count(uint32_t key) const;
+        std::optional<hive_value> get_value(uint32_t key, size_t index) const;
+
+      private:
+        hive_file file_{};
+    };
+} // namespace sogen
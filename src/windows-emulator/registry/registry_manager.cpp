@@ -5,6 +5,8 @@
 #include <serialization_helper.hpp>
 
 #include "hive_parser.hpp"
+#include "registry_cache.hpp"
+#include "registry_file.hpp"
 
 namespace sogen
 {
@@ -27,21 +29,6 @@ namespace sogen
             return true;
         }
 
-        void register_hive(registry_manager::hive_map& hives, const utils::path_key& key, const std::filesystem::path& file)
-        {
-            hives[key] = std::make_unique<hive_parser>(file);
-        }
-
-        void register_optional_hive(registry_manager::hive_map& hives, const utils::path_key& key, const std::filesystem::path& file)
-        {
-            if (!std::filesystem::is_regular_file(file))
-            {
-                return;
-            }
-
-            hives[key] = std::make_unique<hive_parser>(file);
-        }
-
         std::pair<utils::path_key, bool> perform_path_substitution(const std::map<utils::path_key, utils::path_key>& path_mapping,
                                                                    utils::path_key path)
         {
@@ -67,30 +54,75 @@ namespace sogen
     registry_manager::registry_manager(registry_manager&&) noexcept = default;
     registry_manager& registry_manager::operator=(registry_manager&&) noexcept = default;
 
-    registry_manager::registry_manager(const std::filesystem::path& hive_path)
-        : hive_path_(std::filesystem::absolute(hive_path))
+    registry_manager::registry_manager(const std::filesystem::path& hive_path, const bool use_cache)
+        : registry_manager(hive_path, {}, use_cache)
     {
-        this->setup();
     }
 
-    void registry_manager::setup()
+    registry_manager::registry_manager(const std::filesystem::path& hive_path, std::vector<std::filesystem::path> registry_files,
+                                       const bool use_cache)
+        : hive_path_(std::filesystem::absolute(hive_path)),
+          registry_files_(std::move(registry_files))
+    {
+        this->setup(use_cache);
+    }
+
+    std::vector<utils::path_key> registry_manager::get_hive_paths() const
+    {
+        std::vector<utils::path_key> paths{};
+        paths.reserve(this->hives_.size());
+
+        for (const auto& hive : this->hives_ | std::views::keys)
+        {
+            paths.push_back(hive);
+        }
+
+        return paths;
+    }
+
+    void registry_manager::register_hive(const std::shared_ptr<const registry_cache>& cache, const utils::path_key& key,
+                                         const std::filesystem::path& file, const bool optional)
+    {
+        this->hive_files_.push_back(file);
+
+        if (cache)
+        {
+            if (const auto root = cache->find_key(registry_cache::make_path(key.get(), {})))
+            {
+                this->hives_[key] = std::make_unique<hive_parser>(cache, *root, key.get());
+                return;
+            }
+        }
+
+        if (optional && !std::filesystem::is_regular_file(file))
+        {
+            return;
+        }
+
+        this->hives_[key] = std::make_unique<hive_parser>(file);
+    }
+
+    void registry_manager::setup(const bool use_cache)
     {
         this->path_mapping_.clear();
         this->overlay_values_.clear();
         this->hives_.clear();
+        this->hive_files_.clear();
+
+        // A cache that is missing, out of date or built with other overlays falls back to parsing the hives.
+        const auto cache = use_cache ? registry_cache::open(this->hive_path_ / registry_cache::file_name, this->registry_files_) : nullptr;
 
         const std::filesystem::path root = R"(\registry)";
         const std::filesystem::path machine = root / "machine";
         const std::filesystem::path user = root / "user";
 
-        register_hive(this->hives_, machine / "system", this->hive_path_ / "SYSTEM");
-        register_hive(this->hives_, machine / "security", this->hive_path_ / "SECURITY");
-        register_hive(this->hives_, machine / "sam", this->hive_path_ / "SAM");
-        register_hive(this->hives_, machine / "software", this->hive_path_ / "SOFTWARE");
-        register_hive(this->hives_, machine / "system", this->hive_path_ / "SYSTEM");
-        register_optional_hive(this->hives_, machine / "hardware", this->hive_path_ / "HARDWARE");
+        this->register_hive(cache, machine / "system", this->hive_path_ / "SYSTEM");
+        this->register_hive(cache, machine / "security", this->hive_path_ / "SECURITY");
+        this->register_hive(cache, machine / "sam", this->hive_path_ / "SAM");
+        this->register_hive(cache, machine / "software", this->hive_path_ / "SOFTWARE");
+        this->register_hive(cache, machine / "hardware", this->hive_path_ / "HARDWARE", true);
 
-        register_hive(this->hives_, root / "user", this->hive_path_ / "NTUSER.DAT");
+        this->register_hive(cache, root / "user", this->hive_path_ / "NTUSER.DAT");
 
         this->add_path_mapping(user / registry_utils::get_user_sid_string(*this), user);
         this->add_path_mapping(user / ".Default", user);
@@ -244,6 +276,15 @@ namespace sogen
         this->add_path_mapping(machine / "SOFTWARE" / "Wow6432Node" / "Policies", machine / "SOFTWARE" / "Policies");
         this->add_path_mapping(machine / "SOFTWARE" / "Wow6432Node" / "RegisteredApplications",
                                machine / "SOFTWARE" / "RegisteredApplications");
+
+        // A matching cache has the overlays compiled in, the raw hives need them imported.
+        if (!cache)
+        {
+            for (const auto& file : this->registry_files_)
+            {
+                import_registry_file(*this, file);
+            }
+        }
     }
 
     utils::path_key registry_manager::normalize_path(utils::path_key path) const
@@ -422,7 +463,7 @@ namespace sogen
     std::optional<registry_value> registry_manager::get_value(const registry_key& key, const size_t index)
     {
         hive_key* backing_key = nullptr;
-        std::ifstream* hive_file = nullptr;
+        const hive_file* hive_file = nullptr;
         size_t backing_count = 0;
         if (const auto iterator = this->hives_.find(key.hive); iterator != this->hives_.end())
         {
@@ -470,7 +511,7 @@ namespace sogen
     size_t registry_manager::get_value_count(const registry_key& key)
     {
         hive_key* backing_key = nullptr;
-        std::ifstream* hive_file = nullptr;
+        const hive_file* hive_file = nullptr;
         size_t result = 0;
         if (const auto iterator = this->hives_.find(key.hive); iterator != this->hives_.end())
         {
@@ -566,7 +607,7 @@ namespace sogen
     std::optional<std::string_view> registry_manager::get_sub_key_name(const registry_key& key, const size_t index)
     {
         hive_key* backing_key = nullptr;
-        std::ifstream* hive_file = nullptr;
+        const hive_file* hive_file = nullptr;
         size_t backing_count = 0;
         if (const auto iterator = this->hives_.find(key.hive); iterator != this->hives_.end())
         {
@@ -613,7 +654,7 @@ namespace sogen
     size_t registry_manager::get_sub_key_count(const registry_key& key)
     {
         hive_key* backing_key = nullptr;
-        std::ifstream* hive_file = nullptr;
+        const hive_file* hive_file = nullptr;
         size_t result = 0;
         if (const auto iterator = this->hives_.find(key.hive); iterator != this->hives_.end())
         {
@@ -26,6 +26,7 @@
 
 namespace sogen
 {
+    class registry_cache;
 
     struct registry_key : ref_counted_object
     {
@@ -98,7 +99,7 @@ namespace sogen
     struct exposed_hive_key
     {
         hive_key& key;
-        std::ifstream& file;
+        const hive_file& file;
     };
 
     class registry_manager
@@ -108,7 +109,10 @@ namespace sogen
         using hive_map = std::unordered_map<utils::path_key, hive_ptr>;
 
         registry_manager();
-        registry_manager(const std::filesystem::path& hive_path);
+        // Uses the registry_cache in hive_path when it is up to date. The .reg files are applied on top of the
+        // hives in order, taken from the cache if it was compiled with the same list.
+        registry_manager(const std::filesystem::path& hive_path, bool use_cache = true);
+        registry_manager(const std::filesystem::path& hive_path, std::vector<std::filesystem::path> registry_files, bool use_cache = true);
         ~registry_manager();
 
         registry_manager(registry_manager&&) noexcept;
@@ -130,6 +134,14 @@ namespace sogen
 
         std::optional<exposed_hive_key> get_hive_key(const registry_key& key);
 
+        std::vector<utils::path_key> get_hive_paths() const;
+
+        // Hive files this manager was set up from, including optional ones that do not exist.
+        const std::vector<std::filesystem::path>& get_hive_files() const
+        {
+            return this->hive_files_;
+        }
+
         std::optional<std::u16string> read_u16string(const registry_key& key, size_t index);
         void serialize_runtime_state(utils::buffer_serializer& buffer) const;
         void deserialize_runtime_state(utils::buffer_deserializer& buffer);
@@ -172,7 +184,9 @@ namespace sogen
         };
 
         std::filesystem::path hive_path_{};
+        std::vector<std::filesystem::path> registry_files_{};
         hive_map hives_{};
+        std::vector<std::filesystem::path> hive_files_{};
         std::map<utils::path_key, utils::path_key> path_mapping_{};
         std::map<utils::path_key, overlay_bucket> overlay_values_{};
 
@@ -183,7 +197,9 @@ namespace sogen
         hive_map::iterator find_hive(const utils::path_key& key);
         hive_map::const_iterator find_hive(const utils::path_key& key) const;
 
-        void setup();
+        void register_hive(const std::shared_ptr<const registry_cache>& cache, const utils::path_key& key,
+                           const std::filesystem::path& file, bool optional = false);
+        void setup(bool use_cache);
     };
 
 } // namespace sogen
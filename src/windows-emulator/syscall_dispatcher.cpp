@@ -28,6 +28,7 @@ namespace sogen
         buffer.read_map(this->handlers_);
         this->add_handlers();
         this->add_callbacks();
+        this->build_syscall_table();
     }
 
     void syscall_dispatcher::setup(const exported_symbols& ntdll_exports, const std::span<const std::byte> ntdll_data,
@@ -43,6 +44,34 @@ namespace sogen
 
         this->add_handlers();
         this->add_callbacks();
+        this->build_syscall_table();
+    }
+
+    void syscall_dispatcher::build_syscall_table()
+    {
+        std::ranges::fill(this->syscall_table_, nullptr);
+
+        for (const auto& [id, entry] : this->handlers_)
+        {
+            // Ids beyond the mask can never be dispatched.
+            if (id < syscall_table_size)
+            {
+                this->syscall_table_[id] = &entry;
+            }
+        }
+    }
+
+    std::optional<uint64_t> syscall_dispatcher::find_syscall_id(const std::string_view name) const
+    {
+        for (const auto& [id, entry] : this->handlers_)
+        {
+            if (entry.name == name)
+            {
+                return id;
+            }
+        }
+
+        return std::nullopt;
     }
 
     void syscall_dispatcher::add_handlers()
@@ -75,8 +104,8 @@ namespace sogen
         const auto raw_syscall_id = emu.reg<uint32_t>(x86_register::eax);
         const auto syscall_id = raw_syscall_id & 0x3FFF; // Only take low bits for WOW64 compatibility, match windoows wraparound
 
-        const auto entry = this->handlers_.find(syscall_id);
-        const auto* syscall_name = (entry != this->handlers_.end()) ? entry->second.name.c_str() : "<unknown>";
+        const auto* entry = this->syscall_table_[syscall_id];
+        const auto* syscall_name = entry ? entry->name.c_str() : "<unknown>";
 
         const syscall_context c{
             .win_emu = win_emu,
@@ -88,7 +117,7 @@ namespace sogen
 
         try
         {
-            if (entry == this->handlers_.end())
+            if (!entry)
             {
                 win_emu.log.error("Unknown syscall: 0x%X (raw: 0x%X)\n", syscall_id, raw_syscall_id);
                 win_emu.record_stop(stop_reason::unknown_syscall, "0x" + utils::string::to_hex_number(syscall_id));
@@ -97,24 +126,24 @@ namespace sogen
                 return;
             }
 
-            const auto res = win_emu.callbacks.on_syscall(syscall_id, entry->second.name);
+            const auto res = win_emu.callbacks.on_syscall(syscall_id, entry->name);
             if (res == instruction_hook_continuation::skip_instruction)
             {
                 return;
             }
 
-            if (!entry->second.handler)
+            if (!entry->handler)
             {
-                win_emu.log.error("Unimplemented syscall: %s - 0x%X (raw: 0x%X)\n", entry->second.name.c_str(), syscall_id, raw_syscall_id);
-                win_emu.record_stop(stop_reason::unimplemented_syscall, entry->second.name);
+                win_emu.log.error("Unimplemented syscall: %s - 0x%X (raw: 0x%X)\n", entry->name.c_str(), syscall_id, raw_syscall_id);
+                win_emu.record_stop(stop_reason::unimplemented_syscall, entry->name);
                 c.emu.reg<uint64_t>(x86_register::rax, STATUS_NOT_SUPPORTED);
                 win_emu.stop();
                 return;
             }
 
-            entry->second.handler(c);
+            entry->handler(c);
 
-            dispatch_callback(win_emu, entry->second.name);
+            dispatch_callback(win_emu, entry->name);
         }
         catch (std::exception& e)
         {
@@ -134,7 +163,7 @@ namespace sogen
         }
     }
 
-    void syscall_dispatcher::dispatch_callback(windows_emulator& win_emu, std::string& syscall_name)
+    void syscall_dispatcher::dispatch_callback(windows_emulator& win_emu, const std::string_view syscall_name)
     {
         // active_cpu(), not emu(): this runs under the syscall's scoped_dispatch, and with more than one
         // vCPU the instrumentation-callback redirect must rewrite the acting vCPU's RIP/r10, not vCPU 0's.
@@ -320,8 +320,14 @@ namespace sogen
         syscall_dispatcher(const exported_symbols& ntdll_exports, std::span<const std::byte> ntdll_data,
                            const exported_symbols& win32u_exports, std::span<const std::byte> win32u_data);
 
+        // The syscall table points into handlers_, which a copy would not carry along.
+        syscall_dispatcher(const syscall_dispatcher&) = delete;
+        syscall_dispatcher& operator=(const syscall_dispatcher&) = delete;
+        syscall_dispatcher(syscall_dispatcher&&) = default;
+        syscall_dispatcher& operator=(syscall_dispatcher&&) = default;
+
         void dispatch(windows_emulator& win_emu, vcpu_context& vcpu);
-        static void dispatch_callback(windows_emulator& win_emu, std::string& syscall_name);
+        static void dispatch_callback(windows_emulator& win_emu, std::string_view syscall_name);
         dispatch_result dispatch_completion(windows_emulator& win_emu, vcpu_context& vcpu, callback_id callback_id,
                                             completion_state* completion_state, const user_callback_result& callback_result);
 
@@ -336,6 +342,8 @@ namespace sogen
             return this->handlers_.at(id).name;
         }
 
+        std::optional<uint64_t> find_syscall_id(std::string_view name) const;
+
         static std::unique_ptr<completion_state> create_completion_state(callback_id id)
         {
             if (auto it = completion_state_factories_.find(id); it != completion_state_factories_.end())
@@ -346,13 +354,19 @@ namespace sogen
         }
 
       private:
+        // Syscall ids are masked to 14 bits, so dispatch indexes this dense table instead of searching
+        // handlers_. Rebuilt whenever handlers_ changes; unknown ids are null.
+        static constexpr size_t syscall_table_size = 0x4000;
+
         std::map<uint64_t, syscall_handler_entry> handlers_{};
+        std::vector<const syscall_handler_entry*> syscall_table_ = std::vector<const syscall_handler_entry*>(syscall_table_size);
         std::map<callback_id, syscall_handler> completion_handlers_;
         static std::map<callback_id, std::function<std::unique_ptr<completion_state>()>> completion_state_factories_;
 
         static void add_handlers(std::map<std::string, syscall_handler>& handler_mapping);
         void add_handlers();
         void add_callbacks();
+        void build_syscall_table();
     };
 
 } // namespace sogen
@@ -33,6 +33,7 @@ namespace sogen
             }
 
             entry->signaled = true;
+            c.proc.scheduler.notify_object(make_handle(handle));
             return STATUS_SUCCESS;
         }
 
@@ -65,6 +66,7 @@ namespace sogen
             }
 
             entry->signaled = false;
+            c.proc.scheduler.notify_object(event_handle);
             return STATUS_SUCCESS;
         }
 
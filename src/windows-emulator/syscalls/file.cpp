@@ -1226,6 +1226,7 @@ namespace sogen
                 if (auto* e = c.proc.events.get(event))
                 {
                     e->signaled = true;
+                    c.proc.scheduler.notify_object(make_handle(event));
                 }
             }
 
@@ -1,6 +1,7 @@
 #include "../std_include.hpp"
 #include "../debug_font.hpp"
 #include "../emulator_utils.hpp"
+#include "../gdi_raster.hpp"
 #include "../syscall_utils.hpp"
 
 #include <array>
@@ -481,44 +482,53 @@ namespace sogen
                     return;
                 }
 
-                if (surface.guest_bpp == 32)
+                if (surface.guest_bpp != 32 && surface.guest_bpp != 24)
                 {
-                    const size_t row_bytes = static_cast<size_t>(surface.width) * sizeof(uint32_t);
-                    if (surface.guest_stride < row_bytes)
-                    {
-                        return;
-                    }
+                    return;
+                }
 
-                    for (uint32_t y = 0; y < surface.height; ++y)
-                    {
-                        const uint32_t guest_row = surface.guest_top_down ? y : (surface.height - 1 - y);
-                        auto* dst = surface.pixels.data() + static_cast<size_t>(y) * surface.width;
-                        c.emu.read_memory(surface.guest_bits + static_cast<uint64_t>(guest_row) * surface.guest_stride, dst, row_bytes);
-                    }
+                const size_t row_bytes = static_cast<size_t>(surface.width) * (surface.guest_bpp / 8);
+                if (surface.guest_stride < row_bytes)
+                {
+                    return;
                 }
-                else if (surface.guest_bpp == 24)
+
+                // The guest writes DIB sections directly, so only rows that differ from the surface count as damage.
+                std::vector<uint8_t> row(row_bytes);
+                std::vector<uint32_t> converted(surface.width);
+                std::optional<uint32_t> first_changed{};
+                uint32_t last_changed = 0;
+
+                for (uint32_t y = 0; y < surface.height; ++y)
                 {
-                    const size_t row_bytes = static_cast<size_t>(surface.width) * 3;
-                    if (surface.guest_stride < row_bytes)
+                    const uint32_t guest_row = surface.guest_top_down ? y : (surface.height - 1 - y);
+                    auto* dst = surface.pixels.data() + static_cast<size_t>(y) * surface.width;
+
+                    if (surface.guest_bpp == 32)
                     {
-                        return;
+                        c.emu.read_memory(surface.guest_bits + static_cast<uint64_t>(guest_row) * surface.guest_stride, converted.data(),
+                                          row_bytes);
                     }
-
-                    std::vector<uint8_t> row(row_bytes);
-                    for (uint32_t y = 0; y < surface.height; ++y)
+                    else
                     {
-                        const uint32_t guest_row = surface.guest_top_down ? y : (surface.height - 1 - y);
                         c.emu.read_memory(surface.guest_bits + static_cast<uint64_t>(guest_row) * surface.guest_stride, row.data(),
                                           row_bytes);
+                        gdi_raster::convert_bgr24_to_bgra(row.data(), converted.data(), surface.width);
+                    }
 
-                        auto* dst = surface.pixels.data() + static_cast<size_t>(y) * surface.width;
-                        for (uint32_t x = 0; x < surface.width; ++x)
-                        {
-                            const uint8_t* px = row.data() + static_cast<size_t>(x) * 3;
-                            dst[x] = static_cast<uint32_t>(px[0]) | (static_cast<uint32_t>(px[1]) << 8) |
-                                     (static_cast<uint32_t>(px[2]) << 16) | 0xFF000000u;
-                        }
+                    if (std::memcmp(dst, converted.data(), converted.size() * sizeof(uint32_t)) == 0)
+                    {
+                        continue;
                     }
+
+                    std::memcpy(dst, converted.data(), converted.size() * sizeof(uint32_t));
+                    first_changed = first_changed.value_or(y);
+                    last_changed = y;
+                }
+
+                if (first_changed)
+                {
+                    surface.add_damage(0, *first_changed, surface.width, static_cast<int64_t>(last_changed) + 1);
                 }
             }
 
@@ -590,6 +600,7 @@ namespace sogen
                     surface.width = width;
                     surface.height = height;
                     surface.pixels.assign(static_cast<size_t>(width) * height, window_surface_fill_color(c, *win));
+                    surface.add_full_damage();
                 }
 
                 origin_x = off_x;
@@ -651,24 +662,20 @@ namespace sogen
                     return;
                 }
 
-                std::vector<uint8_t> row(row_bytes);
+                std::vector<uint8_t> row(bytes_per_pixel == 3 ? row_bytes : 0);
                 for (uint32_t y = 0; y < surface.height; ++y)
                 {
                     const uint32_t guest_row = surface.guest_top_down ? y : (surface.height - 1 - y);
                     const auto* src = surface.pixels.data() + static_cast<size_t>(y) * surface.width;
-                    for (uint32_t x = 0; x < surface.width; ++x)
+                    const void* data = src;
+
+                    if (bytes_per_pixel == 3)
                     {
-                        uint8_t* px = row.data() + static_cast<size_t>(x) * bytes_per_pixel;
-                        const uint32_t pixel = src[x];
-                        px[0] = static_cast<uint8_t>(pixel & 0xFF);
-                        px[1] = static_cast<uint8_t>((pixel >> 8) & 0xFF);
-                        px[2] = static_cast<uint8_t>((pixel >> 16) & 0xFF);
-                        if (bytes_per_pixel == 4)
-                        {
-                            px[3] = static_cast<uint8_t>((pixel >> 24) & 0xFF);
-                        }
+                        gdi_raster::convert_bgra_to_bgr24(src, row.data(), surface.width);
+                        data = row.data();
                     }
-                    c.emu.write_memory(surface.guest_bits + static_cast<uint64_t>(guest_row) * surface.guest_stride, row.data(), row_bytes);
+
+                    c.emu.write_memory(surface.guest_bits + static_cast<uint64_t>(guest_row) * surface.guest_stride, data, row_bytes);
                 }
             }
 
@@ -691,7 +698,8 @@ namespace sogen
                                                                .height = static_cast<int>(surface->height),
                                                                .stride = static_cast<int>(surface->width * sizeof(uint32_t)),
                                                                .format = ui_surface_format::bgra8,
-                                                               .pixels = surface->pixels.data()});
+                                                               .pixels = surface->pixels.data(),
+                                                               .damage = surface->take_damage()});
             }
 
             void set_surface_pixel(gdi_bitmap_surface& surface, const int x, const int y, const uint32_t color)
@@ -702,6 +710,7 @@ namespace sogen
                 }
 
                 surface.pixels[static_cast<size_t>(y) * surface.width + static_cast<size_t>(x)] = color;
+                surface.add_damage(x, y, static_cast<int64_t>(x) + 1, static_cast<int64_t>(y) + 1);
             }
 
             std::optional<uint32_t> get_surface_pixel(const gdi_bitmap_surface& surface, const int x, const int y)
@@ -714,6 +723,21 @@ namespace sogen
                 return surface.pixels[static_cast<size_t>(y) * surface.width + static_cast<size_t>(x)];
             }
 
+            gdi_raster::surface_view get_raster_view(gdi_bitmap_surface& surface)
+            {
+                if (surface.pixels.size() < static_cast<size_t>(surface.width) * surface.height)
+                {
+                    return {};
+                }
+
+                return {
+                    .pixels = surface.pixels.data(),
+                    .stride = surface.width,
+                    .width = static_cast<int32_t>(surface.width),
+                    .height = static_cast<int32_t>(surface.height),
+                };
+            }
+
             uint32_t colorref_to_bgra(const uint32_t colorref)
             {
                 return 0xFF000000u | ((colorref & 0x000000FFu) << 16) | (colorref & 0x0000FF00u) | ((colorref & 0x00FF0000u) >> 16);
@@ -899,19 +923,6 @@ namespace sogen
                 }
             }
 
-            bool point_in_rect(const int x, const int y, const RECT* clip)
-            {
-                return clip == nullptr || (x >= clip->left && x < clip->right && y >= clip->top && y < clip->bottom);
-            }
-
-            void set_text_pixel(gdi_bitmap_surface& surface, const int x, const int y, const uint32_t color, const RECT* clip)
-            {
-                if (point_in_rect(x, y, clip))
-                {
-                    set_surface_pixel(surface, x, y, color);
-                }
-            }
-
             void draw_text_glyph(gdi_bitmap_surface& surface, const int x, const int y, char32_t codepoint, const uint32_t color,
                                  const RECT* clip)
             {
@@ -920,18 +931,12 @@ namespace sogen
                     codepoint = U'?';
                 }
 
+                static_assert(debug_font::glyph_width == 8, "Glyph rows are drawn as one byte each");
+
                 const auto& glyph = debug_font::glyphs[static_cast<size_t>(codepoint - debug_font::first_codepoint)];
-                for (int row = 0; row < debug_font::glyph_height; ++row)
-                {
-                    const uint8_t bits = glyph[static_cast<size_t>(row)];
-                    for (int col = 0; col < debug_font::glyph_width; ++col)
-                    {
-                        if ((bits & (0x01u << col)) != 0)
-                        {
-                            set_text_pixel(surface, x + col, y + k_text_glyph_y_offset + row, color, clip);
-                        }
-                    }
-                }
+                gdi_raster::draw_glyph(get_raster_view(surface), x, y + k_text_glyph_y_offset, glyph, color, clip);
+                surface.add_damage(x, static_cast<int64_t>(y) + k_text_glyph_y_offset, static_cast<int64_t>(x) + debug_font::glyph_width,
+                                   static_cast<int64_t>(y) + k_text_glyph_y_offset + static_cast<int64_t>(std::size(glyph)));
             }
 
             void draw_text(gdi_bitmap_surface& surface, const int x, const int y, const std::u16string_view text, const uint32_t color,
@@ -948,13 +953,8 @@ namespace sogen
             void fill_rect(gdi_bitmap_surface& surface, const int left, const int top, const int right, const int bottom,
                            const uint32_t color)
             {
-                for (int y = top; y < bottom; ++y)
-                {
-                    for (int x = left; x < right; ++x)
-                    {
-                        set_surface_pixel(surface, x, y, color);
-                    }
-                }
+                gdi_raster::fill_rect(get_raster_view(surface), left, top, right, bottom, color);
+                surface.add_damage(left, top, right, bottom);
             }
 
             template <typename Batch>
@@ -1556,49 +1556,6 @@ namespace sogen
 
                 return status;
             }
-
-            bool rop3_uses_source(const uint8_t rop3)
-            {
-                // ROP3 truth-table index: bit0=D, bit1=S, bit2=P.
-                // If changing S can change the output for any D/P pair, the source DC is required.
-                for (uint32_t p = 0; p <= 1; ++p)
-                {
-                    for (uint32_t d = 0; d <= 1; ++d)
-                    {
-                        const uint32_t i0 = (p << 2) | d;
-                        const uint32_t i1 = (p << 2) | 0x02u | d;
-                        if (((rop3 >> i0) & 1u) != ((rop3 >> i1) & 1u))
-                        {
-                            return true;
-                        }
-                    }
-                }
-
-                return false;
-            }
-
-            uint32_t apply_rop3(const uint8_t rop3, const uint32_t src, const uint32_t dst, const uint32_t pat)
-            {
-                uint32_t out = 0;
-
-                // Each bit of rop3 selects the output for one D/S/P boolean combination.
-                // Index layout matches Win32 ROP3 encoding:
-                //   bit0 = D, bit1 = S, bit2 = P
-                for (uint32_t i = 0; i < 8; ++i)
-                {
-                    if (((rop3 >> i) & 1u) == 0)
-                    {
-                        continue;
-                    }
-
-                    uint32_t mask = (i & 0x01u) ? dst : ~dst;
-                    mask &= (i & 0x02u) ? src : ~src;
-                    mask &= (i & 0x04u) ? pat : ~pat;
-                    out |= mask;
-                }
-
-                return out;
-            }
         }
 
         // Returns the surface a paint DC should be presented to, and (via present_handle) the host window handle it
@@ -2062,14 +2019,7 @@ namespace sogen
                 }
                 else
                 {
-                    for (uint32_t x = 0; x < surface.width; ++x)
-                    {
-                        const uint32_t pixel = source[x];
-
-                        destination[x * 3 + 0] = static_cast<uint8_t>(pixel);
-                        destination[x * 3 + 1] = static_cast<uint8_t>(pixel >> 8);
-                        destination[x * 3 + 2] = static_cast<uint8_t>(pixel >> 16);
-                    }
+                    gdi_raster::convert_bgra_to_bgr24(source, destination, surface.width);
                 }
             }
 
@@ -2276,6 +2226,16 @@ namespace sogen
             c.emu.read_memory(bits, data.data(), data.size());
             const auto available_rows = static_cast<uint32_t>(data.size() / stride);
 
+            // Source coordinates are unsigned: a negative source origin selects nothing.
+            if (x_src < 0 || y_src < 0)
+            {
+                return 0;
+            }
+
+            const auto dst_view = get_raster_view(*surface);
+            const auto row_pixels = static_cast<uint32_t>(std::min<uint64_t>(width, src_width - std::min<uint32_t>(src_width, x_src)));
+            std::vector<uint32_t> row_buffer(row_pixels);
+
             uint32_t copied = 0;
             for (uint32_t j = 0; j < height; ++j)
             {
@@ -2290,20 +2250,27 @@ namespace sogen
                     continue;
                 }
 
-                const uint8_t* row = data.data() + static_cast<size_t>(bits_row) * stride;
-                for (uint32_t i = 0; i < width; ++i)
+                const uint8_t* row = data.data() + static_cast<size_t>(bits_row) * stride + static_cast<size_t>(x_src) * bytes_per_pixel;
+                if (bytes_per_pixel == 4)
                 {
-                    const auto src_x = static_cast<uint32_t>(x_src) + i;
-                    if (src_x >= src_width)
-                    {
-                        break;
-                    }
-                    const uint8_t* px = row + static_cast<size_t>(src_x) * bytes_per_pixel;
-                    const uint32_t pixel =
-                        static_cast<uint32_t>(px[0]) | (static_cast<uint32_t>(px[1]) << 8) | (static_cast<uint32_t>(px[2]) << 16);
-                    set_surface_pixel(*surface, x_dest + origin_x + static_cast<int>(i), y_dest + origin_y + static_cast<int>(j),
-                                      pixel | 0xFF000000u);
+                    gdi_raster::convert_bgrx32_to_bgra(row, row_buffer.data(), row_pixels);
+                }
+                else
+                {
+                    gdi_raster::convert_bgr24_to_bgra(row, row_buffer.data(), row_pixels);
                 }
+
+                const gdi_raster::surface_view row_view{
+                    .pixels = row_buffer.data(),
+                    .stride = row_pixels,
+                    .width = static_cast<int32_t>(row_pixels),
+                    .height = 1,
+                };
+
+                gdi_raster::bit_blt(dst_view, static_cast<int64_t>(x_dest) + origin_x, static_cast<int64_t>(y_dest) + origin_y + j,
+                                    row_pixels, 1, &row_view, 0, 0, gdi_raster::rop3_srccopy, 0);
+                surface->add_damage(static_cast<int64_t>(x_dest) + origin_x, static_cast<int64_t>(y_dest) + origin_y + j,
+                                    static_cast<int64_t>(x_dest) + origin_x + row_pixels, static_cast<int64_t>(y_dest) + origin_y + j + 1);
                 ++copied;
             }
 
@@ -2399,66 +2366,53 @@ namespace sogen
             c.emu.read_memory(bits, data.data(), data.size());
             const auto available_rows = static_cast<uint32_t>(data.size() / stride);
 
-            // Nearest-neighbour scale the source rectangle onto the destination rectangle. Negative dest
-            // extents mirror the image (GDI semantics); the source rectangle is taken as positive.
-            const int dst_w = std::abs(dst_width);
-            const int dst_h = std::abs(dst_height);
-            const bool flip_x = dst_width < 0;
-            const bool flip_y = dst_height < 0;
+            // Decode the stored rows, then nearest-neighbour scale the source rectangle onto the destination
+            // rectangle. Negative dest extents mirror the image (GDI semantics); the source rectangle is taken
+            // as positive. Rows missing from a truncated buffer are left out of the decoded image, so the
+            // destination keeps its pixels there.
+            const auto first_row = top_down ? 0 : img_height - available_rows;
+            std::vector<uint32_t> image(static_cast<size_t>(img_width) * available_rows);
 
-            for (int dy = 0; dy < dst_h; ++dy)
+            for (uint32_t y = 0; y < available_rows; ++y)
             {
-                const auto src_off_y = static_cast<uint32_t>(static_cast<int64_t>(dy) * src_height / dst_h);
-                const auto img_y = static_cast<uint32_t>(y_src) + src_off_y;
-                if (img_y >= img_height)
+                const auto img_y = first_row + y;
+                const uint8_t* row = data.data() + static_cast<size_t>(top_down ? img_y : img_height - 1 - img_y) * stride;
+                auto* dst = image.data() + static_cast<size_t>(y) * img_width;
+
+                if (bit_count == 32)
                 {
-                    continue;
+                    gdi_raster::convert_bgrx32_to_bgra(row, dst, img_width);
                 }
-                const uint32_t bits_row = top_down ? img_y : (img_height - 1 - img_y);
-                if (bits_row >= available_rows)
+                else if (bit_count == 24)
                 {
-                    continue;
+                    gdi_raster::convert_bgr24_to_bgra(row, dst, img_width);
                 }
-                const uint8_t* row = data.data() + static_cast<size_t>(bits_row) * stride;
-                const int out_y = y_dst + origin_y + (flip_y ? (dst_h - 1 - dy) : dy);
-
-                for (int dx = 0; dx < dst_w; ++dx)
+                else // 4bpp BI_RGB
                 {
-                    const auto src_off_x = static_cast<uint32_t>(static_cast<int64_t>(dx) * src_width / dst_w);
-                    const auto img_x = static_cast<uint32_t>(x_src) + src_off_x;
-                    if (img_x >= img_width)
+                    for (uint32_t x = 0; x < img_width; ++x)
                     {
-                        continue;
-                    }
-
-                    uint32_t pixel = 0;
-
-                    if (bit_count == 32)
-                    {
-                        std::memcpy(&pixel, row + static_cast<size_t>(img_x) * sizeof(uint32_t), sizeof(pixel));
-                        pixel |= 0xFF000000u;
-                    }
-                    else if (bit_count == 24)
-                    {
-                        const uint8_t* px = row + static_cast<size_t>(img_x) * 3;
-                        pixel = static_cast<uint32_t>(px[0]) | (static_cast<uint32_t>(px[1]) << 8) | (static_cast<uint32_t>(px[2]) << 16) |
-                                0xFF000000u;
-                    }
-                    else // 4bpp BI_RGB
-                    {
-                        const uint8_t packed = row[static_cast<size_t>(img_x) / 2u];
+                        const uint8_t packed = row[x / 2u];
 
                         // In 4bpp DIBs, the left pixel is the high nibble.
-                        const uint8_t index = (img_x & 1u) == 0 ? static_cast<uint8_t>(packed >> 4) : static_cast<uint8_t>(packed & 0x0Fu);
-
-                        pixel = palette[index];
+                        const uint8_t index = (x & 1u) == 0 ? static_cast<uint8_t>(packed >> 4) : static_cast<uint8_t>(packed & 0x0Fu);
+                        dst[x] = palette[index];
                     }
-
-                    const int out_x = x_dst + origin_x + (flip_x ? (dst_w - 1 - dx) : dx);
-                    set_surface_pixel(*surface, out_x, out_y, pixel);
                 }
             }
 
+            const gdi_raster::surface_view image_view{
+                .pixels = image.data(),
+                .stride = img_width,
+                .width = static_cast<int32_t>(img_width),
+                .height = static_cast<int32_t>(available_rows),
+            };
+
+            gdi_raster::stretch_blt(get_raster_view(*surface), x_dst + origin_x, y_dst + origin_y, dst_width, dst_height, &image_view,
+                                    x_src, y_src - static_cast<int32_t>(first_row), src_width, src_height, gdi_raster::rop3_srccopy, 0);
+            surface->add_damage(static_cast<int64_t>(x_dst) + origin_x, static_cast<int64_t>(y_dst) + origin_y,
+                                static_cast<int64_t>(x_dst) + origin_x + std::abs(static_cast<int64_t>(dst_width)),
+                                static_cast<int64_t>(y_dst) + origin_y + std::abs(static_cast<int64_t>(dst_height)));
+
             present_win_surface(c, present_handle, surface);
 
             return static_cast<int>(img_height);
@@ -3447,7 +3401,7 @@ namespace sogen
             }
 
             const auto rop3 = static_cast<uint8_t>((rop >> 16) & 0xFFu);
-            const bool needs_source = rop3_uses_source(rop3);
+            const bool needs_source = gdi_raster::rop3_uses_source(rop3);
 
             int32_t src_origin_x = 0;
             int32_t src_origin_y = 0;
@@ -3468,116 +3422,15 @@ namespace sogen
                 }
             }
 
-            auto dx = static_cast<int64_t>(x_dst) + dst_origin_x;
-            auto dy = static_cast<int64_t>(y_dst) + dst_origin_y;
-            auto sx = static_cast<int64_t>(x_src) + src_origin_x;
-            auto sy = static_cast<int64_t>(y_src) + src_origin_y;
-            int64_t w = width;
-            int64_t h = height;
+            const auto dst_view = get_raster_view(*dst_surface);
+            const auto src_view = src_surface ? get_raster_view(*src_surface) : gdi_raster::surface_view{};
 
-            // Clip to destination surface.
-            if (dx < 0)
-            {
-                const int64_t delta = -dx;
-                dx = 0;
-                sx += delta;
-                w -= delta;
-            }
-            if (dy < 0)
-            {
-                const int64_t delta = -dy;
-                dy = 0;
-                sy += delta;
-                h -= delta;
-            }
-            if (dx + w > static_cast<int64_t>(dst_surface->width))
-            {
-                w = static_cast<int64_t>(dst_surface->width) - dx;
-            }
-            if (dy + h > static_cast<int64_t>(dst_surface->height))
-            {
-                h = static_cast<int64_t>(dst_surface->height) - dy;
-            }
-
-            // Clip to source surface only when the ROP actually depends on S.
-            if (needs_source)
-            {
-                if (sx < 0)
-                {
-                    const int64_t delta = -sx;
-                    sx = 0;
-                    dx += delta;
-                    w -= delta;
-                }
-                if (sy < 0)
-                {
-                    const int64_t delta = -sy;
-                    sy = 0;
-                    dy += delta;
-                    h -= delta;
-                }
-                if (sx + w > static_cast<int64_t>(src_surface->width))
-                {
-                    w = static_cast<int64_t>(src_surface->width) - sx;
-                }
-                if (sy + h > static_cast<int64_t>(src_surface->height))
-                {
-                    h = static_cast<int64_t>(src_surface->height) - sy;
-                }
-            }
-
-            if (w <= 0 || h <= 0)
-            {
-                return TRUE;
-            }
-
-            const auto blt_width = static_cast<size_t>(w);
-            const auto blt_height = static_cast<size_t>(h);
-            const auto pixel_count = blt_width * blt_height;
-
-            if (blt_width != 0 && pixel_count / blt_width != blt_height)
-            {
-                return FALSE;
-            }
-
-            std::vector<uint32_t> dst_snapshot(pixel_count);
-            std::vector<uint32_t> src_snapshot;
-            if (needs_source)
-            {
-                src_snapshot.resize(pixel_count);
-            }
-
-            // Snapshot first. This avoids corrupting overlapping source/destination blits.
-            for (size_t row = 0; row < blt_height; ++row)
-            {
-                const auto dst_index = (static_cast<size_t>(dy) + row) * dst_surface->width + static_cast<size_t>(dx);
-                std::memcpy(dst_snapshot.data() + row * blt_width, dst_surface->pixels.data() + dst_index, blt_width * sizeof(uint32_t));
-
-                if (needs_source)
-                {
-                    const auto src_index = (static_cast<size_t>(sy) + row) * src_surface->width + static_cast<size_t>(sx);
-                    std::memcpy(src_snapshot.data() + row * blt_width, src_surface->pixels.data() + src_index,
-                                blt_width * sizeof(uint32_t));
-                }
-            }
-
-            const uint32_t pattern = get_dc_brush_color(c, dst_dc);
-
-            for (size_t row = 0; row < blt_height; ++row)
-            {
-                auto* dst_row = dst_surface->pixels.data() + (static_cast<size_t>(dy) + row) * dst_surface->width + static_cast<size_t>(dx);
-
-                for (size_t col = 0; col < blt_width; ++col)
-                {
-                    const size_t i = row * blt_width + col;
-                    const uint32_t src = needs_source ? src_snapshot[i] : 0;
-                    const uint32_t dst = dst_snapshot[i];
-
-                    // Your renderer presents BGRA8 surfaces. Keeping alpha opaque matches the rest of this file's
-                    // DIB-to-surface paths. Remove the OR if you later model real alpha-carrying 32-bpp DIB sections.
-                    dst_row[col] = apply_rop3(rop3, src, dst, pattern) | 0xFF000000u;
-                }
-            }
+            gdi_raster::bit_blt(dst_view, static_cast<int64_t>(x_dst) + dst_origin_x, static_cast<int64_t>(y_dst) + dst_origin_y, width,
+                                height, needs_source ? &src_view : nullptr, static_cast<int64_t>(x_src) + src_origin_x,
+                                static_cast<int64_t>(y_src) + src_origin_y, rop3, get_dc_brush_color(c, dst_dc));
+            dst_surface->add_damage(static_cast<int64_t>(x_dst) + dst_origin_x, static_cast<int64_t>(y_dst) + dst_origin_y,
+                                    static_cast<int64_t>(x_dst) + dst_origin_x + std::max(width, 0),
+                                    static_cast<int64_t>(y_dst) + dst_origin_y + std::max(height, 0));
 
             present_win_surface(c, present_handle, dst_surface);
 
@@ -3607,7 +3460,7 @@ namespace sogen
             }
 
             const auto rop3 = static_cast<uint8_t>((rop >> 16) & 0xFFu);
-            const bool needs_source = rop3_uses_source(rop3);
+            const bool needs_source = gdi_raster::rop3_uses_source(rop3);
 
             int32_t src_origin_x = 0;
             int32_t src_origin_y = 0;
@@ -3627,63 +3480,16 @@ namespace sogen
                 }
             }
 
-            const int dst_w = std::abs(dst_width);
-            const int dst_h = std::abs(dst_height);
-            const int src_w = std::abs(src_width);
-            const int src_h = std::abs(src_height);
-            const bool flip_x = dst_width < 0;
-            const bool flip_y = dst_height < 0;
-            // Negative source extents mirror the source image (GDI semantics), independently of the
-            // destination flip; sample the mirrored position within the (absolute) source rectangle.
-            const bool flip_src_x = src_width < 0;
-            const bool flip_src_y = src_height < 0;
-
-            const uint32_t pattern = get_dc_brush_color(c, dst_dc);
-
-            for (int dy = 0; dy < dst_h; ++dy)
-            {
-                const int out_y = y_dst + dst_origin_y + (flip_y ? (dst_h - 1 - dy) : dy);
-                if (out_y < 0 || out_y >= static_cast<int>(dst_surface->height))
-                {
-                    continue;
-                }
-
-                int sy = 0;
-                if (needs_source)
-                {
-                    const int src_dy = static_cast<int>(static_cast<int64_t>(dy) * src_h / dst_h);
-                    sy = y_src + src_origin_y + (flip_src_y ? (src_h - 1 - src_dy) : src_dy);
-                    if (sy < 0 || sy >= static_cast<int>(src_surface->height))
-                    {
-                        continue;
-                    }
-                }
-
-                auto* dst_row = dst_surface->pixels.data() + static_cast<size_t>(out_y) * dst_surface->width;
-
-                for (int dx = 0; dx < dst_w; ++dx)
-                {
-                    const int out_x = x_dst + dst_origin_x + (flip_x ? (dst_w - 1 - dx) : dx);
-                    if (out_x < 0 || out_x >= static_cast<int>(dst_surface->width))
-                    {
-                        continue;
-                    }
-
-                    uint32_t src = 0;
-                    if (needs_source)
-                    {
-                        const int src_dx = static_cast<int>(static_cast<int64_t>(dx) * src_w / dst_w);
-                        const int sx = x_src + src_origin_x + (flip_src_x ? (src_w - 1 - src_dx) : src_dx);
-                        if (sx < 0 || sx >= static_cast<int>(src_surface->width))
-                        {
-                            continue;
-                        }
-                        src = src_surface->pixels[static_cast<size_t>(sy) * src_surface->width + static_cast<size_t>(sx)];
-                    }
+            // Negative extents mirror the image (GDI semantics), the source independently of the destination.
+            const auto dst_view = get_raster_view(*dst_surface);
+            const auto src_view = src_surface ? get_raster_view(*src_surface) : gdi_raster::surface_view{};
 
-                    dst_row[out_x] = apply_rop3(rop3, src, dst_row[out_x], pattern) | 0xFF000000u;
-                }
-            }
+            gdi_raster::stretch_blt(dst_view, x_dst + dst_origin_x, y_dst + dst_origin_y, dst_width, dst_height,
+                                    needs_source ? &src_view : nullptr, x_src + src_origin_x, y_src + src_origin_y, src_width, src_height,
+                                    rop3, get_dc_brush_color(c, dst_dc));
+            dst_surface->add_damage(static_cast<int64_t>(x_dst) + dst_origin_x, static_cast<int64_t>(y_dst) + dst_origin_y,
+                                    static_cast<int64_t>(x_dst) + dst_origin_x + std::abs(static_cast<int64_t>(dst_width)),
+                                    static_cast<int64_t>(y_dst) + dst_origin_y + std::abs(static_cast<int64_t>(dst_height)));
 
             present_win_surface(c, present_handle, dst_surface);
             return TRUE;
@@ -3711,14 +3517,12 @@ namespace sogen
                 return FALSE;
             }
 
-            const auto color = get_dc_brush_color(c, dc);
-            for (int yy = 0; yy < height; ++yy)
-            {
-                for (int xx = 0; xx < width; ++xx)
-                {
-                    set_surface_pixel(*surface, x + xx + origin_x, y + yy + origin_y, color);
-                }
-            }
+            const auto left = static_cast<int64_t>(x) + origin_x;
+            const auto top = static_cast<int64_t>(y) + origin_y;
+            const auto right = left + std::max<int64_t>(width, 0);
+            const auto bottom = top + std::max<int64_t>(height, 0);
+            gdi_raster::fill_rect(get_raster_view(*surface), left, top, right, bottom, get_dc_brush_color(c, dc));
+            surface->add_damage(left, top, right, bottom);
             return TRUE;
         }
 
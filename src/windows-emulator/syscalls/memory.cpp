@@ -361,6 +361,14 @@ namespace sogen
                 return STATUS_INVALID_PAGE_PROTECTION;
             }
 
+            // Protection does not cross reservations, so the kind at the start covers the whole range.
+            const auto region_kind = c.win_emu.memory.get_region_kind(aligned_start);
+            const auto denied_status = memory_region_policy::nt_protect_virtual_memory_denied_status(region_kind);
+            if (denied_status != STATUS_SUCCESS)
+            {
+                return denied_status;
+            }
+
             c.win_emu.callbacks.on_memory_protect(aligned_start, aligned_length, *requested_protection);
 
             nt_memory_permission old_protection_value{};
@@ -609,6 +617,7 @@ namespace sogen
                 const bool success = c.win_emu.memory.release_memory(release_base, 0);
                 if (success)
                 {
+                    c.win_emu.callbacks.on_memory_release(release_base, released_length);
                     base_address.write(release_base);
                     bytes_to_allocate.write(static_cast<uint64_t>(released_length));
                     return STATUS_SUCCESS;
@@ -662,6 +671,7 @@ namespace sogen
                     return STATUS_MEMORY_NOT_ALLOCATED;
                 }
 
+                c.win_emu.callbacks.on_memory_release(decommit_base, decommit_size);
                 base_address.write(decommit_base);
                 bytes_to_allocate.write(static_cast<uint64_t>(decommit_size));
                 return STATUS_SUCCESS;
@@ -25,6 +25,10 @@ namespace sogen
             }
 
             const auto [old_count, succeeded] = mutant->release(c.thread().id);
+            if (succeeded)
+            {
+                c.proc.scheduler.notify_object(mutant_handle);
+            }
 
             if (previous_count)
             {
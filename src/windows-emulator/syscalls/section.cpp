@@ -156,7 +156,7 @@ namespace sogen
                 const auto windows_dir_size = windows_dir.size() * 2;
                 const emulator_object<UNICODE_STRING<EmulatorTraits<Emu64>>> windir_obj{c.emu, obj_address};
                 windir_obj.access([&](UNICODE_STRING<EmulatorTraits<Emu64>>& ucs) {
-                    const auto dir_address = kusd_mmio::address() + offsetof(KUSER_SHARED_DATA64, NtSystemRoot);
+                    const auto dir_address = kusd_page::address() + offsetof(KUSER_SHARED_DATA64, NtSystemRoot);
 
                     ucs.Buffer = dir_address - obj_address;
                     ucs.Length = static_cast<uint16_t>(windows_dir_size);
@@ -58,6 +58,10 @@ namespace sogen
             }
 
             const auto [old_count, succeeded] = mutant->release(release_count);
+            if (succeeded)
+            {
+                c.proc.scheduler.notify_object(semaphore_handle);
+            }
 
             if (previous_count)
             {
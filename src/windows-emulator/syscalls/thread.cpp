@@ -573,16 +573,13 @@ namespace sogen
 
         NTSTATUS handle_NtAlertThreadByThreadId(const syscall_context& c, const uint64_t thread_id)
         {
-            for (auto& t : c.proc.threads | std::views::values)
+            if (auto* t = c.proc.find_thread_by_id(static_cast<uint32_t>(thread_id)); t && t->id == thread_id)
             {
-                if (t.id == thread_id)
-                {
-                    // The alert is sticky: it must be remembered even if the target is not waiting yet, so a
-                    // subsequent NtWaitForAlertByThreadId consumes it instead of blocking forever. This race-free
-                    // delivery is what ntdll's critical sections and SRW locks rely on.
-                    t.alerted = true;
-                    return STATUS_SUCCESS;
-                }
+                // The alert is sticky: it must be remembered even if the target is not waiting yet, so a
+                // subsequent NtWaitForAlertByThreadId consumes it instead of blocking forever. This race-free
+                // delivery is what ntdll's critical sections and SRW locks rely on.
+                t->alerted = true;
+                c.proc.scheduler.wake(t->id);
             }
 
             return STATUS_SUCCESS;
@@ -689,6 +686,7 @@ namespace sogen
             if (old_count > 0)
             {
                 thread->suspended -= 1;
+                c.proc.scheduler.wake(thread->id);
             }
 
             return STATUS_SUCCESS;
@@ -970,6 +968,7 @@ namespace sogen
                 .apc_argument2 = apc_argument2,
                 .apc_argument3 = apc_argument3,
             });
+            c.proc.scheduler.wake(thread->id);
 
             return STATUS_SUCCESS;
         }
@@ -2337,7 +2337,8 @@ namespace sogen
                                                                    .height = static_cast<int>(surface->height),
                                                                    .stride = static_cast<int>(surface->width * sizeof(uint32_t)),
                                                                    .format = ui_surface_format::bgra8,
-                                                                   .pixels = surface->pixels.data()});
+                                                                   .pixels = surface->pixels.data(),
+                                                                   .damage = surface->take_damage()});
                 }
 
                 // BeginPaint allocated a fresh GDI DC (handle table entry + DC_ATTR block) via
@@ -0,0 +1,238 @@
+#include "std_include.hpp"
+#include "thread_scheduler.hpp"
+
+#include <bit>
+
+namespace sogen
+{
+    namespace
+    {
+        // Wheel ticks are milliseconds of emulated steady time, the resolution guest timeouts care about.
+        int64_t get_tick(const thread_scheduler::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        }
+
+        // Handle aliases only differ in the flag bits, so objects are identified by type and index.
+        uint32_t get_object_key(const handle object)
+        {
+            return static_cast<uint32_t>(object.value.id) | (static_cast<uint32_t>(object.value.type) << 23);
+        }
+    }
+
+    void thread_scheduler::reset()
+    {
+        this->runnable_.clear();
+        this->terminated_.clear();
+        this->parked_.clear();
+        this->wait_lists_.clear();
+        this->current_tick_.reset();
+
+        for (auto& slot : this->wheel_)
+        {
+            slot.clear();
+        }
+    }
+
+    void thread_scheduler::add(const uint32_t thread_id)
+    {
+        this->parked_.erase(thread_id);
+        this->terminated_.erase(thread_id);
+        this->make_runnable(thread_id);
+    }
+
+    void thread_scheduler::remove(const uint32_t thread_id)
+    {
+        this->parked_.erase(thread_id);
+        this->terminated_.erase(thread_id);
+        this->runnable_.erase(thread_id);
+    }
+
+    void thread_scheduler::terminate(const uint32_t thread_id)
+    {
+        this->parked_.erase(thread_id);
+        this->runnable_.erase(thread_id);
+        this->terminated_.insert(thread_id);
+    }
+
+    std::vector<uint32_t> thread_scheduler::take_terminated()
+    {
+        std::vector<uint32_t> threads(this->terminated_.begin(), this->terminated_.end());
+        this->terminated_.clear();
+        return threads;
+    }
+
+    void thread_scheduler::park(const uint32_t thread_id, const std::span<const handle> objects, const std::optional<time_point> deadline,
+                                const time_point now)
+    {
+        this->runnable_.erase(thread_id);
+
+        const waiter entry{
+            .thread_id = thread_id,
+            .ticket = this->next_ticket_++,
+        };
+
+        this->parked_[thread_id] = entry.ticket;
+
+        for (const auto& object : objects)
+        {
+            auto& list = this->wait_lists_[get_object_key(object)];
+
+            // Threads timing out and waiting again on an object that never gets signaled leave stale entries
+            // behind, compacting whenever the list doubles keeps that bounded.
+            if (list.size() >= 16 && std::has_single_bit(list.size()))
+            {
+                this->compact(list);
+            }
+
+            list.push_back(entry);
+        }
+
+        if (!deadline)
+        {
+            return;
+        }
+
+        if (!this->current_tick_)
+        {
+            this->current_tick_ = get_tick(now);
+        }
+
+        // Slots up to the current tick have already been processed, anything due goes into the next one.
+        const auto tick = std::max(get_tick(*deadline), *this->current_tick_ + 1);
+        this->wheel_[static_cast<uint64_t>(tick) % WHEEL_SLOTS].push_back({
+            .tick = tick,
+            .thread = entry,
+        });
+    }
+
+    void thread_scheduler::wake(const uint32_t thread_id)
+    {
+        if (this->parked_.erase(thread_id))
+        {
+            this->make_runnable(thread_id);
+        }
+    }
+
+    void thread_scheduler::wake_all()
+    {
+        for (const auto& thread_id : this->parked_ | std::views::keys)
+        {
+            this->make_runnable(thread_id);
+        }
+
+        this->parked_.clear();
+        this->wait_lists_.clear();
+
+        for (auto& slot : this->wheel_)
+        {
+            slot.clear();
+        }
+    }
+
+    void thread_scheduler::notify_object(const handle object)
+    {
+        const auto entry = this->wait_lists_.find(get_object_key(object));
+        if (entry == this->wait_lists_.end())
+        {
+            return;
+        }
+
+        const auto waiters = std::move(entry->second);
+        this->wait_lists_.erase(entry);
+
+        for (const auto& waiter : waiters)
+        {
+            if (this->is_current(waiter))
+            {
+                this->wake(waiter.thread_id);
+            }
+        }
+    }
+
+    void thread_scheduler::expire_timeouts(const time_point now)
+    {
+        const auto now_tick = get_tick(now);
+
+        if (!this->current_tick_ || now_tick <= *this->current_tick_)
+        {
+            this->current_tick_ = this->current_tick_.value_or(now_tick);
+            return;
+        }
+
+        // After a jump of a full revolution every slot has been passed, visiting each once is enough.
+        const auto steps = std::min<int64_t>(now_tick - *this->current_tick_, WHEEL_SLOTS);
+
+        for (int64_t step = 1; step <= steps; ++step)
+        {
+            auto& slot = this->wheel_[static_cast<uint64_t>(*this->current_tick_ + step) % WHEEL_SLOTS];
+
+            for (size_t i = 0; i < slot.size();)
+            {
+                const auto entry = slot[i];
+                const auto due = entry.tick <= now_tick;
+                const auto current = this->is_current(entry.thread);
+
+                if (!due && current)
+                {
+                    ++i;
+                    continue;
+                }
+
+                slot[i] = slot.back();
+                slot.pop_back();
+
+                if (current)
+                {
+                    this->wake(entry.thread.thread_id);
+                }
+            }
+        }
+
+        this->current_tick_ = now_tick;
+    }
+
+    std::optional<thread_scheduler::time_point> thread_scheduler::get_next_deadline() const
+    {
+        std::optional<int64_t> next_tick{};
+
+        for (const auto& slot : this->wheel_)
+        {
+            for (const auto& entry : slot)
+            {
+                if ((!next_tick || entry.tick < *next_tick) && this->is_current(entry.thread))
+                {
+                    next_tick = entry.tick;
+                }
+            }
+        }
+
+        if (!next_tick)
+        {
+            return std::nullopt;
+        }
+
+        return time_point{std::chrono::milliseconds(*next_tick)};
+    }
+
+    void thread_scheduler::make_runnable(const uint32_t thread_id)
+    {
+        this->runnable_.insert(thread_id);
+
+        if (this->wake_callback_)
+        {
+            this->wake_callback_();
+        }
+    }
+
+    bool thread_scheduler::is_current(const waiter& entry) const
+    {
+        const auto parked = this->parked_.find(entry.thread_id);
+        return parked != this->parked_.end() && parked->second == entry.ticket;
+    }
+
+    void thread_scheduler::compact(std::vector<waiter>& list) const
+    {
+        std::erase_if(list, [this](const waiter& entry) { return !this->is_current(entry); });
+    }
+} // namespace sogen
@@ -0,0 +1,101 @@
+#pragma once
+#include "handles.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace sogen
+{
+    // Decides which threads a context switch has to look at. Runnable threads are kept ordered by id and
+    // visited round robin. A blocked thread whose wait can only end through something the kernel does
+    // itself (an object getting signaled, an alert, a resume, an APC or its timeout) gets parked instead:
+    // it is filed in the wait list of every object it waits on and, for a finite timeout, in a hashed timer
+    // wheel, and is not visited again until one of those fires. Waking a thread only makes it runnable, the
+    // switch re-checks its wait, so spurious wake-ups are harmless while a missed one is not.
+    class thread_scheduler
+    {
+      public:
+        using time_point = std::chrono::steady_clock::time_point;
+
+        void reset();
+
+        void add(uint32_t thread_id);
+        void remove(uint32_t thread_id);
+
+        // Terminated threads are neither run nor parked, they wait in a separate set to be reaped.
+        void terminate(uint32_t thread_id);
+        std::vector<uint32_t> take_terminated();
+
+        void park(uint32_t thread_id, std::span<const handle> objects, std::optional<time_point> deadline, time_point now);
+        void wake(uint32_t thread_id);
+        void wake_all();
+
+        void notify_object(handle object);
+        void expire_timeouts(time_point now);
+
+        // Earliest timeout among the parked threads, at tick resolution.
+        std::optional<time_point> get_next_deadline() const;
+
+        // Called whenever a thread becomes runnable, so an idle vCPU can stop waiting.
+        void set_wake_callback(std::function<void()> callback)
+        {
+            this->wake_callback_ = std::move(callback);
+        }
+
+        const std::set<uint32_t>& get_runnable() const
+        {
+            return this->runnable_;
+        }
+
+        bool is_parked(const uint32_t thread_id) const
+        {
+            return this->parked_.contains(thread_id);
+        }
+
+        size_t get_parked_count() const
+        {
+            return this->parked_.size();
+        }
+
+      private:
+        static constexpr size_t WHEEL_SLOTS = 256;
+
+        struct waiter
+        {
+            uint32_t thread_id{};
+            uint64_t ticket{};
+        };
+
+        struct timer_entry
+        {
+            int64_t tick{};
+            waiter thread{};
+        };
+
+        std::set<uint32_t> runnable_{};
+        std::set<uint32_t> terminated_{};
+
+        // Every park hands out a new ticket, so wait list and wheel entries left behind by an earlier park
+        // are recognized as stale and dropped lazily.
+        std::unordered_map<uint32_t, uint64_t> parked_{};
+        uint64_t next_ticket_{1};
+
+        std::unordered_map<uint32_t, std::vector<waiter>> wait_lists_{};
+
+        std::array<std::vector<timer_entry>, WHEEL_SLOTS> wheel_{};
+        std::optional<int64_t> current_tick_{};
+
+        std::function<void()> wake_callback_{};
+
+        void make_runnable(uint32_t thread_id);
+        bool is_current(const waiter& entry) const;
+        void compact(std::vector<waiter>& list) const;
+    };
+} // namespace sogen
@@ -0,0 +1,132 @@
+#include "../std_include.hpp"
+#include <platform/ui_backend.hpp>
+
+#include "frame_capture.hpp"
+
+namespace sogen
+{
+    namespace
+    {
+        // Damage collected from invalidations between two presents of a window. Beyond this many rectangles
+        // they are merged into their bounding rectangle.
+        constexpr size_t max_pending_rects = 32;
+
+        struct pending_damage
+        {
+            bool whole_window{};
+            std::vector<RECT> rects{};
+        };
+
+        RECT unite_rects(const RECT& a, const RECT& b)
+        {
+            return {
+                .left = std::min(a.left, b.left),
+                .top = std::min(a.top, b.top),
+                .right = std::max(a.right, b.right),
+                .bottom = std::max(a.bottom, b.bottom),
+            };
+        }
+
+        // Headless backend for unattended runs: instead of showing windows it records what they present. Damage
+        // comes from invalidations and from the region the GDI surface reports as written, so a present only
+        // compares and encodes the tiles that can have changed.
+        class capture_ui_backend final : public ui_backend
+        {
+          public:
+            explicit capture_ui_backend(const std::filesystem::path& file)
+                : encoder_(file)
+            {
+            }
+
+            void set_event_sink(event_sink /*sink*/) override
+            {
+            }
+
+            void pump_events() override
+            {
+            }
+
+            bool needs_pumping() const override
+            {
+                return false;
+            }
+
+            void reset() override
+            {
+                this->pending_damage_.clear();
+                this->encoder_.forget_all();
+                this->encoder_.flush();
+            }
+
+            void destroy_window(const hwnd window) override
+            {
+                this->pending_damage_.erase(window);
+                this->encoder_.forget(static_cast<uint32_t>(window));
+            }
+
+            void invalidate(const hwnd window, const std::optional<RECT>& rect) override
+            {
+                auto& damage = this->pending_damage_[window];
+                if (!rect)
+                {
+                    damage.whole_window = true;
+                    damage.rects.clear();
+                    return;
+                }
+
+                if (damage.whole_window || rect->left >= rect->right || rect->top >= rect->bottom)
+                {
+                    return;
+                }
+
+                if (damage.rects.size() < max_pending_rects)
+                {
+                    damage.rects.push_back(*rect);
+                    return;
+                }
+
+                auto merged = *rect;
+                for (const auto& pending : damage.rects)
+                {
+                    merged = unite_rects(merged, pending);
+                }
+
+                damage.rects.assign(1, merged);
+            }
+
+            void present_surface(const hwnd window, const ui_surface_desc& surface) override
+            {
+                bool damage_known = surface.damage.has_value();
+                std::vector<RECT> damage{};
+
+                if (surface.damage)
+                {
+                    damage.push_back(*surface.damage);
+                }
+
+                if (const auto pending = this->pending_damage_.find(window); pending != this->pending_damage_.end())
+                {
+                    damage_known = damage_known && !pending->second.whole_window;
+                    damage.insert(damage.end(), pending->second.rects.begin(), pending->second.rects.end());
+                    this->pending_damage_.erase(pending);
+                }
+
+                const auto elapsed = std::chrono::steady_clock::now() - this->start_;
+                const auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+
+                this->encoder_.encode(static_cast<uint32_t>(window), static_cast<uint64_t>(timestamp.count()), surface,
+                                      damage_known ? std::optional<std::span<const RECT>>(damage) : std::nullopt);
+            }
+
+          private:
+            frame_capture::encoder encoder_;
+            std::chrono::steady_clock::time_point start_{std::chrono::steady_clock::now()};
+            std::unordered_map<hwnd, pending_damage> pending_damage_{};
+        };
+    }
+
+    std::unique_ptr<ui_backend> create_capture_ui_backend(const std::filesystem::path& file)
+    {
+        return std::make_unique<capture_ui_backend>(file);
+    }
+}
@@ -0,0 +1,503 @@
+#include "../std_include.hpp"
+#include "frame_capture.hpp"
+
+#include <utils/compression.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace sogen::frame_capture
+{
+    namespace
+    {
+        constexpr int compression_level = 3;
+
+        void append(std::vector<std::byte>& buffer, const void* data, const size_t size)
+        {
+            const auto* bytes = static_cast<const std::byte*>(data);
+            buffer.insert(buffer.end(), bytes, bytes + size);
+        }
+
+        template <typename T>
+        void append(std::vector<std::byte>& buffer, const T& value)
+        {
+            append(buffer, &value, sizeof(value));
+        }
+
+        const std::byte* get_row(const ui_surface_desc& surface, const uint32_t y)
+        {
+            return static_cast<const std::byte*>(surface.pixels) + static_cast<size_t>(y) * static_cast<size_t>(surface.stride);
+        }
+
+        uint32_t get_tile_count(const uint32_t extent, const uint32_t size)
+        {
+            return (extent + size - 1) / size;
+        }
+
+        class payload_reader
+        {
+          public:
+            explicit payload_reader(const std::span<const std::byte> data)
+                : data_(data)
+            {
+            }
+
+            const std::byte* read(const size_t size)
+            {
+                if (this->data_.size() - this->offset_ < size)
+                {
+                    throw std::runtime_error("Frame capture: Truncated frame");
+                }
+
+                const auto* result = this->data_.data() + this->offset_;
+                this->offset_ += size;
+                return result;
+            }
+
+            template <typename T>
+            T read()
+            {
+                T value{};
+                memcpy(&value, this->read(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+          private:
+            std::span<const std::byte> data_{};
+            size_t offset_{};
+        };
+
+        uint32_t crc32(const std::span<const uint8_t> data, uint32_t crc = 0)
+        {
+            static const auto table = [] {
+                std::array<uint32_t, 256> result{};
+                for (uint32_t i = 0; i < result.size(); ++i)
+                {
+                    uint32_t value = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                    {
+                        value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+                    }
+
+                    result[i] = value;
+                }
+
+                return result;
+            }();
+
+            crc = ~crc;
+            for (const auto byte : data)
+            {
+                crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+            }
+
+            return ~crc;
+        }
+
+        uint32_t adler32(const std::span<const uint8_t> data)
+        {
+            constexpr uint32_t modulus = 65521;
+            constexpr size_t block_size = 5552;
+
+            uint32_t a = 1;
+            uint32_t b = 0;
+
+            for (size_t offset = 0; offset < data.size(); offset += block_size)
+            {
+                const auto end = std::min(data.size(), offset + block_size);
+                for (auto i = offset; i < end; ++i)
+                {
+                    a += data[i];
+                    b += a;
+                }
+
+                a %= modulus;
+                b %= modulus;
+            }
+
+            return (b << 16) | a;
+        }
+
+        void append_be32(std::vector<uint8_t>& buffer, const uint32_t value)
+        {
+            buffer.push_back(static_cast<uint8_t>(value >> 24));
+            buffer.push_back(static_cast<uint8_t>(value >> 16));
+            buffer.push_back(static_cast<uint8_t>(value >> 8));
+            buffer.push_back(static_cast<uint8_t>(value));
+        }
+
+        void append_png_chunk(std::vector<uint8_t>& png, const char (&type)[5], const std::span<const uint8_t> data)
+        {
+            append_be32(png, static_cast<uint32_t>(data.size()));
+
+            const auto type_offset = png.size();
+            png.insert(png.end(), type, type + 4);
+            png.insert(png.end(), data.begin(), data.end());
+
+            append_be32(png, crc32(std::span(png).subspan(type_offset)));
+        }
+    }
+
+    encoder::encoder(const std::filesystem::path& file, const uint32_t keyframe_interval)
+        : file_(file, std::ios::binary | std::ios::trunc),
+          keyframe_interval_(keyframe_interval)
+    {
+        if (!this->file_)
+        {
+            throw std::runtime_error("Frame capture: Failed to open capture file -> " + file.string());
+        }
+
+        const file_header header{};
+        this->file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        this->statistics_.bytes_written += sizeof(header);
+    }
+
+    void encoder::encode(const uint32_t window, const uint64_t timestamp_us, const ui_surface_desc& surface,
+                         const std::optional<std::span<const RECT>> damage)
+    {
+        if (!surface.pixels || surface.width <= 0 || surface.height <= 0 ||
+            static_cast<int64_t>(surface.stride) < static_cast<int64_t>(surface.width) * 4)
+        {
+            return;
+        }
+
+        const auto width = static_cast<uint32_t>(surface.width);
+        const auto height = static_cast<uint32_t>(surface.height);
+        const auto format = surface.format == ui_surface_format::rgba8 ? pixel_format::rgba8 : pixel_format::bgra8;
+
+        auto& state = this->windows_[window];
+        if (state.pixels.empty() || state.width != width || state.height != height || state.format != format ||
+            (this->keyframe_interval_ != 0 && state.frames_since_keyframe >= this->keyframe_interval_))
+        {
+            this->write_keyframe(state, window, timestamp_us, surface);
+            return;
+        }
+
+        const auto tiles_x = get_tile_count(width, tile_size);
+
+        const auto mark_tiles = [&](const uint32_t left, const uint32_t top, const uint32_t right, const uint32_t bottom) {
+            for (auto ty = top / tile_size; ty <= (bottom - 1) / tile_size; ++ty)
+            {
+                for (auto tx = left / tile_size; tx <= (right - 1) / tile_size; ++tx)
+                {
+                    const auto tile = ty * tiles_x + tx;
+                    if (!state.tile_marks[tile])
+                    {
+                        state.tile_marks[tile] = 1;
+                        state.marked_tiles.push_back(tile);
+                    }
+                }
+            }
+        };
+
+        if (!damage)
+        {
+            mark_tiles(0, 0, width, height);
+        }
+        else
+        {
+            for (const auto& rect : *damage)
+            {
+                const auto left = static_cast<uint32_t>(std::clamp<int64_t>(rect.left, 0, width));
+                const auto top = static_cast<uint32_t>(std::clamp<int64_t>(rect.top, 0, height));
+                const auto right = static_cast<uint32_t>(std::clamp<int64_t>(rect.right, 0, width));
+                const auto bottom = static_cast<uint32_t>(std::clamp<int64_t>(rect.bottom, 0, height));
+
+                if (left < right && top < bottom)
+                {
+                    mark_tiles(left, top, right, bottom);
+                }
+            }
+        }
+
+        // Row-major order keeps neighbouring tiles next to each other for the compressor.
+        std::ranges::sort(state.marked_tiles);
+
+        std::vector<uint32_t> changed_tiles{};
+        for (const auto tile : state.marked_tiles)
+        {
+            state.tile_marks[tile] = 0;
+            ++this->statistics_.compared_tiles;
+
+            const auto x = (tile % tiles_x) * tile_size;
+            const auto y = (tile / tiles_x) * tile_size;
+            const auto row_bytes = static_cast<size_t>(std::min(tile_size, width - x)) * sizeof(uint32_t);
+
+            for (auto row = y; row < std::min(y + tile_size, height); ++row)
+            {
+                const auto* current = get_row(surface, row) + static_cast<size_t>(x) * sizeof(uint32_t);
+                const auto* previous = state.pixels.data() + static_cast<size_t>(row) * width + x;
+
+                if (memcmp(current, previous, row_bytes) != 0)
+                {
+                    changed_tiles.push_back(tile);
+                    break;
+                }
+            }
+        }
+
+        state.marked_tiles.clear();
+
+        if (changed_tiles.empty())
+        {
+            return;
+        }
+
+        const frame_header header{
+            .timestamp_us = timestamp_us,
+            .window = window,
+            .width = width,
+            .height = height,
+            .tile_count = static_cast<uint32_t>(changed_tiles.size()),
+            .type = frame_type::delta,
+            .format = format,
+        };
+
+        this->payload_.clear();
+        append(this->payload_, header);
+
+        for (const auto tile : changed_tiles)
+        {
+            append(this->payload_, tile_header{.x = static_cast<uint16_t>(tile % tiles_x), .y = static_cast<uint16_t>(tile / tiles_x)});
+        }
+
+        for (const auto tile : changed_tiles)
+        {
+            const auto x = (tile % tiles_x) * tile_size;
+            const auto y = (tile / tiles_x) * tile_size;
+            const auto row_bytes = static_cast<size_t>(std::min(tile_size, width - x)) * sizeof(uint32_t);
+
+            for (auto row = y; row < std::min(y + tile_size, height); ++row)
+            {
+                const auto* current = get_row(surface, row) + static_cast<size_t>(x) * sizeof(uint32_t);
+                append(this->payload_, current, row_bytes);
+                memcpy(state.pixels.data() + static_cast<size_t>(row) * width + x, current, row_bytes);
+            }
+        }
+
+        this->write_record();
+
+        ++state.frames_since_keyframe;
+        ++this->statistics_.frames;
+        this->statistics_.encoded_tiles += changed_tiles.size();
+    }
+
+    void encoder::write_keyframe(window_state& state, const uint32_t window, const uint64_t timestamp_us, const ui_surface_desc& surface)
+    {
+        state.width = static_cast<uint32_t>(surface.width);
+        state.height = static_cast<uint32_t>(surface.height);
+        state.format = surface.format == ui_surface_format::rgba8 ? pixel_format::rgba8 : pixel_format::bgra8;
+        state.frames_since_keyframe = 0;
+        state.pixels.resize(static_cast<size_t>(state.width) * state.height);
+        state.tile_marks.assign(static_cast<size_t>(get_tile_count(state.width, tile_size)) * get_tile_count(state.height, tile_size), 0);
+        state.marked_tiles.clear();
+
+        const auto row_bytes = static_cast<size_t>(state.width) * sizeof(uint32_t);
+        for (uint32_t y = 0; y < state.height; ++y)
+        {
+            memcpy(state.pixels.data() + static_cast<size_t>(y) * state.width, get_row(surface, y), row_bytes);
+        }
+
+        const frame_header header{
+            .timestamp_us = timestamp_us,
+            .window = window,
+            .width = state.width,
+            .height = state.height,
+            .type = frame_type::keyframe,
+            .format = state.format,
+        };
+
+        this->payload_.clear();
+        append(this->payload_, header);
+        append(this->payload_, state.pixels.data(), state.pixels.size() * sizeof(uint32_t));
+
+        this->write_record();
+
+        ++this->statistics_.frames;
+        ++this->statistics_.keyframes;
+    }
+
+    void encoder::write_record()
+    {
+        const auto compressed = utils::compression::zstd::compress(this->payload_, compression_level);
+        const auto compressed_size = static_cast<uint32_t>(compressed.size());
+
+        this->file_.write(reinterpret_cast<const char*>(&compressed_size), sizeof(compressed_size));
+        this->file_.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+        this->statistics_.bytes_written += sizeof(compressed_size) + compressed.size();
+    }
+
+    void encoder::forget(const uint32_t window)
+    {
+        this->windows_.erase(window);
+    }
+
+    void encoder::forget_all()
+    {
+        this->windows_.clear();
+    }
+
+    void encoder::flush()
+    {
+        this->file_.flush();
+    }
+
+    decoder::decoder(const std::filesystem::path& file)
+        : file_(file, std::ios::binary)
+    {
+        if (!this->file_)
+        {
+            throw std::runtime_error("Frame capture: Failed to open capture file -> " + file.string());
+        }
+
+        file_header header{};
+        this->file_.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!this->file_ || header.magic != file_magic || header.version != file_version || header.tile_size != tile_size)
+        {
+            throw std::runtime_error("Frame capture: Unsupported capture file -> " + file.string());
+        }
+    }
+
+    std::optional<decoded_frame> decoder::next()
+    {
+        uint32_t compressed_size{};
+        if (!this->file_.read(reinterpret_cast<char*>(&compressed_size), sizeof(compressed_size)))
+        {
+            return std::nullopt;
+        }
+
+        std::vector<std::byte> compressed(compressed_size);
+        if (!this->file_.read(reinterpret_cast<char*>(compressed.data()), compressed_size))
+        {
+            throw std::runtime_error("Frame capture: Truncated capture file");
+        }
+
+        const auto payload = utils::compression::zstd::decompress(compressed);
+        payload_reader reader{payload};
+
+        const auto header = reader.read<frame_header>();
+        auto& state = this->windows_[header.window];
+
+        if (header.type == frame_type::keyframe)
+        {
+            state.width = header.width;
+            state.height = header.height;
+            state.pixels.resize(static_cast<size_t>(header.width) * header.height);
+
+            const auto size = state.pixels.size() * sizeof(uint32_t);
+            memcpy(state.pixels.data(), reader.read(size), size);
+        }
+        else if (header.type == frame_type::delta)
+        {
+            if (state.pixels.empty() || state.width != header.width || state.height != header.height)
+            {
+                throw std::runtime_error("Frame capture: Delta frame without a matching keyframe");
+            }
+
+            const auto tiles_x = get_tile_count(header.width, tile_size);
+            const auto tiles_y = get_tile_count(header.height, tile_size);
+
+            std::vector<tile_header> tiles(header.tile_count);
+            for (auto& tile : tiles)
+            {
+                tile = reader.read<tile_header>();
+                if (tile.x >= tiles_x || tile.y >= tiles_y)
+                {
+                    throw std::runtime_error("Frame capture: Tile outside of the frame");
+                }
+            }
+
+            for (const auto& tile : tiles)
+            {
+                const auto x = static_cast<uint32_t>(tile.x) * tile_size;
+                const auto y = static_cast<uint32_t>(tile.y) * tile_size;
+                const auto row_bytes = static_cast<size_t>(std::min(tile_size, header.width - x)) * sizeof(uint32_t);
+
+                for (auto row = y; row < std::min(y + tile_size, header.height); ++row)
+                {
+                    memcpy(state.pixels.data() + static_cast<size_t>(row) * header.width + x, reader.read(row_bytes), row_bytes);
+                }
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Frame capture: Unknown frame type");
+        }
+
+        return decoded_frame{.header = header, .pixels = state.pixels};
+    }
+
+    void write_png(const std::filesystem::path& file, const uint32_t width, const uint32_t height, const std::span<const uint32_t> pixels,
+                   const pixel_format format)
+    {
+        if (pixels.size() < static_cast<size_t>(width) * height)
+        {
+            throw std::runtime_error("Frame capture: Not enough pixels for the image");
+        }
+
+        // Each scanline starts with filter type 0 (none).
+        std::vector<uint8_t> image{};
+        image.reserve((static_cast<size_t>(width) * 3 + 1) * height);
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            image.push_back(0);
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const auto pixel = pixels[static_cast<size_t>(y) * width + x];
+                const auto first = static_cast<uint8_t>(pixel);
+                const auto second = static_cast<uint8_t>(pixel >> 8);
+                const auto third = static_cast<uint8_t>(pixel >> 16);
+
+                image.push_back(format == pixel_format::bgra8 ? third : first);
+                image.push_back(second);
+                image.push_back(format == pixel_format::bgra8 ? first : third);
+            }
+        }
+
+        // zlib stream made of stored deflate blocks.
+        constexpr size_t max_block_size = 0xFFFF;
+
+        std::vector<uint8_t> idat{0x78, 0x01};
+        idat.reserve(image.size() + (image.size() / max_block_size + 1) * 5 + 6);
+
+        size_t offset = 0;
+        do
+        {
+            const auto block_size = std::min(max_block_size, image.size() - offset);
+            const auto last = offset + block_size == image.size();
+            const auto length = static_cast<uint16_t>(block_size);
+            const auto inverted_length = static_cast<uint16_t>(~length);
+
+            idat.push_back(last ? 1 : 0);
+            idat.push_back(static_cast<uint8_t>(length));
+            idat.push_back(static_cast<uint8_t>(length >> 8));
+            idat.push_back(static_cast<uint8_t>(inverted_length));
+            idat.push_back(static_cast<uint8_t>(inverted_length >> 8));
+            idat.insert(idat.end(), image.begin() + static_cast<ptrdiff_t>(offset),
+                        image.begin() + static_cast<ptrdiff_t>(offset + block_size));
+
+            offset += block_size;
+        } while (offset < image.size());
+
+        append_be32(idat, adler32(image));
+
+        std::vector<uint8_t> ihdr{};
+        append_be32(ihdr, width);
+        append_be32(ihdr, height);
+        ihdr.insert(ihdr.end(), {8 /* bit depth */, 2 /* RGB */, 0, 0, 0});
+
+        std::vector<uint8_t> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        append_png_chunk(png, "IHDR", ihdr);
+        append_png_chunk(png, "IDAT", idat);
+        append_png_chunk(png, "IEND", {});
+
+        std::ofstream stream{file, std::ios::binary | std::ios::trunc};
+        if (!stream.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size())))
+        {
+            throw std::runtime_error("Frame capture: Failed to write image -> " + file.string());
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "../std_include.hpp"
+#include <platform/ui_backend.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace sogen::frame_capture
+{
+    // Capture files hold a file_header followed by one record per frame: a uint32_t compressed size and a zstd
+    // frame containing a frame_header and its pixels. Keyframes carry the whole surface, delta frames a list of
+    // tile_header entries followed by the pixels of each tile (rows clipped to the surface) in the same order.
+    constexpr uint32_t file_magic = 0x43464753; // "SGFC"
+    constexpr uint16_t file_version = 1;
+    constexpr uint32_t tile_size = 64;
+
+    enum class frame_type : uint8_t
+    {
+        keyframe = 0,
+        delta = 1,
+    };
+
+    enum class pixel_format : uint8_t
+    {
+        bgra8 = 0,
+        rgba8 = 1,
+    };
+
+#pragma pack(push, 1)
+    struct file_header
+    {
+        uint32_t magic{file_magic};
+        uint16_t version{file_version};
+        uint16_t tile_size{frame_capture::tile_size};
+    };
+
+    struct frame_header
+    {
+        uint64_t timestamp_us{};
+        uint32_t window{};
+        uint32_t width{};
+        uint32_t height{};
+        uint32_t tile_count{};
+        frame_type type{};
+        pixel_format format{};
+        uint16_t reserved{};
+    };
+
+    struct tile_header
+    {
+        uint16_t x{};
+        uint16_t y{};
+    };
+#pragma pack(pop)
+
+    struct statistics
+    {
+        uint64_t frames{};
+        uint64_t keyframes{};
+        uint64_t compared_tiles{};
+        uint64_t encoded_tiles{};
+        uint64_t bytes_written{};
+    };
+
+    // Keeps the last frame of every window and writes only the tiles that changed. Only tiles touching the
+    // reported damage are compared, so the cost of a frame follows the damaged area rather than the surface.
+    class encoder
+    {
+      public:
+        // Every `keyframe_interval` frames of a window are written in full, 0 writes keyframes only when a window
+        // appears or changes size.
+        explicit encoder(const std::filesystem::path& file, uint32_t keyframe_interval = 600);
+
+        // `damage` lists the regions that may have changed since the previous frame of the window, unset means
+        // anything may have changed.
+        void encode(uint32_t window, uint64_t timestamp_us, const ui_surface_desc& surface, std::optional<std::span<const RECT>> damage);
+
+        void forget(uint32_t window);
+        void forget_all();
+        void flush();
+
+        const statistics& get_statistics() const
+        {
+            return this->statistics_;
+        }
+
+      private:
+        struct window_state
+        {
+            uint32_t width{};
+            uint32_t height{};
+            pixel_format format{};
+            uint32_t frames_since_keyframe{};
+            std::vector<uint32_t> pixels{};
+            std::vector<uint8_t> tile_marks{};
+            std::vector<uint32_t> marked_tiles{};
+        };
+
+        std::ofstream file_{};
+        uint32_t keyframe_interval_{};
+        std::unordered_map<uint32_t, window_state> windows_{};
+        std::vector<std::byte> payload_{};
+        statistics statistics_{};
+
+        void write_keyframe(window_state& state, uint32_t window, uint64_t timestamp_us, const ui_surface_desc& surface);
+        void write_record();
+    };
+
+    struct decoded_frame
+    {
+        frame_header header{};
+
+        // The complete window contents after applying the frame, valid until the next call to decoder::next().
+        std::span<const uint32_t> pixels{};
+    };
+
+    class decoder
+    {
+      public:
+        explicit decoder(const std::filesystem::path& file);
+
+        std::optional<decoded_frame> next();
+
+      private:
+        struct window_state
+        {
+            uint32_t width{};
+            uint32_t height{};
+            std::vector<uint32_t> pixels{};
+        };
+
+        std::ifstream file_{};
+        std::unordered_map<uint32_t, window_state> windows_{};
+    };
+
+    // Writes an 8-bit RGB PNG, dropping alpha. The image data is stored without deflate compression.
+    void write_png(const std::filesystem::path& file, uint32_t width, uint32_t height, std::span<const uint32_t> pixels,
+                   pixel_format format);
+}
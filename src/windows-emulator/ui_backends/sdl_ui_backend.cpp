@@ -645,6 +645,12 @@ namespace sogen
                 this->sink_ = std::move(sink);
             }
 
+            bool needs_pumping() const override
+            {
+                // Without a host window there is no input to deliver.
+                return !this->windows_.empty();
+            }
+
             void pump_events() override
             {
                 {
@@ -346,53 +346,143 @@ namespace sogen
             return {.window = top_level, .x = x, .y = y};
         }
 
-        bool has_pending_host_wait(const process_context& process)
+        // Upper bound for one idle wait, catches anything time-driven that is not tracked below.
+        constexpr auto MAX_IDLE_WAIT = std::chrono::milliseconds(100);
+
+        // Cadence for sources that cannot notify: devices that have to be polled and a UI backend that has
+        // to be pumped.
+        constexpr auto IDLE_POLL_INTERVAL = std::chrono::milliseconds(1);
+
+        // Host conditions (e.g. GPU semaphores) are polled much faster, they gate frame presentation.
+        constexpr auto HOST_CONDITION_POLL_INTERVAL = std::chrono::microseconds(100);
+
+        // A socket wait cannot be interrupted by host_wakeup::notify(), so it is taken in slices.
+        constexpr auto SOCKET_WAIT_SLICE = std::chrono::milliseconds(10);
+
+        struct idle_wait
         {
-            for (const auto& thread_entry : process.threads)
+            std::chrono::steady_clock::duration timeout{};
+            std::vector<network::poll_entry> sockets{};
+        };
+
+        // When a thread that keeps being polled (rather than parked) needs to be looked at again.
+        std::optional<std::chrono::steady_clock::time_point> get_polled_thread_deadline(const emulator_thread& thread)
+        {
+            constexpr auto infinite = std::chrono::steady_clock::time_point::min();
+            std::optional<std::chrono::steady_clock::time_point> deadline{};
+
+            const auto wake_at = [&](const std::optional<std::chrono::steady_clock::time_point>& time) {
+                if (time && *time != infinite && (!deadline || *time < *deadline))
+                {
+                    deadline = time;
+                }
+            };
+
+            wake_at(thread.await_time);
+
+            if (thread.await_io_completion)
+            {
+                wake_at(thread.await_io_completion->timeout);
+            }
+
+            if (thread.await_msg || thread.await_msg_mask)
             {
-                if (thread_entry.second.await_host_condition)
+                for (const auto& timer : thread.user_timers | std::views::values)
                 {
-                    return true;
+                    wake_at(timer.due_time);
                 }
             }
 
-            return false;
+            return deadline;
+        }
+
+        idle_wait get_idle_wait(windows_emulator& win_emu, const bool pump_ui)
+        {
+            auto& process = win_emu.process;
+            const auto now = win_emu.clock().steady_now();
+            auto deadline = now + MAX_IDLE_WAIT;
+
+            const auto wake_at = [&](const std::chrono::steady_clock::time_point time) {
+                deadline = std::min(deadline, std::max(time, now)); //
+            };
+
+            // Parked threads cost nothing here, only their earliest timeout counts.
+            if (const auto next_timeout = process.scheduler.get_next_deadline())
+            {
+                wake_at(*next_timeout);
+            }
+
+            for (const auto thread_id : process.scheduler.get_runnable())
+            {
+                const auto* thread = process.find_thread_by_id(thread_id);
+                if (!thread)
+                {
+                    continue;
+                }
+
+                if (thread->await_host_condition)
+                {
+                    wake_at(now + HOST_CONDITION_POLL_INTERVAL);
+                }
+
+                if (const auto thread_deadline = get_polled_thread_deadline(*thread))
+                {
+                    wake_at(*thread_deadline);
+                }
+            }
+
+            io_device_wait device_wait{};
+            for (auto& dev : process.devices | std::views::values)
+            {
+                dev.collect_wait(device_wait);
+            }
+
+            if (device_wait.deadline)
+            {
+                wake_at(*device_wait.deadline);
+            }
+
+            if (device_wait.needs_polling || pump_ui)
+            {
+                wake_at(now + IDLE_POLL_INTERVAL);
+            }
+
+            return {
+                .timeout = deadline - now,
+                .sockets = std::move(device_wait.sockets),
+            };
         }
 
         vcpu_context* find_vcpu_running_thread(windows_emulator& win_emu, const emulator_thread& thread);
 
         void perform_context_switch_work(windows_emulator& win_emu, vcpu_context& vcpu)
         {
-            auto& threads = win_emu.process.threads;
+            auto& process = win_emu.process;
 
-            for (auto it = threads.begin(); it != threads.end();)
+            for (const auto thread_id : process.scheduler.take_terminated())
             {
-                if (!it->second.is_terminated() || it->second.ref_count > 0)
+                // Threads that are still referenced are dropped by the handle store once their last handle closes.
+                auto* thread = process.find_thread_by_id(thread_id);
+                if (!thread || thread->ref_count > 0)
                 {
-                    ++it;
                     continue;
                 }
 
-                if (auto* running_on = find_vcpu_running_thread(win_emu, it->second))
+                if (auto* running_on = find_vcpu_running_thread(win_emu, *thread))
                 {
                     if (running_on != &vcpu)
                     {
                         // Another vCPU still has this thread loaded; it will detach it soon.
-                        ++it;
+                        process.scheduler.terminate(thread_id);
                         continue;
                     }
 
                     running_on->active_thread = nullptr;
                 }
 
-                const auto [new_it, deleted] = threads.erase(it);
-                if (!deleted)
-                {
-                    ++it;
-                }
-                else
+                if (process.threads.erase(process.thread_handles_by_id.at(thread_id)))
                 {
-                    it = new_it;
+                    process.thread_handles_by_id.erase(thread_id);
                 }
             }
 
@@ -408,19 +498,6 @@ namespace sogen
             }
         }
 
-        emulator_thread* get_thread_by_id(process_context& process, const uint32_t id)
-        {
-            for (auto& t : process.threads | std::views::values)
-            {
-                if (t.id == id)
-                {
-                    return &t;
-                }
-            }
-
-            return nullptr;
-        }
-
         void dispatch_next_apc(windows_emulator& win_emu, vcpu_context& vcpu, emulator_thread& thread)
         {
             assert(vcpu.active_thread == &thread);
@@ -557,43 +634,129 @@ namespace sogen
             return switch_to_thread(win_emu, vcpu, *thread);
         }
 
-        bool switch_to_next_thread(windows_emulator& win_emu, vcpu_context& vcpu)
+        bool is_parkable_object(const handle object)
         {
-            perform_context_switch_work(win_emu, vcpu);
+            if (object.value.is_pseudo)
+            {
+                return false;
+            }
 
-            auto& context = win_emu.process;
+            switch (object.value.type)
+            {
+            case handle_types::event:
+            case handle_types::semaphore:
+            case handle_types::mutant:
+            case handle_types::thread:
+                return true;
+            default:
+                return false;
+            }
+        }
 
-            bool next_thread = false;
+        // Parks a thread that could not be switched to, if its wait can only end through the kernel
+        // signaling an object, alerting, resuming or queuing an APC to it, or through its timeout. Waits
+        // that depend on host state, I/O or the message queue keep being polled on every switch.
+        void park_if_blocked(windows_emulator& win_emu, vcpu_context& vcpu, const emulator_thread& thread)
+        {
+            if (thread.is_terminated())
+            {
+                return;
+            }
 
-            for (auto& t : context.threads | std::views::values)
+            if (auto* running_on = find_vcpu_running_thread(win_emu, thread); running_on && running_on != &vcpu)
             {
-                if (next_thread)
-                {
-                    if (switch_to_thread(win_emu, vcpu, t))
-                    {
-                        return true;
-                    }
+                return;
+            }
 
-                    continue;
-                }
+            auto& scheduler = win_emu.process.scheduler;
+            const auto now = win_emu.clock().steady_now();
 
-                if (&t == vcpu.active_thread)
+            if (thread.suspended > 0)
+            {
+                scheduler.park(thread.id, {}, std::nullopt, now);
+                return;
+            }
+
+            if (thread.await_host_condition || thread.await_io_completion || thread.await_msg || thread.await_msg_mask)
+            {
+                return;
+            }
+
+            constexpr auto infinite = std::chrono::steady_clock::time_point::min();
+            const auto deadline = thread.await_time == infinite ? std::nullopt : thread.await_time;
+
+            if (thread.waiting_for_alert)
+            {
+                scheduler.park(thread.id, {}, deadline, now);
+                return;
+            }
+
+            if (!thread.await_objects.empty())
+            {
+                if (std::ranges::all_of(thread.await_objects, is_parkable_object))
                 {
-                    next_thread = true;
+                    scheduler.park(thread.id, thread.await_objects, deadline, now);
                 }
+
+                return;
+            }
+
+            if (thread.await_time)
+            {
+                scheduler.park(thread.id, {}, deadline, now);
             }
+        }
+
+        // Tries the runnable threads with ids in [first, last] in order, parking the ones that stay blocked.
+        bool switch_to_runnable_thread(windows_emulator& win_emu, vcpu_context& vcpu, const uint32_t first, const uint32_t last)
+        {
+            auto& process = win_emu.process;
+            const auto& runnable = process.scheduler.get_runnable();
 
-            for (auto& t : context.threads | std::views::values)
+            for (auto it = runnable.lower_bound(first); it != runnable.end() && *it <= last;)
             {
-                if (switch_to_thread(win_emu, vcpu, t))
+                // Parking removes the current entry, so move on first.
+                const auto thread_id = *it++;
+
+                auto* thread = process.find_thread_by_id(thread_id);
+                if (!thread)
+                {
+                    process.scheduler.remove(thread_id);
+                    continue;
+                }
+
+                if (switch_to_thread(win_emu, vcpu, *thread))
                 {
                     return true;
                 }
+
+                park_if_blocked(win_emu, vcpu, *thread);
             }
 
             return false;
         }
 
+        bool switch_to_next_thread(windows_emulator& win_emu, vcpu_context& vcpu)
+        {
+            perform_context_switch_work(win_emu, vcpu);
+
+            win_emu.process.scheduler.expire_timeouts(win_emu.clock().steady_now());
+
+            if (!vcpu.active_thread)
+            {
+                return switch_to_runnable_thread(win_emu, vcpu, 0, UINT32_MAX);
+            }
+
+            // The active thread may have kept running while parked (e.g. across a stop, or forced by the
+            // debugger), so its current wait always gets looked at.
+            const auto active_id = vcpu.active_thread->id;
+            win_emu.process.scheduler.wake(active_id);
+
+            // Round robin: the threads after the active one first, then wrap around up to and including it.
+            return (active_id < UINT32_MAX && switch_to_runnable_thread(win_emu, vcpu, active_id + 1, UINT32_MAX)) ||
+                   switch_to_runnable_thread(win_emu, vcpu, 0, active_id);
+        }
+
         struct instruction_tick_clock : utils::tick_clock
         {
             const uint64_t* instructions_{};
@@ -704,7 +867,8 @@ namespace sogen
           file_sys(emulation_root.empty() ? emulation_root : emulation_root / "filesys"),
           memory(*this->emu_),
           registry(settings.load_registry
-                       ? registry_manager{emulation_root.empty() ? settings.registry_directory : emulation_root / "registry"}
+                       ? registry_manager{emulation_root.empty() ? settings.registry_directory : emulation_root / "registry",
+                                          settings.registry_files}
                        : registry_manager{}),
           mod_manager(memory, file_sys, this->callbacks),
           process(*this->emu_, memory, *this->clock_, this->callbacks),
@@ -743,6 +907,7 @@ namespace sogen
         }
 
         this->ui_backend_->set_event_sink([this](const ui_event& event) { this->handle_ui_event(event); });
+        this->process.scheduler.set_wake_callback([this] { this->host_wakeup_.notify(); });
 #ifndef OS_WINDOWS
         if (this->emulation_root.empty())
         {
@@ -827,8 +992,14 @@ namespace sogen
 
         const auto needed_switch = vcpu.switch_thread.exchange(false);
 
-        while (!switch_to_next_thread(*this, vcpu))
+        for (uint32_t idle_rounds = 1; !switch_to_next_thread(*this, vcpu); ++idle_rounds)
         {
+            if (idle_rounds % 64 == 0)
+            {
+                // Backstop for a wake-up that slipped through: every now and then, re-check all parked threads.
+                this->process.scheduler.wake_all();
+            }
+
             if (this->vcpu_count_ > 1 && vcpu.active_thread)
             {
                 // Nothing runnable for this vCPU: detach the stale thread so another
@@ -837,10 +1008,13 @@ namespace sogen
                 vcpu.active_thread = nullptr;
             }
 
-            const auto host_wait_pending = has_pending_host_wait(this->process);
+            // Taken before deciding how long to wait, so a wake-up from here on cuts the wait short.
+            const auto wake_generation = this->host_wakeup_.get_generation();
+            auto wait = this->use_relative_time_ ? idle_wait{}
+                                                 : get_idle_wait(*this, this->vcpu_count_ == 1 && this->ui_backend_->needs_pumping());
 
             // Idle: nothing is ready. Release the kernel lock while pumping UI events
-            // and sleeping so other threads (UI delivery, vCPU workers) can run.
+            // and waiting so other threads (UI delivery, vCPU workers) can run.
             lock.unlock();
 
             if (this->vcpu_count_ == 1)
@@ -853,15 +1027,21 @@ namespace sogen
             {
                 this->executed_instructions_ += MAX_INSTRUCTIONS_PER_TIME_SLICE;
             }
-            else if (host_wait_pending)
+            else if (!wait.sockets.empty() && this->vcpu_count_ == 1)
             {
-                // A host wait (e.g. a GPU semaphore) is parked - re-poll immediately to wake it promptly.
-                std::this_thread::yield();
+                // Only this thread touches devices, so their sockets stay valid without the lock.
+                const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(std::min<std::chrono::steady_clock::duration>(
+                    wait.timeout, SOCKET_WAIT_SLICE));
+                this->socket_factory_->poll_sockets(wait.sockets, timeout);
             }
             else
             {
-                // Only timed waits remain; nothing host-side wakes sooner than wall-clock, so don't busy-spin.
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                if (!wait.sockets.empty())
+                {
+                    wait.timeout = std::min<std::chrono::steady_clock::duration>(wait.timeout, IDLE_POLL_INTERVAL);
+                }
+
+                this->host_wakeup_.wait_until(wake_generation, std::chrono::steady_clock::now() + wait.timeout);
             }
 
             lock.lock();
@@ -873,6 +1053,10 @@ namespace sogen
             }
         }
 
+        // Every quantum ends here, whether the interrupt thread's timer, the instruction budget or a wait
+        // ended it, so the guest never sees KUSD time more than one quantum old.
+        this->process.kusd.refresh();
+
         return true;
     }
 
@@ -912,7 +1096,7 @@ namespace sogen
     {
         const std::scoped_lock lock(this->kernel_lock_);
 
-        auto* thread = get_thread_by_id(this->process, id);
+        auto* thread = this->process.find_thread_by_id(id);
         if (!thread)
         {
             return false;
@@ -1174,7 +1358,7 @@ namespace sogen
                         (service == BREAKPOINT_PRINT || service == BREAKPOINT_LOAD_SYMBOLS || service == BREAKPOINT_UNLOAD_SYMBOLS ||
                          service == BREAKPOINT_COMMAND_STRING))
                     {
-                        const auto ip = this->uses_instruction_precision() //
+                        const auto ip = this->tracks_current_instruction() //
                                             ? vcpu.thread().current_ip
                                             : acting.read_instruction_pointer();
                         acting.reg(x86_register::rip, ip + 3);
@@ -1247,12 +1431,7 @@ namespace sogen
 
         if (this->uses_instruction_precision())
         {
-            this->emu().hook_memory_execution([&](cpu_interface& cpu, const uint64_t address) {
-                const std::scoped_lock lock(this->kernel_lock_);
-                auto& vcpu = this->vcpu(cpu.index());
-                const scoped_dispatch dispatch(*this, vcpu);
-                this->on_instruction_execution(vcpu, address); //
-            });
+            this->update_instruction_accounting_hook();
         }
         else if (!this->emu().is_stop_thread_safe())
         {
@@ -1266,6 +1445,78 @@ namespace sogen
         }
     }
 
+    void windows_emulator::update_instruction_accounting_hook()
+    {
+        // Per-instruction hooks are only needed to feed callbacks.on_instruction, or when the backend can not
+        // tell how many instructions a basic block holds. Consumers may register the callback after
+        // construction, so this is re-evaluated whenever emulation starts.
+        const auto per_instruction = static_cast<bool>(this->callbacks.on_instruction) //
+                                     || !this->emu().supports_basic_block_instruction_counts();
+
+        if (this->instruction_accounting_hook_ && per_instruction == this->per_instruction_accounting_)
+        {
+            return;
+        }
+
+        if (this->instruction_accounting_hook_)
+        {
+            this->emu().delete_hook(this->instruction_accounting_hook_);
+        }
+
+        this->per_instruction_accounting_ = per_instruction;
+
+        if (per_instruction)
+        {
+            this->instruction_accounting_hook_ = this->emu().hook_memory_execution([&](cpu_interface& cpu, const uint64_t address) {
+                const std::scoped_lock lock(this->kernel_lock_);
+                auto& vcpu = this->vcpu(cpu.index());
+                const scoped_dispatch dispatch(*this, vcpu);
+                this->on_instruction_execution(vcpu, address); //
+            });
+        }
+        else
+        {
+            this->instruction_accounting_hook_ = this->emu().hook_basic_block([&](cpu_interface& cpu, const basic_block& block) {
+                const std::scoped_lock lock(this->kernel_lock_);
+                auto& vcpu = this->vcpu(cpu.index());
+                const scoped_dispatch dispatch(*this, vcpu);
+                this->on_counted_basic_block_execution(vcpu, block); //
+            });
+        }
+    }
+
+    void windows_emulator::on_counted_basic_block_execution(vcpu_context& vcpu, const basic_block& block)
+    {
+        // Same accounting as on_instruction_execution, at block granularity. A block is accounted for in
+        // full when it is entered, so time slices end on block boundaries.
+        auto& thread = vcpu.thread();
+
+        if (!thread.callback_stack.empty() && block.address == this->process.zw_callback_return)
+        {
+            thread.callback_return_rax = vcpu.cpu.reg<uint64_t>(x86_register::rax);
+        }
+
+        const auto count = static_cast<uint64_t>(block.instruction_count);
+        const auto previous_slice = thread.executed_instructions / MAX_INSTRUCTIONS_PER_TIME_SLICE;
+
+        this->executed_instructions_ += count;
+        thread.executed_instructions += count;
+
+        if (thread.executed_instructions / MAX_INSTRUCTIONS_PER_TIME_SLICE != previous_slice)
+        {
+            this->yield_thread(vcpu);
+        }
+
+        // Only block starts are known here; see tracks_current_instruction.
+        thread.previous_ip = thread.current_ip;
+        thread.current_ip = block.address;
+
+        if (!this->uses_section_first_execution_hooks())
+        {
+            this->track_section_first_execution(block.address);
+        }
+    }
+
     void windows_emulator::on_basic_block_execution(vcpu_context& vcpu, const basic_block&)
     {
         auto& thread = vcpu.thread();
@@ -1288,6 +1539,11 @@ namespace sogen
         this->last_stop_detail_.clear();
         this->setup_process_if_necessary();
 
+        if (this->uses_instruction_precision())
+        {
+            this->update_instruction_accounting_hook();
+        }
+
         if (count > 0 && this->vcpu_count_ > 1)
         {
             throw std::invalid_argument("Instruction-count budgets require a single vCPU");
@@ -1454,7 +1710,7 @@ namespace sogen
             return;
         }
 
-        auto* thread = get_thread_by_id(this->process, raw_win->thread_id);
+        auto* thread = this->process.find_thread_by_id(raw_win->thread_id);
         if (!thread)
         {
             return;
@@ -1503,7 +1759,7 @@ namespace sogen
             return;
         }
 
-        auto* thread = get_thread_by_id(this->process, win->thread_id);
+        auto* thread = this->process.find_thread_by_id(win->thread_id);
         if (!thread)
         {
             return;
@@ -1703,6 +1959,8 @@ namespace sogen
         }
 
         entry->signaled = true;
+        this->process.scheduler.notify_object(event_handle);
+        this->host_wakeup_.notify();
         return true;
     }
 
@@ -1737,6 +1995,8 @@ namespace sogen
         {
             this->vcpu(i).cpu.stop();
         }
+
+        this->host_wakeup_.notify();
     }
 
     void windows_emulator::register_factories(utils::buffer_deserializer& buffer)
@@ -1929,7 +2189,7 @@ namespace sogen
         }
     }
 
-    void windows_emulator::save_snapshot()
+    std::vector<std::byte> windows_emulator::serialize_snapshot_state() const
     {
         utils::buffer_serializer buffer{};
 
@@ -1942,22 +2202,17 @@ namespace sogen
 
         // Snapshot path still uses regular backend state serialization.
         // Backend snapshot mode (is_snapshot=true) is not reliable yet.
+        // Memory is kept outside the buffer so restore_snapshot can rewrite only what changed.
         this->emu().serialize_state(buffer, false);
-        this->memory.serialize_memory_state(buffer, false);
         this->mod_manager.serialize(buffer);
         this->dispatcher.serialize(buffer);
         this->process.serialize(buffer, this->vcpus_[0]->active_thread);
 
-        this->process_snapshot_ = buffer.move_buffer();
+        return buffer.move_buffer();
     }
 
-    void windows_emulator::restore_snapshot()
+    void windows_emulator::deserialize_snapshot_state(std::shared_ptr<const memory_manager::memory_image> fork_memory)
     {
-        if (this->process_snapshot_.empty())
-        {
-            throw std::runtime_error("No snapshot saved");
-        }
-
         utils::buffer_deserializer buffer{this->process_snapshot_};
 
         this->register_factories(buffer);
@@ -1969,11 +2224,20 @@ namespace sogen
         this->version.deserialize(buffer);
         this->registry.deserialize_runtime_state(buffer);
 
-        this->memory.unmap_all_memory();
         this->clear_section_first_execution_hooks();
 
         this->emu().deserialize_state(buffer, false);
-        this->memory.deserialize_memory_state(buffer, false);
+
+        if (fork_memory)
+        {
+            this->memory.unmap_all_memory();
+            this->memory.fork_memory_image(std::move(fork_memory));
+        }
+        else
+        {
+            this->memory.restore_snapshot();
+        }
+
         this->mod_manager.deserialize(buffer);
         this->install_section_first_execution_hooks();
         this->dispatcher.deserialize(buffer);
@@ -1981,4 +2245,44 @@ namespace sogen
         this->restore_ui_backend();
     }
 
+    void windows_emulator::save_snapshot()
+    {
+        this->process_snapshot_ = this->serialize_snapshot_state();
+        this->memory.save_snapshot();
+    }
+
+    void windows_emulator::restore_snapshot()
+    {
+        if (this->process_snapshot_.empty())
+        {
+            throw std::runtime_error("No snapshot saved");
+        }
+
+        this->deserialize_snapshot_state(nullptr);
+    }
+
+    std::shared_ptr<const windows_emulator::fork_image> windows_emulator::create_fork_image() const
+    {
+        auto image = std::make_shared<fork_image>();
+        image->settings = this->application_settings_;
+        image->use_relative_time = this->use_relative_time_;
+        image->state = this->serialize_snapshot_state();
+        image->memory = this->memory.create_memory_image();
+
+        return image;
+    }
+
+    void windows_emulator::fork_from(const fork_image& image)
+    {
+        if (image.use_relative_time != this->use_relative_time_)
+        {
+            throw std::runtime_error("Can not fork emulator with different time dimensions");
+        }
+
+        this->application_settings_ = image.settings;
+        this->process_snapshot_ = image.state;
+
+        this->deserialize_snapshot_state(image.memory);
+    }
+
 } // namespace sogen
@@ -9,6 +9,7 @@
 #include "syscall_dispatcher.hpp"
 #include "process_context.hpp"
 #include "kernel_lock.hpp"
+#include "host_wakeup.hpp"
 #include "logger.hpp"
 #include "file_system.hpp"
 #include "memory_manager.hpp"
@@ -35,6 +36,7 @@ namespace sogen
 
         opt_func<void(uint64_t address, uint64_t length, memory_permission)> on_memory_protect{};
         opt_func<void(uint64_t address, uint64_t length, memory_permission, bool commit)> on_memory_allocate{};
+        opt_func<void(uint64_t address, uint64_t length)> on_memory_release{}; // Released or decommitted
         opt_func<void(uint64_t address, uint64_t length, memory_operation, memory_violation_type type)> on_memory_violate{};
 
         opt_func<void()> on_rdtsc{};
@@ -78,7 +80,7 @@ namespace sogen
     // Knobs for values the emulator exposes to the emulated process that don't
     // depend on the host environment. Samples (particularly anti-analysis
     // payloads) probe these to detect VM/sandbox; today they are hardcoded in
-    // process_context.cpp (PEB.NumberOfProcessors = 4) and kusd_mmio.cpp
+    // process_context.cpp (PEB.NumberOfProcessors = 4) and kusd_page.cpp
     // (KUSER_SHARED_DATA.NtProductType = NtProductWinNt). Defaults match the
     // legacy hardcoded values — behavior is unchanged when consumers leave
     // this field at its default.
@@ -97,6 +99,9 @@ namespace sogen
         std::filesystem::path emulation_root{};
         std::filesystem::path registry_directory{"./registry"};
 
+        // .reg files applied on top of the hives, in order.
+        std::vector<std::filesystem::path> registry_files{};
+
         // When false, construct without loading the registry hives. Intended for headless harnesses
         // (e.g. fuzzing) that never run the guest and don't read the registry, so they can construct
         // with no emulation root / registry directory on disk. The registry ctor otherwise eagerly
@@ -343,6 +348,14 @@ namespace sogen
             return this->instruction_precision_;
         }
 
+        // Whether emulator_thread::current_ip follows every executed instruction. Without an on_instruction
+        // consumer, instruction precision is kept through per-block accounting where the backend supports
+        // it, and current_ip then only tracks basic block starts.
+        bool tracks_current_instruction() const
+        {
+            return this->instruction_precision_ && this->per_instruction_accounting_;
+        }
+
         bool uses_relative_time() const
         {
             return this->use_relative_time_;
@@ -383,6 +396,22 @@ namespace sogen
         void save_snapshot();
         void restore_snapshot();
 
+        // An emulator captured once for cheap duplication: guest memory lives in a shared image that forks
+        // map copy-on-write, the remaining state is serialized like a snapshot.
+        struct fork_image
+        {
+            application_settings settings{};
+            bool use_relative_time{};
+            std::vector<std::byte> state{};
+            std::shared_ptr<const memory_manager::memory_image> memory{};
+        };
+
+        std::shared_ptr<const fork_image> create_fork_image() const;
+
+        // Turns this emulator into a copy of the image's source, with the image as its snapshot, so
+        // restore_snapshot resets it to the fork point.
+        void fork_from(const fork_image& image);
+
         uint16_t get_host_port(const uint16_t emulator_port) const
         {
             const auto entry = this->port_mappings_.find(emulator_port);
@@ -430,6 +459,8 @@ namespace sogen
       private:
         bool use_relative_time_{false}; // TODO: Get rid of that
         bool instruction_precision_{true};
+        bool per_instruction_accounting_{false};
+        emulator_hook* instruction_accounting_hook_{};
         uint32_t vcpu_count_{1};
         std::atomic_bool should_stop{false};
 
@@ -437,6 +468,9 @@ namespace sogen
         // released while guest code executes (docs/multi-vcpu-design.md, section 7).
         kernel_lock kernel_lock_{};
 
+        // What an idle vCPU blocks on until a guest thread may have become runnable.
+        host_wakeup host_wakeup_{};
+
         // The vCPU currently running a handler under the kernel lock; drives
         // current_thread(). See scoped_dispatch.
         vcpu_context* dispatch_vcpu_{};
@@ -462,6 +496,8 @@ namespace sogen
         void vcpu_worker(vcpu_context& vcpu);
         void on_instruction_execution(vcpu_context& vcpu, uint64_t address);
         void on_basic_block_execution(vcpu_context& vcpu, const basic_block& block);
+        void on_counted_basic_block_execution(vcpu_context& vcpu, const basic_block& block);
+        void update_instruction_accounting_hook();
 
         bool uses_section_first_execution_hooks() const;
         void clear_section_first_execution_hooks();
@@ -471,6 +507,9 @@ namespace sogen
         void restore_ui_backend();
 
         void register_factories(utils::buffer_deserializer& buffer);
+
+        std::vector<std::byte> serialize_snapshot_state() const;
+        void deserialize_snapshot_state(std::shared_ptr<const memory_manager::memory_image> fork_memory);
     };
 
 } // namespace sogen
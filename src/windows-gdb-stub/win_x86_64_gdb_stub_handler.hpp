@@ -168,6 +168,30 @@ namespace sogen
             return library_stop_pending_;
         }
 
+        std::vector<gdb_stub::memory_region> get_memory_regions() override
+        {
+            std::vector<gdb_stub::memory_region> regions{};
+
+            for (const auto& [base, reserved] : this->win_emu_->memory.get_reserved_regions())
+            {
+                (void)base;
+
+                for (const auto& [address, committed] : reserved.committed_regions)
+                {
+                    if (!regions.empty() && regions.back().address + regions.back().length == address)
+                    {
+                        regions.back().length += committed.length;
+                    }
+                    else
+                    {
+                        regions.push_back({.address = address, .length = committed.length});
+                    }
+                }
+            }
+
+            return regions;
+        }
+
         std::vector<gdb_stub::thread_info> get_thread_list() const override
         {
             std::vector<gdb_stub::thread_info> thread_list{};